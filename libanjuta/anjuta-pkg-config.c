@@ -18,6 +18,7 @@
  */
 
 #include <glib.h>
+#include <glib/gstdio.h>
 #include <string.h>
 
 #include <libanjuta/anjuta-pkg-config.h>
@@ -51,8 +52,8 @@ remove_includes (GList* includes, GList* dependencies)
 }
 
 
-GList*
-anjuta_pkg_config_list_dependencies (const gchar* package, GError** error)
+static GList*
+pkg_config_spawn_dependencies (const gchar* package, GError** error)
 {
 	GList* deps = NULL;
 	gchar* cmd;
@@ -84,8 +85,8 @@ anjuta_pkg_config_list_dependencies (const gchar* package, GError** error)
 	return deps;
 }
 
-GList*
-anjuta_pkg_config_get_directories (const gchar* pkg_name, gboolean no_deps, GError** error)
+static GList*
+pkg_config_spawn_directories (const gchar* pkg_name, gboolean no_deps, GError** error)
 {
 	gchar *cmd;
 	gchar *err;
@@ -120,11 +121,11 @@ anjuta_pkg_config_get_directories (const gchar* pkg_name, gboolean no_deps, GErr
 
 	if (dirs && no_deps)
 	{
-		GList* pkgs = anjuta_pkg_config_list_dependencies (pkg_name, error);
+		GList* pkgs = pkg_config_spawn_dependencies (pkg_name, error);
 		GList* pkg;
 		for (pkg = pkgs; pkg != NULL; pkg = g_list_next (pkg))
 		{
-			GList* dep_dirs = anjuta_pkg_config_get_directories (pkg->data, FALSE, NULL);
+			GList* dep_dirs = pkg_config_spawn_directories (pkg->data, FALSE, NULL);
 			dirs = remove_includes (dirs, dep_dirs);
 			anjuta_util_glist_strings_free (dep_dirs);
 		}
@@ -134,6 +135,474 @@ anjuta_pkg_config_get_directories (const gchar* pkg_name, gboolean no_deps, GErr
 	return dirs;
 }
 
+/* Running pkg-config once for each package and again for each of its
+ * dependencies is slow, so the .pc files are parsed here and the include
+ * directories and dependencies of each package are kept in memory. An entry
+ * is parsed again when the mtime of its .pc file changes. When a package
+ * cannot be found or parsed, we fall back to running pkg-config.
+ */
+
+typedef struct
+{
+	gchar* pc_file;
+	gint64 mtime;
+	gchar** requires;		/* In the same format as --print-requires */
+	gchar** depends;		/* Package names only */
+	gchar** include_dirs;
+} PkgConfigEntry;
+
+G_LOCK_DEFINE_STATIC (pkg_config_cache);
+static GHashTable* pkg_config_cache = NULL;
+static gchar** pkg_config_path = NULL;
+
+static void
+pkg_config_entry_free (PkgConfigEntry* entry)
+{
+	g_free (entry->pc_file);
+	g_strfreev (entry->requires);
+	g_strfreev (entry->depends);
+	g_strfreev (entry->include_dirs);
+	g_slice_free (PkgConfigEntry, entry);
+}
+
+static void
+pkg_config_add_search_dirs (GPtrArray* path, const gchar* dirs)
+{
+	gchar** split = g_strsplit (dirs, G_SEARCHPATH_SEPARATOR_S, -1);
+	gchar** dir;
+
+	for (dir = split; *dir != NULL; dir++)
+	{
+		if (**dir != '\0')
+			g_ptr_array_add (path, g_strdup (*dir));
+	}
+	g_strfreev (split);
+}
+
+static gchar**
+pkg_config_get_search_path (void)
+{
+	if (pkg_config_path == NULL)
+	{
+		GPtrArray* path = g_ptr_array_new ();
+		const gchar* env;
+
+		env = g_getenv ("PKG_CONFIG_PATH");
+		if (env != NULL)
+			pkg_config_add_search_dirs (path, env);
+
+		env = g_getenv ("PKG_CONFIG_LIBDIR");
+		if (env != NULL)
+		{
+			pkg_config_add_search_dirs (path, env);
+		}
+		else
+		{
+			gchar* out = NULL;
+
+			if (g_spawn_command_line_sync ("pkg-config --variable pc_path pkg-config",
+			                               &out, NULL, NULL, NULL))
+			{
+				pkg_config_add_search_dirs (path, g_strstrip (out));
+			}
+			g_free (out);
+		}
+		g_ptr_array_add (path, NULL);
+		pkg_config_path = (gchar**) g_ptr_array_free (path, FALSE);
+	}
+
+	return pkg_config_path;
+}
+
+static gchar*
+pkg_config_find_pc_file (const gchar* name)
+{
+	gchar* basename;
+	gchar** dir;
+	gchar* pc_file = NULL;
+
+	/* Let pkg-config handle paths to .pc files */
+	if (strchr (name, G_DIR_SEPARATOR) != NULL || g_str_has_suffix (name, ".pc"))
+		return NULL;
+
+	basename = g_strconcat (name, ".pc", NULL);
+	for (dir = pkg_config_get_search_path (); *dir != NULL; dir++)
+	{
+		pc_file = g_build_filename (*dir, basename, NULL);
+		if (g_file_test (pc_file, G_FILE_TEST_IS_REGULAR))
+			break;
+		g_free (pc_file);
+		pc_file = NULL;
+	}
+	g_free (basename);
+
+	return pc_file;
+}
+
+/* Returns NULL if the value uses an undefined variable */
+static gchar*
+pkg_config_expand (const gchar* value, GHashTable* variables)
+{
+	GString* str = g_string_new (NULL);
+	const gchar* ptr;
+
+	for (ptr = value; *ptr != '\0'; ptr++)
+	{
+		if ((ptr[0] == '$') && (ptr[1] == '$'))
+		{
+			g_string_append_c (str, '$');
+			ptr++;
+		}
+		else if ((ptr[0] == '$') && (ptr[1] == '{') && (strchr (ptr, '}') != NULL))
+		{
+			const gchar* end = strchr (ptr, '}');
+			gchar* name = g_strndup (ptr + 2, end - ptr - 2);
+			const gchar* var = g_hash_table_lookup (variables, name);
+
+			g_free (name);
+			if (var == NULL)
+			{
+				g_string_free (str, TRUE);
+				return NULL;
+			}
+			g_string_append (str, var);
+			ptr = end;
+		}
+		else
+		{
+			g_string_append_c (str, *ptr);
+		}
+	}
+
+	return g_string_free (str, FALSE);
+}
+
+static void
+pkg_config_parse_requires (const gchar* value, GPtrArray* requires, GPtrArray* depends)
+{
+	gchar** tokens = g_strsplit_set (value, " \t,", -1);
+	gchar** token;
+
+	for (token = tokens; *token != NULL; token++)
+	{
+		if (**token == '\0')
+			continue;
+
+		if (strchr ("<>=!", **token) != NULL)
+		{
+			/* Version constraint on the previous package */
+			gchar** version = token + 1;
+			gchar* last;
+
+			while ((*version != NULL) && (**version == '\0'))
+				version++;
+			if ((*version == NULL) || (requires->len == 0))
+				break;
+
+			last = g_ptr_array_index (requires, requires->len - 1);
+			g_ptr_array_index (requires, requires->len - 1) =
+				g_strdup_printf ("%s %s %s", last, *token, *version);
+			g_free (last);
+			token = version;
+		}
+		else
+		{
+			g_ptr_array_add (requires, g_strdup (*token));
+			g_ptr_array_add (depends, g_strdup (*token));
+		}
+	}
+	g_strfreev (tokens);
+}
+
+static gboolean
+pkg_config_parse_cflags (const gchar* value, GPtrArray* include_dirs)
+{
+	gchar** argv;
+	gint argc;
+	gint i;
+
+	if (*value == '\0')
+		return TRUE;
+	if (!g_shell_parse_argv (value, &argc, &argv, NULL))
+		return FALSE;
+
+	for (i = 0; i < argc; i++)
+	{
+		const gchar* dir = NULL;
+
+		if (strcmp (argv[i], "-I") == 0)
+		{
+			if (i + 1 < argc)
+				dir = argv[++i];
+		}
+		else if (g_str_has_prefix (argv[i], "-I"))
+		{
+			dir = argv[i] + 2;
+		}
+
+		if ((dir != NULL) && g_regex_match_simple ("\\.*/include/\\w+", dir, 0, 0))
+			g_ptr_array_add (include_dirs, g_strdup (dir));
+	}
+	g_strfreev (argv);
+
+	return TRUE;
+}
+
+static PkgConfigEntry*
+pkg_config_entry_new (const gchar* pc_file, gint64 mtime)
+{
+	gchar* contents;
+	gchar* ptr;
+	gchar** lines;
+	gchar** line;
+	GHashTable* variables;
+	GPtrArray* requires;
+	GPtrArray* depends;
+	GPtrArray* include_dirs;
+	PkgConfigEntry* entry = NULL;
+	gboolean ok = TRUE;
+
+	if (!g_file_get_contents (pc_file, &contents, NULL, NULL))
+		return NULL;
+
+	/* Join continued lines */
+	for (ptr = contents; *ptr != '\0'; ptr++)
+	{
+		if ((ptr[0] == '\\') && (ptr[1] == '\n'))
+			ptr[0] = ptr[1] = ' ';
+	}
+
+	variables = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	g_hash_table_insert (variables, g_strdup ("pcfiledir"), g_path_get_dirname (pc_file));
+	requires = g_ptr_array_new ();
+	depends = g_ptr_array_new ();
+	include_dirs = g_ptr_array_new ();
+
+	lines = g_strsplit (contents, "\n", -1);
+	for (line = lines; ok && (*line != NULL); line++)
+	{
+		gchar* end;
+		gchar* sep;
+		gchar* key;
+		gchar* value;
+
+		if ((ptr = strchr (*line, '#')) != NULL)
+			*ptr = '\0';
+		g_strstrip (*line);
+
+		for (end = *line; g_ascii_isalnum (*end) || ((*end != '\0') && (strchr ("_.-", *end) != NULL)); end++);
+		for (sep = end; g_ascii_isspace (*sep); sep++);
+		if ((end == *line) || ((*sep != '=') && (*sep != ':')))
+			continue;
+
+		key = g_strndup (*line, end - *line);
+		value = pkg_config_expand (g_strchug (sep + 1), variables);
+		if (value == NULL)
+		{
+			ok = FALSE;
+		}
+		else if (*sep == '=')
+		{
+			g_hash_table_insert (variables, key, value);
+			continue;
+		}
+		else if ((strcmp (key, "Requires") == 0) || (strcmp (key, "Requires.private") == 0))
+		{
+			pkg_config_parse_requires (value, requires, depends);
+		}
+		else if (g_ascii_strcasecmp (key, "Cflags") == 0)
+		{
+			ok = pkg_config_parse_cflags (value, include_dirs);
+		}
+		g_free (key);
+		g_free (value);
+	}
+	g_strfreev (lines);
+	g_free (contents);
+	g_hash_table_destroy (variables);
+
+	g_ptr_array_add (requires, NULL);
+	g_ptr_array_add (depends, NULL);
+	g_ptr_array_add (include_dirs, NULL);
+	if (ok)
+	{
+		entry = g_slice_new (PkgConfigEntry);
+		entry->pc_file = g_strdup (pc_file);
+		entry->mtime = mtime;
+		entry->requires = (gchar**) g_ptr_array_free (requires, FALSE);
+		entry->depends = (gchar**) g_ptr_array_free (depends, FALSE);
+		entry->include_dirs = (gchar**) g_ptr_array_free (include_dirs, FALSE);
+	}
+	else
+	{
+		g_strfreev ((gchar**) g_ptr_array_free (requires, FALSE));
+		g_strfreev ((gchar**) g_ptr_array_free (depends, FALSE));
+		g_strfreev ((gchar**) g_ptr_array_free (include_dirs, FALSE));
+	}
+
+	return entry;
+}
+
+/* Must be called with the cache lock held */
+static PkgConfigEntry*
+pkg_config_lookup (const gchar* name)
+{
+	PkgConfigEntry* entry;
+	GStatBuf st;
+	gchar* pc_file;
+
+	if (pkg_config_cache == NULL)
+	{
+		pkg_config_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+		                                          (GDestroyNotify) pkg_config_entry_free);
+	}
+
+	entry = g_hash_table_lookup (pkg_config_cache, name);
+	if (entry != NULL)
+	{
+		if ((g_stat (entry->pc_file, &st) == 0) && (st.st_mtime == entry->mtime))
+			return entry;
+
+		DEBUG_PRINT ("Package %s changed, parsing %s again", name, entry->pc_file);
+		g_hash_table_remove (pkg_config_cache, name);
+		entry = NULL;
+	}
+
+	pc_file = pkg_config_find_pc_file (name);
+	if ((pc_file != NULL) && (g_stat (pc_file, &st) == 0))
+	{
+		entry = pkg_config_entry_new (pc_file, st.st_mtime);
+		if (entry != NULL)
+			g_hash_table_insert (pkg_config_cache, g_strdup (name), entry);
+	}
+	g_free (pc_file);
+
+	return entry;
+}
+
+/* Add the include directories of a package and all its dependencies to list,
+ * return FALSE if one of them cannot be found. Called with the lock held */
+static gboolean
+pkg_config_collect_directories (const gchar* name, GHashTable* packages, GHashTable* dirs, GList** list)
+{
+	PkgConfigEntry* entry;
+	gchar** item;
+
+	if (g_hash_table_contains (packages, name))
+		return TRUE;
+
+	entry = pkg_config_lookup (name);
+	if (entry == NULL)
+		return FALSE;
+	g_hash_table_add (packages, g_strdup (name));
+
+	for (item = entry->include_dirs; *item != NULL; item++)
+	{
+		if (!g_hash_table_contains (dirs, *item))
+		{
+			gchar* dir = g_strdup (*item);
+
+			g_hash_table_add (dirs, dir);
+			*list = g_list_prepend (*list, dir);
+		}
+	}
+	for (item = entry->depends; *item != NULL; item++)
+	{
+		if (!pkg_config_collect_directories (*item, packages, dirs, list))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+pkg_config_get_all_directories (const gchar* name, GList** list)
+{
+	GHashTable* packages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	GHashTable* dirs = g_hash_table_new (g_str_hash, g_str_equal);
+	gboolean found;
+
+	found = pkg_config_collect_directories (name, packages, dirs, list);
+	g_hash_table_destroy (packages);
+	g_hash_table_destroy (dirs);
+
+	return found;
+}
+
+static gboolean
+pkg_config_get_cached_directories (const gchar* pkg_name, gboolean no_deps, GList** result)
+{
+	GList* dirs = NULL;
+	PkgConfigEntry* entry;
+	gboolean found;
+
+	G_LOCK (pkg_config_cache);
+	found = pkg_config_get_all_directories (pkg_name, &dirs);
+	entry = found ? pkg_config_lookup (pkg_name) : NULL;
+	if (entry != NULL && dirs && no_deps)
+	{
+		gchar** dep;
+
+		for (dep = entry->depends; *dep != NULL; dep++)
+		{
+			GList* dep_dirs = NULL;
+
+			if (anjuta_pkg_config_ignore_package (*dep))
+				continue;
+			pkg_config_get_all_directories (*dep, &dep_dirs);
+			dirs = remove_includes (dirs, dep_dirs);
+			anjuta_util_glist_strings_free (dep_dirs);
+		}
+	}
+	G_UNLOCK (pkg_config_cache);
+
+	if (!found)
+	{
+		anjuta_util_glist_strings_free (dirs);
+		return FALSE;
+	}
+	*result = dirs;
+
+	return TRUE;
+}
+
+GList*
+anjuta_pkg_config_list_dependencies (const gchar* package, GError** error)
+{
+	GList* deps = NULL;
+	PkgConfigEntry* entry;
+
+	G_LOCK (pkg_config_cache);
+	entry = pkg_config_lookup (package);
+	if (entry != NULL)
+	{
+		gchar** depend;
+
+		for (depend = entry->requires; *depend != NULL; depend++)
+		{
+			if (!anjuta_pkg_config_ignore_package (*depend))
+				deps = g_list_prepend (deps, g_strdup (*depend));
+		}
+	}
+	G_UNLOCK (pkg_config_cache);
+
+	if (entry == NULL)
+		return pkg_config_spawn_dependencies (package, error);
+
+	return g_list_reverse (deps);
+}
+
+GList*
+anjuta_pkg_config_get_directories (const gchar* pkg_name, gboolean no_deps, GError** error)
+{
+	GList* dirs = NULL;
+
+	if (pkg_config_get_cached_directories (pkg_name, no_deps, &dirs))
+		return dirs;
+
+	return pkg_config_spawn_directories (pkg_name, no_deps, error);
+}
+
 gboolean
 anjuta_pkg_config_ignore_package (const gchar* name)
 {
@@ -32,6 +32,9 @@
 #include <libanjuta/anjuta-utils.h>
 #include <libanjuta/anjuta-pkg-config.h>
 #include <gio/gio.h>
+#include <glib/gstdio.h>
+#include <string.h>
+#include <sys/stat.h>
 
 enum
 {
@@ -45,32 +48,12 @@ struct _AnjutaPkgScannerPrivate
 	gchar* package;
 	gchar* version;
 	GList* files;
+	gboolean pending;
 };
 
 G_DEFINE_TYPE (AnjutaPkgScanner, anjuta_pkg_scanner, ANJUTA_TYPE_ASYNC_COMMAND);
 
 
-
-static void
-anjuta_pkg_scanner_init (AnjutaPkgScanner *object)
-{
-	object->priv = G_TYPE_INSTANCE_GET_PRIVATE (object,
-	                                            ANJUTA_TYPE_PKG_SCANNER,
-	                                            AnjutaPkgScannerPrivate);
-	object->priv->files = NULL;
-}
-
-static void
-anjuta_pkg_scanner_finalize (GObject *object)
-{
-	AnjutaPkgScanner* scanner = ANJUTA_PKG_SCANNER (object);
-	g_free (scanner->priv->package);
-	g_free (scanner->priv->version);
-	anjuta_util_glist_strings_free (scanner->priv->files);
-	
-	G_OBJECT_CLASS (anjuta_pkg_scanner_parent_class)->finalize (object);
-}
-
 static void
 anjuta_pkg_scanner_set_property (GObject *object, guint prop_id, const GValue *value, GParamSpec *pspec)
 {
@@ -117,44 +100,380 @@ anjuta_pkg_scanner_get_property (GObject *object, guint prop_id, GValue *value,
 	}
 }
 
+/* Listing cache
+ *
+ * The list of files and sub directories of each scanned directory is kept in
+ * a cache file with the modification time of the directory. Scanning an
+ * unchanged directory needs only a stat call. The cache is shared by all
+ * scanners, which can run in different threads.
+ *---------------------------------------------------------------------------*/
+
+#define PKG_SCANNER_CACHE_FILE		"pkg-scanner.cache"
+
+/* Increment it when the format of the cache changes */
+#define PKG_SCANNER_CACHE_VERSION	1
+
+/* version, directories (path, mtime, sub directories, files) */
+#define PKG_SCANNER_CACHE_FORMAT	"(ua(sxasas))"
+
+/* Maximum number of directory trees scanned at the same time */
+#define PKG_SCANNER_MAX_THREADS		4
+
+typedef struct
+{
+	gint ref_count;
+	gint64 mtime;
+	gchar **directories;
+	gchar **files;
+} AnjutaPkgScannerDir;
+
+G_LOCK_DEFINE_STATIC (pkg_scanner_cache);
+static GHashTable *pkg_scanner_cache = NULL;	/* path -> AnjutaPkgScannerDir */
+static gboolean pkg_scanner_cache_modified = FALSE;
+
+static AnjutaPkgScannerDir *
+pkg_scanner_dir_ref (AnjutaPkgScannerDir *dir)
+{
+	g_atomic_int_inc (&dir->ref_count);
+
+	return dir;
+}
+
 static void
-anjuta_pkg_scanner_list_files (GList **children, GFile *dir)
+pkg_scanner_dir_unref (AnjutaPkgScannerDir *dir)
+{
+	if (g_atomic_int_dec_and_test (&dir->ref_count))
+	{
+		g_strfreev (dir->directories);
+		g_strfreev (dir->files);
+		g_slice_free (AnjutaPkgScannerDir, dir);
+	}
+}
+
+static AnjutaPkgScannerDir *
+pkg_scanner_dir_new (gint64 mtime, gchar **directories, gchar **files)
 {
+	AnjutaPkgScannerDir *dir;
+
+	dir = g_slice_new (AnjutaPkgScannerDir);
+	dir->ref_count = 1;
+	dir->mtime = mtime;
+	dir->directories = directories;
+	dir->files = files;
+
+	return dir;
+}
+
+/* Must be called with the cache locked */
+static void
+pkg_scanner_cache_load (void)
+{
+	gchar *cache_path;
+	gchar *data;
+	gsize length;
+	GVariant *cache;
+	guint32 version;
+	GVariantIter *dir_iter;
+	const gchar *path;
+	gint64 mtime;
+	gchar **directories;
+	gchar **files;
+
+	pkg_scanner_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                           g_free, (GDestroyNotify)pkg_scanner_dir_unref);
+
+	cache_path = anjuta_util_get_user_cache_file_path (PKG_SCANNER_CACHE_FILE, NULL);
+	if (!g_file_get_contents (cache_path, &data, &length, NULL))
+	{
+		g_free (cache_path);
+		return;
+	}
+	g_free (cache_path);
+
+	cache = g_variant_new_from_data (G_VARIANT_TYPE (PKG_SCANNER_CACHE_FORMAT),
+	                                 data, length, FALSE,
+	                                 (GDestroyNotify)g_free, data);
+	g_variant_ref_sink (cache);
+
+	g_variant_get (cache, "(ua(sxasas))", &version, &dir_iter);
+	if (version == PKG_SCANNER_CACHE_VERSION)
+	{
+		while (g_variant_iter_next (dir_iter, "(&sx^as^as)",
+		                            &path, &mtime, &directories, &files))
+		{
+			g_hash_table_insert (pkg_scanner_cache, g_strdup (path),
+			                     pkg_scanner_dir_new (mtime, directories, files));
+		}
+	}
+	g_variant_iter_free (dir_iter);
+	g_variant_unref (cache);
+}
+
+static void
+pkg_scanner_cache_save (void)
+{
+	GVariantBuilder builder;
+	GVariant *cache = NULL;
+	GHashTableIter iter;
+	const gchar *path;
+	AnjutaPkgScannerDir *dir;
+	gchar *cache_path;
+
+	G_LOCK (pkg_scanner_cache);
+	if (pkg_scanner_cache_modified)
+	{
+		g_variant_builder_init (&builder, G_VARIANT_TYPE (PKG_SCANNER_CACHE_FORMAT));
+		g_variant_builder_add (&builder, "u", (guint32)PKG_SCANNER_CACHE_VERSION);
+		g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sxasas)"));
+		g_hash_table_iter_init (&iter, pkg_scanner_cache);
+		while (g_hash_table_iter_next (&iter, (gpointer *)&path, (gpointer *)&dir))
+		{
+			g_variant_builder_add (&builder, "(sx^as^as)",
+			                       path, dir->mtime, dir->directories, dir->files);
+		}
+		g_variant_builder_close (&builder);
+		cache = g_variant_ref_sink (g_variant_builder_end (&builder));
+		pkg_scanner_cache_modified = FALSE;
+	}
+	G_UNLOCK (pkg_scanner_cache);
+
+	if (cache == NULL) return;
+
+	cache_path = anjuta_util_get_user_cache_file_path (PKG_SCANNER_CACHE_FILE, NULL);
+	g_file_set_contents (cache_path,
+	                     g_variant_get_data (cache),
+	                     g_variant_get_size (cache),
+	                     NULL);
+	g_free (cache_path);
+	g_variant_unref (cache);
+}
+
+/* Batch of scanners
+ *
+ * All the scanners created before the previous ones have finished form a
+ * batch. Each scanner returns all the files of its package, the listings of
+ * directories shared with other packages come from the cache, which is
+ * written when the last scanner of the batch is done, run or not.
+ *---------------------------------------------------------------------------*/
+
+G_LOCK_DEFINE_STATIC (pkg_scanner_batch);
+static guint pkg_scanner_pending = 0;
+
+static void
+pkg_scanner_batch_enter (AnjutaPkgScanner *scanner)
+{
+	G_LOCK (pkg_scanner_batch);
+	pkg_scanner_pending++;
+	scanner->priv->pending = TRUE;
+	G_UNLOCK (pkg_scanner_batch);
+}
+
+/* Save the cache if it was the last scanner of the batch */
+static void
+pkg_scanner_batch_leave (AnjutaPkgScanner *scanner)
+{
+	gboolean last = FALSE;
+
+	G_LOCK (pkg_scanner_batch);
+	if (scanner->priv->pending)
+	{
+		scanner->priv->pending = FALSE;
+		pkg_scanner_pending--;
+		last = pkg_scanner_pending == 0;
+	}
+	G_UNLOCK (pkg_scanner_batch);
+
+	if (last)
+		pkg_scanner_cache_save ();
+}
+
+static void
+anjuta_pkg_scanner_init (AnjutaPkgScanner *object)
+{
+	object->priv = G_TYPE_INSTANCE_GET_PRIVATE (object,
+	                                            ANJUTA_TYPE_PKG_SCANNER,
+	                                            AnjutaPkgScannerPrivate);
+	object->priv->files = NULL;
+	pkg_scanner_batch_enter (object);
+}
+
+static void
+anjuta_pkg_scanner_finalize (GObject *object)
+{
+	AnjutaPkgScanner* scanner = ANJUTA_PKG_SCANNER (object);
+
+	/* Scanner destroyed without being run */
+	pkg_scanner_batch_leave (scanner);
+	g_free (scanner->priv->package);
+	g_free (scanner->priv->version);
+	anjuta_util_glist_strings_free (scanner->priv->files);
+	
+	G_OBJECT_CLASS (anjuta_pkg_scanner_parent_class)->finalize (object);
+}
+
+/* List a directory, the type of each file is read with its name */
+static AnjutaPkgScannerDir *
+pkg_scanner_dir_read (const gchar *path, gint64 mtime)
+{
+	GFile *dir;
 	GFileEnumerator *list;
-					
+	GPtrArray *directories;
+	GPtrArray *files;
+	GFileInfo *info;
+
+	dir = g_file_new_for_path (path);
 	list = g_file_enumerate_children (dir,
-	    G_FILE_ATTRIBUTE_STANDARD_NAME,
+	    G_FILE_ATTRIBUTE_STANDARD_NAME "," G_FILE_ATTRIBUTE_STANDARD_TYPE,
 	    G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
 	    NULL,
 	    NULL);
+	if (list == NULL)
+	{
+		g_object_unref (dir);
+		return NULL;
+	}
 
-	if (list != NULL)
+	directories = g_ptr_array_new ();
+	files = g_ptr_array_new ();
+	while ((info = g_file_enumerator_next_file (list, NULL, NULL)) != NULL)
 	{
-		GFileInfo *info;
-		
-		while ((info = g_file_enumerator_next_file (list, NULL, NULL)) != NULL)
+		const gchar *name;
+		GFileType type;
+
+		name = g_file_info_get_name (info);
+		type = g_file_info_get_file_type (info);
+		if (type == G_FILE_TYPE_SYMBOLIC_LINK)
 		{
-			const gchar *name;
-			GFile *file;
+			/* Follow links to directories */
+			GFile *file = g_file_get_child (dir, name);
 
-			name = g_file_info_get_name (info);
-			file = g_file_get_child (dir, name);
-			g_object_unref (info);
+			type = g_file_query_file_type (file, G_FILE_QUERY_INFO_NONE, NULL);
+			g_object_unref (file);
+		}
 
-			if (g_file_query_file_type (file, G_FILE_QUERY_INFO_NONE, NULL) == G_FILE_TYPE_DIRECTORY)
-			{
-				anjuta_pkg_scanner_list_files (children, file);
-			}
-			else
+		if (type == G_FILE_TYPE_DIRECTORY)
+			g_ptr_array_add (directories, g_strdup (name));
+		else
+			g_ptr_array_add (files, g_strdup (name));
+		g_object_unref (info);
+	}
+	g_file_enumerator_close (list, NULL, NULL);
+	g_object_unref (list);
+	g_object_unref (dir);
+
+	g_ptr_array_add (directories, NULL);
+	g_ptr_array_add (files, NULL);
+
+	return pkg_scanner_dir_new (mtime,
+	                            (gchar **)g_ptr_array_free (directories, FALSE),
+	                            (gchar **)g_ptr_array_free (files, FALSE));
+}
+
+/* Get the content of a directory from the cache if it has not changed */
+static AnjutaPkgScannerDir *
+pkg_scanner_get_dir (const gchar *path)
+{
+	GStatBuf st;
+	AnjutaPkgScannerDir *dir;
+
+	if ((g_stat (path, &st) != 0) || !S_ISDIR (st.st_mode))
+		return NULL;
+
+	G_LOCK (pkg_scanner_cache);
+	if (pkg_scanner_cache == NULL)
+		pkg_scanner_cache_load ();
+	dir = g_hash_table_lookup (pkg_scanner_cache, path);
+	if ((dir != NULL) && (dir->mtime == st.st_mtime))
+	{
+		pkg_scanner_dir_ref (dir);
+		G_UNLOCK (pkg_scanner_cache);
+
+		return dir;
+	}
+	G_UNLOCK (pkg_scanner_cache);
+
+	dir = pkg_scanner_dir_read (path, st.st_mtime);
+	if (dir != NULL)
+	{
+		G_LOCK (pkg_scanner_cache);
+		g_hash_table_replace (pkg_scanner_cache, g_strdup (path),
+		                      pkg_scanner_dir_ref (dir));
+		pkg_scanner_cache_modified = TRUE;
+		G_UNLOCK (pkg_scanner_cache);
+	}
+
+	return dir;
+}
+
+static void
+anjuta_pkg_scanner_list_files (GList **children, const gchar *path)
+{
+	AnjutaPkgScannerDir *dir;
+	gchar **name;
+
+	dir = pkg_scanner_get_dir (path);
+	if (dir == NULL) return;
+
+	for (name = dir->files; *name != NULL; name++)
+	{
+		*children = g_list_prepend (*children, g_build_filename (path, *name, NULL));
+	}
+	for (name = dir->directories; *name != NULL; name++)
+	{
+		gchar *child = g_build_filename (path, *name, NULL);
+
+		anjuta_pkg_scanner_list_files (children, child);
+		g_free (child);
+	}
+	pkg_scanner_dir_unref (dir);
+}
+
+/* Remove duplicated directories and directories included in another one,
+ * they would be scanned twice */
+static GList *
+anjuta_pkg_scanner_remove_nested (GList *dirs)
+{
+	GList *kept = NULL;
+	GList *node;
+
+	dirs = g_list_sort (dirs, (GCompareFunc)strcmp);
+	for (node = dirs; node != NULL; node = g_list_next (node))
+	{
+		const gchar *path = (const gchar *)node->data;
+		gboolean nested = FALSE;
+		GList *top;
+
+		for (top = kept; top != NULL; top = g_list_next (top))
+		{
+			gsize len = strlen (top->data);
+
+			if ((strncmp (path, top->data, len) == 0) &&
+			    ((path[len] == '\0') || (path[len] == G_DIR_SEPARATOR)))
 			{
-				gchar* filename = g_file_get_path (file);
-				*children = g_list_prepend (*children, filename);
+				nested = TRUE;
+				break;
 			}
-			g_object_unref (file);
 		}
-		g_file_enumerator_close (list, NULL, NULL);
-		g_object_unref (list);
+		if (nested)
+			g_free (node->data);
+		else
+			kept = g_list_prepend (kept, node->data);
 	}
+	g_list_free (dirs);
+
+	return g_list_reverse (kept);
+}
+
+typedef struct
+{
+	gchar *path;
+	GList *files;
+} AnjutaPkgScannerTree;
+
+static void
+anjuta_pkg_scanner_list_tree (AnjutaPkgScannerTree *tree, gpointer user_data)
+{
+	anjuta_pkg_scanner_list_files (&tree->files, tree->path);
 }
 
 static guint
@@ -162,14 +481,41 @@ anjuta_pkg_scanner_run (AnjutaCommand* command)
 {
 	AnjutaPkgScanner* scanner = ANJUTA_PKG_SCANNER (command);
 	GList* dirs = anjuta_pkg_config_get_directories (scanner->priv->package, TRUE, NULL);
+	AnjutaPkgScannerTree *trees;
+	GThreadPool *pool = NULL;
 	GList* dir;
-	
-	for (dir = dirs; dir != NULL; dir = g_list_next (dir))
+	guint count;
+	guint i;
+
+	dirs = anjuta_pkg_scanner_remove_nested (dirs);
+	count = g_list_length (dirs);
+	trees = g_new0 (AnjutaPkgScannerTree, count);
+
+	/* Scan independent directory trees in parallel */
+	if (count > 1)
+	{
+		pool = g_thread_pool_new ((GFunc)anjuta_pkg_scanner_list_tree, NULL,
+		                          MIN (count, PKG_SCANNER_MAX_THREADS), FALSE, NULL);
+	}
+	for (dir = dirs, i = 0; dir != NULL; dir = g_list_next (dir), i++)
 	{
-		GFile* file = g_file_new_for_path (dir->data);
-		anjuta_pkg_scanner_list_files (&scanner->priv->files, file);
+		trees[i].path = (gchar *)dir->data;
+		if ((pool == NULL) || !g_thread_pool_push (pool, &trees[i], NULL))
+			anjuta_pkg_scanner_list_tree (&trees[i], NULL);
 	}
+	if (pool != NULL)
+		g_thread_pool_free (pool, FALSE, TRUE);
+
+	/* Keep files in the order of the directories */
+	for (i = count; i > 0; i--)
+	{
+		scanner->priv->files = g_list_concat (trees[i - 1].files, scanner->priv->files);
+	}
+	g_free (trees);
 	anjuta_util_glist_strings_free (dirs);
+
+	pkg_scanner_batch_leave (scanner);
+
 	return 0;
 }
 
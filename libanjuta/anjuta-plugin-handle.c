@@ -468,26 +468,44 @@ property_to_list (const char *value)
 
 AnjutaPluginHandle*
 anjuta_plugin_handle_new (const gchar *plugin_desc_path)
+{
+	AnjutaPluginHandle *plugin_handle;
+	gchar *contents = NULL;
+	
+	/* Load file content */
+	if (!g_file_get_contents (plugin_desc_path, &contents, NULL, NULL))
+		return NULL;
+
+	plugin_handle = anjuta_plugin_handle_new_from_contents (plugin_desc_path,
+															contents);
+	g_free (contents);
+
+	return plugin_handle;
+}
+
+/**
+ * anjuta_plugin_handle_new_from_contents:
+ * @plugin_desc_path: path of the plugin description file
+ * @contents: content of the plugin description file
+ *
+ * Creates a plugin handle from the content of a plugin description file
+ * already read, by example from a cache.
+ *
+ * Return value: a new plugin handle or %NULL if the description is invalid
+ */
+AnjutaPluginHandle*
+anjuta_plugin_handle_new_from_contents (const gchar *plugin_desc_path,
+										const gchar *contents)
 {
 	AnjutaPluginHandle *plugin_handle;
 	AnjutaPluginDescription *desc;
 	char *str;
 	gboolean enable;
-	gchar *contents = NULL;
 	gboolean success = TRUE;
-	
-	/* Load file content */
-	if (g_file_get_contents (plugin_desc_path, &contents, NULL, NULL)) {
-		
-		desc = anjuta_plugin_description_new_from_string (contents, NULL);
-		g_free (contents);
-		if (!desc) {
-			g_warning ("Bad plugin file: %s\n", plugin_desc_path);
-			return NULL;
-		}
-	}
-	else
-	{
+
+	desc = anjuta_plugin_description_new_from_string ((gchar *)contents, NULL);
+	if (!desc) {
+		g_warning ("Bad plugin file: %s\n", plugin_desc_path);
 		return NULL;
 	}
 	
@@ -50,6 +50,8 @@ struct _AnjutaPluginHandle
 
 GType anjuta_plugin_handle_get_type (void) G_GNUC_CONST;
 AnjutaPluginHandle* anjuta_plugin_handle_new (const gchar *plugin_desc_path);
+AnjutaPluginHandle* anjuta_plugin_handle_new_from_contents (const gchar *plugin_desc_path,
+															const gchar *contents);
 const char* anjuta_plugin_handle_get_id (AnjutaPluginHandle *plugin_handle);
 const char* anjuta_plugin_handle_get_name (AnjutaPluginHandle *plugin_handle);
 const char* anjuta_plugin_handle_get_about (AnjutaPluginHandle *plugin_handle);
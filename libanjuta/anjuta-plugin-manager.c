@@ -31,8 +31,6 @@
 #  include <config.h>
 #endif
 
-#include <sys/types.h>
-#include <dirent.h>
 #include <string.h>
 
 #include <libanjuta/anjuta-plugin-manager.h>
@@ -41,9 +39,14 @@
 #include <libanjuta/anjuta-plugin-handle.h>
 #include <libanjuta/anjuta-plugin.h>
 #include <libanjuta/anjuta-c-plugin-factory.h>
+#include <libanjuta/anjuta-utils.h>
 #include <libanjuta/interfaces/ianjuta-plugin-factory.h>
 #include <libanjuta/interfaces/ianjuta-preferences.h>
 
+#include "anjuta-plugin-registry.h"
+
+#define PLUGIN_REGISTRY_CACHE "plugins.cache"
+
 
 enum
 {
@@ -79,6 +82,12 @@ struct _AnjutaPluginManagerPriv
 	GHashTable   *plugins_by_interfaces;
 	GHashTable   *plugins_by_name;
 	GHashTable   *plugins_by_description;
+
+	/* Indexes of plugin attributes => list of plugin handles. Exact values
+	 * are indexed by section, key and lower case value, values containing
+	 * a star are kept by section and key */
+	GHashTable   *plugins_by_attribute;
+	GHashTable   *plugins_by_pattern;
 	
 	/* Plugins that are currently activated */
 	GHashTable   *activated_plugins;
@@ -358,35 +367,130 @@ resolve_dependencies (AnjutaPluginManager *plugin_manager, GList **cycles)
 
 /* Plugins loading */
 
-static gboolean
-str_has_suffix (const char *haystack, const char *needle)
+typedef struct _AnjutaPluginPattern AnjutaPluginPattern;
+
+struct _AnjutaPluginPattern
 {
-	const char *h, *n;
+	gchar *pattern;
+	AnjutaPluginHandle *plugin;
+};
 
-	if (needle == NULL) {
-		return TRUE;
+static void
+anjuta_plugin_pattern_free (AnjutaPluginPattern *pattern)
+{
+	g_free (pattern->pattern);
+	g_slice_free (AnjutaPluginPattern, pattern);
+}
+
+static void
+anjuta_plugin_pattern_list_free (GList *list)
+{
+	g_list_foreach (list, (GFunc)anjuta_plugin_pattern_free, NULL);
+	g_list_free (list);
+}
+
+static gchar *
+attribute_key (const gchar *section, const gchar *name, const gchar *value)
+{
+	if (value == NULL)
+	{
+		return g_strconcat (section, "\n", name, NULL);
 	}
-	if (haystack == NULL) {
-		return needle[0] == '\0';
+	else
+	{
+		gchar *lower = g_ascii_strdown (value, -1);
+		gchar *key = g_strconcat (section, "\n", name, "\n", lower, NULL);
+
+		g_free (lower);
+		return key;
 	}
-		
-	/* Eat one character at a time. */
-	h = haystack + strlen(haystack);
-	n = needle + strlen(needle);
-	do {
-		if (n == needle) {
-			return TRUE;
+}
+
+/* Match a value containing '*' wild cards */
+static gboolean
+attribute_pattern_match (const gchar *pattern, const gchar *value)
+{
+	gchar **segments;
+	gchar **seg_ptr;
+	const gchar *cursor;
+
+	segments = g_strsplit (pattern, "*", -1);
+
+	seg_ptr = segments;
+	cursor = value;
+	while (*seg_ptr != NULL)
+	{
+		if (strlen (*seg_ptr) > 0) {
+			cursor = strstr (cursor, *seg_ptr);
+			if (cursor == NULL)
+				break;
 		}
-		if (h == haystack) {
-			return FALSE;
+		cursor += strlen (*seg_ptr);
+		seg_ptr++;
+	}
+	g_strfreev (segments);
+
+	return cursor != NULL;
+}
+
+/* Add @data to the list associated with @key, @key is owned by the index */
+static void
+index_add (GHashTable *index, gchar *key, gpointer data)
+{
+	GList *list;
+
+	list = g_hash_table_lookup (index, key);
+	if (list == NULL)
+	{
+		g_hash_table_insert (index, key, g_list_prepend (NULL, data));
+	}
+	else
+	{
+		/* Insert after the first element to keep the same list head */
+		list = g_list_insert (list, data, 1);
+		g_free (key);
+	}
+}
+
+static void
+index_plugin_attributes (AnjutaPluginManager *plugin_manager,
+						 AnjutaPluginHandle *plugin_handle,
+						 GPtrArray *attributes)
+{
+	AnjutaPluginManagerPriv *priv = plugin_manager->priv;
+	guint i;
+
+	for (i = 0; i < attributes->len; i++)
+	{
+		AnjutaPluginAttribute *attr = g_ptr_array_index (attributes, i);
+		gchar **value;
+
+		for (value = attr->values; *value != NULL; value++)
+		{
+			if (strchr (*value, '*') != NULL)
+			{
+				AnjutaPluginPattern *pattern;
+
+				pattern = g_slice_new (AnjutaPluginPattern);
+				pattern->pattern = g_strdup (*value);
+				pattern->plugin = plugin_handle;
+				index_add (priv->plugins_by_pattern,
+						   attribute_key (attr->section, attr->key, NULL),
+						   pattern);
+			}
+			else
+			{
+				index_add (priv->plugins_by_attribute,
+						   attribute_key (attr->section, attr->key, *value),
+						   plugin_handle);
+			}
 		}
-	} while (*--h == *--n);
-	return FALSE;
+	}
 }
 
 static void
 load_plugin (AnjutaPluginManager *plugin_manager,
-			 const gchar *plugin_desc_path)
+			 AnjutaPluginRegistryEntry *plugin_entry)
 {
 	AnjutaPluginManagerPriv *priv;
 	AnjutaPluginHandle *plugin_handle;
@@ -394,7 +498,8 @@ load_plugin (AnjutaPluginManager *plugin_manager,
 	g_return_if_fail (ANJUTA_IS_PLUGIN_MANAGER (plugin_manager));
 	priv = plugin_manager->priv;
 	
-	plugin_handle = anjuta_plugin_handle_new (plugin_desc_path);
+	plugin_handle = anjuta_plugin_handle_new_from_contents (plugin_entry->path,
+															plugin_entry->contents);
 	if (plugin_handle)
 	{
 		if (g_hash_table_lookup (priv->plugins_by_name,
@@ -417,6 +522,10 @@ load_plugin (AnjutaPluginManager *plugin_manager,
 			g_hash_table_insert (priv->plugins_by_description,
 								 anjuta_plugin_handle_get_description (plugin_handle),
 								 plugin_handle);
+
+			/* Index by attributes values */
+			index_plugin_attributes (plugin_manager, plugin_handle,
+									 plugin_entry->attributes);
 			
 			/* Index by interfaces exported by this plugin */
 			node = anjuta_plugin_handle_get_interfaces (plugin_handle);
@@ -456,29 +565,19 @@ load_plugin (AnjutaPluginManager *plugin_manager,
 
 static void
 load_plugins_from_directory (AnjutaPluginManager* plugin_manager,
+							 AnjutaPluginRegistry *registry,
 							 const gchar *dirname)
 {
-	DIR *dir;
-	struct dirent *entry;
-	
-	dir = opendir (dirname);
-	
-	if (!dir)
+	GList *entries;
+	GList *node;
+
+	/* The registry reads only new or modified plugin files */
+	entries = anjuta_plugin_registry_get_directory (registry, dirname);
+	for (node = entries; node != NULL; node = g_list_next (node))
 	{
-		return;
+		load_plugin (plugin_manager, (AnjutaPluginRegistryEntry *)node->data);
 	}
-	
-	for (entry = readdir (dir); entry != NULL; entry = readdir (dir))
-	{
-		if (str_has_suffix (entry->d_name, ".plugin"))
-		{
-			gchar *pathname;
-			pathname = g_strdup_printf ("%s/%s", dirname, entry->d_name);
-			load_plugin (plugin_manager,pathname);
-			g_free (pathname);
-		}
-	}
-	closedir (dir);
+	g_list_free (entries);
 }
 
 /* Plugin activation and deactivation */
@@ -1684,6 +1783,7 @@ anjuta_plugin_manager_list_query (AnjutaPluginManager *plugin_manager,
 	const gchar *aname;
 	const gchar *avalue;
 	GList *available;
+	GHashTable *candidates = NULL;
 	
 	g_return_val_if_fail (ANJUTA_IS_PLUGIN_MANAGER (plugin_manager), NULL);
 	
@@ -1707,95 +1807,63 @@ anjuta_plugin_manager_list_query (AnjutaPluginManager *plugin_manager,
 	g_return_val_if_fail (secs != NULL, NULL);
 	g_return_val_if_fail (anames != NULL, NULL);
 	g_return_val_if_fail (avalues != NULL, NULL);
-	
-	while (available)
+
+	/* Intersect the set of plugins matching each attribute */
+	for (; secs != NULL; secs = g_list_next (secs))
 	{
-		GList* s_node = secs;
-		GList* n_node = anames;
-		GList* v_node = avalues;
-		
-		gboolean satisfied = FALSE;
-		
-		AnjutaPluginHandle *plugin = available->data;
-		AnjutaPluginDescription *desc =
-			anjuta_plugin_handle_get_description (plugin);
-		
-		while (s_node)
+		GHashTable *matches;
+		gchar *key;
+		GList *node;
+
+		sec = secs->data;
+		aname = anames->data;
+		avalue = avalues->data;
+
+		matches = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+		key = attribute_key (sec, aname, avalue);
+		for (node = g_hash_table_lookup (priv->plugins_by_attribute, key);
+			 node != NULL; node = g_list_next (node))
 		{
-			gchar *val;
-			GList *vals;
-			GList *node;
-			gboolean found = FALSE;
-			
-			satisfied = TRUE;
-			
-			sec = s_node->data;
-			aname = n_node->data;
-			avalue = v_node->data;
-			
-			if (!anjuta_plugin_description_get_string (desc, sec, aname, &val))
-			{
-				satisfied = FALSE;
-				break;
-			}
-			
-			vals = property_to_list (val);
-			g_free (val);
-			
-			node = vals;
-			while (node)
-			{
-				if (strchr(node->data, '*') != NULL)
-				{
-					// Star match.
-					gchar **segments;
-					gchar **seg_ptr;
-					const gchar *cursor;
-					
-					segments = g_strsplit (node->data, "*", -1);
-					
-					seg_ptr = segments;
-					cursor = avalue;
-					while (*seg_ptr != NULL)
-					{
-						if (strlen (*seg_ptr) > 0) {
-							cursor = strstr (cursor, *seg_ptr);
-							if (cursor == NULL)
-								break;
-						}
-						cursor += strlen (*seg_ptr);
-						seg_ptr++;
-					}
-					if (*seg_ptr == NULL)
-						found = TRUE;
-					g_strfreev (segments);
-				}
-				else if (g_ascii_strcasecmp (node->data, avalue) == 0)
-				{
-					// String match.
-					found = TRUE;
-				}
-				g_free (node->data);
-				node = g_list_next (node);
-			}
-			g_list_free (vals);
-			if (!found)
-			{
-				satisfied = FALSE;
-				break;
-			}
-			s_node = g_list_next (s_node);
-			n_node = g_list_next (n_node);
-			v_node = g_list_next (v_node);
+			if ((candidates == NULL) || g_hash_table_lookup (candidates, node->data))
+				g_hash_table_insert (matches, node->data, node->data);
 		}
-		if (satisfied)
+		g_free (key);
+
+		key = attribute_key (sec, aname, NULL);
+		for (node = g_hash_table_lookup (priv->plugins_by_pattern, key);
+			 node != NULL; node = g_list_next (node))
 		{
-			selected_plugins = g_list_prepend (selected_plugins, desc);
-			/* DEBUG_PRINT ("Satisfied, Adding %s",
-						 anjuta_plugin_handle_get_name (plugin));*/
+			AnjutaPluginPattern *pattern = (AnjutaPluginPattern *)node->data;
+
+			if (((candidates == NULL) || g_hash_table_lookup (candidates, pattern->plugin))
+				&& attribute_pattern_match (pattern->pattern, avalue))
+				g_hash_table_insert (matches, pattern->plugin, pattern->plugin);
 		}
-		available = g_list_next (available);
+		g_free (key);
+
+		if (candidates != NULL)
+			g_hash_table_destroy (candidates);
+		candidates = matches;
+		if (g_hash_table_size (candidates) == 0)
+			break;
+
+		anames = g_list_next (anames);
+		avalues = g_list_next (avalues);
 	}
+
+	/* Keep the order of available plugins */
+	for (; available != NULL; available = g_list_next (available))
+	{
+		AnjutaPluginHandle *plugin = available->data;
+
+		if (g_hash_table_lookup (candidates, plugin))
+		{
+			selected_plugins = g_list_prepend (selected_plugins,
+											   anjuta_plugin_handle_get_description (plugin));
+		}
+	}
+	g_hash_table_destroy (candidates);
 	
 	return g_list_reverse (selected_plugins);
 }
@@ -2212,6 +2280,14 @@ anjuta_plugin_manager_init (AnjutaPluginManager *object)
 											   (GDestroyNotify) g_list_free);
 	object->priv->plugins_by_description = g_hash_table_new (g_direct_hash,
 														   g_direct_equal);
+	object->priv->plugins_by_attribute = g_hash_table_new_full (g_str_hash,
+																g_str_equal,
+																g_free,
+																(GDestroyNotify) g_list_free);
+	object->priv->plugins_by_pattern = g_hash_table_new_full (g_str_hash,
+															  g_str_equal,
+															  g_free,
+															  (GDestroyNotify) anjuta_plugin_pattern_list_free);
 	object->priv->activated_plugins = g_hash_table_new (g_direct_hash,
 													  g_direct_equal);
 	object->priv->plugins_cache = g_hash_table_new (g_direct_hash,
@@ -2258,6 +2334,16 @@ anjuta_plugin_manager_finalize (GObject *object)
 		g_hash_table_destroy (priv->plugins_by_interfaces);
 		priv->plugins_by_interfaces = NULL;
 	}
+	if (priv->plugins_by_attribute)
+	{
+		g_hash_table_destroy (priv->plugins_by_attribute);
+		priv->plugins_by_attribute = NULL;
+	}
+	if (priv->plugins_by_pattern)
+	{
+		g_hash_table_destroy (priv->plugins_by_pattern);
+		priv->plugins_by_pattern = NULL;
+	}
 	if (priv->plugin_dirs)
 	{
 		g_list_foreach (priv->plugin_dirs, (GFunc)g_free, NULL);
@@ -2455,6 +2541,8 @@ anjuta_plugin_manager_new (GObject *shell, AnjutaStatus *status,
 	char **p;
 	GList *node;
 	GList *plugin_dirs = NULL;
+	AnjutaPluginRegistry *registry;
+	gchar *cache_path;
 
 	/* Initialize the anjuta plugin system */
 	manager_object = g_object_new (ANJUTA_TYPE_PLUGIN_MANAGER,
@@ -2488,12 +2576,21 @@ anjuta_plugin_manager_new (GObject *shell, AnjutaStatus *status,
 	plugin_dirs = g_list_reverse (plugin_dirs);
 	/* load_plugins (); */
 
+	/* Plugin descriptions are cached between sessions */
+	cache_path = anjuta_util_get_user_cache_file_path (PLUGIN_REGISTRY_CACHE, NULL);
+	registry = anjuta_plugin_registry_new (cache_path);
+	g_free (cache_path);
+
 	node = plugin_dirs;
 	while (node)
 	{
-		load_plugins_from_directory (plugin_manager, (char*)node->data);
+		load_plugins_from_directory (plugin_manager, registry, (char*)node->data);
 		node = g_list_next (node);
 	}
+	if (!anjuta_plugin_registry_save (registry))
+		g_warning ("Unable to save the plugin registry cache");
+	anjuta_plugin_registry_free (registry);
+
 	resolve_dependencies (plugin_manager, &cycles);
 	g_list_foreach(plugin_dirs, (GFunc) g_free, NULL);
 	g_list_free(plugin_dirs);
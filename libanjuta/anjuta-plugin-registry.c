@@ -0,0 +1,485 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-plugin-registry.c
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * The plugin registry keeps the content of all .plugin files found in the
+ * plugin directories in a binary cache file. An entry is reused as long as
+ * the modification time and the size of its file are unchanged and the list
+ * of files of a directory is read only when the directory has changed.
+ * Each entry keeps all non localized attributes of the description already
+ * split so the plugin manager can index them without parsing them again.
+ */
+
+#include <string.h>
+
+#include <glib/gstdio.h>
+
+#include <libanjuta/anjuta-plugin-description.h>
+#include <libanjuta/anjuta-debug.h>
+
+#include "anjuta-plugin-registry.h"
+
+/* Increment it when the format of the cache changes */
+#define REGISTRY_VERSION	1
+
+/* version, directories (name, mtime, plugins (path, mtime, size, contents,
+ * attributes (section, key, values))) */
+#define REGISTRY_FORMAT		"(ua(sxa(sxxaya(ssas))))"
+
+typedef struct _AnjutaPluginRegistryDir AnjutaPluginRegistryDir;
+
+struct _AnjutaPluginRegistryDir
+{
+	gint64 mtime;
+	GHashTable *entries;	/* basename -> AnjutaPluginRegistryEntry */
+};
+
+struct _AnjutaPluginRegistry
+{
+	gchar *cache_path;
+	GHashTable *directories;	/* dirname -> AnjutaPluginRegistryDir */
+	gboolean modified;
+};
+
+static void
+attribute_free (AnjutaPluginAttribute *attr)
+{
+	g_free (attr->section);
+	g_free (attr->key);
+	g_strfreev (attr->values);
+	g_slice_free (AnjutaPluginAttribute, attr);
+}
+
+static AnjutaPluginRegistryEntry *
+entry_new (const gchar *path)
+{
+	AnjutaPluginRegistryEntry *entry;
+
+	entry = g_slice_new0 (AnjutaPluginRegistryEntry);
+	entry->path = g_strdup (path);
+	entry->attributes = g_ptr_array_new_with_free_func ((GDestroyNotify)attribute_free);
+
+	return entry;
+}
+
+static void
+entry_free (AnjutaPluginRegistryEntry *entry)
+{
+	g_free (entry->path);
+	g_free (entry->contents);
+	g_ptr_array_free (entry->attributes, TRUE);
+	g_slice_free (AnjutaPluginRegistryEntry, entry);
+}
+
+static AnjutaPluginRegistryDir *
+dir_new (void)
+{
+	AnjutaPluginRegistryDir *dir;
+
+	dir = g_slice_new0 (AnjutaPluginRegistryDir);
+	dir->mtime = -1;
+	dir->entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+										  g_free, (GDestroyNotify)entry_free);
+
+	return dir;
+}
+
+static void
+dir_free (AnjutaPluginRegistryDir *dir)
+{
+	g_hash_table_destroy (dir->entries);
+	g_slice_free (AnjutaPluginRegistryDir, dir);
+}
+
+/* Split attributes
+ *---------------------------------------------------------------------------*/
+
+typedef struct
+{
+	AnjutaPluginRegistryEntry *entry;
+	const gchar *section;
+} SplitData;
+
+static gchar **
+split_property (const gchar *value)
+{
+	gchar **values;
+	gchar **p;
+
+	values = g_strsplit (value, ",", -1);
+	for (p = values; *p != NULL; p++)
+		g_strstrip (*p);
+
+	return values;
+}
+
+static void
+on_split_key (AnjutaPluginDescription *desc, const gchar *key,
+			  const gchar *locale, const gchar *value, gpointer user_data)
+{
+	SplitData *data = (SplitData *)user_data;
+	AnjutaPluginAttribute *attr;
+	gchar *str;
+
+	/* Skip comments and translations */
+	if ((key == NULL) || (locale != NULL))
+		return;
+
+	if (!anjuta_plugin_description_get_string (desc, data->section, key, &str))
+		return;
+
+	attr = g_slice_new (AnjutaPluginAttribute);
+	attr->section = g_strdup (data->section);
+	attr->key = g_strdup (key);
+	attr->values = split_property (str);
+	g_free (str);
+
+	g_ptr_array_add (data->entry->attributes, attr);
+}
+
+static void
+on_split_section (AnjutaPluginDescription *desc, const gchar *name,
+				  gpointer user_data)
+{
+	SplitData *data = (SplitData *)user_data;
+
+	if (name == NULL)
+		return;
+
+	data->section = name;
+	anjuta_plugin_description_foreach_key (desc, name, FALSE,
+										   on_split_key, data);
+}
+
+static gboolean
+entry_read (AnjutaPluginRegistryEntry *entry, GStatBuf *st)
+{
+	AnjutaPluginDescription *desc;
+	SplitData data;
+
+	g_free (entry->contents);
+	entry->contents = NULL;
+	g_ptr_array_set_size (entry->attributes, 0);
+
+	if (!g_file_get_contents (entry->path, &entry->contents, NULL, NULL))
+		return FALSE;
+
+	entry->mtime = st->st_mtime;
+	entry->size = st->st_size;
+
+	/* An invalid description is kept, it is reported when loaded */
+	desc = anjuta_plugin_description_new_from_string (entry->contents, NULL);
+	if (desc != NULL)
+	{
+		data.entry = entry;
+		data.section = NULL;
+		anjuta_plugin_description_foreach_section (desc, on_split_section, &data);
+		anjuta_plugin_description_free (desc);
+	}
+
+	return TRUE;
+}
+
+/* Cache file
+ *---------------------------------------------------------------------------*/
+
+static void
+registry_load (AnjutaPluginRegistry *registry)
+{
+	gchar *data;
+	gsize length;
+	GVariant *cache;
+	GVariantIter *dir_iter;
+	guint32 version;
+	const gchar *dirname;
+	gint64 dir_mtime;
+	GVariantIter *entry_iter;
+
+	if (!g_file_get_contents (registry->cache_path, &data, &length, NULL))
+		return;
+
+	cache = g_variant_new_from_data (G_VARIANT_TYPE (REGISTRY_FORMAT),
+									 data, length, FALSE,
+									 (GDestroyNotify)g_free, data);
+	g_variant_ref_sink (cache);
+
+	g_variant_get (cache, "(ua(sxa(sxxaya(ssas))))", &version, &dir_iter);
+	if (version != REGISTRY_VERSION)
+	{
+		g_variant_iter_free (dir_iter);
+		g_variant_unref (cache);
+		return;
+	}
+
+	while (g_variant_iter_next (dir_iter, "(&sxa(sxxaya(ssas)))",
+								&dirname, &dir_mtime, &entry_iter))
+	{
+		AnjutaPluginRegistryDir *dir;
+		const gchar *path;
+		gint64 mtime;
+		gint64 size;
+		const gchar *contents;
+		GVariantIter *attr_iter;
+
+		dir = dir_new ();
+		dir->mtime = dir_mtime;
+		g_hash_table_insert (registry->directories, g_strdup (dirname), dir);
+
+		while (g_variant_iter_next (entry_iter, "(&sxx^&aya(ssas))",
+									&path, &mtime, &size, &contents, &attr_iter))
+		{
+			AnjutaPluginRegistryEntry *entry;
+			const gchar *section;
+			const gchar *key;
+			gchar **values;
+
+			entry = entry_new (path);
+			entry->mtime = mtime;
+			entry->size = size;
+			entry->contents = g_strdup (contents);
+			while (g_variant_iter_next (attr_iter, "(&s&s^as)",
+										&section, &key, &values))
+			{
+				AnjutaPluginAttribute *attr;
+
+				attr = g_slice_new (AnjutaPluginAttribute);
+				attr->section = g_strdup (section);
+				attr->key = g_strdup (key);
+				attr->values = values;
+				g_ptr_array_add (entry->attributes, attr);
+			}
+			g_variant_iter_free (attr_iter);
+
+			g_hash_table_insert (dir->entries, g_path_get_basename (path), entry);
+		}
+		g_variant_iter_free (entry_iter);
+	}
+	g_variant_iter_free (dir_iter);
+	g_variant_unref (cache);
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+AnjutaPluginRegistry *
+anjuta_plugin_registry_new (const gchar *cache_path)
+{
+	AnjutaPluginRegistry *registry;
+
+	registry = g_new0 (AnjutaPluginRegistry, 1);
+	registry->cache_path = g_strdup (cache_path);
+	registry->directories = g_hash_table_new_full (g_str_hash, g_str_equal,
+												   g_free, (GDestroyNotify)dir_free);
+	if (cache_path != NULL)
+		registry_load (registry);
+
+	return registry;
+}
+
+void
+anjuta_plugin_registry_free (AnjutaPluginRegistry *registry)
+{
+	g_hash_table_destroy (registry->directories);
+	g_free (registry->cache_path);
+	g_free (registry);
+}
+
+static gint
+compare_entry (gconstpointer a, gconstpointer b)
+{
+	return strcmp (((const AnjutaPluginRegistryEntry *)a)->path,
+				   ((const AnjutaPluginRegistryEntry *)b)->path);
+}
+
+/*
+ * Returns the list of all valid plugin entries in @dirname. The directory
+ * is read only if it has changed since the last time and each file is read
+ * only if it has changed. The entries are owned by the registry.
+ */
+GList *
+anjuta_plugin_registry_get_directory (AnjutaPluginRegistry *registry,
+									  const gchar *dirname)
+{
+	AnjutaPluginRegistryDir *dir;
+	GStatBuf st;
+	GList *names = NULL;
+	GList *entries = NULL;
+	GList *node;
+
+	if (g_stat (dirname, &st) != 0)
+	{
+		if (g_hash_table_remove (registry->directories, dirname))
+			registry->modified = TRUE;
+		return NULL;
+	}
+
+	dir = g_hash_table_lookup (registry->directories, dirname);
+	if (dir == NULL)
+	{
+		dir = dir_new ();
+		g_hash_table_insert (registry->directories, g_strdup (dirname), dir);
+	}
+
+	if (dir->mtime != st.st_mtime)
+	{
+		GDir *gdir;
+		const gchar *name;
+		GHashTable *new_entries;
+
+		/* The list of files has changed, read it again */
+		gdir = g_dir_open (dirname, 0, NULL);
+		if (gdir == NULL)
+			return NULL;
+
+		new_entries = g_hash_table_new_full (g_str_hash, g_str_equal,
+											 g_free, (GDestroyNotify)entry_free);
+		while ((name = g_dir_read_name (gdir)) != NULL)
+		{
+			AnjutaPluginRegistryEntry *entry;
+			gchar *key;
+
+			if (!g_str_has_suffix (name, ".plugin"))
+				continue;
+
+			/* Move still existing entries in the new table */
+			if (g_hash_table_lookup_extended (dir->entries, name,
+											  (gpointer *)&key,
+											  (gpointer *)&entry))
+			{
+				g_hash_table_steal (dir->entries, name);
+			}
+			else
+			{
+				gchar *path = g_build_filename (dirname, name, NULL);
+
+				key = g_strdup (name);
+				entry = entry_new (path);
+				entry->mtime = -1;
+				g_free (path);
+			}
+			g_hash_table_insert (new_entries, key, entry);
+		}
+		g_dir_close (gdir);
+
+		g_hash_table_destroy (dir->entries);
+		dir->entries = new_entries;
+		dir->mtime = st.st_mtime;
+		registry->modified = TRUE;
+	}
+
+	/* Check each file */
+	names = g_hash_table_get_keys (dir->entries);
+	for (node = names; node != NULL; node = g_list_next (node))
+	{
+		AnjutaPluginRegistryEntry *entry;
+
+		entry = g_hash_table_lookup (dir->entries, node->data);
+		if (g_stat (entry->path, &st) != 0)
+		{
+			g_hash_table_remove (dir->entries, node->data);
+			registry->modified = TRUE;
+			continue;
+		}
+		if ((entry->mtime != st.st_mtime) || (entry->size != st.st_size))
+		{
+			DEBUG_PRINT ("Reading plugin file %s", entry->path);
+			registry->modified = TRUE;
+			if (!entry_read (entry, &st))
+			{
+				g_hash_table_remove (dir->entries, node->data);
+				continue;
+			}
+		}
+		entries = g_list_prepend (entries, entry);
+	}
+	g_list_free (names);
+
+	return g_list_sort (entries, compare_entry);
+}
+
+static void
+add_directory_variant (gpointer key, gpointer value, gpointer user_data)
+{
+	const gchar *dirname = (const gchar *)key;
+	AnjutaPluginRegistryDir *dir = (AnjutaPluginRegistryDir *)value;
+	GVariantBuilder *builder = (GVariantBuilder *)user_data;
+	GHashTableIter iter;
+	AnjutaPluginRegistryEntry *entry;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("(sxa(sxxaya(ssas)))"));
+	g_variant_builder_add (builder, "s", dirname);
+	g_variant_builder_add (builder, "x", dir->mtime);
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("a(sxxaya(ssas))"));
+	g_hash_table_iter_init (&iter, dir->entries);
+	while (g_hash_table_iter_next (&iter, NULL, (gpointer *)&entry))
+	{
+		guint i;
+
+		/* Entries not read yet */
+		if (entry->contents == NULL)
+			continue;
+
+		g_variant_builder_open (builder, G_VARIANT_TYPE ("(sxxaya(ssas))"));
+		g_variant_builder_add (builder, "s", entry->path);
+		g_variant_builder_add (builder, "x", entry->mtime);
+		g_variant_builder_add (builder, "x", entry->size);
+		g_variant_builder_add (builder, "^ay", entry->contents);
+		g_variant_builder_open (builder, G_VARIANT_TYPE ("a(ssas)"));
+		for (i = 0; i < entry->attributes->len; i++)
+		{
+			AnjutaPluginAttribute *attr = g_ptr_array_index (entry->attributes, i);
+
+			g_variant_builder_add (builder, "(ss^as)",
+								   attr->section, attr->key, attr->values);
+		}
+		g_variant_builder_close (builder);
+		g_variant_builder_close (builder);
+	}
+	g_variant_builder_close (builder);
+	g_variant_builder_close (builder);
+}
+
+/* Write the cache file if something has changed */
+gboolean
+anjuta_plugin_registry_save (AnjutaPluginRegistry *registry)
+{
+	GVariantBuilder builder;
+	GVariant *cache;
+	gboolean ok;
+
+	if (!registry->modified || (registry->cache_path == NULL))
+		return TRUE;
+
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (REGISTRY_FORMAT));
+	g_variant_builder_add (&builder, "u", (guint32)REGISTRY_VERSION);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sxa(sxxaya(ssas)))"));
+	g_hash_table_foreach (registry->directories, add_directory_variant, &builder);
+	g_variant_builder_close (&builder);
+	cache = g_variant_ref_sink (g_variant_builder_end (&builder));
+
+	ok = g_file_set_contents (registry->cache_path,
+							  g_variant_get_data (cache),
+							  g_variant_get_size (cache),
+							  NULL);
+	g_variant_unref (cache);
+	if (ok)
+		registry->modified = FALSE;
+
+	return ok;
+}
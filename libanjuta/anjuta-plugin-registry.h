@@ -0,0 +1,59 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta-plugin-registry.h
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+#ifndef _ANJUTA_PLUGIN_REGISTRY_H_
+#define _ANJUTA_PLUGIN_REGISTRY_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _AnjutaPluginRegistry AnjutaPluginRegistry;
+typedef struct _AnjutaPluginRegistryEntry AnjutaPluginRegistryEntry;
+typedef struct _AnjutaPluginAttribute AnjutaPluginAttribute;
+
+/* One non localized key of a plugin description, with its value already
+ * split as a comma separated list */
+struct _AnjutaPluginAttribute
+{
+	gchar *section;
+	gchar *key;
+	gchar **values;
+};
+
+/* One .plugin file */
+struct _AnjutaPluginRegistryEntry
+{
+	gchar *path;
+	gint64 mtime;
+	gint64 size;
+	gchar *contents;
+	GPtrArray *attributes;	/* of AnjutaPluginAttribute */
+};
+
+AnjutaPluginRegistry *anjuta_plugin_registry_new (const gchar *cache_path);
+void anjuta_plugin_registry_free (AnjutaPluginRegistry *registry);
+
+GList *anjuta_plugin_registry_get_directory (AnjutaPluginRegistry *registry,
+											 const gchar *dirname);
+
+gboolean anjuta_plugin_registry_save (AnjutaPluginRegistry *registry);
+
+G_END_DECLS
+
+#endif /* _ANJUTA_PLUGIN_REGISTRY_H_ */
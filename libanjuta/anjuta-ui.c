@@ -79,8 +79,24 @@ struct _AnjutaUIPrivate {
 	GtkTreeModel *accel_model;
 	GHashTable *customizable_actions_hash;
 	GHashTable *uncustomizable_actions_hash;
+
+	/* All user configurable actions, sorted by group and action label when
+	 * actions_sorted is TRUE. The accel editor models are created from it
+	 * only when the editor is displayed. */
+	GPtrArray *actions;
+	GHashTable *actions_hash;
+	gboolean actions_sorted;
 };
 
+/* One user configurable action */
+typedef struct {
+	GtkAction *action;
+	GtkActionGroup *group;
+	gchar *group_label;
+	gchar *group_key;
+	gchar *label_key;
+} AnjutaUIAction;
+
 enum {
 	COLUMN_PIXBUF,
 	COLUMN_ACTION_LABEL,
@@ -116,6 +132,47 @@ get_action_label (GtkAction *action)
 	return action_label;
 }
 
+static AnjutaUIAction *
+anjuta_ui_action_new (GtkAction *action, GtkActionGroup *group, const gchar *group_label)
+{
+	AnjutaUIAction *entry;
+	gchar *label;
+
+	entry = g_slice_new (AnjutaUIAction);
+	entry->action = g_object_ref (action);
+	entry->group = group;
+	entry->group_label = g_strdup (group_label);
+	entry->group_key = g_utf8_collate_key (group_label, -1);
+	label = get_action_label (action);
+	entry->label_key = g_utf8_collate_key (label, -1);
+	g_free (label);
+
+	return entry;
+}
+
+static void
+anjuta_ui_action_free (AnjutaUIAction *entry)
+{
+	g_object_unref (entry->action);
+	g_free (entry->group_label);
+	g_free (entry->group_key);
+	g_free (entry->label_key);
+	g_slice_free (AnjutaUIAction, entry);
+}
+
+static gint
+compare_ui_action (gconstpointer a, gconstpointer b)
+{
+	const AnjutaUIAction *entry_a = *(const AnjutaUIAction **)a;
+	const AnjutaUIAction *entry_b = *(const AnjutaUIAction **)b;
+	gint comp;
+
+	comp = strcmp (entry_a->group_key, entry_b->group_key);
+	if (comp == 0) comp = strcmp (entry_a->label_key, entry_b->label_key);
+
+	return comp;
+}
+
 /* Find action in tree */
 static gboolean
 find_action (GtkTreeModel *model, GtkTreeIter *iter, GtkAction *action)
@@ -883,6 +940,93 @@ accel_set_func (GtkTreeViewColumn *tree_column,
 	}
 }
 						 
+/* Fill the model sorted by name with all registered actions, they have to be
+ * already sorted */
+static void
+fill_sort_by_name_store (GtkTreeStore *store, GPtrArray *actions)
+{
+	GtkTreeIter parent;
+	const gchar *group_label = NULL;
+	guint i;
+
+	for (i = 0; i < actions->len; i++)
+	{
+		AnjutaUIAction *entry = (AnjutaUIAction *)g_ptr_array_index (actions, i);
+		GtkTreeIter iter;
+
+		if ((group_label == NULL) || (strcmp (group_label, entry->group_label) != 0))
+		{
+			gtk_tree_store_append (store, &parent, NULL);
+			gtk_tree_store_set (store, &parent,
+								COLUMN_ACTION_LABEL, entry->group_label,
+								COLUMN_SHOW_VISIBLE, FALSE,
+								-1);
+			group_label = entry->group_label;
+		}
+		gtk_tree_store_append (store, &iter, &parent);
+		fill_action_data (GTK_TREE_MODEL (store), &iter, entry->action, entry->group);
+	}
+}
+
+static GtkTreeStore *
+create_action_store (void)
+{
+	return gtk_tree_store_new (N_COLUMNS,
+							   GDK_TYPE_PIXBUF,
+							   G_TYPE_STRING,
+							   G_TYPE_BOOLEAN,
+							   G_TYPE_BOOLEAN,
+							   G_TYPE_BOOLEAN,
+							   G_TYPE_OBJECT,
+							   G_TYPE_POINTER);
+}
+
+/* Create accel editor models from the registered actions, afterward they are
+ * updated when action groups are added or removed */
+static void
+anjuta_ui_ensure_models (AnjutaUI *ui)
+{
+	if (ui->priv->name_model != NULL) return;
+
+	if (!ui->priv->actions_sorted)
+	{
+		g_ptr_array_sort (ui->priv->actions, compare_ui_action);
+		ui->priv->actions_sorted = TRUE;
+	}
+
+	/* Both unreferenced in dispose() method. */
+	ui->priv->name_model = GTK_TREE_MODEL (create_action_store ());
+	fill_sort_by_name_store (GTK_TREE_STORE (ui->priv->name_model), ui->priv->actions);
+
+	/* Accel model is filled only if needed */
+	ui->priv->accel_model = GTK_TREE_MODEL (create_action_store ());
+}
+
+/* Remove all actions of the group from the registry keeping the order */
+static void
+unregister_action_in_group (AnjutaUI *ui, GtkActionGroup *group)
+{
+	GPtrArray *actions = ui->priv->actions;
+	guint i;
+	guint j;
+
+	for (i = j = 0; i < actions->len; i++)
+	{
+		AnjutaUIAction *entry = (AnjutaUIAction *)g_ptr_array_index (actions, i);
+
+		if (entry->group == group)
+		{
+			g_hash_table_remove (ui->priv->actions_hash, entry->action);
+			anjuta_ui_action_free (entry);
+		}
+		else
+		{
+			actions->pdata[j++] = entry;
+		}
+	}
+	g_ptr_array_set_size (actions, j);
+}
+
 G_DEFINE_TYPE(AnjutaUI, anjuta_ui, GTK_TYPE_UI_MANAGER)
 
 static void
@@ -919,6 +1063,18 @@ anjuta_ui_dispose (GObject *obj)
 		g_hash_table_destroy (ui->priv->uncustomizable_actions_hash);
 		ui->priv->uncustomizable_actions_hash = NULL;
 	}
+	if (ui->priv->actions_hash)
+	{
+		g_hash_table_destroy (ui->priv->actions_hash);
+		ui->priv->actions_hash = NULL;
+	}
+	if (ui->priv->actions)
+	{
+		/* This will release the refs on all registered actions */
+		g_ptr_array_foreach (ui->priv->actions, (GFunc)anjuta_ui_action_free, NULL);
+		g_ptr_array_free (ui->priv->actions, TRUE);
+		ui->priv->actions = NULL;
+	}
 	if (ui->priv->icon_factory) {
 		g_object_unref (G_OBJECT (ui->priv->icon_factory));
 		ui->priv->icon_factory = NULL;
@@ -946,8 +1102,6 @@ anjuta_ui_class_init (AnjutaUIClass *class)
 static void
 anjuta_ui_init (AnjutaUI *ui)
 {
-	GtkTreeStore *store;
-	
 	/* Initialize member data */
 	ui->priv = g_new0 (AnjutaUIPrivate, 1);
 	ui->priv->customizable_actions_hash =
@@ -960,35 +1114,17 @@ anjuta_ui_init (AnjutaUI *ui)
 							   g_str_equal,
 							   (GDestroyNotify) g_free,
 							   NULL);
+	ui->priv->actions = g_ptr_array_new ();
+	ui->priv->actions_hash = g_hash_table_new (g_direct_hash, g_direct_equal);
+	ui->priv->actions_sorted = TRUE;
+
 	/* Create Icon factory */
 	ui->priv->icon_factory = gtk_icon_factory_new ();
 	gtk_icon_factory_add_default (ui->priv->icon_factory);
-	
-	/* Create Accel editor sorted by name model */
-	store = gtk_tree_store_new (N_COLUMNS,
-								GDK_TYPE_PIXBUF,
-								G_TYPE_STRING,
-								G_TYPE_BOOLEAN,
-								G_TYPE_BOOLEAN,
-								G_TYPE_BOOLEAN,
-								G_TYPE_OBJECT,
-								G_TYPE_POINTER);
-	
-	/* unreferenced in dispose() method. */
-	ui->priv->name_model = GTK_TREE_MODEL (store);
-	
-	/* Create Accel editor sorted by accelerator model */
-	store = gtk_tree_store_new (N_COLUMNS,
-								GDK_TYPE_PIXBUF,
-								G_TYPE_STRING,
-								G_TYPE_BOOLEAN,
-								G_TYPE_BOOLEAN,
-								G_TYPE_BOOLEAN,
-								G_TYPE_OBJECT,
-								G_TYPE_POINTER);
-	
-	/* unreferenced in dispose() method. */
-	ui->priv->accel_model = GTK_TREE_MODEL (store);
+
+	/* Accel editor models are created when needed */
+	ui->priv->name_model = NULL;
+	ui->priv->accel_model = NULL;
 }
 
 /**
@@ -1146,6 +1282,7 @@ anjuta_ui_add_action_group (AnjutaUI *ui,
 		gint n_handlers;
 		GtkTreeIter iter;
 		GtkAction *action = l->data;
+		AnjutaUIAction *entry;
 		
 		if (!action)
 			continue;
@@ -1156,6 +1293,17 @@ anjuta_ui_add_action_group (AnjutaUI *ui,
 		if (n_handlers == 0)
 			continue; /* The action element is not user configuration */
 
+		if (g_hash_table_lookup (ui->priv->actions_hash, action) != NULL)
+			continue; /* Already registered */
+
+		entry = anjuta_ui_action_new (action, action_group, action_group_label);
+		g_ptr_array_add (ui->priv->actions, entry);
+		g_hash_table_insert (ui->priv->actions_hash, action, entry);
+		ui->priv->actions_sorted = FALSE;
+
+		if (ui->priv->name_model == NULL)
+			continue; /* Accel editor models are not created yet */
+
 		insert_sorted_by_name (ui->priv->name_model, &iter, action_group_label, action);
 		fill_action_data (ui->priv->name_model, &iter, action, action_group);
 
@@ -1191,8 +1339,12 @@ anjuta_ui_remove_action_group (AnjutaUI *ui, GtkActionGroup *action_group)
 {
 	g_return_if_fail (ANJUTA_IS_UI (ui));
 
-	remove_action_in_group (ui->priv->name_model, action_group);
-	remove_action_in_group (ui->priv->accel_model, action_group);
+	unregister_action_in_group (ui, action_group);
+	if (ui->priv->name_model != NULL)
+	{
+		remove_action_in_group (ui->priv->name_model, action_group);
+		remove_action_in_group (ui->priv->accel_model, action_group);
+	}
 
 	gtk_ui_manager_remove_action_group (GTK_UI_MANAGER (ui), action_group);
 
@@ -1381,6 +1533,7 @@ anjuta_ui_get_accel_editor (AnjutaUI *ui)
 	GtkTreeViewColumn *column;
 	GtkCellRenderer *renderer;
 
+	anjuta_ui_ensure_models (ui);
 	store = GTK_TREE_STORE (ui->priv->name_model);
 	
 	tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
@@ -0,0 +1,757 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-deps.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ * Find if an automake program or library is up to date without running
+ * make -q. The objects of a target are read from the variables of the
+ * generated Makefile and the prerequisites of each object from the
+ * dependency file written by the compiler in $(DEPDIR). Everything is
+ * cached and read again only when the file has changed, so after the first
+ * check only the modification times are read.
+ *
+ * When the answer cannot be known for sure, by example if a prerequisite
+ * is a generated file or if the Makefile needs to be regenerated, the
+ * caller has to fall back to make -q.
+ */
+
+#include <config.h>
+
+#include "build-deps.h"
+
+#include <string.h>
+
+/* Types
+ *---------------------------------------------------------------------------*/
+
+typedef enum
+{
+	BUILD_DEPS_UNKNOWN,
+	BUILD_DEPS_OUT_OF_DATE,
+	BUILD_DEPS_UP_TO_DATE
+} BuildDepsState;
+
+/* Variables of a generated Makefile */
+typedef struct
+{
+	gint64 mtime;
+	gint64 size;
+	GHashTable *variables;
+} BuildDepsMakefile;
+
+/* Prerequisites of an object read from its dependency file */
+typedef struct
+{
+	gint64 mtime;
+	gint64 size;
+	gchar **prerequisites;	/* NULL if the file has no information */
+} BuildDepsObject;
+
+struct _BuildDeps
+{
+	GHashTable *makefiles;	/* Makefile path -> BuildDepsMakefile */
+	GHashTable *objects;	/* dependency file path -> BuildDepsObject */
+};
+
+/* Constants
+ *---------------------------------------------------------------------------*/
+
+#define BUILD_DEPS_MAX_EXPANSION_DEPTH 32
+#define BUILD_DEPS_MAX_LIBRARY_DEPTH 8
+
+/* Files which trigger a regeneration of the Makefile when they are newer */
+static const gchar *build_deps_makefile_sources[] = {
+	"$(srcdir)/Makefile.in",
+	"$(srcdir)/Makefile.am",
+	"$(top_builddir)/config.status",
+	"$(top_srcdir)/configure",
+	"$(top_srcdir)/configure.ac",
+	NULL};
+
+/* Helper functions
+ *---------------------------------------------------------------------------*/
+
+/* Get the modification time in microseconds, a build often writes several
+ * files in the same second */
+static gboolean
+build_deps_stat (const gchar *path, gint64 *mtime, gint64 *size)
+{
+	GFile *file;
+	GFileInfo *info;
+
+	file = g_file_new_for_path (path);
+	info = g_file_query_info (file,
+	                          G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+	                          G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+	                          G_FILE_ATTRIBUTE_STANDARD_SIZE,
+	                          G_FILE_QUERY_INFO_NONE, NULL, NULL);
+	g_object_unref (file);
+	if (info == NULL) return FALSE;
+
+	*mtime = g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED) * G_USEC_PER_SEC +
+		g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC);
+	if (size != NULL) *size = g_file_info_get_size (info);
+	g_object_unref (info);
+
+	return TRUE;
+}
+
+/* make considers a prerequisite as old as the target up to date but the
+ * file system could have dropped the fraction of second, let make decide */
+static BuildDepsState
+build_deps_compare_mtime (gint64 mtime, gint64 target_mtime)
+{
+	if (mtime > target_mtime)
+	{
+		return BUILD_DEPS_OUT_OF_DATE;
+	}
+	else if (mtime == target_mtime)
+	{
+		return BUILD_DEPS_UNKNOWN;
+	}
+	else
+	{
+		return BUILD_DEPS_UP_TO_DATE;
+	}
+}
+
+static gchar *
+build_deps_path (const gchar *dir, const gchar *name)
+{
+	return g_path_is_absolute (name) ? g_strdup (name) : g_build_filename (dir, name, NULL);
+}
+
+static gboolean
+build_deps_strv_contains (gchar **strv, const gchar *str)
+{
+	for (; *strv != NULL; strv++)
+	{
+		if (strcmp (*strv, str) == 0) return TRUE;
+	}
+
+	return FALSE;
+}
+
+static gboolean
+build_deps_is_variable_name (const gchar *name)
+{
+	const gchar *ptr;
+
+	if (*name == '\0') return FALSE;
+
+	for (ptr = name; *ptr != '\0'; ptr++)
+	{
+		if (!g_ascii_isalnum (*ptr) && (*ptr != '_') && (*ptr != '.') && (*ptr != '-')) return FALSE;
+	}
+
+	return TRUE;
+}
+
+/* Split a file in lines, joining lines ending with a backslash */
+static GPtrArray *
+build_deps_split_lines (const gchar *contents)
+{
+	GPtrArray *lines;
+	GString *line;
+	const gchar *ptr;
+
+	lines = g_ptr_array_new_with_free_func (g_free);
+	line = g_string_new (NULL);
+	for (ptr = contents; *ptr != '\0'; ptr++)
+	{
+		if ((ptr[0] == '\\') && (ptr[1] == '\n'))
+		{
+			g_string_append_c (line, ' ');
+			ptr++;
+		}
+		else if (*ptr == '\n')
+		{
+			g_ptr_array_add (lines, g_string_free (line, FALSE));
+			line = g_string_new (NULL);
+		}
+		else
+		{
+			g_string_append_c (line, *ptr);
+		}
+	}
+	g_ptr_array_add (lines, g_string_free (line, FALSE));
+
+	return lines;
+}
+
+static gchar **
+build_deps_split_words (const gchar *text)
+{
+	GPtrArray *words;
+	gchar **split;
+	gchar **word;
+
+	words = g_ptr_array_new ();
+	split = g_strsplit_set (text, " \t\r", -1);
+	for (word = split; *word != NULL; word++)
+	{
+		if (**word == '\0')
+		{
+			g_free (*word);
+		}
+		else
+		{
+			g_ptr_array_add (words, *word);
+		}
+	}
+	g_free (split);
+	g_ptr_array_add (words, NULL);
+
+	return (gchar **)g_ptr_array_free (words, FALSE);
+}
+
+/* Expand variables references, functions, substitution references and
+ * automatic variables are not supported */
+static gboolean
+build_deps_expand (GHashTable *variables, const gchar *text, GString *out, gint depth)
+{
+	const gchar *ptr;
+
+	if (depth > BUILD_DEPS_MAX_EXPANSION_DEPTH) return FALSE;
+
+	for (ptr = text; *ptr != '\0'; ptr++)
+	{
+		if (*ptr != '$')
+		{
+			g_string_append_c (out, *ptr);
+			continue;
+		}
+
+		ptr++;
+		if (*ptr == '$')
+		{
+			g_string_append_c (out, '$');
+		}
+		else if ((*ptr == '(') || (*ptr == '{'))
+		{
+			const gchar *end;
+			gchar *name;
+			const gchar *value;
+
+			end = strchr (ptr, *ptr == '(' ? ')' : '}');
+			if (end == NULL) return FALSE;
+
+			name = g_strndup (ptr + 1, end - ptr - 1);
+			if (!build_deps_is_variable_name (name))
+			{
+				g_free (name);
+				return FALSE;
+			}
+			value = g_hash_table_lookup (variables, name);
+			g_free (name);
+			if ((value != NULL) && !build_deps_expand (variables, value, out, depth + 1)) return FALSE;
+			ptr = end;
+		}
+		else
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Makefile
+ *---------------------------------------------------------------------------*/
+
+static void
+build_deps_makefile_free (BuildDepsMakefile *makefile)
+{
+	g_hash_table_destroy (makefile->variables);
+	g_slice_free (BuildDepsMakefile, makefile);
+}
+
+static BuildDepsMakefile *
+build_deps_makefile_load (const gchar *path)
+{
+	BuildDepsMakefile *makefile;
+	gchar *contents;
+	GPtrArray *lines;
+	guint i;
+
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) return NULL;
+
+	makefile = g_slice_new0 (BuildDepsMakefile);
+	makefile->variables = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+	/* Keep only variable assignments, conditionals are already replaced
+	 * by comments in a generated Makefile */
+	lines = build_deps_split_lines (contents);
+	for (i = 0; i < lines->len; i++)
+	{
+		const gchar *line = (const gchar *)g_ptr_array_index (lines, i);
+		const gchar *equal;
+		const gchar *end;
+		gchar *name;
+		gchar *value;
+		gchar op = '=';
+
+		if ((*line == '\t') || (*line == '#')) continue;
+		equal = strchr (line, '=');
+		if ((equal == NULL) || (equal == line)) continue;
+
+		end = equal;
+		if ((equal[-1] == '+') || (equal[-1] == ':') || (equal[-1] == '?'))
+		{
+			op = equal[-1];
+			end--;
+		}
+		name = g_strstrip (g_strndup (line, end - line));
+		if (!build_deps_is_variable_name (name))
+		{
+			g_free (name);
+			continue;
+		}
+		value = g_strstrip (g_strdup (equal + 1));
+
+		if ((op == '+') || (op == '?'))
+		{
+			const gchar *old = g_hash_table_lookup (makefile->variables, name);
+
+			if ((old != NULL) && (op == '?'))
+			{
+				g_free (name);
+				g_free (value);
+				continue;
+			}
+			if (old != NULL)
+			{
+				gchar *both = g_strconcat (old, " ", value, NULL);
+
+				g_free (value);
+				value = both;
+			}
+		}
+		g_hash_table_insert (makefile->variables, name, value);
+	}
+	g_ptr_array_free (lines, TRUE);
+	g_free (contents);
+
+	return makefile;
+}
+
+/* Return the words of an expanded variable, an empty list if the variable
+ * is not defined or NULL if it cannot be expanded */
+static gchar **
+build_deps_makefile_get_words (BuildDepsMakefile *makefile, const gchar *text)
+{
+	GString *out;
+	gchar **words;
+
+	out = g_string_new (NULL);
+	if (!build_deps_expand (makefile->variables, text, out, 0))
+	{
+		g_string_free (out, TRUE);
+		return NULL;
+	}
+	words = build_deps_split_words (out->str);
+	g_string_free (out, TRUE);
+
+	return words;
+}
+
+static gchar **
+build_deps_makefile_get_variable (BuildDepsMakefile *makefile, const gchar *name)
+{
+	const gchar *value;
+
+	value = g_hash_table_lookup (makefile->variables, name);
+
+	return build_deps_makefile_get_words (makefile, value != NULL ? value : "");
+}
+
+/* Check that make will not regenerate the Makefile before anything else */
+static gboolean
+build_deps_makefile_is_current (BuildDepsMakefile *makefile, const gchar *dir)
+{
+	const gchar **source;
+
+	for (source = build_deps_makefile_sources; *source != NULL; source++)
+	{
+		gchar **words;
+		gboolean current = FALSE;
+
+		words = build_deps_makefile_get_words (makefile, *source);
+		if ((words != NULL) && (words[0] != NULL) && (words[1] == NULL))
+		{
+			gchar *path;
+			gint64 mtime;
+
+			path = build_deps_path (dir, words[0]);
+			current = !build_deps_stat (path, &mtime, NULL) || (mtime < makefile->mtime);
+			g_free (path);
+		}
+		g_strfreev (words);
+		if (!current) return FALSE;
+	}
+
+	return TRUE;
+}
+
+static BuildDepsMakefile *
+build_deps_get_makefile (BuildDeps *deps, const gchar *dir)
+{
+	BuildDepsMakefile *makefile;
+	gchar *path;
+	gint64 mtime;
+	gint64 size;
+
+	path = g_build_filename (dir, "Makefile", NULL);
+	makefile = g_hash_table_lookup (deps->makefiles, path);
+	if (!build_deps_stat (path, &mtime, &size))
+	{
+		g_hash_table_remove (deps->makefiles, path);
+		g_free (path);
+		return NULL;
+	}
+	if ((makefile != NULL) && (makefile->mtime == mtime) && (makefile->size == size))
+	{
+		g_free (path);
+		return makefile;
+	}
+
+	makefile = build_deps_makefile_load (path);
+	if (makefile == NULL)
+	{
+		g_hash_table_remove (deps->makefiles, path);
+		g_free (path);
+		return NULL;
+	}
+	makefile->mtime = mtime;
+	makefile->size = size;
+	g_hash_table_replace (deps->makefiles, path, makefile);
+
+	return makefile;
+}
+
+/* Dependency file
+ *---------------------------------------------------------------------------*/
+
+static void
+build_deps_object_free (BuildDepsObject *object)
+{
+	g_strfreev (object->prerequisites);
+	g_slice_free (BuildDepsObject, object);
+}
+
+static BuildDepsObject *
+build_deps_object_load (const gchar *path)
+{
+	BuildDepsObject *object;
+	gchar *contents;
+	GPtrArray *lines;
+	guint i;
+
+	if (!g_file_get_contents (path, &contents, NULL, NULL)) return NULL;
+
+	object = g_slice_new0 (BuildDepsObject);
+
+	/* The first rule lists the object prerequisites, the following ones
+	 * are empty rules added for each header. A file containing only a
+	 * comment has been created by configure, the object has never been
+	 * compiled. */
+	lines = build_deps_split_lines (contents);
+	for (i = 0; i < lines->len; i++)
+	{
+		const gchar *line = (const gchar *)g_ptr_array_index (lines, i);
+		const gchar *colon;
+
+		if (*line == '#') continue;
+		colon = strchr (line, ':');
+		if (colon == NULL) continue;
+
+		object->prerequisites = build_deps_split_words (colon + 1);
+		break;
+	}
+	g_ptr_array_free (lines, TRUE);
+	g_free (contents);
+
+	return object;
+}
+
+static BuildDepsObject *
+build_deps_get_object (BuildDeps *deps, const gchar *path)
+{
+	BuildDepsObject *object;
+	gint64 mtime;
+	gint64 size;
+
+	object = g_hash_table_lookup (deps->objects, path);
+	if (!build_deps_stat (path, &mtime, &size))
+	{
+		g_hash_table_remove (deps->objects, path);
+		return NULL;
+	}
+	if ((object != NULL) && (object->mtime == mtime) && (object->size == size))
+	{
+		return object;
+	}
+
+	object = build_deps_object_load (path);
+	if (object == NULL)
+	{
+		g_hash_table_remove (deps->objects, path);
+		return NULL;
+	}
+	object->mtime = mtime;
+	object->size = size;
+	g_hash_table_replace (deps->objects, g_strdup (path), object);
+
+	return object;
+}
+
+/* Check
+ *---------------------------------------------------------------------------*/
+
+static BuildDepsState
+build_deps_check_object (BuildDeps *deps, const gchar *dir, const gchar *depdir,
+                         const gchar *name, gint64 target_mtime, gchar **generated)
+{
+	BuildDepsObject *object;
+	BuildDepsState state;
+	gchar *path;
+	gint64 mtime;
+	gchar *object_dir;
+	gchar *base;
+	gchar *ext;
+	gchar **prerequisite;
+
+	path = build_deps_path (dir, name);
+	if (!build_deps_stat (path, &mtime, NULL))
+	{
+		g_free (path);
+		return BUILD_DEPS_OUT_OF_DATE;
+	}
+	g_free (path);
+	state = build_deps_compare_mtime (mtime, target_mtime);
+	if (state != BUILD_DEPS_UP_TO_DATE) return state;
+
+	/* foo.o and foo.lo have their dependencies in $(DEPDIR)/foo.Po and
+	 * $(DEPDIR)/foo.Plo */
+	base = g_path_get_basename (name);
+	ext = strrchr (base, '.');
+	if (ext == NULL)
+	{
+		g_free (base);
+		return BUILD_DEPS_UNKNOWN;
+	}
+	*ext = '\0';
+	object_dir = g_path_get_dirname (name);
+	path = g_strconcat (base, strcmp (ext + 1, "lo") == 0 ? ".Plo" : ".Po", NULL);
+	g_free (base);
+	base = build_deps_path (dir, object_dir);
+	g_free (object_dir);
+	object_dir = base;
+	base = path;
+	path = g_build_filename (object_dir, depdir, base, NULL);
+	g_free (object_dir);
+	g_free (base);
+
+	object = build_deps_get_object (deps, path);
+	g_free (path);
+	if ((object == NULL) || (object->prerequisites == NULL)) return BUILD_DEPS_UNKNOWN;
+
+	/* The compiler writes prerequisites relative to the build directory */
+	state = BUILD_DEPS_UP_TO_DATE;
+	for (prerequisite = object->prerequisites; (*prerequisite != NULL) && (state == BUILD_DEPS_UP_TO_DATE); prerequisite++)
+	{
+		gint64 prerequisite_mtime;
+
+		/* A generated file can be out of date itself */
+		if (build_deps_strv_contains (generated, *prerequisite)) return BUILD_DEPS_UNKNOWN;
+
+		path = build_deps_path (dir, *prerequisite);
+		if (!build_deps_stat (path, &prerequisite_mtime, NULL))
+		{
+			state = BUILD_DEPS_UNKNOWN;
+		}
+		else
+		{
+			state = build_deps_compare_mtime (prerequisite_mtime, mtime);
+		}
+		g_free (path);
+	}
+
+	return state;
+}
+
+static BuildDepsState build_deps_check_target (BuildDeps *deps, const gchar *dir, const gchar *target, gint depth);
+
+static BuildDepsState
+build_deps_check_dependency (BuildDeps *deps, const gchar *dir, const gchar *name,
+                             gint64 target_mtime, gint depth)
+{
+	BuildDepsState state;
+	gchar *path;
+	gint64 mtime;
+
+	path = build_deps_path (dir, name);
+	if (!build_deps_stat (path, &mtime, NULL))
+	{
+		state = BUILD_DEPS_UNKNOWN;
+	}
+	else
+	{
+		state = build_deps_compare_mtime (mtime, target_mtime);
+	}
+	if ((state == BUILD_DEPS_UP_TO_DATE) && (strchr (name, G_DIR_SEPARATOR) == NULL) &&
+	    (g_str_has_suffix (name, ".la") || g_str_has_suffix (name, ".a")))
+	{
+		/* Like make, check only libraries built by the same Makefile, the
+		 * other ones are just compared by date */
+		state = depth < BUILD_DEPS_MAX_LIBRARY_DEPTH ? build_deps_check_target (deps, dir, name, depth + 1) : BUILD_DEPS_UNKNOWN;
+	}
+	g_free (path);
+
+	return state;
+}
+
+static BuildDepsState
+build_deps_check_target (BuildDeps *deps, const gchar *dir, const gchar *target, gint depth)
+{
+	BuildDepsMakefile *makefile;
+	BuildDepsState state;
+	gchar **exeext;
+	gchar *canonical;
+	gchar *ptr;
+	gchar *name;
+	gchar **objects = NULL;
+	gchar **dependencies = NULL;
+	gchar **built_sources = NULL;
+	gchar **nodist_sources = NULL;
+	gchar **depdir = NULL;
+	gchar *path;
+	gint64 mtime;
+	gchar **word;
+
+	makefile = build_deps_get_makefile (deps, dir);
+	if ((makefile == NULL) || !build_deps_makefile_is_current (makefile, dir)) return BUILD_DEPS_UNKNOWN;
+
+	/* Variables use the canonical name of the target without the
+	 * executable extension */
+	canonical = g_strdup (target);
+	exeext = build_deps_makefile_get_variable (makefile, "EXEEXT");
+	if ((exeext != NULL) && (exeext[0] != NULL) && g_str_has_suffix (canonical, exeext[0]))
+	{
+		canonical[strlen (canonical) - strlen (exeext[0])] = '\0';
+	}
+	g_strfreev (exeext);
+	for (ptr = canonical; *ptr != '\0'; ptr++)
+	{
+		if (!g_ascii_isalnum (*ptr) && (*ptr != '_') && (*ptr != '@')) *ptr = '_';
+	}
+
+	name = g_strconcat (canonical, "_OBJECTS", NULL);
+	if (g_hash_table_lookup (makefile->variables, name) != NULL)
+	{
+		objects = build_deps_makefile_get_variable (makefile, name);
+	}
+	g_free (name);
+	name = g_strconcat (canonical, "_DEPENDENCIES", NULL);
+	dependencies = build_deps_makefile_get_variable (makefile, name);
+	g_free (name);
+	name = g_strconcat ("nodist_", canonical, "_SOURCES", NULL);
+	nodist_sources = build_deps_makefile_get_variable (makefile, name);
+	g_free (name);
+	built_sources = build_deps_makefile_get_variable (makefile, "BUILT_SOURCES");
+	depdir = build_deps_makefile_get_variable (makefile, "DEPDIR");
+	g_free (canonical);
+
+	if ((objects == NULL) || (dependencies == NULL) || (nodist_sources == NULL) ||
+	    (built_sources == NULL) || (depdir == NULL) || (depdir[0] == NULL))
+	{
+		/* Not an automake program or library */
+		state = BUILD_DEPS_UNKNOWN;
+	}
+	else if (nodist_sources[0] != NULL)
+	{
+		/* Generated sources could be out of date themselves */
+		state = BUILD_DEPS_UNKNOWN;
+	}
+	else
+	{
+		path = build_deps_path (dir, target);
+		state = build_deps_stat (path, &mtime, NULL) ? BUILD_DEPS_UP_TO_DATE : BUILD_DEPS_OUT_OF_DATE;
+		g_free (path);
+
+		for (word = objects; (*word != NULL) && (state == BUILD_DEPS_UP_TO_DATE); word++)
+		{
+			state = build_deps_check_object (deps, dir, depdir[0], *word, mtime, built_sources);
+		}
+		for (word = dependencies; (*word != NULL) && (state == BUILD_DEPS_UP_TO_DATE); word++)
+		{
+			state = build_deps_check_dependency (deps, dir, *word, mtime, depth);
+		}
+	}
+
+	g_strfreev (objects);
+	g_strfreev (dependencies);
+	g_strfreev (nodist_sources);
+	g_strfreev (built_sources);
+	g_strfreev (depdir);
+
+	return state;
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+BuildDeps *
+build_deps_new (void)
+{
+	BuildDeps *deps;
+
+	deps = g_new0 (BuildDeps, 1);
+	deps->makefiles = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)build_deps_makefile_free);
+	deps->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, (GDestroyNotify)build_deps_object_free);
+
+	return deps;
+}
+
+void
+build_deps_free (BuildDeps *deps)
+{
+	g_hash_table_destroy (deps->makefiles);
+	g_hash_table_destroy (deps->objects);
+	g_free (deps);
+}
+
+/* Return TRUE and set built if the answer is known, else make -q has to
+ * be used */
+gboolean
+build_deps_is_built (BuildDeps *deps, GFile *dir, const gchar *target, gboolean *built)
+{
+	BuildDepsState state;
+	gchar *path;
+
+	path = g_file_get_path (dir);
+	if (path == NULL) return FALSE;
+
+	state = build_deps_check_target (deps, path, target, 0);
+	g_free (path);
+	if (state == BUILD_DEPS_UNKNOWN) return FALSE;
+
+	*built = state == BUILD_DEPS_UP_TO_DATE;
+
+	return TRUE;
+}
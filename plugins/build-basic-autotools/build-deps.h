@@ -0,0 +1,33 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-deps.h
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __BUILD_DEPS_H__
+#define __BUILD_DEPS_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+typedef struct _BuildDeps BuildDeps;
+
+BuildDeps *build_deps_new (void);
+void build_deps_free (BuildDeps *deps);
+
+gboolean build_deps_is_built (BuildDeps *deps, GFile *dir, const gchar *target, gboolean *built);
+
+#endif /* __BUILD_DEPS_H__ */
@@ -0,0 +1,371 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-topology.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+
+/*
+ * Remember for each directory of the project its build directory, the
+ * kind of Makefiles it contains and the object files built from its
+ * sources. The existence of files is checked only once, a file monitor
+ * on each directory invalidates the cached value when one of these files
+ * is created or deleted. Everything is dropped when the project or the
+ * build directory changes, typically when another configuration is
+ * selected.
+ */
+
+#include <config.h>
+
+#include "build-topology.h"
+
+#include <string.h>
+
+/* Types
+ *---------------------------------------------------------------------------*/
+
+typedef enum
+{
+	BUILD_TOPOLOGY_MAKEFILE = 1 << 0,
+	BUILD_TOPOLOGY_MAKEFILE_AM = 1 << 1,
+	BUILD_TOPOLOGY_CONFIGURE = 1 << 2
+} BuildTopologyKind;
+
+typedef struct
+{
+	const gchar *name;
+	BuildTopologyKind kind;
+} BuildTopologyFile;
+
+typedef struct
+{
+	GFile *directory;
+	GFile *build_dir;		/* NULL if not computed yet */
+	guint known;			/* Kinds checked and monitored */
+	guint present;			/* Kinds found in the directory */
+	GHashTable *objects;	/* source basename -> object basename or NULL */
+	GFileMonitor *monitor;
+} BuildTopologyDir;
+
+struct _BuildTopology
+{
+	GFile *root_dir;
+	GFile *build_dir;
+	GHashTable *dirs;		/* GFile -> BuildTopologyDir */
+};
+
+/* Constants
+ *---------------------------------------------------------------------------*/
+
+static const BuildTopologyFile build_topology_files[] = {
+	{"Makefile", BUILD_TOPOLOGY_MAKEFILE},
+	{"makefile", BUILD_TOPOLOGY_MAKEFILE},
+	{"MAKEFILE", BUILD_TOPOLOGY_MAKEFILE},
+	{"Makefile.am", BUILD_TOPOLOGY_MAKEFILE_AM},
+	{"GNUmakefile.am", BUILD_TOPOLOGY_MAKEFILE_AM},
+	{"configure.ac", BUILD_TOPOLOGY_CONFIGURE},
+	{"configure.in", BUILD_TOPOLOGY_CONFIGURE},
+	{NULL, 0}};
+
+/* Directory
+ *---------------------------------------------------------------------------*/
+
+static void
+on_build_topology_dir_changed (GFileMonitor *monitor, GFile *file, GFile *other_file,
+                               GFileMonitorEvent event_type, gpointer user_data)
+{
+	BuildTopologyDir *dir = (BuildTopologyDir *)user_data;
+	const BuildTopologyFile *known;
+	gchar *name;
+
+	if ((event_type != G_FILE_MONITOR_EVENT_CREATED) &&
+	    (event_type != G_FILE_MONITOR_EVENT_DELETED)) return;
+
+	if (g_file_equal (file, dir->directory))
+	{
+		/* The directory itself has been created or removed */
+		dir->known = 0;
+		if (dir->objects != NULL) g_hash_table_remove_all (dir->objects);
+		return;
+	}
+
+	name = g_file_get_basename (file);
+	for (known = build_topology_files; known->name != NULL; known++)
+	{
+		if (strcmp (known->name, name) == 0) dir->known &= ~known->kind;
+	}
+	if (dir->objects != NULL) g_hash_table_remove (dir->objects, name);
+	g_free (name);
+}
+
+static void
+build_topology_dir_free (BuildTopologyDir *dir)
+{
+	if (dir->monitor != NULL)
+	{
+		g_signal_handlers_disconnect_by_func (dir->monitor, G_CALLBACK (on_build_topology_dir_changed), dir);
+		g_file_monitor_cancel (dir->monitor);
+		g_object_unref (dir->monitor);
+	}
+	if (dir->objects != NULL) g_hash_table_destroy (dir->objects);
+	if (dir->build_dir != NULL) g_object_unref (dir->build_dir);
+	g_object_unref (dir->directory);
+	g_slice_free (BuildTopologyDir, dir);
+}
+
+static BuildTopologyDir *
+build_topology_get_dir (BuildTopology *topology, GFile *directory)
+{
+	BuildTopologyDir *dir;
+
+	dir = g_hash_table_lookup (topology->dirs, directory);
+	if (dir == NULL)
+	{
+		dir = g_slice_new0 (BuildTopologyDir);
+		dir->directory = g_object_ref (directory);
+		g_hash_table_insert (topology->dirs, g_object_ref (directory), dir);
+	}
+
+	return dir;
+}
+
+/* Start watching the directory, return FALSE if it is not possible */
+static gboolean
+build_topology_dir_monitor (BuildTopologyDir *dir)
+{
+	if (dir->monitor == NULL)
+	{
+		dir->monitor = g_file_monitor_directory (dir->directory, G_FILE_MONITOR_NONE, NULL, NULL);
+		if (dir->monitor != NULL)
+		{
+			g_signal_connect (dir->monitor, "changed", G_CALLBACK (on_build_topology_dir_changed), dir);
+		}
+	}
+
+	return dir->monitor != NULL;
+}
+
+/* Return TRUE if the directory contains a file of this kind */
+static gboolean
+build_topology_dir_has (BuildTopology *topology, GFile *directory, BuildTopologyKind kind)
+{
+	BuildTopologyDir *dir;
+
+	dir = build_topology_get_dir (topology, directory);
+	if (!(dir->known & kind))
+	{
+		const BuildTopologyFile *known;
+		gboolean exists = FALSE;
+		gboolean monitored;
+
+		monitored = build_topology_dir_monitor (dir);
+
+		for (known = build_topology_files; (known->name != NULL) && !exists; known++)
+		{
+			if (known->kind == kind)
+			{
+				GFile *file = g_file_get_child (directory, known->name);
+
+				exists = g_file_query_exists (file, NULL);
+				g_object_unref (file);
+			}
+		}
+		if (exists)
+		{
+			dir->present |= kind;
+		}
+		else
+		{
+			dir->present &= ~kind;
+		}
+
+		/* Without a monitor, the value cannot be kept */
+		if (monitored) dir->known |= kind;
+	}
+
+	return (dir->present & kind) != 0;
+}
+
+/* Return source directory corresponding to a build directory */
+static GFile *
+build_topology_get_source_dir (BuildTopology *topology, GFile *directory)
+{
+	if ((topology->build_dir == NULL) || (topology->root_dir == NULL))
+	{
+		return g_object_ref (directory);
+	}
+	else if (g_file_has_prefix (directory, topology->build_dir))
+	{
+		gchar *relative;
+		GFile *source_dir;
+
+		relative = g_file_get_relative_path (topology->build_dir, directory);
+		source_dir = g_file_get_child (topology->root_dir, relative);
+		g_free (relative);
+
+		return source_dir;
+	}
+	else if (g_file_equal (directory, topology->build_dir))
+	{
+		return g_object_ref (topology->root_dir);
+	}
+	else
+	{
+		return g_object_ref (directory);
+	}
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+BuildTopology *
+build_topology_new (void)
+{
+	BuildTopology *topology;
+
+	topology = g_new0 (BuildTopology, 1);
+	topology->dirs = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal,
+	                                        g_object_unref, (GDestroyNotify)build_topology_dir_free);
+
+	return topology;
+}
+
+void
+build_topology_free (BuildTopology *topology)
+{
+	g_hash_table_destroy (topology->dirs);
+	if (topology->root_dir != NULL) g_object_unref (topology->root_dir);
+	if (topology->build_dir != NULL) g_object_unref (topology->build_dir);
+	g_free (topology);
+}
+
+static gboolean
+build_topology_same_file (GFile *a, GFile *b)
+{
+	return (a == b) || ((a != NULL) && (b != NULL) && g_file_equal (a, b));
+}
+
+/* Drop all cached data if the project or the build directory has changed */
+void
+build_topology_set_project (BuildTopology *topology, GFile *root_dir, GFile *build_dir)
+{
+	if (build_topology_same_file (topology->root_dir, root_dir) &&
+	    build_topology_same_file (topology->build_dir, build_dir)) return;
+
+	g_hash_table_remove_all (topology->dirs);
+	if (topology->root_dir != NULL) g_object_unref (topology->root_dir);
+	topology->root_dir = root_dir != NULL ? g_object_ref (root_dir) : NULL;
+	if (topology->build_dir != NULL) g_object_unref (topology->build_dir);
+	topology->build_dir = build_dir != NULL ? g_object_ref (build_dir) : NULL;
+}
+
+/* Return build path from a source directory */
+GFile *
+build_topology_get_build_dir (BuildTopology *topology, GFile *directory)
+{
+	BuildTopologyDir *dir;
+
+	dir = build_topology_get_dir (topology, directory);
+	if (dir->build_dir != NULL) return g_object_ref (dir->build_dir);
+
+	if ((topology->root_dir == NULL) || (topology->build_dir == NULL))
+	{
+		/* No change if there is no project or no build directory */
+		dir->build_dir = g_object_ref (directory);
+	}
+	else if (g_file_has_prefix (directory, topology->build_dir) || g_file_equal (directory, topology->build_dir))
+	{
+		/* No change, already in build directory */
+		dir->build_dir = g_object_ref (directory);
+	}
+	else if (g_file_equal (directory, topology->root_dir))
+	{
+		/* Use build directory instead of source directory */
+		dir->build_dir = g_object_ref (topology->build_dir);
+	}
+	else if (g_file_has_prefix (directory, topology->root_dir))
+	{
+		/* Get corresponding file in build directory */
+		gchar *relative;
+
+		relative = g_file_get_relative_path (topology->root_dir, directory);
+		dir->build_dir = g_file_resolve_relative_path (topology->build_dir, relative);
+		g_free (relative);
+	}
+	else
+	{
+		/* File outside the project directory */
+		dir->build_dir = g_object_ref (directory);
+	}
+
+	return g_object_ref (dir->build_dir);
+}
+
+gboolean
+build_topology_has_makefile (BuildTopology *topology, GFile *dir)
+{
+	return build_topology_dir_has (topology, dir, BUILD_TOPOLOGY_MAKEFILE);
+}
+
+/* Return TRUE if the directory is part of an automake project, the
+ * Makefile.am is searched in the source directory */
+gboolean
+build_topology_has_makefile_am (BuildTopology *topology, GFile *dir)
+{
+	GFile *source_dir;
+	gboolean exists;
+
+	/* We need configure.ac or configure.in too */
+	if (topology->root_dir == NULL) return FALSE;
+	if (!build_topology_dir_has (topology, topology->root_dir, BUILD_TOPOLOGY_CONFIGURE)) return FALSE;
+
+	source_dir = build_topology_get_source_dir (topology, dir);
+	exists = build_topology_dir_has (topology, source_dir, BUILD_TOPOLOGY_MAKEFILE_AM);
+	g_object_unref (source_dir);
+
+	return exists;
+}
+
+/* Get the object file built from a source file if it is already known,
+ * object is set to NULL if there is no such file */
+gboolean
+build_topology_get_object (BuildTopology *topology, GFile *dir, const gchar *name, const gchar **object)
+{
+	BuildTopologyDir *entry;
+	gpointer value;
+
+	entry = build_topology_get_dir (topology, dir);
+	if (entry->objects == NULL) return FALSE;
+	if (!g_hash_table_lookup_extended (entry->objects, name, NULL, &value)) return FALSE;
+
+	*object = (const gchar *)value;
+
+	return TRUE;
+}
+
+void
+build_topology_set_object (BuildTopology *topology, GFile *dir, const gchar *name, const gchar *object)
+{
+	BuildTopologyDir *entry;
+
+	entry = build_topology_get_dir (topology, dir);
+	if (!build_topology_dir_monitor (entry)) return;
+	if (entry->objects == NULL)
+	{
+		entry->objects = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+	}
+	g_hash_table_replace (entry->objects, g_strdup (name), g_strdup (object));
+}
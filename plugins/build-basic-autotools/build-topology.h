@@ -0,0 +1,40 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    build-topology.h
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#ifndef __BUILD_TOPOLOGY_H__
+#define __BUILD_TOPOLOGY_H__
+
+#include <glib.h>
+#include <gio/gio.h>
+
+typedef struct _BuildTopology BuildTopology;
+
+BuildTopology *build_topology_new (void);
+void build_topology_free (BuildTopology *topology);
+
+void build_topology_set_project (BuildTopology *topology, GFile *root_dir, GFile *build_dir);
+
+GFile *build_topology_get_build_dir (BuildTopology *topology, GFile *dir);
+gboolean build_topology_has_makefile (BuildTopology *topology, GFile *dir);
+gboolean build_topology_has_makefile_am (BuildTopology *topology, GFile *dir);
+
+gboolean build_topology_get_object (BuildTopology *topology, GFile *dir, const gchar *name, const gchar **object);
+void build_topology_set_object (BuildTopology *topology, GFile *dir, const gchar *name, const gchar *object);
+
+#endif /* __BUILD_TOPOLOGY_H__ */
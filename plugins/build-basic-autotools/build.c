@@ -117,89 +117,25 @@ normalize_project_file (GFile *file, GFile *root)
 	return new_file;
 }
 
-gboolean
-directory_has_makefile_am (BasicAutotoolsPlugin *bb_plugin,  GFile *dir)
+/* Return the topology cache of the current configuration */
+static BuildTopology *
+build_get_topology (BasicAutotoolsPlugin *plugin)
 {
-	GFile *file;
-	gboolean exists;
-
-	/* We need configure.ac or configure.in too */
-	if (bb_plugin->project_root_dir == NULL) return FALSE;
+	build_topology_set_project (plugin->topology, plugin->project_root_dir, plugin->project_build_dir);
 
-	exists = TRUE;
-	file = g_file_get_child (bb_plugin->project_root_dir,  "configure.ac");
-	if (!g_file_query_exists (file, NULL))
-	{
-		g_object_unref (file);
-		file =  g_file_get_child (bb_plugin->project_root_dir,  "configure.in");
-		if (!g_file_query_exists (file, NULL))
-		{
-			exists = FALSE;
-		}
-	}
-	g_object_unref (file);
-
-	/* Check for Makefile.am or GNUmakefile.am */
-	if (g_file_has_prefix (dir, bb_plugin->project_build_dir))
-	{
-		/* Check for Makefile.am in source directory not build directory */
-		gchar *relative;
-		GFile *src_dir;
-
-		relative = g_file_get_relative_path (bb_plugin->project_build_dir, dir);
-		src_dir = g_file_get_child (bb_plugin->project_root_dir, relative);
-		file = g_file_get_child (src_dir,  "Makefile.am");
-		g_object_unref (src_dir);
-		g_free (relative);
-	}
-	else if (g_file_equal (dir, bb_plugin->project_build_dir))
-	{
-		file = g_file_get_child (bb_plugin->project_root_dir,  "Makefile.am");
-	}
-	else
-	{
-		file = g_file_get_child (dir,  "Makefile.am");
-	}
-
-	if (!g_file_query_exists (file, NULL))
-	{
-		g_object_unref (file);
-		file =  g_file_get_child (dir, "GNUmakefile.am");
-		if (!g_file_query_exists (file, NULL))
-		{
-			exists = FALSE;
-		}
-	}
-	g_object_unref (file);
-
-	return exists;
+	return plugin->topology;
 }
 
 gboolean
-directory_has_makefile (GFile *dir)
+directory_has_makefile_am (BasicAutotoolsPlugin *bb_plugin,  GFile *dir)
 {
-	GFile *file;
-	gboolean exists;
-
-	exists = TRUE;
-	file = g_file_get_child (dir, "Makefile");
-	if (!g_file_query_exists (file, NULL))
-	{
-		g_object_unref (file);
-		file = g_file_get_child (dir, "makefile");
-		if (!g_file_query_exists (file, NULL))
-		{
-			g_object_unref (file);
-			file = g_file_get_child (dir, "MAKEFILE");
-			if (!g_file_query_exists (file, NULL))
-			{
-				exists = FALSE;
-			}
-		}
-	}
-	g_object_unref (file);
+	return build_topology_has_makefile_am (build_get_topology (bb_plugin), dir);
+}
 
-	return exists;
+gboolean
+directory_has_makefile (BasicAutotoolsPlugin *bb_plugin, GFile *dir)
+{
+	return build_topology_has_makefile (build_get_topology (bb_plugin), dir);
 }
 
 static gboolean
@@ -243,7 +179,7 @@ is_configured (BasicAutotoolsPlugin *plugin, GFile *file)
 
 	/* Get build directory and check for makefiles */
 	build_dir = build_file_from_file (plugin, file, NULL);
-	has_makefile = directory_has_makefile (build_dir);
+	has_makefile = directory_has_makefile (plugin, build_dir);
 	has_makefile_am = directory_has_makefile_am (plugin, build_dir);
 	g_object_unref (build_dir);
 
@@ -254,39 +190,7 @@ is_configured (BasicAutotoolsPlugin *plugin, GFile *file)
 static GFile *
 build_file_from_directory (BasicAutotoolsPlugin *plugin, GFile *directory)
 {
-	GFile *build_file;
-
-	if ((plugin->project_root_dir == NULL) || (plugin->project_build_dir == NULL))
-	{
-		/* No change if there is no project or no build directory */
-		build_file = g_object_ref (directory);
-	}
-	else if (g_file_has_prefix (directory, plugin->project_build_dir) || g_file_equal (directory, plugin->project_build_dir))
-	{
-		/* No change, already in build directory */
-		build_file = g_object_ref (directory);
-	}
-	else if (g_file_equal (directory, plugin->project_root_dir))
-	{
-		/* Use build directory instead of source directory */
-		build_file = g_object_ref (plugin->project_build_dir);
-	}
-	else if (g_file_has_prefix (directory, plugin->project_root_dir))
-	{
-		/* Get corresponding file in build directory */
-		gchar *relative;
-
-		relative = g_file_get_relative_path (plugin->project_root_dir, directory);
-		build_file = g_file_resolve_relative_path (plugin->project_build_dir, relative);
-		g_free (relative);
-	}
-	else
-	{
-		/* File outside the project directory */
-		build_file = g_object_ref (directory);
-	}
-
-	return build_file;
+	return build_topology_get_build_dir (build_get_topology (plugin), directory);
 }
 
 /* Return build path and target from a GFile */
@@ -389,12 +293,24 @@ build_object_from_file (BasicAutotoolsPlugin *plugin, GFile *file)
 	}
 	else
 	{
-		/* Use language plugin trying to find an object file */
+		/* Use language plugin trying to find an object file, the result
+		 * depends only on the file name so it is cached */
 		IAnjutaLanguage* langman =	anjuta_shell_get_interface (ANJUTA_PLUGIN (plugin)->shell,
 			                                                      IAnjutaLanguage,
 			                                                      NULL);
-
-		if (langman != NULL)
+		BuildTopology *topology = build_get_topology (plugin);
+		GFile *parent;
+		gchar *basename;
+		gchar *targetname = NULL;
+		const gchar *cached;
+
+		parent = g_file_get_parent (file);
+		basename = g_file_get_basename (file);
+		if (build_topology_get_object (topology, parent, basename, &cached))
+		{
+			targetname = g_strdup (cached);
+		}
+		else if (langman != NULL)
 		{
 			GFileInfo* file_info;
 
@@ -411,24 +327,22 @@ build_object_from_file (BasicAutotoolsPlugin *plugin, GFile *file)
 				if (id > 0)
 				{
 					const gchar *obj_ext = ianjuta_language_get_make_target (langman, id, NULL);
-					gchar *basename;
 					gchar *ext;
-					gchar *targetname;
-					GFile *parent;
 
-					basename = g_file_get_basename (file);
 					ext = strrchr (basename, '.');
 					if ((ext != NULL) && (ext != basename)) *ext = '\0';
 					targetname = g_strconcat (basename, obj_ext, NULL);
-					g_free (basename);
-					parent = g_file_get_parent (file);
-					object = g_file_get_child (parent, targetname);
-					g_object_unref (parent);
-					g_free (targetname);
+					if (ext != NULL) *ext = '.';
 				}
+				build_topology_set_object (topology, parent, basename, targetname);
+				g_object_unref (file_info);
 			}
-			g_object_unref (file_info);
 		}
+
+		if (targetname != NULL) object = g_file_get_child (parent, targetname);
+		g_free (targetname);
+		g_free (basename);
+		g_object_unref (parent);
 	}
 
 	return object;
@@ -595,6 +509,7 @@ build_is_file_built (BasicAutotoolsPlugin *plugin, GFile *file,
 	BuildContext *context;
 	BuildConfiguration *config;
 	GList *vars;
+	gboolean built;
 
 
 	config = build_configuration_list_get_selected (plugin->configurations);
@@ -614,7 +529,20 @@ build_is_file_built (BasicAutotoolsPlugin *plugin, GFile *file,
 	build_program_set_callback (prog, callback, user_data);
 	build_program_add_env_list (prog, vars);
 
-	context = build_save_and_execute_command (plugin, prog, FALSE, FALSE, err);
+	/* Avoid running make -q if the dependency files give the answer */
+	if ((target != NULL) &&
+	    (plugin->commands[IANJUTA_BUILDABLE_COMMAND_IS_BUILT] == NULL) &&
+	    !build_has_unsaved_files (plugin) &&
+	    build_deps_is_built (plugin->deps, build_dir, target, &built))
+	{
+		context = build_get_context (plugin, prog->work_dir, FALSE, FALSE);
+		build_set_command_in_context (context, prog);
+		build_answer_command_in_context (context, built);
+	}
+	else
+	{
+		context = build_save_and_execute_command (plugin, prog, FALSE, FALSE, err);
+	}
 
 	g_free (target);
 	g_object_unref (build_dir);
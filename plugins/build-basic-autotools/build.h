@@ -32,7 +32,7 @@
 GFile * build_file_from_file (BasicAutotoolsPlugin *plugin, GFile *file, gchar **target);
 GFile * build_object_from_file (BasicAutotoolsPlugin *plugin, GFile *file);
 GFile * normalize_project_file (GFile *file, GFile *root);
-gboolean directory_has_makefile (GFile *dir);
+gboolean directory_has_makefile (BasicAutotoolsPlugin *bb_plugin, GFile *dir);
 gboolean directory_has_makefile_am (BasicAutotoolsPlugin *bb_plugin,  GFile *dir);
 
 /* Build function type */
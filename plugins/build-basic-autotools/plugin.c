@@ -124,6 +124,11 @@ struct _BuildContext
 
 	/* Saved files */
 	gint file_saved;
+
+	/* Result known without running the command */
+	guint answer_idle;
+	gboolean answer;
+	gboolean answer_canceled;
 };
 
 /* Declarations */
@@ -336,12 +341,26 @@ build_context_get_plugin (BuildContext* context)
 static void
 build_context_cancel (BuildContext *context)
 {
-	if (context->launcher != NULL)
+	if (context->answer_idle != 0)
+	{
+		context->answer_canceled = TRUE;
+	}
+	else if (context->launcher != NULL)
 	{
 		anjuta_launcher_signal (context->launcher, SIGTERM);
 	}
 }
 
+static void
+build_context_remove_answer (BuildContext *context)
+{
+	if (context->answer_idle != 0)
+	{
+		g_source_remove (context->answer_idle);
+		context->answer_idle = 0;
+	}
+}
+
 static gboolean
 build_context_destroy_command (BuildContext *context)
 {
@@ -370,6 +389,7 @@ build_context_destroy_command (BuildContext *context)
 		ANJUTA_PLUGIN_BASIC_AUTOTOOLS (context->plugin)->contexts_pool =
 			g_list_remove (ANJUTA_PLUGIN_BASIC_AUTOTOOLS (context->plugin)->contexts_pool,
 							context);
+		build_context_remove_answer (context);
 		g_free (context);
 
 		return TRUE;
@@ -412,6 +432,7 @@ build_context_destroy_view (BuildContext *context)
 		plugin->contexts_pool =
 			g_list_remove (plugin->contexts_pool,
 			               context);
+		build_context_remove_answer (context);
 		g_free (context);
 	}
 	else
@@ -1031,6 +1052,37 @@ on_build_terminated (AnjutaLauncher *launcher,
 	build_context_destroy_command (context);
 }
 
+static gboolean
+on_build_answered (gpointer user_data)
+{
+	BuildContext *context = (BuildContext *)user_data;
+
+	context->answer_idle = 0;
+	context->used = FALSE;
+	if (context->program->callback != NULL)
+	{
+		GError *err = NULL;
+
+		if (context->answer_canceled)
+		{
+			err = g_error_new (ianjuta_builder_error_quark (),
+							   IANJUTA_BUILDER_CANCELED,
+							   _("Command canceled by user"));
+		}
+		else if (!context->answer)
+		{
+			err = g_error_new (ianjuta_builder_error_quark (),
+							   1,
+							   _("Command exited with status %d"), 1);
+		}
+		build_program_callback (context->program, G_OBJECT (context->plugin), context, err);
+		if (err != NULL) g_error_free (err);
+	}
+	if (!context->used) build_context_destroy_command (context);
+
+	return FALSE;
+}
+
 static void
 on_message_view_destroyed (BuildContext *context, GtkWidget *view)
 {
@@ -1307,6 +1359,41 @@ build_delayed_execute_command (IAnjutaFileSavable *savable, GFile *file, gpointe
 	}
 }
 
+/* Complete the command of the context as if it has been run, with success
+ * or with the exit status 1 */
+void
+build_answer_command_in_context (BuildContext* context, gboolean success)
+{
+	context->answer = success;
+	context->answer_canceled = FALSE;
+	context->answer_idle = g_idle_add (on_build_answered, context);
+}
+
+gboolean
+build_has_unsaved_files (BasicAutotoolsPlugin *plugin)
+{
+	IAnjutaDocumentManager *docman;
+	gboolean unsaved = FALSE;
+
+	docman = anjuta_shell_get_interface (ANJUTA_PLUGIN (plugin)->shell, IAnjutaDocumentManager, NULL);
+	if (docman != NULL)
+	{
+		GList *doc_list = ianjuta_document_manager_get_doc_widgets (docman, NULL);
+		GList *node;
+
+		for (node = g_list_first (doc_list); (node != NULL) && !unsaved; node = g_list_next (node))
+		{
+			if (IANJUTA_IS_FILE_SAVABLE (node->data))
+			{
+				unsaved = ianjuta_file_savable_is_dirty (IANJUTA_FILE_SAVABLE (node->data), NULL);
+			}
+		}
+		g_list_free (doc_list);
+	}
+
+	return unsaved;
+}
+
 gboolean
 build_save_and_execute_command_in_context (BuildContext* context, GError **err)
 {
@@ -1855,7 +1942,7 @@ update_module_ui (BasicAutotoolsPlugin *bb_plugin)
 			filename = escape_label (target);
 			g_free (target);
 		}
-		has_makefile = directory_has_makefile (mod) || directory_has_makefile_am (bb_plugin, mod);
+		has_makefile = directory_has_makefile (bb_plugin, mod) || directory_has_makefile_am (bb_plugin, mod);
 		g_object_unref (mod);
 
 		mod = build_object_from_file (bb_plugin, bb_plugin->current_editor_file);
@@ -1920,7 +2007,7 @@ update_fm_module_ui (BasicAutotoolsPlugin *bb_plugin)
 		mod = build_module_from_file (bb_plugin, bb_plugin->fm_current_file, NULL);
 		if (mod != NULL)
 		{
-			has_makefile = directory_has_makefile (mod) || directory_has_makefile_am (bb_plugin, mod);
+			has_makefile = directory_has_makefile (bb_plugin, mod) || directory_has_makefile_am (bb_plugin, mod);
 			g_object_unref (mod);
 		}
 
@@ -1979,7 +2066,7 @@ update_pm_module_ui (BasicAutotoolsPlugin *bb_plugin)
 		mod = build_module_from_file (bb_plugin, bb_plugin->pm_current_file, NULL);
 		if (mod != NULL)
 		{
-			has_makefile = directory_has_makefile (mod) || directory_has_makefile_am (bb_plugin, mod);
+			has_makefile = directory_has_makefile (bb_plugin, mod) || directory_has_makefile_am (bb_plugin, mod);
 			g_object_unref (mod);
 		}
 
@@ -2029,7 +2116,7 @@ update_project_ui (BasicAutotoolsPlugin *bb_plugin)
 	DEBUG_PRINT ("%s", "Updating project UI");
 
 	has_project = bb_plugin->project_root_dir != NULL;
-	has_makefile = has_project && (directory_has_makefile (bb_plugin->project_build_dir) || directory_has_makefile_am (bb_plugin, bb_plugin->project_build_dir));
+	has_makefile = has_project && (directory_has_makefile (bb_plugin, bb_plugin->project_build_dir) || directory_has_makefile_am (bb_plugin, bb_plugin->project_build_dir));
 
 	ui = anjuta_shell_get_ui (ANJUTA_PLUGIN (bb_plugin)->shell, NULL);
 	action = anjuta_ui_get_action (ui, "ActionGroupBuild",
@@ -2566,6 +2653,9 @@ dispose (GObject *obj)
 {
 	BasicAutotoolsPlugin *ba_plugin = ANJUTA_PLUGIN_BASIC_AUTOTOOLS (obj);
 
+	/* Do not answer commands of a plugin being destroyed */
+	g_list_foreach (ba_plugin->contexts_pool, (GFunc)build_context_remove_answer, NULL);
+
 	g_object_unref (ba_plugin->settings);
 
 	G_OBJECT_CLASS (parent_class)->dispose (obj);
@@ -2590,6 +2680,8 @@ finalize (GObject *obj)
 	if (ba_plugin->project_build_dir != NULL) g_object_unref (ba_plugin->project_build_dir);
 	g_free (ba_plugin->program_args);
 	build_configuration_list_free (ba_plugin->configurations);
+	build_deps_free (ba_plugin->deps);
+	build_topology_free (ba_plugin->topology);
 
 	ba_plugin->fm_current_file = NULL;
 	ba_plugin->pm_current_file = NULL;
@@ -2598,6 +2690,8 @@ finalize (GObject *obj)
 	ba_plugin->project_build_dir = NULL;
 	ba_plugin->program_args = NULL;
 	ba_plugin->configurations = NULL;
+	ba_plugin->deps = NULL;
+	ba_plugin->topology = NULL;
 
 	G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -2619,6 +2713,8 @@ basic_autotools_plugin_instance_init (GObject *obj)
 	ba_plugin->current_editor = NULL;
 	ba_plugin->contexts_pool = NULL;
 	ba_plugin->configurations = build_configuration_list_new ();
+	ba_plugin->deps = build_deps_new ();
+	ba_plugin->topology = build_topology_new ();
 	ba_plugin->program_args = NULL;
 	ba_plugin->run_in_terminal = TRUE;
 	ba_plugin->last_exec_uri = NULL;
@@ -26,6 +26,8 @@
 #include <libanjuta/interfaces/ianjuta-editor.h>
 
 #include "configuration-list.h"
+#include "build-deps.h"
+#include "build-topology.h"
 #include "program.h"
 
 #define BUILDER_FILE PACKAGE_DATA_DIR "/glade/anjuta-build-basic-autotools-plugin.ui"
@@ -73,6 +75,12 @@ struct _BasicAutotoolsPlugin{
 	
 	/* Build parameters */
 	BuildConfigurationList *configurations;
+
+	/* Cached dependencies of built targets */
+	BuildDeps *deps;
+
+	/* Cached layout of source and build directories */
+	BuildTopology *topology;
 	
 	/* Execution parameters */
 	gchar *program_args;
@@ -98,6 +106,8 @@ void build_context_destroy (BuildContext *context);
 void build_set_command_in_context (BuildContext* context, BuildProgram *prog);
 gboolean build_execute_command_in_context (BuildContext* context, GError **err);
 gboolean build_save_and_execute_command_in_context (BuildContext* context, GError **err);
+void build_answer_command_in_context (BuildContext* context, gboolean success);
+gboolean build_has_unsaved_files (BasicAutotoolsPlugin *plugin);
 const gchar *build_context_get_work_dir (BuildContext* context);
 AnjutaPlugin *build_context_get_plugin (BuildContext* context);
 
@@ -942,7 +942,12 @@ dma_queue_evaluate_variable (DmaDebuggerQueue *self, const gchar *name, IAnjutaD
 gboolean
 dma_queue_assign_variable (DmaDebuggerQueue *self, const gchar *name, const gchar *value)
 {
-	return dma_debugger_queue_append (self, dma_command_new (DMA_ASSIGN_VARIABLE_COMMAND, name, value));
+	if (!dma_debugger_queue_append (self, dma_command_new (DMA_ASSIGN_VARIABLE_COMMAND, name, value)))
+		return FALSE;
+
+	g_signal_emit_by_name (self, "memory-changed");
+
+	return TRUE;
 }
 
 gboolean
@@ -33,7 +33,9 @@ enum
 	DMA_DATA_BUFFER_PAGE_SIZE = 512,
 	DMA_DATA_BUFFER_LAST_LEVEL_SIZE = 8,
 	DMA_DATA_BUFFER_LEVEL_SIZE = 16,
-	DMA_DATA_BUFFER_LEVEL = 6
+	DMA_DATA_BUFFER_LEVEL = 6,
+	DMA_DATA_BUFFER_MAX_PAGE = 256,		/* Keep at most 128 KB of data */
+	DMA_DATA_BUFFER_READ_AHEAD = 4		/* Pages read in the scroll direction */
 };
 
 enum
@@ -52,6 +54,8 @@ struct _DmaDataBufferPage
 	gchar data[DMA_DATA_BUFFER_PAGE_SIZE];
 	gchar tag[DMA_DATA_BUFFER_PAGE_SIZE];
 	guint validation;
+	gulong address;
+	GList lru;
 };
 
 struct _DmaDataBufferNode
@@ -77,6 +81,13 @@ struct _DmaDataBuffer
 	
 	guint validation;
 	DmaDataBufferNode *top;
+
+	/* Pages, most recently used first */
+	GQueue pages;
+
+	/* Used to guess the scroll direction */
+	gulong last_lower;
+	gint direction;
 };
 
 struct _DmaDataBufferClass
@@ -209,6 +220,17 @@ dma_data_buffer_get_page (DmaDataBuffer *buffer, gulong address)
 }
 #endif
 
+static void
+dma_data_buffer_remove_page (DmaDataBuffer *buffer, DmaDataBufferPage *page)
+{
+	DmaDataBufferNode **node;
+
+	node = dma_data_buffer_find_node (buffer, page->address);
+	*node = NULL;
+	g_queue_unlink (&buffer->pages, &page->lru);
+	g_free (page);
+}
+
 static DmaDataBufferPage* 
 dma_data_buffer_add_page (DmaDataBuffer *buffer, gulong address)
 {
@@ -222,10 +244,24 @@ dma_data_buffer_add_page (DmaDataBuffer *buffer, gulong address)
 		*node = (DmaDataBufferNode *)g_new0 (DmaDataBufferPage, 1);
 		page = (DmaDataBufferPage *)*node;
 		page->validation = buffer->validation - 1;
+		page->address = address - (address % DMA_DATA_BUFFER_PAGE_SIZE);
+		page->lru.data = page;
+		g_queue_push_head_link (&buffer->pages, &page->lru);
+
+		/* Drop least recently used page if the buffer is full */
+		if (buffer->pages.length > DMA_DATA_BUFFER_MAX_PAGE)
+		{
+			dma_data_buffer_remove_page (buffer, (DmaDataBufferPage *)g_queue_peek_tail (&buffer->pages));
+		}
 	}
 	else
 	{
 		page = (DmaDataBufferPage *)*node;
+		if (buffer->pages.head != &page->lru)
+		{
+			g_queue_unlink (&buffer->pages, &page->lru);
+			g_queue_push_head_link (&buffer->pages, &page->lru);
+		}
 	}
 	
 	return page;
@@ -242,7 +278,7 @@ dma_data_buffer_read_page (DmaDataBuffer *buffer, gulong address)
 	{
 		if (page != NULL) page->validation = buffer->validation;
 		/* Data need to be refresh */
-		if (buffer->read != NULL);
+		if (buffer->read != NULL)
 			buffer->read (address - (address % DMA_DATA_BUFFER_PAGE_SIZE), DMA_DATA_BUFFER_PAGE_SIZE, buffer->user_data);
 		
 		return page;
@@ -252,6 +288,80 @@ dma_data_buffer_read_page (DmaDataBuffer *buffer, gulong address)
 	return page;
 }
 
+/* Request all pages needed to display the range from lower to lower + length
+ * and a few pages more in the scroll direction. Valid pages are kept, 
+ * contiguous invalid pages are read using a single request */
+static void
+dma_data_buffer_fetch (DmaDataBuffer *buffer, gulong lower, gulong length)
+{
+	gulong first;
+	gulong last;
+	gulong address;
+	gulong start;
+	gboolean missing;
+	gulong ahead;
+
+	if ((length == 0) || (buffer->read == NULL)) return;
+
+	if (lower > buffer->last_lower)
+	{
+		buffer->direction = 1;
+	}
+	else if (lower < buffer->last_lower)
+	{
+		buffer->direction = -1;
+	}
+	buffer->last_lower = lower;
+	
+	first = lower - (lower % DMA_DATA_BUFFER_PAGE_SIZE);
+	last = lower + length - 1;
+	if (last < lower) last = buffer->upper;
+	last -= last % DMA_DATA_BUFFER_PAGE_SIZE;
+	
+	if ((buffer->direction > 0) && (last < buffer->upper))
+	{
+		ahead = MIN (DMA_DATA_BUFFER_READ_AHEAD, (buffer->upper - last) / DMA_DATA_BUFFER_PAGE_SIZE);
+		last += ahead * DMA_DATA_BUFFER_PAGE_SIZE;
+	}
+	else if ((buffer->direction < 0) && (first > buffer->lower))
+	{
+		ahead = MIN (DMA_DATA_BUFFER_READ_AHEAD, (first - buffer->lower) / DMA_DATA_BUFFER_PAGE_SIZE);
+		first -= ahead * DMA_DATA_BUFFER_PAGE_SIZE;
+	}
+
+	/* Never request more than half of the buffer, else the visible pages
+	 * could be dropped */
+	if ((last - first) / DMA_DATA_BUFFER_PAGE_SIZE >= DMA_DATA_BUFFER_MAX_PAGE / 2)
+	{
+		last = first + (DMA_DATA_BUFFER_MAX_PAGE / 2 - 1) * DMA_DATA_BUFFER_PAGE_SIZE;
+	}
+
+	missing = FALSE;
+	start = first;
+	for (address = first;; address += DMA_DATA_BUFFER_PAGE_SIZE)
+	{
+		DmaDataBufferPage *page;
+
+		page = dma_data_buffer_add_page (buffer, address);
+		if (page->validation != buffer->validation)
+		{
+			page->validation = buffer->validation;
+			if (!missing) start = address;
+			missing = TRUE;
+		}
+		else if (missing)
+		{
+			buffer->read (start, address - start, buffer->user_data);
+			missing = FALSE;
+		}
+		if (address == last) break;
+	}
+	if (missing)
+	{
+		buffer->read (start, last - start + DMA_DATA_BUFFER_PAGE_SIZE, buffer->user_data);
+	}
+}
+
 static void
 dma_data_buffer_free_node (DmaDataBufferNode *node, gint level)
 {
@@ -291,6 +401,7 @@ dma_data_buffer_remove_all_page (DmaDataBuffer *buffer)
 		g_free (buffer->top);
 		buffer->top = NULL;
 	}
+	g_queue_init (&buffer->pages);
 }
 
 gulong
@@ -345,6 +456,8 @@ dma_data_buffer_get_data (DmaDataBuffer *buffer, gulong lower, guint length, gui
 	guint len;
 
 	line = (length + step - 1) / step;
+
+	dma_data_buffer_fetch (buffer, lower, (gulong)line * step);
 											  
 	switch (base & DMA_DATA_BASE)
 	{
@@ -479,6 +592,9 @@ dma_data_buffer_instance_init (DmaDataBuffer *this)
 	this->lower = 0;
 	this->upper = 0;
 	this->top = NULL;
+	g_queue_init (&this->pages);
+	this->last_lower = 0;
+	this->direction = 0;
 }
 
 /* class_init intialize the class itself not the instance */
@@ -102,10 +102,12 @@ struct _DmaVariableData {
 	gboolean deleted;	/* variable should be deleted */
 	
 	gboolean auto_update;
+	gboolean expanded;	/* Children are updated only when expanded */
 	
 	DmaVariablePacket* packet;
 		
 	gchar* name;
+	gchar* value;		/* Value from global update, not displayed yet */
 };
 
 /* Constant
@@ -133,6 +135,9 @@ static gchar *tree_title[] = {
 
 static GList* gTreeList = NULL;
 
+/* Variable data of all trees indexed by debugger object name */
+static GHashTable* gVariableIndex = NULL;
+
 /* Helper functions
  *---------------------------------------------------------------------------*/
 
@@ -177,16 +182,37 @@ get_current_iter (GtkTreeView *view, GtkTreeIter* iter)
 	return gtk_tree_selection_get_selected (selection, NULL, iter);
 }
 
+static void
+dma_variable_data_set_name (DmaVariableData *data, const gchar *name)
+{
+	if (data->name != NULL)
+	{
+		if ((gVariableIndex != NULL) && (g_hash_table_lookup (gVariableIndex, data->name) == data))
+		{
+			g_hash_table_remove (gVariableIndex, data->name);
+		}
+		g_free (data->name);
+		data->name = NULL;
+	}
+
+	if (name != NULL)
+	{
+		data->name = g_strdup (name);
+		if (gVariableIndex == NULL)
+		{
+			gVariableIndex = g_hash_table_new (g_str_hash, g_str_equal);
+		}
+		g_hash_table_replace (gVariableIndex, data->name, data);
+	}
+}
+
 static DmaVariableData *
 dma_variable_data_new(const gchar *const name, gboolean auto_update)
 {
 	DmaVariableData *data;
 		
 	data = g_new0 (DmaVariableData, 1);
-	if (name != NULL)
-	{
-		data->name = g_strdup (name);
-	}
+	dma_variable_data_set_name (data, name);
 
 	data->auto_update = auto_update;
 		
@@ -205,10 +231,8 @@ dma_variable_data_free(DmaVariableData * data)
 		pack->data= NULL;
 	}
 	
-	if (data->name != NULL)
-	{
-		g_free (data->name);
-	}
+	dma_variable_data_set_name (data, NULL);
+	g_free (data->value);
 	
 	g_free(data);
 }
@@ -559,7 +583,7 @@ gdb_var_create (IAnjutaDebuggerVariableObject *variable, gpointer user_data, GEr
 	
 	if ((variable->name != NULL) && (data->name == NULL))
 	{
-		data->name = strdup (variable->name);
+		dma_variable_data_set_name (data, variable->name);
 	}
 	data->changed = TRUE;
 	data->deleted = FALSE;
@@ -598,6 +622,8 @@ gdb_var_create (IAnjutaDebuggerVariableObject *variable, gpointer user_data, GEr
 
 /* ------------------------------------------------------------------ */
 
+static gboolean debug_tree_update_real (GtkTreeModel *model, DmaDebuggerQueue *debugger, GtkTreeIter* iter, gboolean force);
+
 static void
 on_treeview_row_expanded       (GtkTreeView     *treeview,
                                  GtkTreeIter     *iter,
@@ -618,12 +644,22 @@ on_treeview_row_expanded       (GtkTreeView     *treeview,
 			/* Expand variable node */
 			GtkTreeIter child;
 			
+			data->expanded = TRUE;
 			if (gtk_tree_model_iter_children (model, &child, iter))
 			{
 				DmaVariableData *child_data;
 				
 				gtk_tree_model_get (model, &child, DTREE_ENTRY_COLUMN, &child_data, -1);
-				if ((child_data == NULL) || (child_data->name == NULL))
+				if ((child_data != NULL) && (child_data->name != NULL))
+				{
+					/* Children already known, display pending changes */
+					do
+					{
+						debug_tree_update_real (model, tree->debugger, &child, FALSE);
+					}
+					while (gtk_tree_model_iter_next (model, &child));
+				}
+				else
 				{
 					/* Dummy children, get the real children */
 					DmaVariablePacket *pack;
@@ -670,6 +706,33 @@ on_treeview_row_expanded       (GtkTreeView     *treeview,
 	return;
 }
 
+static gboolean
+on_collapse_variable (GtkTreeModel *model,
+						GtkTreePath *path,
+						GtkTreeIter *iter,
+						gpointer user_data)
+{
+	DmaVariableData *data;
+
+	gtk_tree_model_get (model, iter, DTREE_ENTRY_COLUMN, &data, -1);
+	if (data != NULL) data->expanded = FALSE;
+	my_gtk_tree_model_foreach_child (model, iter, on_collapse_variable, NULL);
+
+	return FALSE;
+}
+
+static void
+on_treeview_row_collapsed       (GtkTreeView     *treeview,
+                                 GtkTreeIter     *iter,
+                                 GtkTreePath     *path,
+                                 gpointer         user_data)
+{
+	GtkTreeModel *const model = gtk_tree_view_get_model (treeview);
+
+	/* Hidden children are not expanded anymore */
+	on_collapse_variable (model, path, iter, NULL);
+}
+
 static void
 on_debug_tree_variable_changed (GtkCellRendererText *cell,
 						  gchar *path_string,
@@ -810,72 +873,6 @@ debug_tree_remove_all (DebugTree *tree)
 	debug_tree_remove_model (tree, model);
 }
 
-static gboolean
-debug_tree_find_name (const GtkTreeModel *model, GtkTreeIter *iter, const gchar *name)
-{
-	size_t len = 0;
-	GtkTreeIter parent_iter;
-	GtkTreeIter* parent = NULL;
-	
-	for (;;)
-	{
-		const gchar *ptr;
-		
-		/* Check if we look for a child variable */
-		ptr = strchr(name + len + 1, '.');
-		if (ptr != NULL)
-		{
-			/* Child variable */
-			gboolean search;
-			
-			len = ptr - name;
-			for (search = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), iter, parent);
-				search != FALSE;
-	    		search = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), iter))
-			{
-				DmaVariableData *iData;
-        		gtk_tree_model_get (GTK_TREE_MODEL (model), iter, DTREE_ENTRY_COLUMN, &iData, -1);
-			
-				if ((iData != NULL) && (iData->name != NULL) && (name[len] == '.') && (strncmp (name, iData->name, len) == 0))
-				{
-					break;
-				}
-			}
-			
-			if (search == TRUE)
-			{
-				parent_iter = *iter;
-				parent = &parent_iter;
-				continue;
-			}
-			else
-			{
-				return FALSE;
-			}
-		}
-		else
-		{
-			/* Variable without any child */
-			gboolean search;
-
-			for (search = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), iter, parent);
-				search != FALSE;
-				search = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), iter))
-			{
-				DmaVariableData *iData;
-				gtk_tree_model_get (GTK_TREE_MODEL (model), iter, DTREE_ENTRY_COLUMN, &iData, -1);
-			
-				if ((iData != NULL) && (iData->name != NULL) && (strcmp (name, iData->name) == 0))
-				{
-					return TRUE;
-				}
-			}
-			
-			return FALSE;
-		}
-	}
-}
-
 void
 debug_tree_replace_list (DebugTree *tree, const GList *expressions)
 {
@@ -1041,34 +1038,58 @@ on_debug_tree_changed (gpointer data, gpointer user_data)
 {
 	IAnjutaDebuggerVariableObject *var = (IAnjutaDebuggerVariableObject *)data;
 
-	if (var->name != NULL)
+	if ((var->name != NULL) && (gVariableIndex != NULL))
 	{
-		/* Search corresponding variable in one tree */
-		GList *tree;
-		
-		for (tree = g_list_first (gTreeList); tree != NULL; tree = g_list_next (tree))
+		/* Search corresponding variable in all trees */
+		DmaVariableData *data;
+
+		data = g_hash_table_lookup (gVariableIndex, var->name);
+		if (data != NULL)
 		{
-			GtkTreeIter iter;
-			GtkTreeModel *model;
-			
-			model =  GTK_TREE_MODEL (tree->data);
-			
-			if (debug_tree_find_name (model, &iter, var->name))
-			{
-				DmaVariableData *data;
-				gtk_tree_model_get (model, &iter, DTREE_ENTRY_COLUMN, &data, -1);
+			data->changed = var->changed;
+			data->exited = var->exited;
+			data->deleted = var->deleted;
+			g_free (data->value);
+			data->value = g_strdup (var->value);
+		}
+	}
+}
 
-				if (data != NULL)
-				{	
-					data->changed = var->changed;
-					data->exited = var->exited;
-					data->deleted = var->deleted;
-				}
-				
-				return;
-			}
+/* Update a row hidden in a collapsed parent without asking anything to the
+ * debugger, the values needing an evaluation are kept changed until the
+ * row is expanded. Return TRUE if the row or one of its children has
+ * changed */
+static gboolean
+debug_tree_update_hidden (GtkTreeModel *model, GtkTreeIter* iter)
+{
+	DmaVariableData *data = NULL;
+	GtkTreeIter child;
+	gboolean search;
+
+	gtk_tree_model_get (model, iter, DTREE_ENTRY_COLUMN, &data, -1);
+	if ((data == NULL) || (data->name == NULL)) return FALSE;
+
+	data->modified = (data->changed != FALSE);
+	if (data->changed && !data->deleted && (data->value != NULL))
+	{
+		/* Value already returned by the global update */
+		gtk_tree_store_set (GTK_TREE_STORE (model), iter, VALUE_COLUMN, data->value, -1);
+		g_free (data->value);
+		data->value = NULL;
+		data->changed = FALSE;
+	}
+
+	for (search = gtk_tree_model_iter_children(model, &child, iter);
+		search == TRUE;
+	    search = gtk_tree_model_iter_next (model, &child))
+	{
+		if (debug_tree_update_hidden (model, &child))
+		{
+			data->modified = TRUE;
 		}
 	}
+
+	return data->modified;
 }
 
 static gboolean
@@ -1087,8 +1108,7 @@ debug_tree_update_real (GtkTreeModel *model, DmaDebuggerQueue *debugger, GtkTree
 	{
 		/* Variable deleted (by example if type change), try to recreate it */
 		dma_queue_delete_variable (debugger, data->name);
-		g_free (data->name);
-		data->name = NULL;
+		dma_variable_data_set_name (data, NULL);
 	}
 	
 	if (data->name == NULL)
@@ -1114,14 +1134,24 @@ debug_tree_update_real (GtkTreeModel *model, DmaDebuggerQueue *debugger, GtkTree
 	}	
 	else if (force || (data->auto_update && data->changed))
 	{
-		DmaVariablePacket *pack = dma_variable_packet_new(model, iter, debugger, data, 0);
 		refresh = data->modified != (data->changed != FALSE);
 		data->modified = (data->changed != FALSE);
-		dma_queue_evaluate_variable (
-				debugger,
-				data->name,
-				(IAnjutaDebuggerCallback)gdb_var_evaluate_expression,
-				pack);
+		if (!force && (data->value != NULL))
+		{
+			/* Value already returned by the global update */
+			gtk_tree_store_set (GTK_TREE_STORE (model), iter, VALUE_COLUMN, data->value, -1);
+		}
+		else
+		{
+			DmaVariablePacket *pack = dma_variable_packet_new(model, iter, debugger, data, 0);
+			dma_queue_evaluate_variable (
+					debugger,
+					data->name,
+					(IAnjutaDebuggerCallback)gdb_var_evaluate_expression,
+					pack);
+		}
+		g_free (data->value);
+		data->value = NULL;
 		data->changed = FALSE;
 	}
 	else
@@ -1130,12 +1160,20 @@ debug_tree_update_real (GtkTreeModel *model, DmaDebuggerQueue *debugger, GtkTree
 		data->modified = FALSE;
 	}
 	
-	/* update children */
+	/* update children, the ones of collapsed rows are only evaluated when
+	 * they are expanded but still mark their parent as modified */
 	for (search = gtk_tree_model_iter_children(model, &child, iter);
 		search == TRUE;
 	    search = gtk_tree_model_iter_next (model, &child))
 	{
-		if (debug_tree_update_real (model, debugger, &child, force))
+		gboolean modified;
+
+		if (force || data->expanded)
+			modified = debug_tree_update_real (model, debugger, &child, force);
+		else
+			modified = debug_tree_update_hidden (model, &child);
+
+		if (modified)
 		{
 			refresh = data->modified == TRUE;
 			data->modified = TRUE;
@@ -1341,8 +1379,7 @@ on_disconnect_variable (GtkTreeModel *model,
 
 	if (data != NULL)
 	{
-		g_free (data->name);
-		data->name = NULL;
+		dma_variable_data_set_name (data, NULL);
 	}
 
 	return FALSE;
@@ -1543,6 +1580,7 @@ debug_tree_new_with_view (AnjutaPlugin *plugin, GtkTreeView *view)
 	
 	/* Connect signal */
     g_signal_connect(GTK_TREE_VIEW (tree->view), "row_expanded", G_CALLBACK (on_treeview_row_expanded), tree);
+    g_signal_connect(GTK_TREE_VIEW (tree->view), "row_collapsed", G_CALLBACK (on_treeview_row_collapsed), tree);
 	
 
 	return tree;
@@ -1572,6 +1610,8 @@ debug_tree_free (DebugTree * tree)
 	
 	g_signal_handlers_disconnect_by_func (GTK_TREE_VIEW (tree->view),
 				  G_CALLBACK (on_treeview_row_expanded), tree);
+	g_signal_handlers_disconnect_by_func (GTK_TREE_VIEW (tree->view),
+				  G_CALLBACK (on_treeview_row_collapsed), tree);
 	
 	gtk_widget_destroy (tree->view);
 	
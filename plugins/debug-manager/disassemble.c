@@ -419,6 +419,7 @@ on_disassemble (const IAnjutaDebuggerInstructionDisassembly *block, DmaSparseBuf
 		/* Create a dummy node */
 		len = (trans->length + DMA_DISASSEMBLY_DEFAULT_LINE_LENGTH - 1) / DMA_DISASSEMBLY_DEFAULT_LINE_LENGTH;
 		node = (DmaDisassemblyBufferNode *)g_malloc0 (sizeof(DmaDisassemblyBufferNode) + sizeof(DmaDisassemblyLine) * len);
+		node->parent.bytes = sizeof(DmaDisassemblyBufferNode) + sizeof(DmaDisassemblyLine) * len;
 		node->parent.lower = address;
 		for (i = 0; i < len; i++)
 		{
@@ -458,6 +459,7 @@ on_disassemble (const IAnjutaDebuggerInstructionDisassembly *block, DmaSparseBuf
 		}
 	
 		node = (DmaDisassemblyBufferNode *)g_malloc0 (sizeof(DmaDisassemblyBufferNode) + sizeof(DmaDisassemblyLine) * line + size);
+		node->parent.bytes = sizeof(DmaDisassemblyBufferNode) + sizeof(DmaDisassemblyLine) * line + size;
 	
 		/* Copy all data */
 		dst = (gchar *)&(node->data[line]);
@@ -127,6 +127,19 @@ on_program_stopped (DmaMemory *mem)
 	dma_memory_update (mem);
 }
 
+static void
+on_program_running (DmaMemory *mem)
+{
+	/* Memory could change, do not keep cached data */
+	dma_data_buffer_invalidate (mem->buffer);
+}
+
+static void
+on_memory_changed (DmaMemory *mem)
+{
+	dma_memory_update (mem);
+}
+
 static void
 destroy_memory_gui (DmaMemory *mem)
 {
@@ -157,6 +170,8 @@ on_debugger_stopped (DmaMemory *mem)
 	
 	g_signal_handlers_disconnect_by_func (mem->plugin, G_CALLBACK (on_debugger_stopped), mem);
 	g_signal_handlers_disconnect_by_func (mem->plugin, G_CALLBACK (on_program_stopped), mem);
+	g_signal_handlers_disconnect_by_func (mem->plugin, G_CALLBACK (on_program_running), mem);
+	g_signal_handlers_disconnect_by_func (mem->debugger, G_CALLBACK (on_memory_changed), mem);
 	
 	destroy_memory_gui (mem);
 }
@@ -198,6 +213,8 @@ on_debugger_started (DmaMemory *mem)
 	/* Connect signals */
 	g_signal_connect_swapped (mem->plugin, "debugger-stopped", G_CALLBACK (on_debugger_stopped), mem);
 	g_signal_connect_swapped (mem->plugin, "program-stopped", G_CALLBACK (on_program_stopped), mem);
+	g_signal_connect_swapped (mem->plugin, "program-running", G_CALLBACK (on_program_running), mem);
+	g_signal_connect_swapped (mem->debugger, "memory-changed", G_CALLBACK (on_memory_changed), mem);
 }
 
 /* Constructor & Destructor
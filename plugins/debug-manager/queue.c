@@ -932,6 +932,16 @@ dma_debugger_queue_class_init (DmaDebuggerQueueClass * klass)
 	
 	object_class->dispose = dma_debugger_queue_dispose;
 	object_class->finalize = dma_debugger_queue_finalize;
+
+	/* Emitted when a command modifying the program memory is queued */
+	g_signal_new ("memory-changed",
+	              G_OBJECT_CLASS_TYPE (object_class),
+	              G_SIGNAL_RUN_LAST,
+	              0,
+	              NULL, NULL,
+	              g_cclosure_marshal_VOID__VOID,
+	              G_TYPE_NONE,
+	              0);
 }
 
 GType
@@ -0,0 +1,142 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    sparse-buffer-benchmark.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/*
+ * Measure the time needed to insert blocks at scattered addresses in a
+ * DmaSparseBuffer and to look them up, like random jumps in the
+ * disassembly window.
+ *
+ * Usage: sparse-buffer-benchmark [blocks] [lookups]
+ */
+
+#include <stdlib.h>
+#include <glib.h>
+
+#include "sparse_buffer.h"
+
+#define BLOCK_SIZE 256
+#define CACHED_BLOCKS 1000
+
+static DmaSparseBufferNode *
+new_block (guint lower)
+{
+	DmaSparseBufferNode *node;
+
+	node = g_new0 (DmaSparseBufferNode, 1);
+	node->lower = lower;
+	node->upper = lower + BLOCK_SIZE - 1;
+	node->bytes = sizeof (DmaSparseBufferNode);
+
+	return node;
+}
+
+/* Return addresses of count blocks separated by a gap, in random order */
+static guint *
+shuffled_addresses (guint count)
+{
+	guint *address;
+	guint i;
+
+	address = g_new (guint, count);
+	for (i = 0; i < count; i++)
+	{
+		address[i] = i * BLOCK_SIZE * 2;
+	}
+	for (i = count - 1; i > 0; i--)
+	{
+		guint j = g_random_int_range (0, i + 1);
+		guint tmp = address[i];
+
+		address[i] = address[j];
+		address[j] = tmp;
+	}
+
+	return address;
+}
+
+int
+main (int argc, char **argv)
+{
+	DmaSparseBuffer *buffer;
+	GTimer *timer;
+	guint blocks = 20000;
+	guint lookups = 1000000;
+	guint *address;
+	guint i;
+	guint found = 0;
+
+	if (argc > 1) blocks = atoi (argv[1]);
+	if (argc > 2) lookups = atoi (argv[2]);
+	if (blocks == 0) return 1;
+
+	g_type_init ();
+	g_random_set_seed (42);
+
+	buffer = dma_sparse_buffer_new (0, G_MAXUINT);
+	dma_sparse_buffer_set_max_size (buffer, G_MAXSIZE);
+	address = shuffled_addresses (blocks);
+	timer = g_timer_new ();
+
+	/* Insert all blocks in random order */
+	g_timer_start (timer);
+	for (i = 0; i < blocks; i++)
+	{
+		dma_sparse_buffer_insert (buffer, new_block (address[i]));
+	}
+	g_print ("insert %u blocks: %.3f s\n", blocks, g_timer_elapsed (timer, NULL));
+
+	/* Look up scattered addresses, half of them are in gaps */
+	g_timer_start (timer);
+	for (i = 0; i < lookups; i++)
+	{
+		guint adr = g_random_int_range (0, blocks * BLOCK_SIZE * 2);
+		DmaSparseBufferNode *node;
+
+		node = dma_sparse_buffer_lookup (buffer, adr);
+		if ((node == NULL) || (node->lower > adr) ||
+		    ((node->next != NULL) && (node->next->lower <= adr)))
+		{
+			g_printerr ("wrong block for address %x\n", adr);
+			return 1;
+		}
+		if (adr <= node->upper) found++;
+	}
+	g_print ("%u scattered lookups (%u hits): %.3f s\n", lookups, found, g_timer_elapsed (timer, NULL));
+
+	/* Insert the same blocks again with a limited cache */
+	dma_sparse_buffer_remove_all (buffer);
+	dma_sparse_buffer_set_max_size (buffer, CACHED_BLOCKS * sizeof (DmaSparseBufferNode));
+	g_timer_start (timer);
+	for (i = 0; i < blocks; i++)
+	{
+		dma_sparse_buffer_insert (buffer, new_block (address[i]));
+	}
+	g_print ("insert %u blocks keeping %u: %.3f s\n", blocks, CACHED_BLOCKS, g_timer_elapsed (timer, NULL));
+	if (buffer->size > CACHED_BLOCKS * sizeof (DmaSparseBufferNode))
+	{
+		g_printerr ("cache limit not respected\n");
+		return 1;
+	}
+
+	g_timer_destroy (timer);
+	g_free (address);
+	dma_sparse_buffer_free (buffer);
+
+	return 0;
+}
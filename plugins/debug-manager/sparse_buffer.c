@@ -44,12 +44,17 @@
  *
  * The DmaSparseBuffer does not have any graphical knowledge, like which data
  * correspond to one line in the GtkTextBuffer.
+ *
+ * Blocks are kept in a list sorted by address and indexed by a balanced tree
+ * (a GSequence), so finding the block of any address is done in logarithmic
+ * time. When the memory used by all blocks is above a limit, the least
+ * recently viewed blocks are removed.
  *---------------------------------------------------------------------------*/
 
 enum
 {
-	DMA_SPARSE_BUFFER_NODE_SIZE = 512,
-	DMA_SPARSE_BUFFER_MAX_PAGE = 60,
+	DMA_SPARSE_BUFFER_NODE_SIZE = 512,		/* Default size of a block */
+	DMA_SPARSE_BUFFER_MAX_SIZE = 1024 * 1024,
 };
 
 static GObjectClass *parent_class = NULL;
@@ -68,6 +73,83 @@ static guint signals[LAST_SIGNAL] = {0};
 /* DmaBufferNode functions
  *---------------------------------------------------------------------------*/
 
+static gint
+dma_sparse_buffer_node_compare (gconstpointer a, gconstpointer b, gpointer user_data)
+{
+	guint lower_a = ((const DmaSparseBufferNode *)a)->lower;
+	guint lower_b = ((const DmaSparseBufferNode *)b)->lower;
+	
+	return lower_a < lower_b ? -1 : (lower_a > lower_b ? 1 : 0);
+}
+
+static gsize
+dma_sparse_buffer_node_size (const DmaSparseBufferNode *node)
+{
+	return node->bytes != 0 ? node->bytes : DMA_SPARSE_BUFFER_NODE_SIZE;
+}
+
+static void
+dma_sparse_buffer_cache_unlink (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
+{
+	if (node->cache.next != NULL)
+	{
+		node->cache.next->cache.prev = node->cache.prev;
+	}
+	else
+	{
+		buffer->cache.tail = node->cache.prev;
+	}
+	if (node->cache.prev != NULL)
+	{
+		node->cache.prev->cache.next = node->cache.next;
+	}
+	else
+	{
+		buffer->cache.head = node->cache.next;
+	}
+}
+
+static void
+dma_sparse_buffer_cache_prepend (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
+{
+	node->cache.prev = NULL;
+	node->cache.next = buffer->cache.head;
+	if (buffer->cache.head != NULL)
+	{
+		buffer->cache.head->cache.prev = node;
+	}
+	else
+	{
+		buffer->cache.tail = node;
+	}
+	buffer->cache.head = node;
+}
+
+/* Mark node as recently viewed */
+static void
+dma_sparse_buffer_touch (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
+{
+	if ((node != NULL) && (buffer->cache.head != node))
+	{
+		dma_sparse_buffer_cache_unlink (buffer, node);
+		dma_sparse_buffer_cache_prepend (buffer, node);
+	}
+}
+
+/* Remove least recently viewed nodes until the buffer fits in its limit,
+ * keep at least the node keep */
+static void
+dma_sparse_buffer_shrink (DmaSparseBuffer *buffer, DmaSparseBufferNode *keep)
+{
+	while ((buffer->size > buffer->max_size) &&
+	       (buffer->cache.tail != NULL) &&
+	       (buffer->cache.tail != keep))
+	{
+		DEBUG_PRINT ("drop block %x %x", buffer->cache.tail->lower, buffer->cache.tail->upper);
+		dma_sparse_buffer_remove (buffer, buffer->cache.tail);
+	}
+}
+
 /* Transport functions
  *---------------------------------------------------------------------------*/
 
@@ -112,61 +194,23 @@ dma_sparse_buffer_free_transport (DmaSparseBufferTransport *trans)
 /* Private functions
  *---------------------------------------------------------------------------*/
 
+/* Return the node containing the address or the nearest one before it */
 static DmaSparseBufferNode*
 dma_sparse_buffer_find (DmaSparseBuffer *buffer, guint address)
 {
-	DmaSparseBufferNode *node = NULL;
-	DmaSparseBufferNode *next;
+	DmaSparseBufferNode key;
+	GSequenceIter *pos;
 	
-	/* Look in last node */
-	if (buffer->cache.head != NULL)
+	/* Get first node starting after address */
+	key.lower = address;
+	pos = g_sequence_search (buffer->index, &key, dma_sparse_buffer_node_compare, NULL);
+	if (g_sequence_iter_is_begin (pos))
 	{
-		gint gap = buffer->cache.head->lower - address + DMA_SPARSE_BUFFER_NODE_SIZE * 4;
-		
-		if (gap < DMA_SPARSE_BUFFER_NODE_SIZE * 9)
-		{
-			/* node should be quite near */
-			node = buffer->cache.head;
-		}
-		else
-		{
-			node = buffer->head;
-		}
-	}
-	else
-	{
-		node = buffer->head;
-	}
-
-	for (;;)
-	{
-		if (node == NULL) break;
-		
-		if (node->lower > address)
-		{
-			/* Search backward */
-			node = node->prev;
-		}
-		else if (node->upper < address)
-		{
-			/* Search forward */
-			next = node->next;
-			
-			if ((next == NULL) || (next->lower > address))
-			{
-				/* Corresponding node doesn't exist */
-				break;
-			}
-			node = next;
-		}
-		else
-		{
-			/* Find current node */
-			break;
-		}
+		/* No node before address */
+		return NULL;
 	}
 	
-	return node;
+	return (DmaSparseBufferNode *)g_sequence_get (g_sequence_iter_prev (pos));
 }
 
 static void
@@ -189,6 +233,13 @@ dma_sparse_buffer_first (DmaSparseBuffer *buffer)
 	return buffer->head;
 }
 
+void
+dma_sparse_buffer_set_max_size (DmaSparseBuffer *buffer, gsize size)
+{
+	buffer->max_size = size;
+	dma_sparse_buffer_shrink (buffer, NULL);
+}
+
 void
 dma_sparse_buffer_insert (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
 {
@@ -235,15 +286,16 @@ dma_sparse_buffer_insert (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
 		/* node overlap, remove it */
 		dma_sparse_buffer_remove (buffer, node->next);
 	}
+
+	/* Add node in index */
+	node->position = g_sequence_insert_sorted (buffer->index, node, dma_sparse_buffer_node_compare, NULL);
+	buffer->size += dma_sparse_buffer_node_size (node);
 		
 	/* Insert node at the beginning of cache list */
-	node->cache.prev = NULL;
-	node->cache.next = buffer->cache.head;
-	if (buffer->cache.head != NULL)
-	{
-		buffer->cache.head->prev = node;
-	}
+	dma_sparse_buffer_cache_prepend (buffer, node);
 	buffer->stamp++;
+
+	dma_sparse_buffer_shrink (buffer, node);
 }
 
 void
@@ -263,23 +315,10 @@ dma_sparse_buffer_remove (DmaSparseBuffer *buffer, DmaSparseBufferNode *node)
 		buffer->head = node->next;
 	}
 	
-	/* Remove node from cache list */
-	if (node->cache.next != NULL)
-	{
-		node->cache.next->prev = node->cache.prev;
-	}
-	if (node->cache.prev != NULL)
-	{
-		node->cache.prev->next = node->cache.next;
-	}
-	if (buffer->cache.head == node)
-	{
-		buffer->cache.head = node->cache.next;
-	}
-	if (buffer->cache.tail == node)
-	{
-		buffer->cache.tail = node->cache.prev;
-	}
+	/* Remove node from index and cache list */
+	g_sequence_remove (node->position);
+	buffer->size -= dma_sparse_buffer_node_size (node);
+	dma_sparse_buffer_cache_unlink (buffer, node);
 
 	g_free (node);
 	
@@ -297,6 +336,9 @@ dma_sparse_buffer_remove_all (DmaSparseBuffer *buffer)
 		next = node->next;
 		g_free (node);
 	}
+	g_sequence_remove_range (g_sequence_get_begin_iter (buffer->index),
+	                         g_sequence_get_end_iter (buffer->index));
+	buffer->size = 0;
 	buffer->cache.head = NULL;
 	buffer->cache.tail = NULL;
 	buffer->head = NULL;
@@ -436,6 +478,7 @@ dma_sparse_buffer_get_iterator_at_address (DmaSparseBuffer *buffer, DmaSparseIte
 
 	iter->buffer = buffer;
 	iter->node = dma_sparse_buffer_find (buffer, address);
+	dma_sparse_buffer_touch (buffer, iter->node);
 	iter->base = address;
 	iter->offset = 0;
 	iter->stamp = buffer->stamp;
@@ -452,6 +495,7 @@ dma_sparse_buffer_get_iterator_near_address (DmaSparseBuffer *buffer, DmaSparseI
 	
 	iter->buffer = buffer;
 	iter->node = dma_sparse_buffer_find (buffer, address);
+	dma_sparse_buffer_touch (buffer, iter->node);
 	iter->base = address;
 	iter->offset = 1;
 	iter->line = 0;
@@ -484,6 +528,7 @@ dma_sparse_iter_refresh (DmaSparseIter *iter)
 	if (iter->buffer->stamp != iter->stamp)
 	{
 		iter->node = dma_sparse_buffer_find (iter->buffer, iter->base);
+		dma_sparse_buffer_touch (iter->buffer, iter->node);
 		iter->stamp = iter->buffer->stamp;
        	DMA_GET_SPARSE_BUFFER_CLASS (iter->buffer)->refresh_iter (iter);
 	}
@@ -537,6 +582,7 @@ dma_sparse_iter_insert_lines (DmaSparseIter *src, GtkTextIter *dst, guint count)
 	DmaSparseIter iter;
 	guint line = 0;
 	GtkTextBuffer *buffer;
+	DmaSparseBufferNode *node = NULL;
 	
 	buffer = gtk_text_iter_get_buffer (dst);
 
@@ -550,6 +596,12 @@ dma_sparse_iter_insert_lines (DmaSparseIter *src, GtkTextIter *dst, guint count)
 	/* Fill with data */
 	for (; line < count; line++)
 	{
+		if (iter.node != node)
+		{
+			/* Keep displayed nodes in cache */
+			node = iter.node;
+			dma_sparse_buffer_touch (iter.buffer, node);
+		}
 		dma_sparse_iter_insert_line (&iter, dst);
 		if (!dma_sparse_iter_forward_line (&iter))
 		{
@@ -605,6 +657,8 @@ dma_sparse_buffer_finalize (GObject *object)
 		g_hash_table_destroy (buffer->mark);
 		buffer->mark = NULL;
 	}
+
+	g_sequence_free (buffer->index);
 	
 	G_OBJECT_CLASS (parent_class)->finalize (object);
 }
@@ -621,6 +675,9 @@ dma_sparse_buffer_instance_init (DmaSparseBuffer *buffer)
 	buffer->cache.head = NULL;
 	buffer->cache.tail = NULL;
 	buffer->head = NULL;
+	buffer->index = g_sequence_new (NULL);
+	buffer->size = 0;
+	buffer->max_size = DMA_SPARSE_BUFFER_MAX_SIZE;
 	buffer->stamp = 0;
 	buffer->pending = NULL;
 	buffer->mark = NULL;
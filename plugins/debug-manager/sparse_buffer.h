@@ -47,6 +47,7 @@ void dma_sparse_buffer_remove (DmaSparseBuffer *buffer, DmaSparseBufferNode *nod
 void dma_sparse_buffer_remove_all (DmaSparseBuffer *buffer);
 DmaSparseBufferNode *dma_sparse_buffer_lookup (DmaSparseBuffer *self, guint address);
 DmaSparseBufferNode *dma_sparse_buffer_first (DmaSparseBuffer *self);
+void dma_sparse_buffer_set_max_size (DmaSparseBuffer *buffer, gsize size);
 
 guint dma_sparse_buffer_get_lower (const DmaSparseBuffer *buffer);
 guint dma_sparse_buffer_get_upper (const DmaSparseBuffer *buffer);
@@ -85,6 +86,9 @@ struct _DmaSparseBuffer
 		DmaSparseBufferNode *tail;
 	} cache;
 	DmaSparseBufferNode *head;
+	GSequence *index;	/* Nodes sorted by address */
+	gsize size;			/* Memory used by all nodes */
+	gsize max_size;
 	
 	gint stamp;
 	DmaSparseBufferTransport *pending;
@@ -116,8 +120,11 @@ struct _DmaSparseBufferNode
 	DmaSparseBufferNode *prev;
 	DmaSparseBufferNode *next;
 	
+	GSequenceIter *position;	/* Position in index */
+	
 	guint lower;		/* Lowest address of block */
 	guint upper;		/* Highest address in the block (avoid overflow) */
+	gsize bytes;		/* Allocated size, set by the caller */
 };
 
 struct _DmaSparseIter
@@ -59,12 +59,15 @@ struct _AnjutaDocmanPriv {
 	DocmanPlugin *plugin;
 	GSettings* settings;
 	GList *pages;		/* list of AnjutaDocmanPage's */
+	GHashTable *pages_by_file;	/* canonical file key -> GList of AnjutaDocmanPage */
 
 	GtkWidget *fileselection;
 
 	GtkWidget *popup_menu;	/* shared context-menu for main-notebook pages */
 	gboolean tab_pressed;	/* flag for deferred notebook page re-arrangement */
 	gboolean shutingdown;
+	gint switching_page;	/* depth of switch-page emissions */
+	AnjutaDocmanPage *loading_page;	/* placeholder being replaced */
 
 	GSList* radio_group;
 	GtkActionGroup *documents_action_group;
@@ -83,6 +86,14 @@ struct _AnjutaDocmanPage {
 	GtkWidget *label;
 	GtkWidget *menu_label;	/* notebook page-switch menu-label */
 	gboolean is_current;
+
+	/* Placeholder pages restored lazily from a session have no document
+	 * yet, only the file and cursor line to load when the page is shown */
+	GFile *pending_file;
+	gint pending_line;
+	guint pending_idle_id;
+
+	gchar *file_key;	/* key of the page in pages_by_file, NULL if none */
 };
 
 static guint docman_signals[LAST_SIGNAL] = { 0 };
@@ -102,6 +113,14 @@ anjuta_docman_get_nth_page (AnjutaDocman *docman, gint page_num);
 
 static AnjutaDocmanPage *
 anjuta_docman_get_current_page (AnjutaDocman *docman);
+static IAnjutaDocument *
+anjuta_docman_load_pending_page (AnjutaDocman *docman, AnjutaDocmanPage *page);
+static void
+anjuta_docman_remove_pending_page (AnjutaDocman *docman, AnjutaDocmanPage *page);
+static void
+anjuta_docman_index_page (AnjutaDocman *docman, AnjutaDocmanPage *page);
+static void
+anjuta_docman_unindex_page (AnjutaDocman *docman, AnjutaDocmanPage *page);
 
 static void
 on_document_toggled (GtkAction* action,
@@ -251,6 +270,12 @@ on_notebook_page_close_button_click (GtkButton* button,
 			page = (AnjutaDocmanPage *) node->data;
 			if (page->close_button == GTK_WIDGET (button))
 			{
+				if (page->doc == NULL)
+				{
+					/* No need to load a document only to close it */
+					anjuta_docman_remove_pending_page (docman, page);
+					return;
+				}
 				anjuta_docman_set_current_document (docman, page->doc);
 				break;
 			}
@@ -259,7 +284,9 @@ on_notebook_page_close_button_click (GtkButton* button,
 			return;
 	}
 
-	if (page != NULL)
+	if (page != NULL && page->doc == NULL)
+		anjuta_docman_remove_pending_page (docman, page);
+	else if (page != NULL)
 		on_close_file_activate (NULL, docman->priv->plugin);
 }
 
@@ -310,6 +337,11 @@ on_notebook_tab_btnrelease (GtkWidget *widget, GdkEventButton *event, AnjutaDocm
 			page = (AnjutaDocmanPage *) node->data;
 			if (page->box == widget)
 			{
+				if (page->doc == NULL)
+				{
+					anjuta_docman_remove_pending_page (docman, page);
+					return FALSE;
+				}
 				/* we've found the page that user wants to close. Save the current
 				 * page for a later setup
 				 */
@@ -433,9 +465,11 @@ anjuta_docman_page_init (AnjutaDocman *docman, IAnjutaDocument *doc,
 	gint h, w;
 	GdkColor color;
 	const gchar *filename;
+	gchar *basename = NULL;
 	gchar *ruri;
 
-	g_return_if_fail (IANJUTA_IS_DOCUMENT (doc));
+	g_return_if_fail (doc == NULL || IANJUTA_IS_DOCUMENT (doc));
+	g_return_if_fail (doc != NULL || file != NULL);
 
 	gtk_icon_size_lookup (GTK_ICON_SIZE_MENU, &w, &h);
 
@@ -453,7 +487,10 @@ anjuta_docman_page_init (AnjutaDocman *docman, IAnjutaDocument *doc,
 	gtk_widget_set_size_request (close_button, w, h);
 	gtk_widget_set_tooltip_text (close_button, _("Close file"));
 
-	filename = ianjuta_document_get_filename (doc, NULL);
+	if (doc != NULL)
+		filename = ianjuta_document_get_filename (doc, NULL);
+	else
+		filename = basename = g_file_get_basename (file);
 	label = gtk_label_new (filename);
 	gtk_misc_set_alignment (GTK_MISC (label), 0.0, 0.5);
 	gtk_widget_show (label);
@@ -461,6 +498,7 @@ anjuta_docman_page_init (AnjutaDocman *docman, IAnjutaDocument *doc,
 	menu_label = gtk_label_new (filename);
 	gtk_misc_set_alignment (GTK_MISC (menu_label), 0.0, 0.5);
 	gtk_widget_show (menu_label);
+	g_free (basename);
 	menu_box = gtk_box_new(GTK_ORIENTATION_HORIZONTAL, 2);
 
 	color.red = 0;
@@ -487,12 +525,16 @@ anjuta_docman_page_init (AnjutaDocman *docman, IAnjutaDocument *doc,
 	gtk_box_pack_start (GTK_BOX (menu_box), page->menu_icon, FALSE, FALSE, 0);
 	if (file != NULL)
 	{
-		GdkPixbuf* pixbuf = anjuta_docman_get_pixbuf_for_file (file);
-		if (pixbuf != NULL)
+		/* Querying the icon needs a file access, keep placeholders cheap */
+		if (doc != NULL)
 		{
-			gtk_image_set_from_pixbuf (GTK_IMAGE (page->menu_icon), pixbuf);
-			gtk_image_set_from_pixbuf (GTK_IMAGE (page->mime_icon), pixbuf);
-			g_object_unref (pixbuf);
+			GdkPixbuf* pixbuf = anjuta_docman_get_pixbuf_for_file (file);
+			if (pixbuf != NULL)
+			{
+				gtk_image_set_from_pixbuf (GTK_IMAGE (page->menu_icon), pixbuf);
+				gtk_image_set_from_pixbuf (GTK_IMAGE (page->mime_icon), pixbuf);
+				g_object_unref (pixbuf);
+			}
 		}
 		ruri = g_file_get_parse_name (file);
 		if (ruri != NULL)
@@ -544,7 +586,10 @@ anjuta_docman_page_init (AnjutaDocman *docman, IAnjutaDocument *doc,
 	                  G_CALLBACK (on_notebook_tab_double_click),
 	                  docman);
 
-	page->widget = GTK_WIDGET (doc);	/* this is the notebook-page child widget */
+	if (doc != NULL)
+		page->widget = GTK_WIDGET (doc);	/* this is the notebook-page child widget */
+	else
+		page->widget = gtk_label_new (_("Loading…"));
 	page->doc = doc;
 	page->box = box;
 	page->close_image = close_pixmap;
@@ -571,6 +616,13 @@ anjuta_docman_page_destroy (AnjutaDocmanPage *page)
 	/* Notebook holds a reference on the widget of page and destroys
 	 * them properly
 	 */
+	if (page == NULL)
+		return;
+	if (page->pending_idle_id != 0)
+		g_source_remove (page->pending_idle_id);
+	if (page->pending_file != NULL)
+		g_object_unref (page->pending_file);
+	g_free (page->file_key);
 	g_free (page);
 }
 
@@ -827,6 +879,17 @@ anjuta_docman_dispose (GObject *obj)
 		}
 		g_list_free (pages);
 	}
+	if (docman->priv->pages_by_file)
+	{
+		GHashTableIter iter;
+		gpointer pages;
+
+		g_hash_table_iter_init (&iter, docman->priv->pages_by_file);
+		while (g_hash_table_iter_next (&iter, NULL, &pages))
+			g_list_free ((GList *)pages);
+		g_hash_table_destroy (docman->priv->pages_by_file);
+		docman->priv->pages_by_file = NULL;
+	}
 	G_OBJECT_CLASS (parent_class)->dispose (obj);
 }
 
@@ -847,10 +910,30 @@ anjuta_docman_finalize (GObject *obj)
 	G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
 
+/* A placeholder cannot be replaced while the notebook is switching pages */
+static void
+on_notebook_switch_page_begin (GtkNotebook *notebook,
+							   GtkWidget *notebook_page,
+							   gint page_num, AnjutaDocman *docman)
+{
+	docman->priv->switching_page++;
+}
+
+static void
+on_notebook_switch_page_end (GtkNotebook *notebook,
+							 GtkWidget *notebook_page,
+							 gint page_num, AnjutaDocman *docman)
+{
+	docman->priv->switching_page--;
+}
+
 static void
 anjuta_docman_instance_init (AnjutaDocman *docman)
 {
 	docman->priv = g_new0 (AnjutaDocmanPriv, 1);
+	/* Several pages can have the same file, the lists are freed in dispose */
+	docman->priv->pages_by_file = g_hash_table_new_full (g_str_hash, g_str_equal,
+														 g_free, NULL);
 /*g_new0 NULL's all content
 	docman->priv->popup_menu = NULL;
 	docman->priv->popup_menu_det = NULL;
@@ -858,8 +941,12 @@ anjuta_docman_instance_init (AnjutaDocman *docman)
 */
 	gtk_notebook_popup_enable (GTK_NOTEBOOK (docman));
 	gtk_notebook_set_scrollable (GTK_NOTEBOOK (docman), TRUE);
+	g_signal_connect (G_OBJECT (docman), "switch-page",
+					  G_CALLBACK (on_notebook_switch_page_begin), docman);
 	g_signal_connect (G_OBJECT (docman), "switch-page",
 					  G_CALLBACK (on_notebook_switch_page), docman);
+	g_signal_connect_after (G_OBJECT (docman), "switch-page",
+							G_CALLBACK (on_notebook_switch_page_end), docman);
 	/* update pages-list after re-ordering (or deleting) */
 	g_signal_connect (G_OBJECT (docman), "page-reordered",
 						G_CALLBACK (on_notebook_page_reordered), docman);
@@ -938,6 +1025,24 @@ anjuta_docman_new (DocmanPlugin* plugin)
 /*! state flag for Ctrl-TAB */
 static gboolean g_tabbing = FALSE;
 
+static gboolean
+on_pending_page_idle (gpointer user_data)
+{
+	AnjutaDocmanPage *page = (AnjutaDocmanPage *)user_data;
+	AnjutaDocman *docman;
+	gint page_num;
+
+	page->pending_idle_id = 0;
+	docman = ANJUTA_DOCMAN (gtk_widget_get_parent (page->widget));
+
+	/* Do not load it if another page has been selected in the meantime */
+	page_num = gtk_notebook_page_num (GTK_NOTEBOOK (docman), page->widget);
+	if (page_num == gtk_notebook_get_current_page (GTK_NOTEBOOK (docman)))
+		anjuta_docman_load_pending_page (docman, page);
+
+	return FALSE;
+}
+
 static void
 on_notebook_switch_page (GtkNotebook *notebook,
 						 GtkWidget *notebook_page,
@@ -948,6 +1053,14 @@ on_notebook_switch_page (GtkNotebook *notebook,
 		AnjutaDocmanPage *page;
 
 		page = anjuta_docman_get_nth_page (docman, page_num);
+		if (page->doc == NULL)
+		{
+			/* A placeholder cannot be replaced while the notebook is
+			 * switching pages, load the document from an idle handler */
+			if (page->pending_idle_id == 0)
+				page->pending_idle_id = g_idle_add (on_pending_page_idle, page);
+			return;
+		}
 		g_signal_handlers_block_by_func (G_OBJECT (docman),
 										 (gpointer) on_notebook_switch_page,
 										 (gpointer) docman);
@@ -975,7 +1088,54 @@ static void
 on_document_update_save_ui (IAnjutaDocument *doc,
 						AnjutaDocman *docman)
 {
+	AnjutaDocmanPage *page;
+
 	anjuta_docman_update_page_label (docman, doc);
+
+	/* The file could have been renamed */
+	page = anjuta_docman_get_page_for_document (docman, doc);
+	if (page != NULL)
+		anjuta_docman_index_page (docman, page);
+}
+
+static void on_document_destroy (IAnjutaDocument *doc, AnjutaDocman *docman);
+
+/* The file of a document can change after a save as or when another file
+ * is opened in the same editor */
+static void
+on_document_saved (IAnjutaFileSavable *savable, GFile *file,
+				   AnjutaDocman *docman)
+{
+	AnjutaDocmanPage *page;
+
+	page = anjuta_docman_get_page_for_document (docman, IANJUTA_DOCUMENT (savable));
+	if (page != NULL)
+		anjuta_docman_index_page (docman, page);
+}
+
+static void
+on_document_opened (IAnjutaFile *ifile, AnjutaDocman *docman)
+{
+	AnjutaDocmanPage *page;
+
+	page = anjuta_docman_get_page_for_document (docman, IANJUTA_DOCUMENT (ifile));
+	if (page != NULL)
+		anjuta_docman_index_page (docman, page);
+}
+
+static void
+anjuta_docman_connect_document (AnjutaDocman *docman, IAnjutaDocument *doc)
+{
+	g_signal_connect (G_OBJECT (doc), "update-save-ui",
+					  G_CALLBACK (on_document_update_save_ui), docman);
+	g_signal_connect (G_OBJECT (doc), "destroy",
+					  G_CALLBACK (on_document_destroy), docman);
+	if (IANJUTA_IS_FILE_SAVABLE (doc))
+		g_signal_connect (G_OBJECT (doc), "saved",
+						  G_CALLBACK (on_document_saved), docman);
+	if (IANJUTA_IS_FILE (doc))
+		g_signal_connect (G_OBJECT (doc), "opened",
+						  G_CALLBACK (on_document_opened), docman);
 }
 
 static void
@@ -990,8 +1150,15 @@ on_document_destroy (IAnjutaDocument *doc, AnjutaDocman *docman)
 	g_signal_handlers_disconnect_by_func (G_OBJECT (doc),
 										  G_CALLBACK (on_document_destroy),
 										  docman);
+	g_signal_handlers_disconnect_by_func (G_OBJECT (doc),
+										  G_CALLBACK (on_document_saved),
+										  docman);
+	g_signal_handlers_disconnect_by_func (G_OBJECT (doc),
+										  G_CALLBACK (on_document_opened),
+										  docman);
 
 	page = anjuta_docman_get_page_for_document (docman, doc);
+	anjuta_docman_unindex_page (docman, page);
 	docman->priv->pages = g_list_remove (docman->priv->pages, page);
 
 	if (!docman->priv->shutingdown)
@@ -1056,10 +1223,8 @@ anjuta_docman_add_document (AnjutaDocman *docman, IAnjutaDocument *doc,
 	gtk_notebook_set_tab_reorderable (GTK_NOTEBOOK (docman), page->widget,
 									 TRUE);
 
-	g_signal_connect (G_OBJECT (doc), "update-save-ui",
-					  G_CALLBACK (on_document_update_save_ui), docman);
-	g_signal_connect (G_OBJECT (doc), "destroy",
-					  G_CALLBACK (on_document_destroy), docman);
+	anjuta_docman_connect_document (docman, doc);
+	anjuta_docman_index_page (docman, page);
 
 	g_object_ref (doc);
 
@@ -1069,6 +1234,181 @@ anjuta_docman_add_document (AnjutaDocman *docman, IAnjutaDocument *doc,
 	g_signal_emit_by_name (docman, "document-added", doc);
 }
 
+/**
+ * anjuta_docman_add_pending_document:
+ * @docman: pointer to docman data struct
+ * @file: file to open
+ * @line: line to go to once the file is loaded, -1 to keep the default
+ *
+ * Add a placeholder tab for @file without loading it. The editor is created
+ * only when the tab is shown or when the document is requested by
+ * anjuta_docman_get_document_for_file().
+ */
+void
+anjuta_docman_add_pending_document (AnjutaDocman *docman, GFile *file,
+									gint line)
+{
+	AnjutaDocmanPage *page;
+
+	g_return_if_fail (file != NULL);
+
+	page = anjuta_docman_page_new ();
+	anjuta_docman_page_init (docman, NULL, file, page);
+	page->pending_file = g_object_ref (file);
+	page->pending_line = line;
+	anjuta_docman_index_page (docman, page);
+
+	docman->priv->pages = g_list_prepend (docman->priv->pages, (gpointer)page);
+
+	gtk_notebook_prepend_page_menu (GTK_NOTEBOOK (docman), page->widget,
+									page->box, page->menu_box);
+	gtk_notebook_set_tab_reorderable (GTK_NOTEBOOK (docman), page->widget,
+									 TRUE);
+	anjuta_docman_update_documents_menu (docman);
+}
+
+static IAnjutaDocument *
+anjuta_docman_load_pending_page (AnjutaDocman *docman, AnjutaDocmanPage *page)
+{
+	GtkNotebook *notebook = GTK_NOTEBOOK (docman);
+	IAnjutaEditorFactory* factory;
+	IAnjutaEditor *te;
+	IAnjutaDocument *doc;
+	gint page_num;
+	gboolean is_current;
+
+	if (page->doc != NULL)
+		return page->doc;
+
+	if (page->pending_idle_id != 0)
+	{
+		g_source_remove (page->pending_idle_id);
+		page->pending_idle_id = 0;
+	}
+
+	factory = anjuta_shell_get_interface (docman->shell, IAnjutaEditorFactory, NULL);
+	docman->priv->loading_page = page;
+	te = ianjuta_editor_factory_new_editor (factory, page->pending_file, NULL, NULL);
+	docman->priv->loading_page = NULL;
+	if (te == NULL)
+	{
+		anjuta_docman_remove_pending_page (docman, page);
+		return NULL;
+	}
+	doc = IANJUTA_DOCUMENT (te);
+	if (IANJUTA_IS_EDITOR (te))
+		ianjuta_editor_set_popup_menu (te, docman->priv->popup_menu, NULL);
+
+	page_num = gtk_notebook_page_num (notebook, page->widget);
+	is_current = page_num == gtk_notebook_get_current_page (notebook);
+
+	/* Replace the placeholder by the editor, keeping the same tab widgets */
+	g_object_ref (page->box);
+	g_object_ref (page->menu_box);
+	g_signal_handlers_block_by_func (G_OBJECT (docman),
+									 (gpointer) on_notebook_switch_page,
+									 (gpointer) docman);
+	gtk_notebook_remove_page (notebook, page_num);
+	page->widget = GTK_WIDGET (doc);
+	page->doc = doc;
+	gtk_widget_show_all (page->widget);
+	gtk_notebook_insert_page_menu (notebook, page->widget,
+								   page->box, page->menu_box, page_num);
+	gtk_notebook_set_tab_reorderable (notebook, page->widget, TRUE);
+	if (is_current)
+		gtk_notebook_set_current_page (notebook, page_num);
+	g_signal_handlers_unblock_by_func (G_OBJECT (docman),
+									   (gpointer) on_notebook_switch_page,
+									   (gpointer) docman);
+	g_object_unref (page->box);
+	g_object_unref (page->menu_box);
+
+	anjuta_docman_connect_document (docman, doc);
+	g_object_ref (doc);
+
+	if ((page->pending_line >= 0) && IANJUTA_IS_EDITOR (doc))
+		ianjuta_editor_goto_line (te, page->pending_line, NULL);
+	g_object_unref (page->pending_file);
+	page->pending_file = NULL;
+
+	anjuta_docman_update_page_label (docman, doc);
+	g_signal_emit_by_name (docman, "document-added", doc);
+	if (is_current)
+		on_notebook_switch_page (notebook, page->widget, page_num, docman);
+
+	return doc;
+}
+
+static void
+anjuta_docman_remove_pending_page (AnjutaDocman *docman, AnjutaDocmanPage *page)
+{
+	anjuta_docman_unindex_page (docman, page);
+	docman->priv->pages = g_list_remove (docman->priv->pages, page);
+	gtk_widget_destroy (page->widget);
+	anjuta_docman_page_destroy (page);
+	anjuta_docman_update_documents_menu (docman);
+}
+
+/**
+ * anjuta_docman_get_session_uris:
+ * @docman: pointer to docman data struct
+ * @session: session being saved
+ * @uris: list of session uris
+ *
+ * Prepend the session uris of the editors and of the placeholder tabs which
+ * have not been loaded yet to @uris. Documents are added in front of the
+ * notebook when they are restored, so the uris are listed from the last tab
+ * to the first one to keep the tab order.
+ *
+ * Return value: the new start of the list
+ */
+GList *
+anjuta_docman_get_session_uris (AnjutaDocman *docman,
+								AnjutaSession *session,
+								GList *uris)
+{
+	GList *session_uris = NULL;
+	gint n_pages;
+	gint i;
+
+	n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (docman));
+	for (i = 0; i < n_pages; i++)
+	{
+		AnjutaDocmanPage *page = anjuta_docman_get_nth_page (docman, i);
+		GFile *file = NULL;
+		gchar *line_number = NULL;
+
+		if (page == NULL)
+			continue;
+
+		if (page->doc == NULL)
+		{
+			file = g_object_ref (page->pending_file);
+			if (page->pending_line >= 0)
+				line_number = g_strdup_printf ("%d", page->pending_line);
+		}
+		else if (IANJUTA_IS_EDITOR (page->doc))
+		{
+			/* only editor-documents are logged here. glade files etc handled elsewhere */
+			file = ianjuta_file_get_file (IANJUTA_FILE (page->doc), NULL);
+			line_number = g_strdup_printf ("%d",
+										   ianjuta_editor_get_lineno (IANJUTA_EDITOR (page->doc), NULL));
+		}
+
+		if (file != NULL)
+		{
+			session_uris = g_list_prepend (session_uris,
+										   anjuta_session_get_relative_uri_from_file (session,
+																					  file,
+																					  line_number));
+			g_object_unref (file);
+		}
+		g_free (line_number);
+	}
+
+	return g_list_concat (session_uris, uris);
+}
+
 void
 anjuta_docman_remove_document (AnjutaDocman *docman, IAnjutaDocument *doc)
 {
@@ -1083,9 +1423,11 @@ anjuta_docman_remove_document (AnjutaDocman *docman, IAnjutaDocument *doc)
 	page = anjuta_docman_get_page_for_document (docman, doc);
 	if (page)
 	{
+		anjuta_docman_unindex_page (docman, page);
 		docman->priv->pages = g_list_remove (docman->priv->pages, (gpointer)page);
 		if (!g_list_length (docman->priv->pages))
 				g_signal_emit (G_OBJECT (docman), docman_signals[DOC_CHANGED], 0, NULL);
+		g_free (page->file_key);
 		g_free (page);
 	}
 	gtk_widget_destroy(GTK_WIDGET(doc));
@@ -1170,14 +1512,28 @@ anjuta_docman_get_current_page (AnjutaDocman* docman)
 	return page;
 }
 
+/**
+ * anjuta_docman_get_current_document:
+ * @docman: pointer to docman data struct
+ *
+ * A placeholder tab is replaced by its editor first. It is not possible
+ * while the notebook is switching pages or while the editor is created, NULL
+ * is returned in this case.
+ *
+ * Return value: the document of the current page or NULL
+ */
 IAnjutaDocument *
 anjuta_docman_get_current_document (AnjutaDocman *docman)
 {
 	AnjutaDocmanPage* page = anjuta_docman_get_current_page (docman);
-	if (page)
-		return page->doc;
-	else
+	if (page == NULL)
 		return NULL;
+
+	if ((page->doc == NULL) && (docman->priv->switching_page == 0)
+		&& (docman->priv->loading_page != page))
+		return anjuta_docman_load_pending_page (docman, page);
+
+	return page->doc;
 }
 
 void
@@ -1373,7 +1729,19 @@ anjuta_docman_get_file (AnjutaDocman *docman, const gchar *fn)
 		AnjutaDocmanPage *page;
 
 		page = (AnjutaDocmanPage *) node->data;
-		if (strcmp (fname, ianjuta_document_get_filename (page->doc, NULL)) == 0)
+		if (page->doc == NULL)
+		{
+			gchar *pending_name = g_file_get_basename (page->pending_file);
+			gboolean found = strcmp (fname, pending_name) == 0;
+
+			g_free (pending_name);
+			if (found)
+			{
+				g_free (fname);
+				return g_object_ref (page->pending_file);
+			}
+		}
+		else if (strcmp (fname, ianjuta_document_get_filename (page->doc, NULL)) == 0)
 		{
 			g_free (fname);
 			return ianjuta_file_get_file (IANJUTA_FILE (page->doc), NULL);
@@ -1610,7 +1978,10 @@ anjuta_docman_order_tabs (AnjutaDocman *docman)
 		{
 			page = node->data;
 			tab_labels[i].m_widget = page->widget; /* CHECKME needed ? */
-			tab_labels[i].m_label = ianjuta_document_get_filename (page->doc, NULL);
+			if (page->doc != NULL)
+				tab_labels[i].m_label = ianjuta_document_get_filename (page->doc, NULL);
+			else
+				tab_labels[i].m_label = gtk_label_get_text (GTK_LABEL (page->label));
 			node = g_list_next (node);
 		}
 	}
@@ -1627,87 +1998,104 @@ anjuta_docman_order_tabs (AnjutaDocman *docman)
 	anjuta_docman_update_documents_menu(docman);
 }
 
+/* Return a string identifying the file, using the real path for local files
+ * so symbolic links or relative components give the same key */
+static gchar *
+anjuta_docman_get_file_key (GFile *file)
+{
+	gchar *path;
+
+	path = g_file_get_path (file);
+	if (path != NULL)
+	{
+		gchar *real_path = anjuta_util_get_real_path (path);
+
+		if (real_path != NULL)
+		{
+			g_free (path);
+			path = real_path;
+		}
+		return path;
+	}
+	else
+	{
+		return g_file_get_uri (file);
+	}
+}
+
+static void
+anjuta_docman_unindex_page (AnjutaDocman *docman, AnjutaDocmanPage *page)
+{
+	GList *pages;
+
+	if ((page == NULL) || (page->file_key == NULL)
+		|| (docman->priv->pages_by_file == NULL))
+		return;
+
+	/* Keep the other pages having the same file */
+	pages = g_hash_table_lookup (docman->priv->pages_by_file, page->file_key);
+	pages = g_list_remove (pages, page);
+	if (pages == NULL)
+		g_hash_table_remove (docman->priv->pages_by_file, page->file_key);
+	else
+		g_hash_table_insert (docman->priv->pages_by_file,
+							 g_strdup (page->file_key), pages);
+	g_free (page->file_key);
+	page->file_key = NULL;
+}
+
+static void
+anjuta_docman_index_page (AnjutaDocman *docman, AnjutaDocmanPage *page)
+{
+	GFile *file = NULL;
+
+	anjuta_docman_unindex_page (docman, page);
+
+	if (page->doc == NULL)
+		file = g_object_ref (page->pending_file);
+	else if (IANJUTA_IS_FILE (page->doc))
+		file = ianjuta_file_get_file (IANJUTA_FILE (page->doc), NULL);
+
+	if (file != NULL)
+	{
+		GList *pages;
+
+		page->file_key = anjuta_docman_get_file_key (file);
+		pages = g_hash_table_lookup (docman->priv->pages_by_file, page->file_key);
+		pages = g_list_append (pages, page);
+		g_hash_table_insert (docman->priv->pages_by_file,
+							 g_strdup (page->file_key), pages);
+		g_object_unref (file);
+	}
+}
+
 IAnjutaDocument *
 anjuta_docman_get_document_for_file (AnjutaDocman *docman, GFile* file)
 {
-	IAnjutaDocument *file_doc = NULL;
+	GList *pages;
 	GList *node;
+	gchar *key;
 
 	g_return_val_if_fail (file != NULL, NULL);
 
-	for (node = docman->priv->pages; node != NULL; node = g_list_next (node))
-	{
-		AnjutaDocmanPage *page;
-		GFile* doc_file;
-
-		page = (AnjutaDocmanPage *) node->data;
+	key = anjuta_docman_get_file_key (file);
+	pages = g_hash_table_lookup (docman->priv->pages_by_file, key);
+	g_free (key);
 
-		if (page && page->widget && IANJUTA_IS_DOCUMENT (page->doc))
-		{
-			IAnjutaDocument *doc;
+	if (pages == NULL)
+		return NULL;
 
-			doc = page->doc;
-			doc_file = ianjuta_file_get_file (IANJUTA_FILE (doc), NULL);
-			if (doc_file)
-			{
-				gchar *path;
-				gchar *local_real_path = NULL;
-				
-				/* Try exact match first */
-				if (g_file_equal (file, doc_file))
-				{
-					g_object_unref (doc_file);
-					file_doc = doc;
-					break;
-				}
+	/* Prefer a loaded document */
+	for (node = pages; node != NULL; node = g_list_next (node))
+	{
+		AnjutaDocmanPage *page = (AnjutaDocmanPage *) node->data;
 
-				/* Try a local file alias */
-				path = g_file_get_path (file);
-				if (path)
-				{
-					local_real_path = anjuta_util_get_real_path (path);
-					if (local_real_path)
-					{
-						g_free (path);
-					}
-					else
-					{
-						local_real_path = path;
-					}
-				}
-				else
-				{
-					continue;
-				}
-				
-				if ((file_doc == NULL) && (local_real_path))
-				{
-					gchar *doc_path = g_file_get_path (doc_file);
-					if (doc_path)
-					{
-						gchar *doc_real_path = anjuta_util_get_real_path (doc_path);
-						if (doc_real_path)
-						{
-							g_free (doc_path);
-						}
-						else
-						{
-							doc_real_path = doc_path;
-						}
-						if ((strcmp (doc_real_path, local_real_path) == 0))
-						{
-							file_doc = doc;
-						}
-						g_free (doc_real_path);
-					}
-				}
-				g_free (local_real_path);
-				g_object_unref (doc_file);
-			}
-		}
+		if (page->doc != NULL)
+			return page->doc;
 	}
 
-	return file_doc;
+	/* Load the placeholder of a lazily restored file if needed */
+	return anjuta_docman_load_pending_page (docman, (AnjutaDocmanPage *) pages->data);
 }
 
 GList*
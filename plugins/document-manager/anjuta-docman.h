@@ -64,6 +64,12 @@ IAnjutaEditor *anjuta_docman_add_editor (AnjutaDocman *docman, GFile* file,
 void anjuta_docman_add_document (AnjutaDocman *docman, IAnjutaDocument *doc,
 								 GFile* file);
 
+void anjuta_docman_add_pending_document (AnjutaDocman *docman, GFile *file,
+										 gint line);
+GList *anjuta_docman_get_session_uris (AnjutaDocman *docman,
+									   AnjutaSession *session,
+									   GList *uris);
+
 void anjuta_docman_remove_document (AnjutaDocman *docman, IAnjutaDocument *doc);
 
 IAnjutaDocument *anjuta_docman_get_current_document (AnjutaDocman *docman);
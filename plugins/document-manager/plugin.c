@@ -19,6 +19,7 @@
 */
 
 #include <config.h>
+#include <stdlib.h>
 #include <libanjuta/anjuta-shell.h>
 #include <libanjuta/anjuta-debug.h>
 #include <libanjuta/anjuta-encodings.h>
@@ -1350,6 +1351,7 @@ on_window_key_press_event (AnjutaShell *shell,
 #define EDITOR_TABS_ORDERING       "docman-tabs-ordering"
 #define AUTOSAVE_TIMER             "docman-autosave-timer"
 #define SAVE_AUTOMATIC             "docman-automatic-save"
+#define LAZY_RESTORE               "docman-lazy-restore"
 
 static gboolean
 on_window_key_release_event (AnjutaShell *shell,
@@ -1381,10 +1383,100 @@ on_window_key_release_event (AnjutaShell *shell,
 	return FALSE;
 }
 
+/* Only plain text files are restored lazily, other files could be handled
+ * by another plugin than the document manager. The content type is guessed
+ * from the file name only to avoid reading the file. */
+static gboolean
+is_lazy_restorable_file (GFile *file)
+{
+	gchar *basename;
+	gchar *content_type;
+	gchar *mime_type;
+	gboolean uncertain;
+	gboolean restorable = FALSE;
+
+	basename = g_file_get_basename (file);
+	content_type = g_content_type_guess (basename, NULL, 0, &uncertain);
+	mime_type = g_content_type_get_mime_type (content_type);
+	if (!uncertain && (mime_type != NULL))
+		restorable = g_str_has_prefix (mime_type, "text/");
+	g_free (mime_type);
+	g_free (content_type);
+	g_free (basename);
+
+	return restorable;
+}
+
+/* Create placeholder tabs for the text files of the session and remove them
+ * from the list of files opened by the file loader plugin */
+static void
+restore_session_files_lazily (DocmanPlugin *plugin, AnjutaSession *session)
+{
+	GList *files, *node;
+	GList *remaining = NULL;
+	GTimer *timer;
+	gint count = 0;
+
+	files = anjuta_session_get_string_list (session, "File Loader", "Files");
+	if (!files)
+		return;
+
+	timer = g_timer_new ();
+	for (node = g_list_first (files); node != NULL; node = g_list_next (node))
+	{
+		gchar *uri = node->data;
+		const gchar *fragment = NULL;
+		GFile *file;
+
+		if (uri == NULL)
+			continue;
+
+		if (anjuta_util_is_project_file (uri))
+		{
+			remaining = g_list_prepend (remaining, uri);
+			continue;
+		}
+
+		file = anjuta_session_get_file_from_relative_uri (session, uri, &fragment);
+		if (is_lazy_restorable_file (file))
+		{
+			anjuta_docman_add_pending_document (ANJUTA_DOCMAN (plugin->docman),
+												file,
+												fragment != NULL ? atoi (fragment) : -1);
+			count++;
+			g_free (uri);
+		}
+		else
+		{
+			remaining = g_list_prepend (remaining, uri);
+		}
+		g_object_unref (file);
+	}
+	g_list_free (files);
+
+	remaining = g_list_reverse (remaining);
+	anjuta_session_set_string_list (session, "File Loader", "Files", remaining);
+	g_list_foreach (remaining, (GFunc)g_free, NULL);
+	g_list_free (remaining);
+
+	DEBUG_PRINT ("Session: %d files restored lazily in %g s",
+				 count, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
+}
+
 static void
 on_session_load (AnjutaShell *shell, AnjutaSessionPhase phase,
 				 AnjutaSession *session, DocmanPlugin *plugin)
 {
+	/* Run before the file loader plugin which opens the files in the
+	 * first phase */
+	if (phase == ANJUTA_SESSION_PHASE_START)
+	{
+		if (g_settings_get_boolean (plugin->settings, LAZY_RESTORE))
+			restore_session_files_lazily (plugin, session);
+		return;
+	}
+
 	if (phase != ANJUTA_SESSION_PHASE_NORMAL)
 		return;
 
@@ -1396,39 +1488,15 @@ static void
 on_session_save (AnjutaShell *shell, AnjutaSessionPhase phase,
 				 AnjutaSession *session, DocmanPlugin *plugin)
 {
-	GList *docwids, *node, *files;
+	GList *files;
 
 	if (phase != ANJUTA_SESSION_PHASE_NORMAL)
 		return;
 
 	files = anjuta_session_get_string_list (session, "File Loader", "Files"); /* probably NULL */
-	/* buffers list is ordered last-opened to first-opened */
-	docwids = anjuta_docman_get_all_doc_widgets (ANJUTA_DOCMAN (plugin->docman));
-	if (docwids)
-	{
-		for (node = docwids; node != NULL; node = g_list_next (node))
-		{
-			/* only editor-documents are logged here. glade files etc handled elsewhere */
-			if (IANJUTA_IS_EDITOR (node->data))
-			{
-				IAnjutaEditor *te;
-				GFile* file;
-
-				te = IANJUTA_EDITOR (node->data);
-				file = ianjuta_file_get_file (IANJUTA_FILE (te), NULL);
-				if (file)
-				{
-					/* Save line locations also */
-					gchar *line_number;
-
-					line_number = g_strdup_printf ("%d", ianjuta_editor_get_lineno (te, NULL));
-					files = g_list_prepend (files, anjuta_session_get_relative_uri_from_file (session, file, line_number));
-					g_free (line_number);
-				}
-			}
-		}
-		g_list_free (docwids);
-	}
+	/* Editors and files restored lazily and not shown yet, in tab order */
+	files = anjuta_docman_get_session_uris (ANJUTA_DOCMAN (plugin->docman),
+											session, files);
 	if (files)
 	{
 		anjuta_session_set_string_list (session, "File Loader", "Files", files);
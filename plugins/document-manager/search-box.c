@@ -43,6 +43,16 @@
 #define LINE_ENTRY_WIDTH 7
 #define SEARCH_ENTRY_WIDTH 45
 
+/* Number of compiled regular expressions kept */
+#define REGEX_CACHE_SIZE 16
+
+/* Number of characters fetched from the editor at once when searching a
+ * regular expression */
+#define REGEX_CHUNK_SIZE 65536
+/* Number of characters fetched after the chunk when searching backward, it
+ * is doubled as long as a match could end after it */
+#define REGEX_CHUNK_OVERLAP 1024
+
 struct _SearchBoxPrivate
 {
 	GtkWidget* grid;
@@ -75,7 +85,17 @@ struct _SearchBoxPrivate
 	gboolean regex_mode;
 	
 	gboolean highlight_complete;
-	
+
+	/* Regular expression search */
+	GHashTable* regex_cache;
+	GRegex* regex;
+	gchar* regex_pattern;
+	IAnjutaEditor* regex_editor;
+	gulong regex_changed_id;
+	gint regex_origin;
+	gint regex_position;
+	gboolean regex_wrapped;
+	guint regex_idle;
 };
 
 #ifdef GET_PRIVATE
@@ -86,6 +106,8 @@ struct _SearchBoxPrivate
 
 G_DEFINE_TYPE (SearchBox, search_box, GTK_TYPE_HBOX);
 
+static void search_box_regex_search_reset (SearchBox* search_box);
+
 static void
 on_search_box_hide (GtkWidget* button, SearchBox* search_box)
 {
@@ -105,6 +127,7 @@ on_document_changed (AnjutaDocman* docman, IAnjutaDocument* doc,
 	{
 		search_box->priv->current_editor = IANJUTA_EDITOR (doc);
 	}
+	search_box_regex_search_reset (search_box);
 }
 
 static void
@@ -238,21 +261,412 @@ on_search_focus_out (GtkWidget* widget, GdkEvent* event, SearchBox* search_box)
 
 
 static gboolean
-incremental_regex_search (const gchar* search_entry, const gchar* editor_text, gint * start_pos, gint * end_pos, gboolean search_forward)
+regex_is_literal (const gchar* pattern)
+{
+	gchar* escaped = g_regex_escape_string (pattern, -1);
+	gboolean literal = strcmp (escaped, pattern) == 0;
+
+	g_free (escaped);
+
+	return literal;
+}
+
+/* Compiled patterns are kept, so searching again or typing back a previous
+ * pattern doesn't compile it again */
+static GRegex*
+search_box_get_regex (SearchBox* search_box, const gchar* pattern)
+{
+	GRegex* regex;
+	GError* err = NULL;
+
+	regex = g_hash_table_lookup (search_box->priv->regex_cache, pattern);
+	if (regex == NULL)
+	{
+		regex = g_regex_new (pattern, G_REGEX_OPTIMIZE, 0, &err);
+		if (err)
+		{
+			DEBUG_PRINT ("%s", err->message);
+			g_error_free (err);
+			return NULL;
+		}
+
+		if (g_hash_table_size (search_box->priv->regex_cache) >= REGEX_CACHE_SIZE)
+			g_hash_table_remove_all (search_box->priv->regex_cache);
+		g_hash_table_insert (search_box->priv->regex_cache, g_strdup (pattern), regex);
+	}
+
+	return regex;
+}
+
+static gint
+search_box_get_length (SearchBox* search_box)
+{
+	IAnjutaIterable* end;
+	gint length;
+
+	end = ianjuta_editor_get_end_position (search_box->priv->current_editor, NULL);
+	length = ianjuta_iterable_get_position (end, NULL);
+	g_object_unref (end);
+
+	return length;
+}
+
+static gchar*
+search_box_get_text (SearchBox* search_box, gint start, gint end)
+{
+	IAnjutaIterable* start_iter;
+	IAnjutaIterable* end_iter;
+	gchar* text;
+
+	start_iter = ianjuta_editor_get_start_position (search_box->priv->current_editor, NULL);
+	end_iter = ianjuta_iterable_clone (start_iter, NULL);
+	ianjuta_iterable_set_position (start_iter, start, NULL);
+	ianjuta_iterable_set_position (end_iter, end, NULL);
+
+	text = ianjuta_editor_get_text (search_box->priv->current_editor,
+	                                start_iter, end_iter, NULL);
+	g_object_unref (start_iter);
+	g_object_unref (end_iter);
+
+	return text != NULL ? text : g_strdup ("");
+}
+
+/* Search forward for the first match from position, fetching only a chunk of
+ * text. If nothing is found, position is moved to the end of the chunk */
+static gboolean
+search_box_regex_search_chunk (SearchBox* search_box, GRegex* regex,
+                               gint* position, gint end, gboolean at_start,
+                               gint* match_start, gint* match_end)
+{
+	gint size = REGEX_CHUNK_SIZE;
+
+	for (;;)
+	{
+		GRegexMatchFlags flags = G_REGEX_MATCH_PARTIAL;
+		GMatchInfo* match_info;
+		gint chunk_end = MIN (end, *position + size);
+		gint start_pos, end_pos;
+		gboolean found;
+		gboolean complete;
+		gchar* text;
+
+		/* ^ and $ match only at the start and the end of the searched range */
+		if (!at_start)
+			flags |= G_REGEX_MATCH_NOTBOL;
+		if (chunk_end < end)
+			flags |= G_REGEX_MATCH_NOTEOL;
+
+		text = search_box_get_text (search_box, *position, chunk_end);
+		found = g_regex_match (regex, text, flags, &match_info);
+		if (found)
+		{
+			/* A match reaching the end of the chunk could be longer */
+			g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+			complete = (text[end_pos] != '\0') || (chunk_end == end);
+			if (complete)
+			{
+				*match_start = *position + g_utf8_pointer_to_offset (text, &text[start_pos]);
+				*match_end = *position + g_utf8_pointer_to_offset (text, &text[end_pos]);
+			}
+		}
+		else
+		{
+			/* A match could start in this chunk and end in the next one */
+			complete = !g_match_info_is_partial_match (match_info) || (chunk_end == end);
+			if (complete)
+				*position = chunk_end;
+		}
+		g_match_info_free (match_info);
+		g_free (text);
+
+		if (complete)
+			return found;
+
+		size *= 2;
+	}
+}
+
+/* Search backward for the last match before position, fetching only a chunk
+ * of text. If nothing is found, position is moved to the start of the chunk */
+static gboolean
+search_box_regex_search_chunk_backward (SearchBox* search_box, GRegex* regex,
+                                        gint start, gint* position, gint end,
+                                        gint* match_start, gint* match_end)
+{
+	gint chunk_start = MAX (start, *position - REGEX_CHUNK_SIZE);
+	gint overlap = REGEX_CHUNK_OVERLAP;
+
+	for (;;)
+	{
+		GRegexMatchFlags flags = G_REGEX_MATCH_PARTIAL;
+		GMatchInfo* match_info;
+		gint chunk_end = MIN (end, *position + overlap);
+		gint start_pos, end_pos;
+		gint last_start = 0, last_end = 0;
+		gboolean found = FALSE;
+		gboolean complete;
+		gchar* text;
+		gchar* limit;
+
+		if (chunk_start > start)
+			flags |= G_REGEX_MATCH_NOTBOL;
+		if (chunk_end < end)
+			flags |= G_REGEX_MATCH_NOTEOL;
+
+		/* The text after position has already been searched, it is fetched
+		 * only to get matches starting before position */
+		text = search_box_get_text (search_box, chunk_start, chunk_end);
+		limit = g_utf8_offset_to_pointer (text, *position - chunk_start);
+		g_regex_match (regex, text, flags, &match_info);
+		while (g_match_info_matches (match_info))
+		{
+			g_match_info_fetch_pos (match_info, 0, &start_pos, &end_pos);
+			if (&text[start_pos] >= limit)
+				break;
+			last_start = start_pos;
+			last_end = end_pos;
+			found = TRUE;
+			g_match_info_next (match_info, NULL);
+		}
+
+		/* The last match could be longer or a match could start before
+		 * position and end after the chunk, fetch more text after it */
+		complete = (chunk_end == end) ||
+			(!g_match_info_is_partial_match (match_info) &&
+			 (!found || (text[last_end] != '\0')));
+		g_match_info_free (match_info);
+
+		if (complete)
+		{
+			if (found)
+			{
+				*match_start = chunk_start + g_utf8_pointer_to_offset (text, &text[last_start]);
+				*match_end = chunk_start + g_utf8_pointer_to_offset (text, &text[last_end]);
+			}
+			else
+			{
+				*position = chunk_start;
+			}
+		}
+		g_free (text);
+
+		if (complete)
+			return found;
+
+		overlap *= 2;
+	}
+}
+
+/* Search for the first or the last match between start and end, going
+ * outward from the cursor one chunk at a time */
+static gboolean
+search_box_regex_search_range (SearchBox* search_box, const gchar* search_text,
+                               gint start, gint end, gboolean search_forward,
+                               gint* match_start, gint* match_end)
+{
+	GRegex* regex;
+	gint position;
+
+	regex = search_box_get_regex (search_box, search_text);
+	if (regex == NULL)
+		return FALSE;
+
+	if (search_forward)
+	{
+		position = start;
+		do
+		{
+			if (search_box_regex_search_chunk (search_box, regex, &position, end,
+			                                   position == start,
+			                                   match_start, match_end))
+				return TRUE;
+		}
+		while (position < end);
+	}
+	else
+	{
+		position = end;
+		do
+		{
+			if (search_box_regex_search_chunk_backward (search_box, regex,
+			                                            start, &position, end,
+			                                            match_start, match_end))
+				return TRUE;
+		}
+		while (position > start);
+	}
+
+	return FALSE;
+}
+
+static void
+search_box_regex_search_reset (SearchBox* search_box)
+{
+	SearchBoxPrivate* priv = search_box->priv;
+
+	if (priv->regex_idle)
+	{
+		g_source_remove (priv->regex_idle);
+		priv->regex_idle = 0;
+	}
+	if (priv->regex_editor)
+	{
+		g_signal_handler_disconnect (priv->regex_editor, priv->regex_changed_id);
+		g_object_remove_weak_pointer (G_OBJECT (priv->regex_editor),
+		                              (gpointer *)&priv->regex_editor);
+		priv->regex_editor = NULL;
+	}
+	if (priv->regex)
+	{
+		g_regex_unref (priv->regex);
+		priv->regex = NULL;
+	}
+	g_free (priv->regex_pattern);
+	priv->regex_pattern = NULL;
+}
+
+/* Search the next chunk of text for the pattern being typed, going to the end
+ * of the text and then from the top back to where the search started */
+static gboolean
+on_search_box_regex_idle (gpointer user_data)
+{
+	SearchBox* search_box = SEARCH_BOX (user_data);
+	SearchBoxPrivate* priv = search_box->priv;
+	gint length = search_box_get_length (search_box);
+	gint match_start, match_end;
+	gboolean at_start;
+
+	if (!priv->regex_wrapped && (priv->regex_position >= length))
+	{
+		priv->regex_wrapped = TRUE;
+		priv->regex_position = 0;
+		return TRUE;
+	}
+	if (priv->regex_wrapped && (priv->regex_position >= priv->regex_origin))
+	{
+		/* The whole text has been searched */
+		search_box_set_entry_color (search_box, FALSE);
+		priv->regex_idle = 0;
+		return FALSE;
+	}
+
+	at_start = priv->regex_position == (priv->regex_wrapped ? 0 : priv->regex_origin);
+	if (search_box_regex_search_chunk (search_box, priv->regex,
+	                                   &priv->regex_position, length, at_start,
+	                                   &match_start, &match_end))
+	{
+		if (priv->regex_wrapped && (match_start >= priv->regex_origin))
+		{
+			priv->regex_position = priv->regex_origin;
+			return TRUE;
+		}
+		else
+		{
+			IAnjutaIterable* result_start;
+			IAnjutaIterable* result_end;
+
+			result_start = ianjuta_editor_get_start_position (priv->current_editor, NULL);
+			result_end = ianjuta_iterable_clone (result_start, NULL);
+			ianjuta_iterable_set_position (result_start, match_start, NULL);
+			ianjuta_iterable_set_position (result_end, match_end, NULL);
+			ianjuta_editor_selection_set (IANJUTA_EDITOR_SELECTION (priv->current_editor),
+			                              result_start, result_end, TRUE, NULL);
+			g_object_unref (result_start);
+			g_object_unref (result_end);
+			search_box_set_entry_color (search_box, TRUE);
+
+			/* There is no match between the new origin and the match */
+			priv->regex_origin = match_start;
+			priv->regex_position = match_start;
+			priv->regex_wrapped = FALSE;
+			priv->regex_idle = 0;
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/* Start searching the pattern being typed in idle time. The search is
+ * restarted at each change of the pattern */
+static void
+search_box_regex_search_start (SearchBox* search_box)
+{
+	SearchBoxPrivate* priv = search_box->priv;
+	const gchar* pattern = gtk_entry_get_text (GTK_ENTRY (priv->search_entry));
+	IAnjutaEditorSelection* selection;
+	IAnjutaIterable* start;
+	GRegex* regex;
+	gint origin;
+
+	if (priv->regex_idle)
+	{
+		g_source_remove (priv->regex_idle);
+		priv->regex_idle = 0;
+	}
+	if (!priv->current_editor)
+		return;
+
+	regex = search_box_get_regex (search_box, pattern);
+	if (regex == NULL)
+	{
+		search_box_regex_search_reset (search_box);
+		search_box_set_entry_color (search_box, FALSE);
+		return;
+	}
+
+	selection = IANJUTA_EDITOR_SELECTION (priv->current_editor);
+	if (ianjuta_editor_selection_has_selection (selection, NULL))
+		start = ianjuta_editor_selection_get_start (selection, NULL);
+	else
+		start = ianjuta_editor_get_position (priv->current_editor, NULL);
+	origin = ianjuta_iterable_get_position (start, NULL);
+	g_object_unref (start);
+
+	/* A match of a literal pattern contains a match of all its prefixes, so
+	 * if the previous pattern is extended, the text where it hasn't been found
+	 * doesn't need to be searched again */
+	if ((priv->regex_pattern == NULL) ||
+	    (priv->regex_editor != priv->current_editor) ||
+	    (priv->regex_origin != origin) ||
+	    !g_str_has_prefix (pattern, priv->regex_pattern) ||
+	    !regex_is_literal (priv->regex_pattern) ||
+	    !regex_is_literal (pattern))
+	{
+		search_box_regex_search_reset (search_box);
+
+		/* Any change in the text invalidates the part already searched */
+		priv->regex_editor = priv->current_editor;
+		g_object_add_weak_pointer (G_OBJECT (priv->regex_editor),
+		                           (gpointer *)&priv->regex_editor);
+		priv->regex_changed_id =
+			g_signal_connect_swapped (priv->regex_editor, "changed",
+			                          G_CALLBACK (search_box_regex_search_reset),
+			                          search_box);
+		priv->regex_origin = origin;
+		priv->regex_position = origin;
+		priv->regex_wrapped = FALSE;
+	}
+
+	g_free (priv->regex_pattern);
+	priv->regex_pattern = g_strdup (pattern);
+	if (priv->regex)
+		g_regex_unref (priv->regex);
+	priv->regex = g_regex_ref (regex);
+
+	priv->regex_idle = g_idle_add (on_search_box_regex_idle, search_box);
+}
+
+static gboolean
+incremental_regex_search (SearchBox* search_box, const gchar* search_entry, const gchar* editor_text, gint * start_pos, gint * end_pos, gboolean search_forward)
 {
 	GRegex * regex;
 	GMatchInfo *match_info;
 	gboolean result;
-	GError * err = NULL;
 
-	regex = g_regex_new (search_entry, 0, 0, &err);
-	if (err)
-	{
-		g_message ("%s",err->message);
-		g_error_free (err);
-		g_regex_unref(regex);
+	regex = search_box_get_regex (search_box, search_entry);
+	if (regex == NULL)
 		return FALSE;
-	}
 
 	result = g_regex_match (regex, editor_text, 0, &match_info);
 
@@ -273,8 +687,6 @@ incremental_regex_search (const gchar* search_entry, const gchar* editor_text, g
 		*end_pos = g_utf8_pointer_to_offset(editor_text, &editor_text[*end_pos]);
 	}
 
-	if (regex)
-		g_regex_unref(regex);
 	if (match_info)
 		g_match_info_free (match_info);
 
@@ -300,6 +712,9 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 	if (!search_box->priv->current_editor || !search_text || !strlen (search_text))
 		return FALSE;
 
+	/* Stop searching the pattern being typed */
+	search_box_regex_search_reset (search_box);
+
 	selection = IANJUTA_EDITOR_SELECTION (search_box->priv->current_editor);
 
 	if (ianjuta_editor_selection_has_selection (selection, NULL))
@@ -355,7 +770,7 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 		if (search_box->priv->regex_mode)
 		{
 			/* Always look for first match */
-			if (incremental_regex_search (search_text, selected_text, &start_pos, &end_pos, TRUE))
+			if (incremental_regex_search (search_box, search_text, selected_text, &start_pos, &end_pos, TRUE))
 			{
 				selected_have_search_text = TRUE;
 			}
@@ -413,7 +828,6 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 	gboolean result_set = FALSE;
 
 	gint start_pos, end_pos;
-	gchar * text_to_search;
 	gboolean result;
 
 	if (!found)
@@ -421,14 +835,10 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 		/* Try searching in current position */
 		if (search_box->priv->regex_mode)
 		{
-			text_to_search = ianjuta_editor_get_text (search_box->priv->current_editor,
-				                                      IANJUTA_ITERABLE (search_start),
-				                                      IANJUTA_ITERABLE (search_end), NULL);
-
-			result = incremental_regex_search (search_text, text_to_search, &start_pos, &end_pos, search_forward);
-
-			start_pos += ianjuta_iterable_get_position(IANJUTA_ITERABLE (search_start), NULL);
-			end_pos += ianjuta_iterable_get_position(IANJUTA_ITERABLE (search_start), NULL);
+			result = search_box_regex_search_range (search_box, search_text,
+			                                        ianjuta_iterable_get_position (IANJUTA_ITERABLE (search_start), NULL),
+			                                        ianjuta_iterable_get_position (IANJUTA_ITERABLE (search_end), NULL),
+			                                        search_forward, &start_pos, &end_pos);
 
 			if (result && start_pos >= 0)
 			{
@@ -449,8 +859,6 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 					g_object_unref(result_end);
 				}
 			}
-
-			g_free(text_to_search);
 		}
 		else
 		{
@@ -492,14 +900,10 @@ search_box_incremental_search (SearchBox* search_box, gboolean search_forward,
 		/* Try to search again */
 		if (search_box->priv->regex_mode)
 		{
-			text_to_search = ianjuta_editor_get_text (search_box->priv->current_editor,
-			                                          IANJUTA_ITERABLE(search_start),
-			                                          IANJUTA_ITERABLE(search_end), NULL);
-
-			result = incremental_regex_search (search_text, text_to_search, &start_pos, &end_pos, search_forward);
-
-			start_pos += ianjuta_iterable_get_position(IANJUTA_ITERABLE(search_start), NULL);
-			end_pos += ianjuta_iterable_get_position(IANJUTA_ITERABLE(search_start), NULL);
+			result = search_box_regex_search_range (search_box, search_text,
+			                                        ianjuta_iterable_get_position (IANJUTA_ITERABLE (search_start), NULL),
+			                                        ianjuta_iterable_get_position (IANJUTA_ITERABLE (search_end), NULL),
+			                                        search_forward, &start_pos, &end_pos);
 
 			if (result && start_pos >= 0)
 			{
@@ -649,6 +1053,7 @@ search_box_toggle_regex (SearchBox * search_box, gboolean status)
 	                             status);
 	
 	search_box->priv->regex_mode = status;
+	search_box_regex_search_reset (search_box);
 	search_box_clear_highlight(search_box);
 
 }
@@ -705,22 +1110,26 @@ search_box_search_highlight_all (SearchBox * search_box, gboolean search_forward
 static void
 on_search_box_entry_changed (GtkWidget * widget, SearchBox * search_box)
 {
-	if (!search_box->priv->regex_mode)
+	GtkEntryBuffer* buffer = gtk_entry_get_buffer (GTK_ENTRY(widget));
+	if (gtk_entry_buffer_get_length (buffer))
 	{
-		GtkEntryBuffer* buffer = gtk_entry_get_buffer (GTK_ENTRY(widget));
-		if (gtk_entry_buffer_get_length (buffer))
-			search_box_incremental_search (search_box, TRUE, TRUE);
+		if (search_box->priv->regex_mode)
+			search_box_regex_search_start (search_box);
 		else
-		{
-			/* clear selection */
-			IAnjutaIterable* cursor = 
-				ianjuta_editor_get_position (IANJUTA_EDITOR (search_box->priv->current_editor),
-				                             NULL);
-			ianjuta_editor_selection_set (IANJUTA_EDITOR_SELECTION (search_box->priv->current_editor),
-			                              cursor,
-			                              cursor,
-			                              FALSE, NULL);
-		}
+			search_box_incremental_search (search_box, TRUE, TRUE);
+	}
+	else
+	{
+		/* clear selection */
+		IAnjutaIterable* cursor = 
+			ianjuta_editor_get_position (IANJUTA_EDITOR (search_box->priv->current_editor),
+			                             NULL);
+		search_box_regex_search_reset (search_box);
+		ianjuta_editor_selection_set (IANJUTA_EDITOR_SELECTION (search_box->priv->current_editor),
+		                              cursor,
+		                              cursor,
+		                              FALSE, NULL);
+		g_object_unref (cursor);
 	}
 }
 
@@ -774,7 +1183,7 @@ search_box_replace (SearchBox * search_box, GtkWidget * widget,
 			gchar * replacement_text;
 			gint start_pos, end_pos;
 			GError * err = NULL;
-			gboolean result = incremental_regex_search (search_text, selection_text, &start_pos, &end_pos, TRUE);
+			gboolean result = incremental_regex_search (search_box, search_text, selection_text, &start_pos, &end_pos, TRUE);
 				
 			if (result)
 			{
@@ -999,6 +1408,10 @@ search_box_init (SearchBox *search_box)
 	search_box->priv->case_sensitive = FALSE;
 	search_box->priv->highlight_complete = FALSE;
 
+	search_box->priv->regex_cache = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                                       g_free,
+	                                                       (GDestroyNotify) g_regex_unref);
+
 	/* Initialize search_box grid */
 	search_box->priv->grid = gtk_grid_new();
 	gtk_orientable_set_orientation (GTK_ORIENTABLE (search_box->priv->grid), 
@@ -1063,6 +1476,10 @@ search_box_init (SearchBox *search_box)
 static void
 search_box_finalize (GObject *object)
 {
+	SearchBox* search_box = SEARCH_BOX (object);
+
+	search_box_regex_search_reset (search_box);
+	g_hash_table_destroy (search_box->priv->regex_cache);
 
 	G_OBJECT_CLASS (search_box_parent_class)->finalize (object);
 }
@@ -1156,15 +1156,21 @@ on_session_load (AnjutaShell *shell, AnjutaSessionPhase phase,
 				 AnjutaFileLoaderPlugin *plugin)
 {
 	GList *files, *node;
+	GTimer *timer;
+	gint count = 0;
 
 	/* We want to load the files first before other session loads */
 	if (phase != ANJUTA_SESSION_PHASE_FIRST)
 		return;
 
+	/* The document manager could have already taken the text files
+	 * to restore them lazily */
 	files = anjuta_session_get_string_list (session, "File Loader", "Files");
 	if (!files)
 		return;
 
+	timer = g_timer_new ();
+
 	/* Open all files except project files */
 	for (node = g_list_first (files); node != NULL; node = g_list_next (node))
 	{
@@ -1186,11 +1192,16 @@ on_session_load (AnjutaShell *shell, AnjutaSessionPhase phase,
 					}
 				}
 				g_object_unref (file);
+				count++;
 			}
 		}
 		g_free (uri);
 	}
 	g_list_free (files);
+
+	DEBUG_PRINT ("Session: %d files loaded in %g s",
+				 count, g_timer_elapsed (timer, NULL));
+	g_timer_destroy (timer);
 }
 
 static void
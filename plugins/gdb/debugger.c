@@ -4026,6 +4026,13 @@ gdb_var_update (Debugger *debugger,
 			var->changed = TRUE;
 			var->name = (gchar *)gdbmi_value_literal_get(value);
 			list = g_list_prepend (list, var);
+
+			/* Value is returned with --all-values, no need to evaluate it */
+			value = gdbmi_value_hash_lookup (gdbmi_change, "value");
+			if (value != NULL)
+			{
+				var->value = (gchar *)gdbmi_value_literal_get (value);
+			}
 			
 			value = gdbmi_value_hash_lookup (gdbmi_change, "type_changed");
 			if (value != NULL)
@@ -4066,7 +4073,7 @@ void debugger_update_variable (Debugger *debugger, IAnjutaDebuggerGListCallback
 
 	g_return_if_fail (IS_DEBUGGER (debugger));
 
-	debugger_queue_command (debugger, "-var-update *", 0, gdb_var_update, (IAnjutaDebuggerCallback)callback, user_data);
+	debugger_queue_command (debugger, "-var-update --all-values *", 0, gdb_var_update, (IAnjutaDebuggerCallback)callback, user_data);
 }
 
 GType
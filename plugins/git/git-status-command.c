@@ -26,6 +26,10 @@
 
 #define STATUS_REGEX "((M|A|D|U|\\?|\\s){2}) (.*)"
 
+/* Delay in milliseconds between the last change of a monitored file and the
+ * refresh, git usually writes the index several times in a row */
+#define MONITOR_REFRESH_DELAY 200
+
 struct _GitStatusCommandPriv
 {
 	GQueue *status_queue;
@@ -35,6 +39,7 @@ struct _GitStatusCommandPriv
 	GRegex *status_regex;
 	GFileMonitor *head_monitor;
 	GFileMonitor *index_monitor;
+	guint monitor_timeout;
 };
 
 G_DEFINE_TYPE (GitStatusCommand, git_status_command, GIT_TYPE_COMMAND);
@@ -170,16 +175,31 @@ git_status_command_init (GitStatusCommand *self)
 	g_hash_table_insert (self->priv->conflict_codes, "UU", NULL);
 }
 
+static gboolean
+on_monitor_refresh_timeout (GitStatusCommand *self)
+{
+	self->priv->monitor_timeout = 0;
+	anjuta_command_start (ANJUTA_COMMAND (self));
+
+	return FALSE;
+}
+
 static void
 on_file_monitor_changed (GFileMonitor *monitor, GFile *file, GFile *other_file,
-                         GFileMonitorEvent event, AnjutaCommand *command)
+                         GFileMonitorEvent event, GitStatusCommand *self)
 {
 	/* Handle created and modified events just to cover all possible cases. 
 	 * Sometimes git does some odd things... */
 	if (event == G_FILE_MONITOR_EVENT_CHANGED ||
 	    event == G_FILE_MONITOR_EVENT_CREATED)
 	{
-		anjuta_command_start (command);
+		/* Run the command only once for a burst of changes */
+		if (self->priv->monitor_timeout)
+			g_source_remove (self->priv->monitor_timeout);
+
+		self->priv->monitor_timeout = g_timeout_add (MONITOR_REFRESH_DELAY,
+		                                             (GSourceFunc) on_monitor_refresh_timeout,
+		                                             self);
 	}
 }
 
@@ -239,6 +259,12 @@ git_status_command_stop_automatic_monitor (AnjutaCommand *command)
 
 	self = GIT_STATUS_COMMAND (command); 
 
+	if (self->priv->monitor_timeout)
+	{
+		g_source_remove (self->priv->monitor_timeout);
+		self->priv->monitor_timeout = 0;
+	}
+
 	if (self->priv->head_monitor)
 	{
 		g_file_monitor_cancel (self->priv->head_monitor);
@@ -0,0 +1,366 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ *
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replay synthetic git status snapshots in a GitStatusModel and check that
+ * the store always matches the last snapshot, that only the differences are
+ * applied and that the selection follows the paths.
+ *
+ * Usage: git-status-model-test [files] [refreshes]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <libanjuta/anjuta-utils.h>
+
+#include "git-status-model.h"
+
+typedef struct
+{
+	const gchar *path;
+	AnjutaVcsStatus status;
+} StatusItem;
+
+/* Number of signals emitted by the store */
+typedef struct
+{
+	guint inserted;
+	guint deleted;
+	guint changed;
+} StoreChanges;
+
+static gboolean failed = FALSE;
+
+#define CHECK(cond) \
+	if (!(cond)) { g_printerr ("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); failed = TRUE; }
+
+static void
+on_row_inserted (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter,
+                 StoreChanges *changes)
+{
+	changes->inserted++;
+}
+
+static void
+on_row_deleted (GtkTreeModel *model, GtkTreePath *path, StoreChanges *changes)
+{
+	changes->deleted++;
+}
+
+static void
+on_row_changed (GtkTreeModel *model, GtkTreePath *path, GtkTreeIter *iter,
+                StoreChanges *changes)
+{
+	changes->changed++;
+}
+
+static void
+replay (GitStatusModel *model, StatusType type, const StatusItem *items,
+        guint count)
+{
+	guint i;
+
+	git_status_model_begin (model, type);
+	for (i = 0; i < count; i++)
+		git_status_model_add (model, type, items[i].path, items[i].status);
+	git_status_model_end (model, type);
+}
+
+/* Get the placeholder of a section, the commit section is first */
+static void
+get_section_iter (GtkTreeModel *store, StatusType type, GtkTreeIter *iter)
+{
+	gtk_tree_model_iter_nth_child (store, iter, NULL,
+	                               type == STATUS_TYPE_COMMIT ? 0 : 1);
+}
+
+static gboolean
+find_path (GtkTreeModel *store, StatusType type, const gchar *path,
+           GtkTreeIter *iter)
+{
+	GtkTreeIter parent;
+	gboolean valid;
+
+	get_section_iter (store, type, &parent);
+	for (valid = gtk_tree_model_iter_children (store, iter, &parent); valid;
+	     valid = gtk_tree_model_iter_next (store, iter))
+	{
+		gchar *row_path;
+		gboolean found;
+
+		gtk_tree_model_get (store, iter, COL_PATH, &row_path, -1);
+		found = strcmp (row_path, path) == 0;
+		g_free (row_path);
+		if (found) return TRUE;
+	}
+
+	return FALSE;
+}
+
+/* Check that a section contains exactly the items, in the same order */
+static void
+check_section (GtkTreeModel *store, StatusType type, const StatusItem *items,
+               guint count)
+{
+	GtkTreeIter parent;
+	GtkTreeIter iter;
+	gboolean valid;
+	guint i = 0;
+
+	get_section_iter (store, type, &parent);
+	CHECK (gtk_tree_model_iter_n_children (store, &parent) == (gint) count);
+
+	for (valid = gtk_tree_model_iter_children (store, &iter, &parent);
+	     valid && (i < count);
+	     valid = gtk_tree_model_iter_next (store, &iter), i++)
+	{
+		gchar *path;
+		AnjutaVcsStatus status;
+		StatusType row_type;
+
+		gtk_tree_model_get (store, &iter,
+		                    COL_PATH, &path,
+		                    COL_STATUS, &status,
+		                    COL_TYPE, &row_type,
+		                    -1);
+		CHECK (strcmp (path, items[i].path) == 0);
+		CHECK (status == items[i].status);
+		CHECK (row_type == type);
+		g_free (path);
+	}
+}
+
+static void
+check_changes (StoreChanges *changes, guint inserted, guint deleted,
+               guint changed)
+{
+	/* A new row is inserted then filled, so it is changed too */
+	CHECK (changes->inserted == inserted);
+	CHECK (changes->deleted == deleted);
+	CHECK (changes->changed == changed + inserted);
+
+	memset (changes, 0, sizeof (StoreChanges));
+}
+
+static void
+check_selected (GitStatusModel *model, StatusType type,
+                AnjutaVcsStatus status_codes, const gchar *path)
+{
+	GList *list;
+
+	list = git_status_model_get_selected (model, type, status_codes);
+	if (path == NULL)
+	{
+		CHECK (list == NULL);
+	}
+	else
+	{
+		CHECK (list != NULL && list->next == NULL);
+		CHECK (list != NULL && strcmp (list->data, path) == 0);
+	}
+	anjuta_util_glist_strings_free (list);
+}
+
+static void
+test_snapshots (GtkTreeStore *store, GitStatusModel *model,
+                StoreChanges *changes)
+{
+	const StatusItem first[] = {
+		{"a.c", ANJUTA_VCS_STATUS_MODIFIED},
+		{"b.c", ANJUTA_VCS_STATUS_MODIFIED},
+		{"c.c", ANJUTA_VCS_STATUS_ADDED}};
+	const StatusItem second[] = {
+		{"a.c", ANJUTA_VCS_STATUS_MODIFIED},
+		{"b.c", ANJUTA_VCS_STATUS_DELETED},
+		{"bb.c", ANJUTA_VCS_STATUS_ADDED},
+		{"d.c", ANJUTA_VCS_STATUS_MODIFIED}};
+	const StatusItem third[] = {
+		{"0.c", ANJUTA_VCS_STATUS_ADDED},
+		{"a.c", ANJUTA_VCS_STATUS_MODIFIED}};
+	GtkTreeModel *tree = GTK_TREE_MODEL (store);
+	GtkTreeIter iter;
+
+	/* Initial snapshot */
+	replay (model, STATUS_TYPE_COMMIT, first, G_N_ELEMENTS (first));
+	check_section (tree, STATUS_TYPE_COMMIT, first, G_N_ELEMENTS (first));
+	check_section (tree, STATUS_TYPE_NOT_UPDATED, NULL, 0);
+	check_changes (changes, 3, 0, 0);
+
+	/* Select b.c */
+	CHECK (find_path (tree, STATUS_TYPE_COMMIT, "b.c", &iter));
+	git_status_model_set_selected (model, &iter, TRUE);
+	check_changes (changes, 0, 0, 1);
+	check_selected (model, STATUS_TYPE_COMMIT, ANJUTA_VCS_STATUS_MODIFIED,
+	                "b.c");
+
+	/* Nothing changed */
+	replay (model, STATUS_TYPE_COMMIT, first, G_N_ELEMENTS (first));
+	check_section (tree, STATUS_TYPE_COMMIT, first, G_N_ELEMENTS (first));
+	check_changes (changes, 0, 0, 0);
+
+	/* The same files in the other section are independent */
+	replay (model, STATUS_TYPE_NOT_UPDATED, first, G_N_ELEMENTS (first));
+	check_section (tree, STATUS_TYPE_NOT_UPDATED, first, G_N_ELEMENTS (first));
+	check_changes (changes, 3, 0, 0);
+	check_selected (model, STATUS_TYPE_NOT_UPDATED, ANJUTA_VCS_STATUS_ALL,
+	                NULL);
+
+	/* One status changed, one file added in the middle and at the end, one
+	 * file removed */
+	replay (model, STATUS_TYPE_COMMIT, second, G_N_ELEMENTS (second));
+	check_section (tree, STATUS_TYPE_COMMIT, second, G_N_ELEMENTS (second));
+	check_changes (changes, 2, 1, 1);
+
+	/* The selection follows the new status */
+	check_selected (model, STATUS_TYPE_COMMIT, ANJUTA_VCS_STATUS_MODIFIED,
+	                NULL);
+	check_selected (model, STATUS_TYPE_COMMIT, ANJUTA_VCS_STATUS_DELETED,
+	                "b.c");
+	CHECK (find_path (tree, STATUS_TYPE_COMMIT, "b.c", &iter));
+	{
+		gboolean selected;
+
+		gtk_tree_model_get (tree, &iter, COL_SELECTED, &selected, -1);
+		CHECK (selected);
+	}
+
+	/* The selected file is removed, a file is added at the beginning */
+	replay (model, STATUS_TYPE_COMMIT, third, G_N_ELEMENTS (third));
+	check_section (tree, STATUS_TYPE_COMMIT, third, G_N_ELEMENTS (third));
+	check_changes (changes, 1, 3, 0);
+	check_selected (model, STATUS_TYPE_COMMIT, ANJUTA_VCS_STATUS_ALL, NULL);
+
+	/* A removed file coming back is not selected */
+	replay (model, STATUS_TYPE_COMMIT, second, G_N_ELEMENTS (second));
+	check_changes (changes, 3, 1, 0);
+	check_selected (model, STATUS_TYPE_COMMIT, ANJUTA_VCS_STATUS_ALL, NULL);
+
+	/* Select all and clear */
+	git_status_model_set_all_selected (model, STATUS_TYPE_NOT_UPDATED, TRUE);
+	check_changes (changes, 0, 0, G_N_ELEMENTS (first));
+	check_selected (model, STATUS_TYPE_NOT_UPDATED, ANJUTA_VCS_STATUS_ADDED,
+	                "c.c");
+	git_status_model_set_all_selected (model, STATUS_TYPE_NOT_UPDATED, FALSE);
+	check_changes (changes, 0, 0, G_N_ELEMENTS (first));
+	check_selected (model, STATUS_TYPE_NOT_UPDATED, ANJUTA_VCS_STATUS_ALL,
+	                NULL);
+
+	/* Empty snapshot */
+	replay (model, STATUS_TYPE_COMMIT, NULL, 0);
+	check_section (tree, STATUS_TYPE_COMMIT, NULL, 0);
+	check_changes (changes, 0, G_N_ELEMENTS (second), 0);
+}
+
+/* Refresh a large working tree where a few files change between snapshots */
+static void
+test_stream (GtkTreeStore *store, GitStatusModel *model, StoreChanges *changes,
+             guint files, guint refreshes)
+{
+	StatusItem *items;
+	gchar **paths;
+	gboolean *present;
+	GTimer *timer;
+	guint i;
+	guint count = 0;
+	guint updates = 0;
+
+	paths = g_new (gchar *, files);
+	present = g_new0 (gboolean, files);
+	items = g_new (StatusItem, files);
+	for (i = 0; i < files; i++)
+	{
+		paths[i] = g_strdup_printf ("src/file%06u.c", i);
+		present[i] = g_random_boolean ();
+	}
+
+	timer = g_timer_new ();
+	while (refreshes--)
+	{
+		/* Toggle about 1% of the files */
+		for (i = 0; i < files / 100 + 1; i++)
+		{
+			guint n = g_random_int_range (0, files);
+
+			present[n] = !present[n];
+		}
+
+		for (i = 0, count = 0; i < files; i++)
+		{
+			if (present[i])
+			{
+				items[count].path = paths[i];
+				items[count].status = ANJUTA_VCS_STATUS_MODIFIED;
+				count++;
+			}
+		}
+
+		replay (model, STATUS_TYPE_NOT_UPDATED, items, count);
+		updates += changes->inserted + changes->deleted;
+		memset (changes, 0, sizeof (StoreChanges));
+	}
+	g_print ("%u files, %u row updates: %.3f s\n", files, updates,
+	         g_timer_elapsed (timer, NULL));
+
+	check_section (GTK_TREE_MODEL (store), STATUS_TYPE_NOT_UPDATED, items,
+	               count);
+
+	g_timer_destroy (timer);
+	for (i = 0; i < files; i++)
+		g_free (paths[i]);
+	g_free (paths);
+	g_free (present);
+	g_free (items);
+}
+
+int
+main (int argc, char **argv)
+{
+	GtkTreeStore *store;
+	GitStatusModel *model;
+	StoreChanges changes = {0, 0, 0};
+	guint files = 10000;
+	guint refreshes = 100;
+
+	if (argc > 1) files = atoi (argv[1]);
+	if (argc > 2) refreshes = atoi (argv[2]);
+	if (files == 0) return 1;
+
+	g_type_init ();
+	g_random_set_seed (42);
+
+	/* Same columns as the status_model of the builder file */
+	store = gtk_tree_store_new (4, G_TYPE_BOOLEAN, G_TYPE_INT, G_TYPE_STRING,
+	                            G_TYPE_INT);
+	model = git_status_model_new (store);
+
+	g_signal_connect (store, "row-inserted", G_CALLBACK (on_row_inserted),
+	                  &changes);
+	g_signal_connect (store, "row-deleted", G_CALLBACK (on_row_deleted),
+	                  &changes);
+	g_signal_connect (store, "row-changed", G_CALLBACK (on_row_changed),
+	                  &changes);
+
+	test_snapshots (store, model, &changes);
+	test_stream (store, model, &changes, files, refreshes);
+
+	git_status_model_free (model);
+	g_object_unref (store);
+
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,320 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* 
+ * Keep the status tree store in sync with the output of git status. Each
+ * refresh is a new snapshot of a section: rows are looked up by path, so
+ * only new, changed and removed files update the store. Unchanged rows keep
+ * their position, so the view keeps its scroll position and the rows keep
+ * their selection, which is stored in a separate table keyed by path.
+ */
+
+#include <glib/gi18n.h>
+
+#include "git-status-model.h"
+
+/* A status item */
+typedef struct
+{
+	GtkTreeIter iter;
+	AnjutaVcsStatus status;
+	guint generation;
+} GitStatusModelRow;
+
+/* One of the two sections: Changes to be committed and Changed but not
+ * updated */
+typedef struct
+{
+	GtkTreeIter iter;
+
+	/* Rows by path */
+	GHashTable *rows;
+
+	/* Status of selected items by path */
+	GHashTable *selected;
+
+	/* Current snapshot, rows not seen in it are removed at the end */
+	guint generation;
+
+	/* Last row of the current snapshot, new rows are inserted after it */
+	GtkTreeIter cursor;
+	gboolean has_cursor;
+} GitStatusModelSection;
+
+struct _GitStatusModel
+{
+	GtkTreeStore *store;
+	GitStatusModelSection sections[2];
+};
+
+static void
+git_status_model_row_free (GitStatusModelRow *row)
+{
+	g_slice_free (GitStatusModelRow, row);
+}
+
+static GitStatusModelSection *
+git_status_model_get_section (GitStatusModel *self, StatusType type)
+{
+	switch (type)
+	{
+		case STATUS_TYPE_COMMIT:
+			return &self->sections[0];
+		case STATUS_TYPE_NOT_UPDATED:
+			return &self->sections[1];
+		default:
+			return NULL;
+	}
+}
+
+static void
+git_status_model_add_section (GitStatusModel *self, StatusType type,
+                              const gchar *label)
+{
+	GitStatusModelSection *section;
+
+	section = git_status_model_get_section (self, type);
+
+	gtk_tree_store_append (self->store, &section->iter, NULL);
+	gtk_tree_store_set (self->store, &section->iter, 
+	                    COL_PATH, label, 
+	                    COL_SELECTED, FALSE,
+	                    COL_STATUS, ANJUTA_VCS_STATUS_NONE,
+	                    COL_TYPE, STATUS_TYPE_NONE,
+	                    -1);
+
+	section->rows = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                       (GDestroyNotify) git_status_model_row_free);
+	section->selected = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+	                                           NULL);
+}
+
+GitStatusModel *
+git_status_model_new (GtkTreeStore *store)
+{
+	GitStatusModel *self;
+
+	self = g_new0 (GitStatusModel, 1);
+	self->store = g_object_ref (store);
+
+	/* Create the placeholders */
+	gtk_tree_store_clear (store);
+	git_status_model_add_section (self, STATUS_TYPE_COMMIT,
+	                              _("Changes to be committed"));
+	git_status_model_add_section (self, STATUS_TYPE_NOT_UPDATED,
+	                              _("Changed but not updated"));
+
+	return self;
+}
+
+void
+git_status_model_free (GitStatusModel *self)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (self->sections); i++)
+	{
+		g_hash_table_destroy (self->sections[i].rows);
+		g_hash_table_destroy (self->sections[i].selected);
+	}
+	g_object_unref (self->store);
+	g_free (self);
+}
+
+/* Start a new snapshot of a section */
+void
+git_status_model_begin (GitStatusModel *self, StatusType type)
+{
+	GitStatusModelSection *section;
+
+	section = git_status_model_get_section (self, type);
+	g_return_if_fail (section != NULL);
+
+	section->generation++;
+	section->has_cursor = FALSE;
+}
+
+void
+git_status_model_add (GitStatusModel *self, StatusType type, const gchar *path,
+                      AnjutaVcsStatus status)
+{
+	GitStatusModelSection *section;
+	GitStatusModelRow *row;
+
+	section = git_status_model_get_section (self, type);
+	g_return_if_fail (section != NULL);
+
+	row = g_hash_table_lookup (section->rows, path);
+
+	if (row != NULL)
+	{
+		if (row->status != status)
+		{
+			row->status = status;
+			gtk_tree_store_set (self->store, &row->iter,
+			                    COL_STATUS, status,
+			                    -1);
+
+			/* Keep the selection with the new status */
+			if (g_hash_table_lookup_extended (section->selected, path, NULL, 
+			                                  NULL))
+			{
+				g_hash_table_insert (section->selected, g_strdup (path),
+				                     GINT_TO_POINTER (status));
+			}
+		}
+	}
+	else
+	{
+		row = g_slice_new (GitStatusModelRow);
+		row->status = status;
+
+		/* Keep the order of git output */
+		gtk_tree_store_insert_after (self->store, &row->iter, &section->iter,
+		                             section->has_cursor ? &section->cursor : NULL);
+		gtk_tree_store_set (self->store, &row->iter,
+		                    COL_SELECTED, FALSE,
+		                    COL_STATUS, status,
+		                    COL_PATH, path,
+		                    COL_TYPE, type,
+		                    -1);
+
+		g_hash_table_insert (section->rows, g_strdup (path), row);
+	}
+
+	row->generation = section->generation;
+	section->cursor = row->iter;
+	section->has_cursor = TRUE;
+}
+
+/* Remove all rows which are not in the snapshot */
+void
+git_status_model_end (GitStatusModel *self, StatusType type)
+{
+	GitStatusModelSection *section;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	section = git_status_model_get_section (self, type);
+	g_return_if_fail (section != NULL);
+
+	g_hash_table_iter_init (&iter, section->rows);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		GitStatusModelRow *row = (GitStatusModelRow *) value;
+
+		if (row->generation != section->generation)
+		{
+			gtk_tree_store_remove (self->store, &row->iter);
+			g_hash_table_remove (section->selected, key);
+			g_hash_table_iter_remove (&iter);
+		}
+	}
+	section->has_cursor = FALSE;
+}
+
+static void
+git_status_model_set_row_selected (GitStatusModel *self, 
+                                   GitStatusModelSection *section,
+                                   GtkTreeIter *iter, const gchar *path,
+                                   AnjutaVcsStatus status, gboolean selected)
+{
+	gtk_tree_store_set (self->store, iter, 
+	                    COL_SELECTED, selected, 
+	                    -1);
+
+	if (selected)
+	{
+		g_hash_table_insert (section->selected, g_strdup (path), 
+		                     GINT_TO_POINTER (status));
+	}
+	else
+		g_hash_table_remove (section->selected, path);
+}
+
+void
+git_status_model_set_selected (GitStatusModel *self, GtkTreeIter *iter,
+                               gboolean selected)
+{
+	GitStatusModelSection *section;
+	AnjutaVcsStatus status;
+	gchar *path;
+	StatusType type;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (self->store), iter, 
+	                    COL_STATUS, &status,
+	                    COL_PATH, &path,
+	                    COL_TYPE, &type,
+	                    -1);
+
+	/* Placeholders cannot be selected */
+	section = git_status_model_get_section (self, type);
+	if (section != NULL)
+	{
+		git_status_model_set_row_selected (self, section, iter, path, status,
+		                                   selected);
+	}
+
+	g_free (path);
+}
+
+void
+git_status_model_set_all_selected (GitStatusModel *self, StatusType type,
+                                   gboolean selected)
+{
+	GitStatusModelSection *section;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+
+	section = git_status_model_get_section (self, type);
+	g_return_if_fail (section != NULL);
+
+	g_hash_table_iter_init (&iter, section->rows);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		GitStatusModelRow *row = (GitStatusModelRow *) value;
+
+		git_status_model_set_row_selected (self, section, &row->iter, key,
+		                                   row->status, selected);
+	}
+}
+
+GList *
+git_status_model_get_selected (GitStatusModel *self, StatusType type,
+                               AnjutaVcsStatus status_codes)
+{
+	GitStatusModelSection *section;
+	GHashTableIter iter;
+	gpointer key;
+	gpointer value;
+	GList *list = NULL;
+
+	section = git_status_model_get_section (self, type);
+	g_return_val_if_fail (section != NULL, NULL);
+
+	g_hash_table_iter_init (&iter, section->selected);
+	while (g_hash_table_iter_next (&iter, &key, &value))
+	{
+		if (GPOINTER_TO_INT (value) & status_codes)
+			list = g_list_prepend (list, g_strdup (key));
+	}
+
+	return g_list_reverse (list);
+}
@@ -0,0 +1,64 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GIT_STATUS_MODEL_H_
+#define _GIT_STATUS_MODEL_H_
+
+#include <gtk/gtk.h>
+#include <libanjuta/anjuta-vcs-status.h>
+
+G_BEGIN_DECLS
+
+/* Columns of the status tree store */
+enum
+{
+	COL_SELECTED,
+	COL_STATUS,
+	COL_PATH,
+	COL_TYPE
+};
+
+/* Status item type flags. These help reliably determine which section a status
+ * item belongs to */
+typedef enum
+{
+	STATUS_TYPE_NONE,
+	STATUS_TYPE_COMMIT,
+	STATUS_TYPE_NOT_UPDATED
+} StatusType;
+
+typedef struct _GitStatusModel GitStatusModel;
+
+GitStatusModel *git_status_model_new (GtkTreeStore *store);
+void git_status_model_free (GitStatusModel *self);
+
+void git_status_model_begin (GitStatusModel *self, StatusType type);
+void git_status_model_add (GitStatusModel *self, StatusType type, 
+                           const gchar *path, AnjutaVcsStatus status);
+void git_status_model_end (GitStatusModel *self, StatusType type);
+
+void git_status_model_set_selected (GitStatusModel *self, GtkTreeIter *iter,
+                                    gboolean selected);
+void git_status_model_set_all_selected (GitStatusModel *self, StatusType type,
+                                        gboolean selected);
+GList *git_status_model_get_selected (GitStatusModel *self, StatusType type,
+                                      AnjutaVcsStatus status_codes);
+
+G_END_DECLS
+
+#endif /* _GIT_STATUS_MODEL_H_ */
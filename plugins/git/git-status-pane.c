@@ -18,43 +18,15 @@
  */
 
 #include "git-status-pane.h"
-
-enum
-{
-	COL_SELECTED,
-	COL_STATUS,
-	COL_PATH,
-	COL_TYPE
-};
-
-/* Status item type flags. These help reliably determine which section a status
- * item belongs to */
-typedef enum
-{
-	STATUS_TYPE_NONE,
-	STATUS_TYPE_COMMIT,
-	STATUS_TYPE_NOT_UPDATED
-} StatusType;
-
-/* Data for generating lists of selected items */
-typedef struct
-{
-	AnjutaVcsStatus status_codes;
-	GList *list;
-} StatusSelectionData;
+#include "git-status-model.h"
 
 struct _GitStatusPanePriv
 {
 	GtkBuilder *builder;
 
-	/* Iters for the two sections: Changes to be committed and Changed but not
-	 * updated. Status items will be children of these two iters. */
-	GtkTreeIter commit_iter;
-	GtkTreeIter not_updated_iter;
-
-	/* Hash tables that show which items are selected in each section */
-	GHashTable *selected_commit_items;
-	GHashTable *selected_not_updated_items;
+	/* Status items of the two sections: Changes to be committed and Changed
+	 * but not updated, with the selected items */
+	GitStatusModel *status_model;
 };
 
 G_DEFINE_TYPE (GitStatusPane, git_status_pane, GIT_TYPE_PANE);
@@ -225,36 +197,6 @@ path_renderer_data_func (GtkTreeViewColumn *tree_column,
 	
 }
 
-static void
-git_status_pane_set_path_selection_state (GitStatusPane *self,  
-                                          const gchar *path, 
-                                          AnjutaVcsStatus status, 
-                                          StatusType type, gboolean state)
-{
-	GHashTable *selection_table;
-
-	switch (type)
-	{
-		case STATUS_TYPE_COMMIT:
-			selection_table = self->priv->selected_commit_items;
-			break;
-		case STATUS_TYPE_NOT_UPDATED:
-			selection_table = self->priv->selected_not_updated_items;
-			break;
-		default:
-			return;
-			break;
-	}
-
-	if (state)
-	{
-		g_hash_table_insert (selection_table, g_strdup (path), 
-		                     GINT_TO_POINTER (status));
-	}
-	else
-		g_hash_table_remove (selection_table, path);
-}
-
 static void
 on_selected_renderer_toggled (GtkCellRendererToggle *renderer, gchar *tree_path,
                               GitStatusPane *self)
@@ -262,9 +204,6 @@ on_selected_renderer_toggled (GtkCellRendererToggle *renderer, gchar *tree_path,
 	GtkTreeModel *status_model;
 	GtkTreeIter iter;
 	gboolean selected;
-	AnjutaVcsStatus status;
-	gchar *path;
-	StatusType type;
 	
 	status_model = GTK_TREE_MODEL (gtk_builder_get_object (self->priv->builder,
 	                                                       "status_model"));
@@ -273,31 +212,17 @@ on_selected_renderer_toggled (GtkCellRendererToggle *renderer, gchar *tree_path,
 	                                     tree_path);
 	gtk_tree_model_get (status_model, &iter, 
 	                    COL_SELECTED, &selected,
-	                    COL_STATUS, &status,
-	                    COL_PATH, &path,
-	                    COL_TYPE, &type,
-	                    -1);
-
-	selected = !selected;
-
-	gtk_tree_store_set (GTK_TREE_STORE (status_model), &iter,
-	                    COL_SELECTED, selected,
 	                    -1);
 
-	git_status_pane_set_path_selection_state (self, path, status, type, 
-	                                          selected);
-
-	g_free (path);
+	git_status_model_set_selected (self->priv->status_model, &iter, !selected);
 }
 
 static void
-add_status_items (GQueue *output, GtkTreeStore *status_model, 
-                  GtkTreeIter *parent_iter, StatusType type)
+add_status_items (GQueue *output, GitStatusModel *status_model, StatusType type)
 {
 	GitStatus *status_object;
 	AnjutaVcsStatus status;
 	gchar *path;
-	GtkTreeIter iter;
 
 	while (g_queue_peek_head (output))
 	{
@@ -305,13 +230,7 @@ add_status_items (GQueue *output, GtkTreeStore *status_model,
 		status = git_status_get_vcs_status (status_object);
 		path = git_status_get_path (status_object);
 
-		gtk_tree_store_append (status_model, &iter, parent_iter);
-		gtk_tree_store_set (status_model, &iter,
-		                    COL_SELECTED, FALSE,
-		                    COL_STATUS, status,
-		                    COL_PATH, path,
-		                    COL_TYPE, type,
-		                    -1);
+		git_status_model_add (status_model, type, path, status);
 
 		g_free (path);
 		g_object_unref (status_object);
@@ -322,130 +241,70 @@ static void
 on_commit_status_data_arrived (AnjutaCommand *command, 
                                GitStatusPane *self)
 {
-	GtkTreeStore *status_model;
 	GQueue *output;
 
-	status_model = GTK_TREE_STORE (gtk_builder_get_object (self->priv->builder,
-	                                                       "status_model"));
 	output = git_status_command_get_status_queue (GIT_STATUS_COMMAND (command));
 
-	add_status_items (output, status_model, &(self->priv->commit_iter),
-	                  STATUS_TYPE_COMMIT);
-
+	add_status_items (output, self->priv->status_model, STATUS_TYPE_COMMIT);
 }
 
 static void
 on_not_updated_status_data_arrived (AnjutaCommand *command,
                                     GitStatusPane *self)
 {
-	GtkTreeStore *status_model;
 	GQueue *output;
 
-	status_model = GTK_TREE_STORE (gtk_builder_get_object (self->priv->builder,
-	                                                       "status_model"));
 	output = git_status_command_get_status_queue (GIT_STATUS_COMMAND (command));
 
-	add_status_items (output, status_model, &(self->priv->not_updated_iter),
+	add_status_items (output, self->priv->status_model, 
 	                  STATUS_TYPE_NOT_UPDATED);
 }
 
+/* Each run of a status command gives a new snapshot of its section, only the
+ * differences with the previous one are applied to the model */
 static void
-git_status_pane_clear (GitStatusPane *self)
+on_commit_status_command_started (AnjutaCommand *command, GitStatusPane *self)
 {
-	GtkTreeStore *status_model;
-	GtkTreeView *status_view;
-
-	status_model = GTK_TREE_STORE (gtk_builder_get_object (self->priv->builder,	
-	                                                       "status_model"));
-	status_view = GTK_TREE_VIEW (gtk_builder_get_object (self->priv->builder,
-	                                                     "status_view"));
-
-	/* Clear any existing model data and create the placeholders */
-	gtk_tree_store_clear (status_model);
-	
-	gtk_tree_store_append (status_model, &(self->priv->commit_iter), NULL);
-	gtk_tree_store_set (status_model, &(self->priv->commit_iter), 
-	                    COL_PATH, _("Changes to be committed"), 
-	                    COL_SELECTED, FALSE,
-	                    COL_STATUS, ANJUTA_VCS_STATUS_NONE,
-	                    COL_TYPE, STATUS_TYPE_NONE,
-	                    -1);
-
-	gtk_tree_store_append (status_model, &(self->priv->not_updated_iter), 
-	                       NULL);
-	gtk_tree_store_set (status_model, &(self->priv->not_updated_iter), 
-	                    COL_PATH, _("Changed but not updated"), 
-	                    COL_SELECTED, FALSE, 
-	                    COL_STATUS, ANJUTA_VCS_STATUS_NONE,
-	                    COL_TYPE, STATUS_TYPE_NONE,
-	                    -1);
-
-	g_hash_table_remove_all (self->priv->selected_commit_items);
-	g_hash_table_remove_all (self->priv->selected_not_updated_items);
+	git_status_model_begin (self->priv->status_model, STATUS_TYPE_COMMIT);
 }
 
 static void
-git_status_pane_set_selected_column_state (GitStatusPane *self, 
-                                           StatusType type, 
-                                           gboolean state)
+on_commit_status_command_finished (AnjutaCommand *command, guint return_code,
+                                   GitStatusPane *self)
 {
-	GtkTreeModel *status_model;
-	GtkTreeIter *parent_iter;
-	gint i;
-	GtkTreeIter iter;
-	gchar *path;
-	AnjutaVcsStatus status;
-
-	status_model = GTK_TREE_MODEL (gtk_builder_get_object (self->priv->builder,
-	                                                       "status_model"));
-	switch (type)
-	{
-		case STATUS_TYPE_COMMIT:
-			parent_iter = &(self->priv->commit_iter);
-			break;
-		case STATUS_TYPE_NOT_UPDATED:
-			parent_iter = &(self->priv->not_updated_iter);
-			break;
-		default:
-			return;
-			break;
-	}
-	
-	i = 0;
-
-	while (gtk_tree_model_iter_nth_child (status_model, &iter, parent_iter,
-	                                      i++))
-	{
-		gtk_tree_store_set (GTK_TREE_STORE (status_model), &iter, 
-		                    COL_SELECTED, state, 
-		                    -1);
-
-		gtk_tree_model_get (status_model, &iter,
-		                    COL_PATH, &path,
-		                    COL_STATUS, &status,
-		                    -1);
+	git_status_model_end (self->priv->status_model, STATUS_TYPE_COMMIT);
+}
 
-		git_status_pane_set_path_selection_state (self, path, status, type,
-		                                          state);
+static void
+on_not_updated_status_command_started (AnjutaCommand *command, 
+                                       GitStatusPane *self)
+{
+	git_status_model_begin (self->priv->status_model, STATUS_TYPE_NOT_UPDATED);
+}
 
-		g_free (path);
-	}
+static void
+on_not_updated_status_command_finished (AnjutaCommand *command, 
+                                        guint return_code, GitStatusPane *self)
+{
+	git_status_model_end (self->priv->status_model, STATUS_TYPE_NOT_UPDATED);
 }
 
 static void
 on_select_all_button_clicked (GtkButton *button, GitStatusPane *self)
 {
-	git_status_pane_set_selected_column_state (self, STATUS_TYPE_COMMIT, TRUE);
-	git_status_pane_set_selected_column_state (self, STATUS_TYPE_NOT_UPDATED, 
-	                                           TRUE);
+	git_status_model_set_all_selected (self->priv->status_model, 
+	                                   STATUS_TYPE_COMMIT, TRUE);
+	git_status_model_set_all_selected (self->priv->status_model, 
+	                                   STATUS_TYPE_NOT_UPDATED, TRUE);
 }
 
 static void
 on_clear_button_clicked (GtkButton *button, GitStatusPane *self)
 {
-	git_status_pane_set_selected_column_state (self, STATUS_TYPE_COMMIT, FALSE);
-	git_status_pane_set_selected_column_state (self, STATUS_TYPE_NOT_UPDATED, 
-	                                           FALSE);
+	git_status_model_set_all_selected (self->priv->status_model, 
+	                                   STATUS_TYPE_COMMIT, FALSE);
+	git_status_model_set_all_selected (self->priv->status_model, 
+	                                   STATUS_TYPE_NOT_UPDATED, FALSE);
 }
 
 static void
@@ -466,14 +325,6 @@ git_status_pane_init (GitStatusPane *self)
 
 	self->priv = g_new0 (GitStatusPanePriv, 1);
 	self->priv->builder = gtk_builder_new ();
-	self->priv->selected_commit_items = g_hash_table_new_full (g_str_hash, 
-	                                                           g_str_equal,
-	                                                           g_free, 
-	                                                           NULL);
-	self->priv->selected_not_updated_items = g_hash_table_new_full (g_str_hash,
-	                                                                g_str_equal,
-	                                                                g_free,
-	                                                                NULL);
 	
 	if (!gtk_builder_add_objects_from_file (self->priv->builder, BUILDER_FILE, 
 	                                        objects, 
@@ -483,6 +334,9 @@ git_status_pane_init (GitStatusPane *self)
 		g_error_free (error);
 	}
 
+	self->priv->status_model = git_status_model_new (GTK_TREE_STORE (gtk_builder_get_object (self->priv->builder,
+	                                                                                         "status_model")));
+
 	status_column = GTK_TREE_VIEW_COLUMN (gtk_builder_get_object (self->priv->builder,
 	                                                              "status_column"));
 	selected_renderer = GTK_CELL_RENDERER (gtk_builder_get_object (self->priv->builder,
@@ -540,9 +394,8 @@ git_status_pane_finalize (GObject *object)
 
 	self = GIT_STATUS_PANE (object);
 
+	git_status_model_free (self->priv->status_model);
 	g_object_unref (self->priv->builder);
-	g_hash_table_destroy (self->priv->selected_commit_items);
-	g_hash_table_destroy (self->priv->selected_not_updated_items);
 	g_free (self->priv);
 
 	G_OBJECT_CLASS (git_status_pane_parent_class)->finalize (object);
@@ -593,10 +446,25 @@ git_status_pane_new (Git *plugin)
 	status_view = GTK_TREE_VIEW (gtk_builder_get_object (self->priv->builder,
 														 "status_view"));
 
-	g_signal_connect_swapped (G_OBJECT (plugin->commit_status_command), 
-	                          "command-started",
-	                          G_CALLBACK (git_status_pane_clear),
-	                          self);
+	g_signal_connect (G_OBJECT (plugin->commit_status_command), 
+	                  "command-started",
+	                  G_CALLBACK (on_commit_status_command_started),
+	                  self);
+
+	g_signal_connect (G_OBJECT (plugin->commit_status_command), 
+	                  "command-finished",
+	                  G_CALLBACK (on_commit_status_command_finished),
+	                  self);
+
+	g_signal_connect (G_OBJECT (plugin->not_updated_status_command), 
+	                  "command-started",
+	                  G_CALLBACK (on_not_updated_status_command_started),
+	                  self);
+
+	g_signal_connect (G_OBJECT (plugin->not_updated_status_command), 
+	                  "command-finished",
+	                  G_CALLBACK (on_not_updated_status_command_finished),
+	                  self);
 
 	/* Expand the placeholders so something is visible to the user after 
 	 * refreshing */
@@ -618,62 +486,30 @@ git_status_pane_new (Git *plugin)
 	return ANJUTA_DOCK_PANE (self);
 }
 
-static void
-selected_items_table_foreach (gchar *path, gpointer status, 
-                              StatusSelectionData *data)
-{
-	if (GPOINTER_TO_INT (status) & data->status_codes)
-		data->list = g_list_append (data->list, g_strdup (path));
-}
-
 GList *
 git_status_pane_get_selected_commit_items (GitStatusPane *self,
                                            AnjutaVcsStatus status_codes)
 {
-	StatusSelectionData data;
-
-	data.status_codes = status_codes;
-	data.list = NULL;
-
-	g_hash_table_foreach (self->priv->selected_commit_items, 
-	                      (GHFunc) selected_items_table_foreach,
-	                      &data);
-
-	return data.list;
+	return git_status_model_get_selected (self->priv->status_model,
+	                                      STATUS_TYPE_COMMIT, status_codes);
 }
 
 GList *
 git_status_pane_get_selected_not_updated_items (GitStatusPane *self,
                                                 AnjutaVcsStatus status_codes)
 {
-	StatusSelectionData data;
-
-	data.status_codes = status_codes;
-	data.list = NULL;
-
-	g_hash_table_foreach (self->priv->selected_not_updated_items, 
-	                      (GHFunc) selected_items_table_foreach,
-	                      &data);
-
-	return data.list;
+	return git_status_model_get_selected (self->priv->status_model,
+	                                      STATUS_TYPE_NOT_UPDATED, status_codes);
 }
 
 GList *
 git_status_pane_get_all_selected_items (GitStatusPane *self,
                                         AnjutaVcsStatus status_codes)
 {
-	StatusSelectionData data;
-
-	data.status_codes = status_codes;
-	data.list = NULL;
-
-	g_hash_table_foreach (self->priv->selected_commit_items, 
-	                      (GHFunc) selected_items_table_foreach,
-	                      &data);
-
-	g_hash_table_foreach (self->priv->selected_not_updated_items, 
-	                      (GHFunc) selected_items_table_foreach,
-	                      &data);
-
-	return data.list;
+	return g_list_concat (git_status_model_get_selected (self->priv->status_model,
+	                                                     STATUS_TYPE_COMMIT, 
+	                                                     status_codes),
+	                      git_status_model_get_selected (self->priv->status_model,
+	                                                     STATUS_TYPE_NOT_UPDATED, 
+	                                                     status_codes));
 }
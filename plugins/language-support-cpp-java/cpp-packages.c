@@ -34,6 +34,9 @@
 #define PROJECT_LOADED "__cpp_packages_loaded"
 #define USER_LOADED "__cpp_user_packages_loaded"
 
+/* Maximum number of packages scanned at the same time */
+#define MAX_SCANS 4
+
 /**
  * Standard files of the C library (according to
  * https://secure.wikimedia.org/wikipedia/en/wiki/C_standard_library)
@@ -80,38 +83,23 @@ enum
 	PROP_PLUGIN
 };
 
-typedef struct
-{
-	gchar* pkg;
-	gchar* version;
-} PackageData;
-
-static int
-pkg_data_compare (gpointer data1, gpointer pkg2)
-{
-	PackageData* pkg_data1 = data1;
-
-	return strcmp (pkg_data1->pkg, (const gchar*) pkg2);
-}
-
-static void
-pkg_data_free (PackageData* data)
-{
-	g_free (data->pkg);
-	g_free (data->version);
-	g_free (data);
-}
-
-
 G_DEFINE_TYPE (CppPackages, cpp_packages, G_TYPE_OBJECT);
 
-static GList*
-cpp_packages_activate_package (IAnjutaSymbolManager* sm, const gchar* pkg,
-                               GList** packages_to_add)
+/**
+ * cpp_packages_add_package:
+ * @pkg: The package name, possibly followed by a version requirement
+ * @wanted: Hash table of package names to their versions
+ *
+ * Adds the package and all its dependencies to @wanted
+ */
+static void
+cpp_packages_add_package (const gchar* pkg, GHashTable* wanted)
 {
 	gchar* name = g_strdup (pkg);
 	gchar* version;
 	gchar* c;
+	GList* deps;
+	GList* dep;
 
 	/* Clean package name */
 	for (c = name; *c != '\0'; c++)
@@ -123,58 +111,155 @@ cpp_packages_activate_package (IAnjutaSymbolManager* sm, const gchar* pkg,
 		}
 	}
 
+	/* Only query each package once */
+	if (g_hash_table_lookup (wanted, name))
+	{
+		g_free (name);
+		return;
+	}
+
 	version = anjuta_pkg_config_get_version (name);
 	if (!version)
 	{
 		g_free (name);
-		return *packages_to_add;
+		return;
 	}
-	
-	/* Only query each package once */
-	if (g_list_find_custom (*packages_to_add,
-	                        name, (GCompareFunc) pkg_data_compare))
-		return *packages_to_add;
-	if (!ianjuta_symbol_manager_activate_package (sm, name, version, NULL))
+	g_hash_table_insert (wanted, name, version);
+
+	deps = anjuta_pkg_config_list_dependencies (name, NULL);
+	for (dep = deps; dep != NULL; dep = g_list_next (dep))
 	{
-		GList* deps = anjuta_pkg_config_list_dependencies (name, NULL);
-		GList* dep;
-		PackageData* data = g_new0 (PackageData, 1);
-		for (dep = deps; dep != NULL; dep = g_list_next (dep))
-		{
-			cpp_packages_activate_package (sm, dep->data, packages_to_add);
-		}
-		anjuta_util_glist_strings_free (deps);
-		data->pkg = g_strdup (name);
-		data->version = g_strdup (version);
-		*packages_to_add = g_list_prepend (*packages_to_add,
-		                                   data);
+		cpp_packages_add_package (dep->data, wanted);
 	}
-	g_free (name);
-	return *packages_to_add;
+	anjuta_util_glist_strings_free (deps);
 }
 
+static void cpp_packages_start_scans (CppPackages* packages);
+
 static void
 on_package_ready (AnjutaCommand* command,
                   gint return_code,
-                  IAnjutaSymbolManager* sm)
+                  CppPackages* packages)
 {
 	AnjutaPkgScanner* scanner = ANJUTA_PKG_SCANNER (command);
-	if (g_list_length (anjuta_pkg_scanner_get_files (scanner)))
+	const gchar* pkg = anjuta_pkg_scanner_get_package (scanner);
+	const gchar* version = anjuta_pkg_scanner_get_version (scanner);
+	IAnjutaSymbolManager* sm =
+		anjuta_shell_get_interface (anjuta_plugin_get_shell (ANJUTA_PLUGIN(packages->plugin)),
+		                            IAnjutaSymbolManager, NULL);
+
+	/* The package could have been removed while it was scanned */
+	if (g_strcmp0 (g_hash_table_lookup (packages->active, pkg), version) == 0)
 	{
-		ianjuta_symbol_manager_add_package (sm,
-		                                    anjuta_pkg_scanner_get_package (scanner),
-		                                    anjuta_pkg_scanner_get_version (scanner),
-		                                    anjuta_pkg_scanner_get_files (scanner),
-		                                    NULL);
+		gboolean added = FALSE;
+
+		if (sm && return_code == 0 &&
+		    g_list_length (anjuta_pkg_scanner_get_files (scanner)))
+		{
+			added = ianjuta_symbol_manager_add_package (sm,
+			                                            pkg,
+			                                            version,
+			                                            anjuta_pkg_scanner_get_files (scanner),
+			                                            NULL);
+		}
+
+		/* Forget the package so it is scanned again on the next update */
+		if (!added)
+			g_hash_table_remove (packages->active, pkg);
 	}
+	g_object_unref (command);
+
+	packages->n_scans--;
+	cpp_packages_start_scans (packages);
 }
 
 static void
-on_queue_finished (AnjutaCommandQueue* queue, CppPackages* packages)
+cpp_packages_start_scans (CppPackages* packages)
 {
-	g_object_unref (queue);
-	packages->loading = FALSE;
-	g_object_unref (packages);
+	while (packages->n_scans < MAX_SCANS && !g_queue_is_empty (packages->scans))
+	{
+		AnjutaCommand* command = g_queue_pop_head (packages->scans);
+
+		packages->n_scans++;
+		anjuta_command_start (command);
+	}
+
+	if (packages->loading && packages->n_scans == 0)
+	{
+		packages->loading = FALSE;
+		g_object_unref (packages);
+	}
+}
+
+static void
+cpp_packages_scan_package (CppPackages* packages, const gchar* pkg,
+                           const gchar* version)
+{
+	AnjutaCommand* command = anjuta_pkg_scanner_new (pkg, version);
+
+	g_signal_connect (command, "command-finished",
+	                  G_CALLBACK (on_package_ready), packages);
+	g_queue_push_tail (packages->scans, command);
+
+	if (!packages->loading)
+	{
+		packages->loading = TRUE;
+		/* Make sure the pointer is valid when the scans finish */
+		g_object_ref (packages);
+	}
+}
+
+/**
+ * cpp_packages_update:
+ * @packages: A CppPackages object
+ * @sm: The symbol manager
+ * @wanted: Hash table of package names to their versions
+ *
+ * Deactivates the packages which are not in @wanted anymore and activates
+ * the new ones, scanning them if they are not known by the symbol manager.
+ * Packages which are already active are kept untouched.
+ */
+static void
+cpp_packages_update (CppPackages* packages, IAnjutaSymbolManager* sm,
+                     GHashTable* wanted)
+{
+	GHashTableIter iter;
+	gpointer name;
+	gpointer version;
+
+	/* Start from a known state the first time */
+	if (!packages->active)
+	{
+		ianjuta_symbol_manager_deactivate_all (sm, NULL);
+		packages->active = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                          g_free, g_free);
+	}
+
+	g_hash_table_iter_init (&iter, packages->active);
+	while (g_hash_table_iter_next (&iter, &name, &version))
+	{
+		if (g_strcmp0 (g_hash_table_lookup (wanted, name), version) != 0)
+		{
+			ianjuta_symbol_manager_deactivate_package (sm, name, version, NULL);
+			g_hash_table_iter_remove (&iter);
+		}
+	}
+
+	g_hash_table_iter_init (&iter, wanted);
+	while (g_hash_table_iter_next (&iter, &name, &version))
+	{
+		if (g_hash_table_lookup (packages->active, name))
+			continue;
+
+		/* A scanned package is kept here while its scan is pending, so it
+		 * is not queued twice, and removed if nothing could be added */
+		if (!ianjuta_symbol_manager_activate_package (sm, name, version, NULL))
+			cpp_packages_scan_package (packages, name, version);
+		g_hash_table_insert (packages->active, g_strdup (name),
+		                     g_strdup (version));
+	}
+
+	cpp_packages_start_scans (packages);
 }
 
 static void
@@ -237,39 +322,21 @@ cpp_packages_load_real (CppPackages* packages, GError* error, IAnjutaProjectMana
 		                            IAnjutaSymbolManager, NULL);		
 	GList* pkgs;
 	GList* pkg;
-	GList* packages_to_add = NULL;
+	GHashTable* wanted;
 	
 	if (!pm || !sm)
 		return;
 
-	ianjuta_symbol_manager_deactivate_all (sm, NULL);
+	wanted = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 	pkgs = ianjuta_project_manager_get_packages (pm, NULL);
 	for (pkg = pkgs; pkg != NULL; pkg = g_list_next (pkg))
 	{
-		cpp_packages_activate_package (sm, pkg->data, &packages_to_add);
+		cpp_packages_add_package (pkg->data, wanted);
 	}
 	g_list_free (pkgs);
-	if (packages_to_add)
-	{
-		packages->loading = TRUE;
-		packages->queue = anjuta_command_queue_new (ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
-		for (pkg = packages_to_add; pkg != NULL; pkg = g_list_next (pkg))
-		{
-			PackageData* pkg_data = pkg->data;
-			AnjutaCommand* command =
-				anjuta_pkg_scanner_new (pkg_data->pkg, pkg_data->version);
-			g_signal_connect (command, "command-finished",
-				              G_CALLBACK (on_package_ready), sm);
-			anjuta_command_queue_push (packages->queue, command);
-		}
-		g_list_foreach (packages_to_add, (GFunc) pkg_data_free, NULL);
-		g_list_free (packages_to_add);
 
-		g_signal_connect (packages->queue, "finished", G_CALLBACK (on_queue_finished), packages);
-		/* Make sure the pointer is valid when the queue finishes */
-		g_object_ref (packages);
-		anjuta_command_queue_start (packages->queue);
-	}
+	cpp_packages_update (packages, sm, wanted);
+	g_hash_table_destroy (wanted);
 }
 
 static void
@@ -288,42 +355,21 @@ cpp_packages_load_user (CppPackages* packages, gboolean force)
 		                                             PREF_USER_PACKAGES);
 		GStrv pkgs = g_strsplit (packages_str, ";", -1);
 		gchar** package;
-		GList* packages_to_add = NULL;
-		GList* pkg;
-		
-		ianjuta_symbol_manager_deactivate_all (sm, NULL);
+		GHashTable* wanted;
 
+		wanted = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 		for (package = pkgs; *package != NULL; package++)
 		{
-			cpp_packages_activate_package (sm, *package, &packages_to_add);
+			cpp_packages_add_package (*package, wanted);
 		}
 		g_strfreev (pkgs);
 		g_free (packages_str);
 
-		if (packages_to_add)
-		{
-			packages->loading = TRUE;
-			packages->queue = anjuta_command_queue_new (ANJUTA_COMMAND_QUEUE_EXECUTE_MANUAL);
-			for (pkg = packages_to_add; pkg != NULL; pkg = g_list_next (pkg))
-			{
-				PackageData* pkg_data = pkg->data;
-				AnjutaCommand* command =
-					anjuta_pkg_scanner_new (pkg_data->pkg, pkg_data->version);
-				g_signal_connect (command, "command-finished",
-						          G_CALLBACK (on_package_ready), sm);
-				anjuta_command_queue_push (packages->queue, command);
-			}
-			g_list_foreach (packages_to_add, (GFunc) pkg_data_free, NULL);
-			g_list_free (packages_to_add);
-
-			g_object_set_data (G_OBJECT (shell), 
-				               USER_LOADED, GINT_TO_POINTER (TRUE));
+		cpp_packages_update (packages, sm, wanted);
+		g_hash_table_destroy (wanted);
 
-			g_signal_connect (packages->queue, "finished", G_CALLBACK (on_queue_finished), packages);
-			/* Make sure the pointer is valid when the queue finishes */
-			g_object_ref (packages);
-			anjuta_command_queue_start (packages->queue);
-		}
+		g_object_set_data (G_OBJECT (shell), 
+		                   USER_LOADED, GINT_TO_POINTER (TRUE));
 	}
 }
 
@@ -396,6 +442,9 @@ cpp_packages_init (CppPackages *packages)
 {	
 	packages->loading = FALSE;
 	packages->idle_id = 0;
+	packages->active = NULL;
+	packages->scans = g_queue_new ();
+	packages->n_scans = 0;
 }
 
 static void
@@ -408,6 +457,10 @@ cpp_packages_finalize (GObject* object)
 	
 	g_signal_handlers_disconnect_by_func (pm, cpp_packages_load_real, packages);
 
+	if (packages->active)
+		g_hash_table_destroy (packages->active);
+	g_queue_free (packages->scans);
+
 	G_OBJECT_CLASS (cpp_packages_parent_class)->finalize (object);
 }
 
@@ -45,7 +45,9 @@ struct _CppPackages
 	GObject parent_instance;
 
 	AnjutaPlugin* plugin;
-	AnjutaCommandQueue* queue;
+	GHashTable* active;		/* Activated package names to versions */
+	GQueue* scans;			/* Package scanners waiting to start */
+	gint n_scans;
 	gboolean loading;
 	guint idle_id;
 };
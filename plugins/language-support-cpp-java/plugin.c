@@ -1301,27 +1301,15 @@ on_package_deactivated (AnjutaPkgConfigChooser *self, const gchar* package,
                         gpointer data)
 {
     CppJavaPlugin* plugin;
-    IAnjutaSymbolManager *isymbol_manager;
-    gchar* version;
 
     plugin = ANJUTA_PLUGIN_CPP_JAVA (data);
 
     DEBUG_PRINT ("deactivated %s", package);
 
-    isymbol_manager = anjuta_shell_get_interface (ANJUTA_PLUGIN (plugin)->shell,
-                                                IAnjutaSymbolManager,
-                                                NULL);
-    version = anjuta_pkg_config_get_version (package);
-    if (version)
-    {
-        ianjuta_symbol_manager_deactivate_package (isymbol_manager,
-                                                   package,
-                                                   version,
-                                                   NULL);
-    }
-    g_free (version);
-
+    /* Let the packages object deactivate it, so it knows about it */
     cpp_java_plugin_update_user_packages (plugin, self);
+    if (plugin->packages)
+        cpp_packages_load (plugin->packages, TRUE);
 }
 
 static void
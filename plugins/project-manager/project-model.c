@@ -46,8 +46,18 @@ struct _GbfProjectModelPrivate {
 	GList               *shortcuts;
 
 	gboolean default_shortcut;	   /* Add shortcut for each primary node */
+
+	GHashTable          *rows;     /* Row -> GbfProjectModelEntry */
+	GHashTable          *nodes;    /* AnjutaProjectNode -> GQueue of entries */
+	GHashTable          *files;    /* GFile -> GQueue of entries */
 };
 
+typedef struct {
+	GtkTreeIter         iter;
+	AnjutaProjectNode   *node;
+	GFile               *file;
+} GbfProjectModelEntry;
+
 enum {
 	PROP_NONE,
 	PROP_PROJECT
@@ -163,6 +173,9 @@ finalize (GObject *obj)
 {
 	GbfProjectModel *model = GBF_PROJECT_MODEL (obj);
 
+	g_hash_table_destroy (model->priv->files);
+	g_hash_table_destroy (model->priv->nodes);
+	g_hash_table_destroy (model->priv->rows);
 	g_free (model->priv);
 
 	G_OBJECT_CLASS (parent_class)->dispose (obj);
@@ -186,6 +199,223 @@ gbf_project_model_class_init (GbfProjectModelClass *klass)
                                        G_PARAM_READWRITE));
 }
 
+/* Row indexes
+ *
+ * Rows having a project node are indexed by node and by file, so finding
+ * them doesn't need to walk the whole tree. GtkTreeStore iterators stay
+ * valid as long as the row exists, all rows are removed from the index
+ * before being removed from the store.
+ *---------------------------------------------------------------------------*/
+
+static void
+gbf_project_model_entry_free (GbfProjectModelEntry *entry)
+{
+	if (entry->file != NULL) g_object_unref (entry->file);
+	g_slice_free (GbfProjectModelEntry, entry);
+}
+
+static void
+gbf_project_model_index_remove (GHashTable *index,
+                                gconstpointer key,
+                                GbfProjectModelEntry *entry)
+{
+	GQueue *entries;
+
+	entries = g_hash_table_lookup (index, key);
+	if (entries != NULL)
+	{
+		g_queue_remove (entries, entry);
+		if (g_queue_is_empty (entries)) g_hash_table_remove (index, key);
+	}
+}
+
+static void
+gbf_project_model_unindex_row (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	GbfProjectModelEntry *entry;
+
+	entry = g_hash_table_lookup (model->priv->rows, iter->user_data);
+	if (entry != NULL)
+	{
+		gbf_project_model_index_remove (model->priv->nodes, entry->node, entry);
+		if (entry->file != NULL)
+			gbf_project_model_index_remove (model->priv->files, entry->file, entry);
+		g_hash_table_remove (model->priv->rows, iter->user_data);
+	}
+}
+
+/* Remove a row and all its children from the index */
+static void
+gbf_project_model_unindex_tree (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	GtkTreeIter child;
+	gboolean valid;
+
+	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &child, iter); valid; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &child))
+	{
+		gbf_project_model_unindex_tree (model, &child);
+	}
+	gbf_project_model_unindex_row (model, iter);
+}
+
+static void
+gbf_project_model_index_row (GbfProjectModel *model, GtkTreeIter *iter)
+{
+	GbfProjectModelEntry *entry;
+	GbfTreeData *data;
+	AnjutaProjectNode *node = NULL;
+	GFile *file = NULL;
+	GQueue *entries;
+
+	gtk_tree_model_get (GTK_TREE_MODEL (model), iter,
+	    GBF_PROJECT_MODEL_COLUMN_DATA, &data,
+	    -1);
+	if (data != NULL) node = gbf_tree_data_get_node (data);
+	if (node != NULL) file = anjuta_project_node_get_file (node);
+
+	/* Check if the row data has changed */
+	entry = g_hash_table_lookup (model->priv->rows, iter->user_data);
+	if (entry != NULL)
+	{
+		if ((entry->node == node) &&
+		    ((entry->file == file) ||
+		     ((entry->file != NULL) && (file != NULL) && g_file_equal (entry->file, file))))
+			return;
+
+		gbf_project_model_unindex_row (model, iter);
+	}
+	if (node == NULL) return;
+
+	entry = g_slice_new (GbfProjectModelEntry);
+	entry->iter = *iter;
+	entry->node = node;
+	entry->file = file != NULL ? g_object_ref (file) : NULL;
+	g_hash_table_insert (model->priv->rows, iter->user_data, entry);
+
+	entries = g_hash_table_lookup (model->priv->nodes, node);
+	if (entries == NULL)
+	{
+		entries = g_queue_new ();
+		g_hash_table_insert (model->priv->nodes, node, entries);
+	}
+	g_queue_push_tail (entries, entry);
+
+	if (file != NULL)
+	{
+		entries = g_hash_table_lookup (model->priv->files, file);
+		if (entries == NULL)
+		{
+			entries = g_queue_new ();
+			g_hash_table_insert (model->priv->files, g_object_ref (file), entries);
+		}
+		g_queue_push_tail (entries, entry);
+	}
+}
+
+static void
+on_row_changed (GtkTreeModel *model,
+                GtkTreePath *path,
+                GtkTreeIter *iter,
+                gpointer user_data)
+{
+	gbf_project_model_index_row (GBF_PROJECT_MODEL (model), iter);
+}
+
+static gboolean
+gbf_project_model_iter_is_descendant (GbfProjectModel *model,
+                                      GtkTreeIter *iter,
+                                      GtkTreeIter *ancestor)
+{
+	GtkTreeIter child;
+	GtkTreeIter parent;
+
+	child = *iter;
+	while (gtk_tree_model_iter_parent (GTK_TREE_MODEL (model), &parent, &child))
+	{
+		if (parent.user_data == ancestor->user_data) return TRUE;
+		child = parent;
+	}
+
+	return FALSE;
+}
+
+/* Compare two rows below a parent at the given depth in the order used by
+ * a search looking at all direct children before going down */
+static gint
+compare_children_first (GtkTreePath *path_a, GtkTreePath *path_b, gint depth)
+{
+	gint depth_a, depth_b;
+	gint *index_a, *index_b;
+
+	index_a = gtk_tree_path_get_indices_with_depth (path_a, &depth_a);
+	index_b = gtk_tree_path_get_indices_with_depth (path_b, &depth_b);
+
+	for (;; depth++)
+	{
+		if ((depth_a == depth + 1) || (depth_b == depth + 1))
+		{
+			if (depth_a != depth_b) return depth_a == depth + 1 ? -1 : 1;
+			return index_a[depth] - index_b[depth];
+		}
+		if (index_a[depth] != index_b[depth]) return index_a[depth] - index_b[depth];
+	}
+}
+
+/* Select among the matching rows the one found first by a recursive search,
+ * either looking at direct children first or in tree order */
+static gboolean
+gbf_project_model_select_row (GbfProjectModel *model,
+                              GList *rows,
+                              GtkTreeIter *parent,
+                              gboolean children_first,
+                              GtkTreeIter *found)
+{
+	GtkTreePath *best = NULL;
+	gint depth = 0;
+	GList *item;
+
+	if (rows == NULL) return FALSE;
+
+	/* Getting a path is slow, avoid it for the common case */
+	if (rows->next == NULL)
+	{
+		*found = *(GtkTreeIter *)rows->data;
+		return TRUE;
+	}
+
+	if (parent != NULL)
+	{
+		GtkTreePath *path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), parent);
+		depth = gtk_tree_path_get_depth (path);
+		gtk_tree_path_free (path);
+	}
+
+	for (item = rows; item != NULL; item = g_list_next (item))
+	{
+		GtkTreePath *path;
+		gint cmp = -1;
+
+		path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), (GtkTreeIter *)item->data);
+		if (best != NULL)
+		{
+			cmp = children_first ? compare_children_first (path, best, depth) : gtk_tree_path_compare (path, best);
+		}
+		if (cmp < 0)
+		{
+			gtk_tree_path_free (best);
+			best = path;
+			*found = *(GtkTreeIter *)item->data;
+		}
+		else
+		{
+			gtk_tree_path_free (path);
+		}
+	}
+	gtk_tree_path_free (best);
+
+	return TRUE;
+}
+
 static void
 gbf_project_model_instance_init (GbfProjectModel *model)
 {
@@ -200,6 +430,15 @@ gbf_project_model_instance_init (GbfProjectModel *model)
 	model->priv = g_new0 (GbfProjectModelPrivate, 1);
 	model->priv->default_shortcut = TRUE;
 
+	/* Indexes, updated each time a row data is set */
+	model->priv->rows = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                           NULL, (GDestroyNotify)gbf_project_model_entry_free);
+	model->priv->nodes = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                            NULL, (GDestroyNotify)g_queue_free);
+	model->priv->files = g_hash_table_new_full (g_file_hash, (GEqualFunc)g_file_equal,
+	                                            g_object_unref, (GDestroyNotify)g_queue_free);
+	g_signal_connect (model, "row-changed", G_CALLBACK (on_row_changed), NULL);
+
 	/* sorting function */
 	gtk_tree_sortable_set_default_sort_func (GTK_TREE_SORTABLE (model),
 						 default_sort_func,
@@ -231,6 +470,7 @@ gbf_project_model_remove_children (GbfProjectModel *model, GtkTreeIter *iter)
 		gtk_tree_model_get (GTK_TREE_MODEL (model), &child,
 		   	 GBF_PROJECT_MODEL_COLUMN_DATA, &data,
 		    	-1);
+		gbf_project_model_unindex_tree (model, &child);
 		valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &child);
 		if (data != NULL) gbf_tree_data_free (data);
 	}
@@ -283,6 +523,7 @@ gbf_project_model_remove_invalid_shortcut (GbfProjectModel *model, GtkTreeIter *
 		if (data->shortcut->type == GBF_TREE_NODE_INVALID)
 		{
 			gbf_project_model_remove_children (model, &child);
+			gbf_project_model_unindex_tree (model, &child);
 			valid = gtk_tree_store_remove (GTK_TREE_STORE (model), &child);
 			if (data != NULL) gbf_tree_data_free (data);
 		}
@@ -429,6 +670,7 @@ gbf_project_model_remove (GbfProjectModel *model, GtkTreeIter *iter)
 	}
 
 	/* Free parent node */
+	gbf_project_model_unindex_tree (model, iter);
 	valid = gtk_tree_store_remove (GTK_TREE_STORE (model), iter);
 	if (data != NULL) gbf_tree_data_free (data);
 
@@ -645,6 +887,7 @@ gbf_project_model_move_target_shortcut (GbfProjectModel *model,
 	src_path = gtk_tree_model_get_path (GTK_TREE_MODEL (model), iter);
 	if (gtk_tree_path_compare (src_path, before_path) != 0)
 	{
+		gbf_project_model_unindex_tree (model, iter);
 		gtk_tree_store_remove (GTK_TREE_STORE (model), iter);
 		gtk_tree_store_insert_before (GTK_TREE_STORE (model), iter, NULL, &sibling);
 		gtk_tree_store_set (GTK_TREE_STORE (model), iter,
@@ -815,6 +1058,31 @@ gbf_project_model_find_tree_data (GbfProjectModel 	*model,
 	GtkTreeIter tmp_iter;
 	gboolean retval = FALSE;
 
+	/* Look first at the rows having the same node */
+	if (data->node != NULL)
+	{
+		GQueue *entries;
+		GList *rows = NULL;
+		GList *item;
+
+		entries = g_hash_table_lookup (model->priv->nodes, data->node);
+		for (item = entries != NULL ? entries->head : NULL; item != NULL; item = g_list_next (item))
+		{
+			GbfProjectModelEntry *entry = (GbfProjectModelEntry *)item->data;
+			GbfTreeData *tmp_data;
+
+			gtk_tree_model_get (GTK_TREE_MODEL (model), &entry->iter,
+			    GBF_PROJECT_MODEL_COLUMN_DATA, &tmp_data, -1);
+			if (gbf_tree_data_equal (tmp_data, data))
+				rows = g_list_prepend (rows, &entry->iter);
+		}
+		retval = gbf_project_model_select_row (model, rows, NULL, FALSE, iter);
+		g_list_free (rows);
+		if (retval) return TRUE;
+	}
+
+	/* Proxy nodes and data of a previous project are only equal by name or
+	 * file */
 	if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (model), &tmp_iter)) {
 		if (recursive_find_tree_data (GTK_TREE_MODEL (model), &tmp_iter, data)) {
 			retval = TRUE;
@@ -833,32 +1101,28 @@ gbf_project_model_find_file (GbfProjectModel 	*model,
      GbfTreeNodeType type,
     GFile		*file)
 {
-	GtkTreeIter iter;
+	GQueue *entries;
+	GList *rows = NULL;
+	GList *item;
 	gboolean valid;
 
-	/* Search for direct children */
-	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
+	entries = g_hash_table_lookup (model->priv->files, file);
+	for (item = entries != NULL ? entries->head : NULL; item != NULL; item = g_list_next (item))
 	{
+		GbfProjectModelEntry *entry = (GbfProjectModelEntry *)item->data;
 		GbfTreeData *data;
 
-		gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
+		gtk_tree_model_get (GTK_TREE_MODEL (model), &entry->iter,
 		    GBF_PROJECT_MODEL_COLUMN_DATA, &data, -1);
 
-		if (gbf_tree_data_equal_file (data, type, file))
+		if (gbf_tree_data_equal_file (data, type, file) &&
+		    ((parent == NULL) || gbf_project_model_iter_is_descendant (model, &entry->iter, parent)))
 		{
-			*found = iter;
-			break;
-		}
-	}
-
-	/* Search for children of children */
-	if (!valid)
-	{
-		for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
-		{
-			if (gbf_project_model_find_file (model, found, &iter, type, file)) break;
+			rows = g_list_prepend (rows, &entry->iter);
 		}
 	}
+	valid = gbf_project_model_select_row (model, rows, parent, TRUE, found);
+	g_list_free (rows);
 
 	return valid;
 }
@@ -869,32 +1133,23 @@ gbf_project_model_find_node (GbfProjectModel 	*model,
     GtkTreeIter		*parent,
     AnjutaProjectNode	*node)
 {
-	GtkTreeIter iter;
+	GQueue *entries;
+	GList *rows = NULL;
+	GList *item;
 	gboolean valid;
 
-	/* Search for direct children */
-	for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
+	entries = g_hash_table_lookup (model->priv->nodes, node);
+	for (item = entries != NULL ? entries->head : NULL; item != NULL; item = g_list_next (item))
 	{
-		GbfTreeData *data;
-
-		gtk_tree_model_get (GTK_TREE_MODEL (model), &iter,
-			GBF_PROJECT_MODEL_COLUMN_DATA, &data, -1);
+		GbfProjectModelEntry *entry = (GbfProjectModelEntry *)item->data;
 
-		if (node == gbf_tree_data_get_node (data))
-		{
-			*found = iter;
-			break;
-		}
-	}
-
-	/* Search for children of children */
-	if (!valid)
-	{
-		for (valid = gtk_tree_model_iter_children (GTK_TREE_MODEL (model), &iter, parent); valid == TRUE; valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (model), &iter))
+		if ((parent == NULL) || gbf_project_model_iter_is_descendant (model, &entry->iter, parent))
 		{
-			if (gbf_project_model_find_node (model, found, &iter, node)) break;
+			rows = g_list_prepend (rows, &entry->iter);
 		}
 	}
+	valid = gbf_project_model_select_row (model, rows, parent, TRUE, found);
+	g_list_free (rows);
 
 	return valid;
 }
@@ -433,6 +433,7 @@ npw_druid_fill_selection_page (NPWDruid* druid, const gchar *directory)
 		npw_header_list_readdir (&druid->header_list, PROJECT_WIZARD_DIRECTORY);
 	}
 	anjuta_autogen_set_library_path (druid->gen, PROJECT_WIZARD_DIRECTORY);
+	npw_header_list_save_cache ();
 
 	if (g_list_length (druid->header_list) == 0)
 	{
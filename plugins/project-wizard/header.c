@@ -37,6 +37,10 @@
 
 /*---------------------------------------------------------------------------*/
 
+/* name, name language, description, description language, icon, category,
+ * order, required programs, required packages */
+#define NPW_HEADER_VARIANT_FORMAT	"(sisissuasas)"
+
 struct _NPWHeader {
 	gchar* name;
 	gint name_lang;
@@ -197,14 +201,81 @@ npw_header_check_required_programs (NPWHeader* self)
 	return failed_programs;
 }
 
+/* Packages already checked, installed or not, they are not checked again
+ * in the same session */
+static GHashTable *npw_checked_packages = NULL;
+
+static gboolean
+npw_packages_are_installed (GList *packages)
+{
+	gchar **argv;
+	GList *node;
+	gint status;
+	gint i;
+	gboolean ok;
+
+	argv = g_new (gchar *, g_list_length (packages) + 3);
+	i = 0;
+	argv[i++] = "pkg-config";
+	argv[i++] = "--exists";
+	for (node = packages; node != NULL; node = g_list_next (node))
+	{
+		argv[i++] = (gchar *)node->data;
+	}
+	argv[i] = NULL;
+
+	ok = g_spawn_sync (NULL, argv, NULL,
+	                   G_SPAWN_SEARCH_PATH | G_SPAWN_STDOUT_TO_DEV_NULL | G_SPAWN_STDERR_TO_DEV_NULL,
+	                   NULL, NULL, NULL, NULL, &status, NULL);
+	g_free (argv);
+
+	return ok && WIFEXITED (status) && (WEXITSTATUS (status) == 0);
+}
+
 GList*
 npw_header_check_required_packages (NPWHeader* self)
 {
 	GList *node = NULL;
+	GList *unknown_packages = NULL;
 	GList *failed_packages = NULL;
+
+	if (npw_checked_packages == NULL)
+	{
+		npw_checked_packages = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	}
+
 	for (node = self->required_packages; node; node = g_list_next (node))
 	{
-		if (!anjuta_util_package_is_installed (node->data, FALSE))
+		if (!g_hash_table_lookup_extended (npw_checked_packages, node->data, NULL, NULL))
+		{
+			unknown_packages = g_list_prepend (unknown_packages, node->data);
+		}
+	}
+
+	if (unknown_packages != NULL)
+	{
+		/* Check all new packages with a single pkg-config call, check
+		 * them one by one only if one is missing */
+		gboolean all = (unknown_packages->next != NULL) && npw_packages_are_installed (unknown_packages);
+
+		for (node = unknown_packages; node; node = g_list_next (node))
+		{
+			gboolean installed = all;
+
+			if (!all)
+			{
+				GList single = {node->data, NULL, NULL};
+
+				installed = npw_packages_are_installed (&single);
+			}
+			g_hash_table_insert (npw_checked_packages, g_strdup (node->data), GINT_TO_POINTER (installed));
+		}
+		g_list_free (unknown_packages);
+	}
+
+	for (node = self->required_packages; node; node = g_list_next (node))
+	{
+		if (!GPOINTER_TO_INT (g_hash_table_lookup (npw_checked_packages, node->data)))
 		{
 			const gchar *const pkg = (const gchar *) node->data;
 			failed_packages = g_list_prepend (failed_packages,
@@ -214,6 +285,80 @@ npw_header_check_required_packages (NPWHeader* self)
 	return failed_packages;
 }
 
+/* Serialize header for the template cache, the file name is not saved */
+GVariant*
+npw_header_to_variant (const NPWHeader* self)
+{
+	GVariantBuilder programs;
+	GVariantBuilder packages;
+	GList *node;
+
+	g_variant_builder_init (&programs, G_VARIANT_TYPE_STRING_ARRAY);
+	for (node = self->required_programs; node; node = g_list_next (node))
+	{
+		g_variant_builder_add (&programs, "s", node->data);
+	}
+	g_variant_builder_init (&packages, G_VARIANT_TYPE_STRING_ARRAY);
+	for (node = self->required_packages; node; node = g_list_next (node))
+	{
+		g_variant_builder_add (&packages, "s", node->data);
+	}
+
+	return g_variant_new (NPW_HEADER_VARIANT_FORMAT,
+	                      self->name != NULL ? self->name : "",
+	                      self->name_lang,
+	                      self->description != NULL ? self->description : "",
+	                      self->description_lang,
+	                      self->iconfile != NULL ? self->iconfile : "",
+	                      self->category != NULL ? self->category : "",
+	                      self->order,
+	                      &programs,
+	                      &packages);
+}
+
+NPWHeader*
+npw_header_new_from_variant (GVariant* variant, const gchar* filename)
+{
+	NPWHeader* self;
+	const gchar *name;
+	const gchar *description;
+	const gchar *iconfile;
+	const gchar *category;
+	GVariantIter *programs;
+	GVariantIter *packages;
+	gchar *value;
+
+	g_return_val_if_fail (g_variant_is_of_type (variant, G_VARIANT_TYPE (NPW_HEADER_VARIANT_FORMAT)), NULL);
+
+	self = npw_header_new ();
+	g_variant_get (variant, "(&si&si&s&suasas)",
+	               &name, &self->name_lang,
+	               &description, &self->description_lang,
+	               &iconfile, &category, &self->order,
+	               &programs, &packages);
+	self->name = *name != '\0' ? g_strdup (name) : NULL;
+	self->description = *description != '\0' ? g_strdup (description) : NULL;
+	self->iconfile = *iconfile != '\0' ? g_strdup (iconfile) : NULL;
+	self->category = *category != '\0' ? g_strdup (category) : NULL;
+	self->filename = g_strdup (filename);
+
+	/* Keep the same order than in the original header */
+	while (g_variant_iter_next (programs, "s", &value))
+	{
+		self->required_programs = g_list_prepend (self->required_programs, value);
+	}
+	self->required_programs = g_list_reverse (self->required_programs);
+	g_variant_iter_free (programs);
+	while (g_variant_iter_next (packages, "s", &value))
+	{
+		self->required_packages = g_list_prepend (self->required_packages, value);
+	}
+	self->required_packages = g_list_reverse (self->required_packages);
+	g_variant_iter_free (packages);
+
+	return self;
+}
+
 /* Header list
  *---------------------------------------------------------------------------*/
 
@@ -61,6 +61,9 @@ void npw_header_add_required_package (NPWHeader* self, const gchar* package);
  */
 GList* npw_header_check_required_packages (NPWHeader* self);
 
+GVariant* npw_header_to_variant (const NPWHeader* self);
+NPWHeader* npw_header_new_from_variant (GVariant* variant, const gchar* filename);
+
 
 GList* npw_header_list_new (void);
 void npw_header_list_free (GList* list);
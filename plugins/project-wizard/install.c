@@ -47,6 +47,9 @@
 
 #define FILE_BUFFER_SIZE	4096
 
+/* Number of autogen processes run concurrently to expand templates */
+#define AUTOGEN_JOBS	4
+
 #define AUTOGEN_START_MACRO_LEN	7
 #define AUTOGEN_MARKER_1	"autogen5"
 #define AUTOGEN_MARKER_2	"template"
@@ -56,9 +59,13 @@
 struct _NPWInstall
 {
 	AnjutaAutogen* gen;
+	AnjutaAutogen* jobs[AUTOGEN_JOBS - 1];	/* Used with gen to run autogen */
 	NPWFileListParser* file_parser;
 	GList* file_list;
-	GList* current_file;
+	GQueue autogen_files;
+	guint autogen_count;
+	guint running;
+	GTimer* timer;
 	NPWActionListParser* action_parser;
 	GList* action_list;
 	GList* action;
@@ -70,9 +77,8 @@ struct _NPWInstall
 
 /*---------------------------------------------------------------------------*/
 
-static void on_install_end_install_file (AnjutaAutogen* gen, gpointer data);
+static void npw_install_install_files (NPWInstall* this);
 static void on_run_terminated (AnjutaLauncher* launcher, gint pid, gint status, gulong time, NPWInstall* this);
-static gboolean npw_install_install_file (NPWInstall* this);
 static gboolean npw_run_action (NPWInstall* this);
 static gboolean npw_open_action (NPWInstall* this);
 
@@ -188,12 +194,19 @@ npw_copy_file (const gchar* destination, const gchar* source)
 NPWInstall* npw_install_new (NPWPlugin* plugin)
 {
 	NPWInstall* this;
+	guint i;
 
 	/* Skip if already created */
 	if (plugin->install != NULL) return plugin->install;
 
 	this = g_new0(NPWInstall, 1);
 	this->gen = anjuta_autogen_new ();
+	for (i = 0; i < G_N_ELEMENTS (this->jobs); i++)
+	{
+		this->jobs[i] = anjuta_autogen_new ();
+	}
+	g_queue_init (&this->autogen_files);
+	this->timer = g_timer_new ();
 	this->plugin = plugin;
 	this->success = TRUE;
 	npw_plugin_create_view (plugin);
@@ -205,6 +218,8 @@ NPWInstall* npw_install_new (NPWPlugin* plugin)
 
 void npw_install_free (NPWInstall* this)
 {
+	guint i;
+
 	if (this->file_parser != NULL)
 	{
 		npw_file_list_parser_free (this->file_parser);
@@ -228,7 +243,13 @@ void npw_install_free (NPWInstall* this)
 		g_signal_handlers_disconnect_by_func (G_OBJECT (this->launcher), G_CALLBACK (on_run_terminated), this);
 		g_object_unref (this->launcher);
 	}
+	g_queue_clear (&this->autogen_files);
+	g_timer_destroy (this->timer);
 	g_object_unref (this->gen);
+	for (i = 0; i < G_N_ELEMENTS (this->jobs); i++)
+	{
+		g_object_unref (this->jobs[i]);
+	}
 	this->plugin->install = NULL;
 	g_free (this);
 }
@@ -236,7 +257,13 @@ void npw_install_free (NPWInstall* this)
 gboolean
 npw_install_set_property (NPWInstall* this, GHashTable* values)
 {
+	guint i;
+
 	anjuta_autogen_write_definition_file (this->gen, values, NULL);
+	for (i = 0; i < G_N_ELEMENTS (this->jobs); i++)
+	{
+		anjuta_autogen_write_definition_file (this->jobs[i], values, NULL);
+	}
 
 	return TRUE;
 }
@@ -264,7 +291,13 @@ npw_install_set_wizard_file (NPWInstall* this, const gchar* filename)
 gboolean
 npw_install_set_library_path (NPWInstall* this, const gchar *directory)
 {
+	guint i;
+
 	anjuta_autogen_set_library_path (this->gen, directory);
+	for (i = 0; i < G_N_ELEMENTS (this->jobs); i++)
+	{
+		anjuta_autogen_set_library_path (this->jobs[i], directory);
+	}
 
 	return TRUE;
 }
@@ -332,7 +365,7 @@ on_install_read_all_action_list (AnjutaAutogen* gen, gpointer data)
 
 	this->action_list = npw_action_list_parser_end_parse (this->action_parser, NULL);
 
-	on_install_end_install_file (NULL, this);
+	npw_install_install_files (this);
 }
 
 static void
@@ -350,7 +383,6 @@ on_install_read_all_file_list (AnjutaAutogen* gen, gpointer data)
 
 	this->file_list = npw_file_list_parser_end_parse (this->file_parser, NULL);
 
-	this->current_file = NULL;
 	this->project_file = NULL;
 
 	if (this->action_list != NULL)
@@ -368,183 +400,235 @@ on_install_read_all_file_list (AnjutaAutogen* gen, gpointer data)
 	anjuta_autogen_execute (this->gen, on_install_read_all_action_list, this, NULL);
 }
 
+gboolean
+npw_install_launch (NPWInstall* this)
+{
+	anjuta_autogen_set_output_callback (this->gen, on_install_read_file_list, this, NULL);
+	anjuta_autogen_execute (this->gen, on_install_read_all_file_list, this, NULL);
+
+	return TRUE;
+}
+
+/* Install all files in three phases: create all needed directories, copy the
+ * files which don't need autogen then expand all templates using several
+ * autogen processes in parallel. */
+
 static void
-on_install_end_install_file (AnjutaAutogen* gen, gpointer data)
+npw_install_print_phase (NPWInstall* this, const gchar* format, guint count)
 {
-	NPWInstall* this = (NPWInstall*)data;
+	gchar* msg;
 
-	/* Warning gen could be invalid */
+	msg = g_strdup_printf (format, count, g_timer_elapsed (this->timer, NULL));
+	npw_plugin_print_view (this->plugin, IANJUTA_MESSAGE_VIEW_TYPE_INFO, msg, "");
+	g_free (msg);
+	g_timer_start (this->timer);
+}
 
-	for (;;)
+static void
+npw_install_end_install_files (NPWInstall* this)
+{
+	GList* node;
+
+	npw_install_print_phase (this, _("%d files generated using AutoGen in %.2f s"), this->autogen_count);
+
+	for (node = g_list_first (this->file_list); node != NULL; node = g_list_next (node))
 	{
-		NPWFile *file;
+		NPWFile *file = (NPWFile *)node->data;
 
-		if (this->current_file == NULL)
+		if (npw_file_get_type (file) != NPW_FILE) continue;
+
+		if (npw_file_get_execute (file))
 		{
-			this->current_file = g_list_first (this->file_list);
+			gint previous;
+			/* Make this file executable */
+			previous = umask (0666);
+			chmod (npw_file_get_destination (file), 0777 & ~previous);
+			umask (previous);
 		}
-		else
+		if (npw_file_get_project (file))
 		{
-			NPWFile *file = (NPWFile *)this->current_file->data;
-
-			if (npw_file_get_execute (file))
-			{
-				gint previous;
-				/* Make this file executable */
-				previous = umask (0666);
-				chmod (npw_file_get_destination (file), 0777 & ~previous);
-				umask (previous);
-			}
-			if (npw_file_get_project (file))
-			{
-				/* Check if project is NULL */
-				this->project_file = npw_file_get_destination (file);
-			}
-			this->current_file = g_list_next (this->current_file);
+			/* Check if project is NULL */
+			this->project_file = npw_file_get_destination (file);
 		}
-		if (this->current_file == NULL)
-		{
-			/* IAnjutaFileLoader* loader; */
-			/* All files have been installed */
-			if (this->success)
-			{
-				npw_plugin_print_view (this->plugin,
-					IANJUTA_MESSAGE_VIEW_TYPE_INFO,
-					 _("New project has been created successfully."),
-					 "");
-			}
-			else
-			{
-				npw_plugin_print_view (this->plugin,
-					IANJUTA_MESSAGE_VIEW_TYPE_ERROR,
-					 _("New project creation has failed."),
-					 "");
-			}
-			on_install_end_action (this);
+	}
 
-			return;
-		}
-		file = (NPWFile *)this->current_file->data;
-		switch (npw_file_get_type (file))
+	/* All files have been installed */
+	if (this->success)
+	{
+		npw_plugin_print_view (this->plugin,
+			IANJUTA_MESSAGE_VIEW_TYPE_INFO,
+			 _("New project has been created successfully."),
+			 "");
+	}
+	else
+	{
+		npw_plugin_print_view (this->plugin,
+			IANJUTA_MESSAGE_VIEW_TYPE_ERROR,
+			 _("New project creation has failed."),
+			 "");
+	}
+	on_install_end_action (this);
+}
+
+static void on_install_end_autogen_file (AnjutaAutogen* gen, gpointer data);
+
+/* Start the next waiting template on gen */
+static void
+npw_install_next_autogen_file (NPWInstall* this, AnjutaAutogen* gen)
+{
+	NPWFile *file;
+
+	while ((file = (NPWFile *)g_queue_pop_head (&this->autogen_files)) != NULL)
+	{
+		const gchar* destination = npw_file_get_destination (file);
+		gboolean ok;
+		gchar* msg;
+
+		anjuta_autogen_set_input_file (gen, npw_file_get_source (file), NULL, NULL);
+		anjuta_autogen_set_output_file (gen, destination);
+		ok = anjuta_autogen_execute (gen, on_install_end_autogen_file, this, NULL);
+		msg = g_strdup_printf (_("Creating %s (using AutoGen)… %s"), destination, ok ? "Ok" : "Fail to Execute");
+		npw_plugin_print_view (this->plugin, ok ? IANJUTA_MESSAGE_VIEW_TYPE_INFO : IANJUTA_MESSAGE_VIEW_TYPE_ERROR, msg, "");
+		g_free (msg);
+
+		if (ok)
 		{
-		case NPW_FILE:
-			npw_install_install_file (this);
+			this->running++;
 			return;
-		default:
-			g_warning("Unknown file type %d\n", npw_file_get_type (file));
-			break;
 		}
+		this->success = FALSE;
 	}
 }
 
-gboolean
-npw_install_launch (NPWInstall* this)
+static void
+on_install_end_autogen_file (AnjutaAutogen* gen, gpointer data)
 {
-	anjuta_autogen_set_output_callback (this->gen, on_install_read_file_list, this, NULL);
-	anjuta_autogen_execute (this->gen, on_install_read_all_file_list, this, NULL);
+	NPWInstall* this = (NPWInstall*)data;
 
-	return TRUE;
+	this->running--;
+	npw_install_next_autogen_file (this, gen);
+
+	if (this->running == 0) npw_install_end_install_files (this);
 }
 
 static gboolean
-npw_install_install_file (NPWInstall* this)
+npw_install_use_autogen (NPWFile *file)
 {
-	gchar* buffer;
-	gchar* sep;
-	guint len;
-	const gchar* destination;
-	const gchar* source;
-	gchar* msg;
-	gboolean use_autogen;
-	gboolean ok = TRUE;
-	NPWFile *file = (NPWFile *)this->current_file->data;
-
-
-	destination = npw_file_get_destination (file);
-	source = npw_file_get_source (file);
-
-	/* Check if file already exist */
-	if (g_file_test (destination, G_FILE_TEST_EXISTS))
-	{
-		msg = g_strdup_printf (_("Skipping %s: file already exists"), destination);
-		npw_plugin_print_view (this->plugin, IANJUTA_MESSAGE_VIEW_TYPE_WARNING, msg, "");
-		g_free (msg);
-		on_install_end_install_file (this->gen, this);
-
-		return FALSE;
-	}
-
-	/* Check if autogen is needed */
 	switch (npw_file_get_autogen (file))
 	{
 	case NPW_TRUE:
-		use_autogen = TRUE;
-		break;
+		return TRUE;
 	case NPW_FALSE:
-		use_autogen = FALSE;
-		break;
+		return FALSE;
 	case NPW_DEFAULT:
-		use_autogen = npw_is_autogen_template (source);
-		break;
+		return npw_is_autogen_template (npw_file_get_source (file));
 	default:
-		use_autogen = FALSE;
+		return FALSE;
 	}
+}
 
-	len = strlen (destination) + 1;
-	buffer = g_new (gchar, MAX (FILE_BUFFER_SIZE, len));
-	strcpy (buffer, destination);
-	sep = buffer;
-	for (;;)
+static void
+npw_install_install_files (NPWInstall* this)
+{
+	GHashTable* directories;
+	GList* files = NULL;
+	GList* node;
+	guint count;
+	guint i;
+
+	/* Create each directory only once, skip existing files */
+	g_timer_start (this->timer);
+	directories = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+	for (node = g_list_first (this->file_list); node != NULL; node = g_list_next (node))
 	{
-		/* Get directory one by one */
-		sep = strstr (sep,G_DIR_SEPARATOR_S);
-		if (sep == NULL) break;
-		/* Create directory if necessary */
-		*sep = '\0';
-		if ((*buffer != '~') && (*buffer != '\0'))
+		NPWFile *file = (NPWFile *)node->data;
+		const gchar* destination;
+		gchar* directory;
+		gpointer created;
+		gchar* msg;
+
+		if (npw_file_get_type (file) != NPW_FILE)
 		{
-			if (!g_file_test (buffer, G_FILE_TEST_EXISTS))
-			{
-				if (mkdir (buffer, 0755) == -1)
-				{
-					msg = g_strdup_printf (_("Creating %s … Failed to create directory"), destination);
-					ok = FALSE;
-					break;
-				}
-			}
+			g_warning("Unknown file type %d\n", npw_file_get_type (file));
+			continue;
 		}
-		*sep++ = G_DIR_SEPARATOR_S[0];
-	}
 
-	if (ok)
-	{
-		if (use_autogen)
+		destination = npw_file_get_destination (file);
+		if (g_file_test (destination, G_FILE_TEST_EXISTS))
+		{
+			msg = g_strdup_printf (_("Skipping %s: file already exists"), destination);
+			npw_plugin_print_view (this->plugin, IANJUTA_MESSAGE_VIEW_TYPE_WARNING, msg, "");
+			g_free (msg);
+			continue;
+		}
+
+		directory = g_path_get_dirname (destination);
+		if (!g_hash_table_lookup_extended (directories, directory, NULL, &created))
 		{
-			anjuta_autogen_set_input_file (this->gen, source, NULL, NULL);
-			anjuta_autogen_set_output_file (this->gen, destination);
-			ok = anjuta_autogen_execute (this->gen, on_install_end_install_file, this, NULL);
-			msg = g_strdup_printf (_("Creating %s (using AutoGen)… %s"), destination, ok ? "Ok" : "Fail to Execute");
+			created = GINT_TO_POINTER ((*directory == '~') || (g_mkdir_with_parents (directory, 0755) == 0));
+			g_hash_table_insert (directories, directory, created);
 		}
 		else
 		{
-			ok = npw_copy_file (destination, source);
-			msg = g_strdup_printf (_("Creating %s … %s"), destination, ok ? "Ok" : "Fail to copy file");
+			g_free (directory);
 		}
-	}
 
-	/* Record failure and display error message */
-	if (!ok)
-	{
-		this->success = FALSE;
+		if (created)
+		{
+			files = g_list_prepend (files, file);
+		}
+		else
+		{
+			msg = g_strdup_printf (_("Creating %s … Failed to create directory"), destination);
+			npw_plugin_print_view (this->plugin, IANJUTA_MESSAGE_VIEW_TYPE_ERROR, msg, "");
+			g_free (msg);
+			this->success = FALSE;
+		}
 	}
-	npw_plugin_print_view (this->plugin, ok ? IANJUTA_MESSAGE_VIEW_TYPE_INFO : IANJUTA_MESSAGE_VIEW_TYPE_ERROR, msg, "");
-	g_free (msg);
+	count = g_hash_table_size (directories);
+	g_hash_table_destroy (directories);
+	files = g_list_reverse (files);
+	npw_install_print_phase (this, _("%d directories created in %.2f s"), count);
+
+	/* Copy plain files, keep templates for later */
+	count = 0;
+	for (node = files; node != NULL; node = g_list_next (node))
+	{
+		NPWFile *file = (NPWFile *)node->data;
+		const gchar* destination;
+		gboolean ok;
+		gchar* msg;
 
-	/* Next file is called automatically if autogen succeed */
-	if (!ok || !use_autogen)
-		on_install_end_install_file (this->gen, this);
+		if (npw_install_use_autogen (file))
+		{
+			g_queue_push_tail (&this->autogen_files, file);
+			continue;
+		}
 
-	return ok;
+		destination = npw_file_get_destination (file);
+		ok = npw_copy_file (destination, npw_file_get_source (file));
+		msg = g_strdup_printf (_("Creating %s … %s"), destination, ok ? "Ok" : "Fail to copy file");
+		npw_plugin_print_view (this->plugin, ok ? IANJUTA_MESSAGE_VIEW_TYPE_INFO : IANJUTA_MESSAGE_VIEW_TYPE_ERROR, msg, "");
+		g_free (msg);
+		if (ok)
+			count++;
+		else
+			this->success = FALSE;
+	}
+	g_list_free (files);
+	npw_install_print_phase (this, _("%d files copied in %.2f s"), count);
+
+	/* Expand templates, running is incremented while starting the processes
+	 * so the installation cannot end before all of them are started */
+	this->autogen_count = g_queue_get_length (&this->autogen_files);
+	this->running++;
+	npw_install_next_autogen_file (this, this->gen);
+	for (i = 0; i < G_N_ELEMENTS (this->jobs); i++)
+	{
+		npw_install_next_autogen_file (this, this->jobs[i]);
+	}
+	this->running--;
+	if (this->running == 0) npw_install_end_install_files (this);
 }
 
 static void
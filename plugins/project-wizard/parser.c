@@ -29,10 +29,14 @@
 
 #include <glib.h>
 
+#include <glib/gstdio.h>
+
 #include <string.h>
 #include <stdarg.h>
+#include <sys/stat.h>
 
 #include <libanjuta/anjuta-debug.h>
+#include <libanjuta/anjuta-utils.h>
 
 /*---------------------------------------------------------------------------*/
 
@@ -158,48 +162,373 @@ typedef enum {
 } NPWParserError;
 
 
+/* Cache of project template headers
+ *
+ * Reading the templates needs to parse the beginning of all .wiz files found
+ * in all template directories. The headers are kept in a cache file with
+ * the list of files of each directory. A directory is read again only if its
+ * modification time has changed and a template only if its own modification
+ * time has changed.
+ *---------------------------------------------------------------------------*/
+
+#define NPW_CATALOGUE_FILE		"project-wizard.cache"
+
+/* Increment it when the format of the cache changes */
+#define NPW_CATALOGUE_VERSION	1
+
+/* version, languages, directories (path, mtime, sub directories,
+ * templates (name, mtime, header)) */
+#define NPW_CATALOGUE_FORMAT	"(usa(sxasa(sxmv)))"
+
+typedef struct {
+	gchar* name;
+	gint64 mtime;
+	GVariant* header;		/* NULL if the file is not a valid template */
+} NPWCatalogueTemplate;
+
+typedef struct {
+	gint64 mtime;
+	GPtrArray* directories;	/* Names of sub directories */
+	GPtrArray* templates;	/* of NPWCatalogueTemplate */
+} NPWCatalogueDir;
+
+static GHashTable* npw_catalogue = NULL;	/* path -> NPWCatalogueDir */
+static gboolean npw_catalogue_modified = FALSE;
+
+static NPWHeader* npw_header_read (const gchar* filename);
+
+static void
+npw_catalogue_template_free (NPWCatalogueTemplate* tpl)
+{
+	g_free (tpl->name);
+	if (tpl->header != NULL) g_variant_unref (tpl->header);
+	g_slice_free (NPWCatalogueTemplate, tpl);
+}
+
+static NPWCatalogueDir*
+npw_catalogue_dir_new (gint64 mtime)
+{
+	NPWCatalogueDir* dir;
+
+	dir = g_slice_new (NPWCatalogueDir);
+	dir->mtime = mtime;
+	dir->directories = g_ptr_array_new_with_free_func (g_free);
+	dir->templates = g_ptr_array_new_with_free_func ((GDestroyNotify)npw_catalogue_template_free);
+
+	return dir;
+}
+
+static void
+npw_catalogue_dir_free (NPWCatalogueDir* dir)
+{
+	g_ptr_array_free (dir->directories, TRUE);
+	g_ptr_array_free (dir->templates, TRUE);
+	g_slice_free (NPWCatalogueDir, dir);
+}
+
+/* Headers contain the language of translated strings, so the cache is valid
+ * only for the same languages */
+static gchar*
+npw_catalogue_get_languages (void)
+{
+	return g_strjoinv (":", (gchar **)g_get_language_names ());
+}
+
+static void
+npw_catalogue_load (void)
+{
+	gchar* cache_path;
+	gchar* data;
+	gsize length;
+	GVariant* cache;
+	guint32 version;
+	const gchar* languages;
+	gchar* current_languages;
+	GVariantIter* dir_iter;
+	const gchar* path;
+	gint64 mtime;
+	GVariantIter* sub_iter;
+	GVariantIter* tpl_iter;
+
+	cache_path = anjuta_util_get_user_cache_file_path (NPW_CATALOGUE_FILE, NULL);
+	if (!g_file_get_contents (cache_path, &data, &length, NULL))
+	{
+		g_free (cache_path);
+		return;
+	}
+	g_free (cache_path);
+
+	cache = g_variant_new_from_data (G_VARIANT_TYPE (NPW_CATALOGUE_FORMAT),
+	                                 data, length, FALSE,
+	                                 (GDestroyNotify)g_free, data);
+	g_variant_ref_sink (cache);
+
+	g_variant_get (cache, "(u&sa(sxasa(sxmv)))", &version, &languages, &dir_iter);
+	current_languages = npw_catalogue_get_languages ();
+	if ((version != NPW_CATALOGUE_VERSION) || (strcmp (languages, current_languages) != 0))
+	{
+		g_free (current_languages);
+		g_variant_iter_free (dir_iter);
+		g_variant_unref (cache);
+		return;
+	}
+	g_free (current_languages);
+
+	while (g_variant_iter_next (dir_iter, "(&sxasa(sxmv))",
+	                            &path, &mtime, &sub_iter, &tpl_iter))
+	{
+		NPWCatalogueDir* dir;
+		gchar* name;
+		GVariant* header;
+
+		dir = npw_catalogue_dir_new (mtime);
+		g_hash_table_insert (npw_catalogue, g_strdup (path), dir);
+
+		while (g_variant_iter_next (sub_iter, "s", &name))
+		{
+			g_ptr_array_add (dir->directories, name);
+		}
+		g_variant_iter_free (sub_iter);
+
+		while (g_variant_iter_next (tpl_iter, "(sxmv)", &name, &mtime, &header))
+		{
+			NPWCatalogueTemplate* tpl;
+
+			tpl = g_slice_new (NPWCatalogueTemplate);
+			tpl->name = name;
+			tpl->mtime = mtime;
+			tpl->header = header;
+			g_ptr_array_add (dir->templates, tpl);
+		}
+		g_variant_iter_free (tpl_iter);
+	}
+	g_variant_iter_free (dir_iter);
+	g_variant_unref (cache);
+}
+
+static GHashTable*
+npw_catalogue_get (void)
+{
+	if (npw_catalogue == NULL)
+	{
+		npw_catalogue = g_hash_table_new_full (g_str_hash, g_str_equal,
+		                                       g_free, (GDestroyNotify)npw_catalogue_dir_free);
+		npw_catalogue_load ();
+	}
+
+	return npw_catalogue;
+}
+
+/* Read the list of files in the directory, templates already known are kept
+ * and will be checked later */
+static NPWCatalogueDir*
+npw_catalogue_dir_read (const gchar* path, gint64 mtime, NPWCatalogueDir* old)
+{
+	NPWCatalogueDir* dir;
+	GHashTable* known;
+	GDir* gdir;
+	const gchar* name;
+	guint i;
+
+	known = g_hash_table_new (g_str_hash, g_str_equal);
+	if (old != NULL)
+	{
+		for (i = 0; i < old->templates->len; i++)
+		{
+			NPWCatalogueTemplate* tpl = g_ptr_array_index (old->templates, i);
+
+			g_hash_table_insert (known, tpl->name, tpl);
+		}
+	}
+
+	dir = npw_catalogue_dir_new (mtime);
+	gdir = g_dir_open (path, 0, NULL);
+	if (gdir != NULL)
+	{
+		while ((name = g_dir_read_name (gdir)) != NULL)
+		{
+			gchar* filename = g_build_filename (path, name, NULL);
+
+			if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+			{
+				g_ptr_array_add (dir->directories, g_strdup (name));
+			}
+			else if (g_str_has_suffix (name, PROJECT_WIZARD_EXTENSION))
+			{
+				NPWCatalogueTemplate* tpl;
+				NPWCatalogueTemplate* old_tpl;
+
+				tpl = g_slice_new0 (NPWCatalogueTemplate);
+				tpl->name = g_strdup (name);
+				tpl->mtime = -1;
+				old_tpl = g_hash_table_lookup (known, name);
+				if (old_tpl != NULL)
+				{
+					tpl->mtime = old_tpl->mtime;
+					tpl->header = old_tpl->header != NULL ? g_variant_ref (old_tpl->header) : NULL;
+				}
+				g_ptr_array_add (dir->templates, tpl);
+			}
+			g_free (filename);
+		}
+		g_dir_close (gdir);
+	}
+	g_hash_table_destroy (known);
+
+	return dir;
+}
+
+/* Get the header of a template, parsing the file only if it has changed */
+static NPWHeader*
+npw_catalogue_template_get_header (NPWCatalogueTemplate* tpl, const gchar* filename)
+{
+	GStatBuf st;
+	NPWHeader* header;
+
+	if (g_stat (filename, &st) != 0) return NULL;
+
+	if (st.st_mtime == tpl->mtime)
+	{
+		return tpl->header != NULL ? npw_header_new_from_variant (tpl->header, filename) : NULL;
+	}
+
+	DEBUG_PRINT ("Reading project template %s", filename);
+	header = npw_header_read (filename);
+	if (tpl->header != NULL) g_variant_unref (tpl->header);
+	tpl->header = header != NULL ? g_variant_ref_sink (npw_header_to_variant (header)) : NULL;
+	tpl->mtime = st.st_mtime;
+	npw_catalogue_modified = TRUE;
+
+	return header;
+}
+
+static void
+add_catalogue_dir_variant (gpointer key, gpointer value, gpointer user_data)
+{
+	const gchar* path = (const gchar*)key;
+	NPWCatalogueDir* dir = (NPWCatalogueDir*)value;
+	GVariantBuilder* builder = (GVariantBuilder*)user_data;
+	guint i;
+
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("(sxasa(sxmv))"));
+	g_variant_builder_add (builder, "s", path);
+	g_variant_builder_add (builder, "x", dir->mtime);
+	g_variant_builder_open (builder, G_VARIANT_TYPE_STRING_ARRAY);
+	for (i = 0; i < dir->directories->len; i++)
+	{
+		g_variant_builder_add (builder, "s", g_ptr_array_index (dir->directories, i));
+	}
+	g_variant_builder_close (builder);
+	g_variant_builder_open (builder, G_VARIANT_TYPE ("a(sxmv)"));
+	for (i = 0; i < dir->templates->len; i++)
+	{
+		NPWCatalogueTemplate* tpl = g_ptr_array_index (dir->templates, i);
+
+		g_variant_builder_add (builder, "(sxmv)", tpl->name, tpl->mtime, tpl->header);
+	}
+	g_variant_builder_close (builder);
+	g_variant_builder_close (builder);
+}
+
+/* Write the cache file if some templates have been read */
+gboolean
+npw_header_list_save_cache (void)
+{
+	GVariantBuilder builder;
+	GVariant* cache;
+	gchar* cache_path;
+	gchar* languages;
+	gboolean ok;
+
+	if ((npw_catalogue == NULL) || !npw_catalogue_modified) return TRUE;
+
+	languages = npw_catalogue_get_languages ();
+	g_variant_builder_init (&builder, G_VARIANT_TYPE (NPW_CATALOGUE_FORMAT));
+	g_variant_builder_add (&builder, "u", (guint32)NPW_CATALOGUE_VERSION);
+	g_variant_builder_add (&builder, "s", languages);
+	g_variant_builder_open (&builder, G_VARIANT_TYPE ("a(sxasa(sxmv))"));
+	g_hash_table_foreach (npw_catalogue, add_catalogue_dir_variant, &builder);
+	g_variant_builder_close (&builder);
+	cache = g_variant_ref_sink (g_variant_builder_end (&builder));
+	g_free (languages);
+
+	cache_path = anjuta_util_get_user_cache_file_path (NPW_CATALOGUE_FILE, NULL);
+	ok = g_file_set_contents (cache_path,
+	                          g_variant_get_data (cache),
+	                          g_variant_get_size (cache),
+	                          NULL);
+	g_free (cache_path);
+	g_variant_unref (cache);
+	if (ok) npw_catalogue_modified = FALSE;
+
+	return ok;
+}
+
 /* Read all project templates in a directory
  *---------------------------------------------------------------------------*/
 
 gboolean
 npw_header_list_readdir (GList** list, const gchar* path)
 {
-	GDir* dir;
-	const gchar* name;
+	GHashTable* catalogue;
+	NPWCatalogueDir* dir;
+	GStatBuf st;
 	gboolean ok = FALSE;
+	guint i;
 
 	g_return_val_if_fail (list != NULL, FALSE);
 	g_return_val_if_fail (path != NULL, FALSE);
 
-	/* Read all project template files */
-	dir = g_dir_open (path, 0, NULL);
-	if (!dir) return FALSE;
+	if ((g_stat (path, &st) != 0) || !S_ISDIR (st.st_mode)) return FALSE;
+
+	/* Read the list of files only if the directory has changed */
+	catalogue = npw_catalogue_get ();
+	dir = g_hash_table_lookup (catalogue, path);
+	if ((dir == NULL) || (dir->mtime != st.st_mtime))
+	{
+		dir = npw_catalogue_dir_read (path, st.st_mtime, dir);
+		g_hash_table_replace (catalogue, g_strdup (path), dir);
+		npw_catalogue_modified = TRUE;
+	}
 
-	while ((name = g_dir_read_name (dir)) != NULL)
+	/* Search recursively in sub directory */
+	for (i = 0; i < dir->directories->len; i++)
 	{
-		char* filename = g_build_filename (path, name, NULL);
+		gchar* filename = g_build_filename (path, g_ptr_array_index (dir->directories, i), NULL);
 
-		if (g_file_test (filename, G_FILE_TEST_IS_DIR))
+		if (npw_header_list_readdir (list, filename))
 		{
-			/* Search recursively in sub directory */
-			if (npw_header_list_readdir (list, filename))
-			{
-				ok = TRUE;
-			}
+			ok = TRUE;
 		}
-		else if (g_str_has_suffix (name, PROJECT_WIZARD_EXTENSION))
+		g_free (filename);
+	}
+
+	/* Read all project template files */
+	for (i = 0; i < dir->templates->len; i++)
+	{
+		NPWCatalogueTemplate* tpl = g_ptr_array_index (dir->templates, i);
+		gchar* filename = g_build_filename (path, tpl->name, NULL);
+		NPWHeader* header;
+
+		header = npw_catalogue_template_get_header (tpl, filename);
+		if (header != NULL)
 		{
-			if (npw_header_list_read (list, filename))
+			/* Read at least one project file */
+			ok = TRUE;
+
+			/* Add header to list if template does not already exist*/
+			if (npw_header_list_find_header (*list, header) == NULL)
 			{
-				/* Read at least one project file */
-				ok = TRUE;
+				*list = npw_header_list_insert_header (*list, header);
+			}
+			else
+			{
+				npw_header_free (header);
 			}
 		}
 		g_free (filename);
 	}
 
-	g_dir_close (dir);
-
 	return ok;
 }
 
@@ -534,11 +863,10 @@ static GMarkupParser header_markup_parser = {
 };
 
 static NPWHeaderParser*
-npw_header_parser_new (GList** list, const gchar* filename)
+npw_header_parser_new (const gchar* filename)
 {
 	NPWHeaderParser* parser;
 
-	g_return_val_if_fail (list != NULL, NULL);
 	g_return_val_if_fail (filename != NULL, NULL);
 
 	parser = g_new0 (NPWHeaderParser, 1);
@@ -580,8 +908,9 @@ npw_header_parser_end_parse (NPWHeaderParser* parser, GError** error)
 	return g_markup_parse_context_end_parse (parser->ctx, error);
 }*/
 
-gboolean
-npw_header_list_read (GList** list, const gchar* filename)
+/* Parse the header of a template file, returns NULL on error */
+static NPWHeader*
+npw_header_read (const gchar* filename)
 {
 	gchar* content;
 	gsize len;
@@ -589,18 +918,17 @@ npw_header_list_read (GList** list, const gchar* filename)
 	NPWHeader* header;
 	GError* err = NULL;
 
-	g_return_val_if_fail (list != NULL, FALSE);
-	g_return_val_if_fail (filename != NULL, FALSE);
+	g_return_val_if_fail (filename != NULL, NULL);
 
 	if (!g_file_get_contents (filename, &content, &len, &err))
 	{
  		g_warning ("%s", err->message);
 		g_error_free (err);
 
-		return FALSE;
+		return NULL;
 	}
 
-	parser = npw_header_parser_new (list, filename);
+	parser = npw_header_parser_new (filename);
 
 	npw_header_parser_parse (parser, content, len, &err);
 	header = parser->header;
@@ -616,7 +944,7 @@ npw_header_list_read (GList** list, const gchar* filename)
 		g_warning ("Missing project wizard block in %s", filename);
 		npw_header_free (header);
 		
-		return FALSE;
+		return NULL;
 	}
 	if (g_error_matches (err, parser_error_quark (), NPW_STOP_PARSING) == FALSE)
 	{
@@ -625,9 +953,23 @@ npw_header_list_read (GList** list, const gchar* filename)
 		g_error_free (err);
 		npw_header_free (header);
 
-		return FALSE;
+		return NULL;
 	}
 	g_error_free (err);
+
+	return header;
+}
+
+gboolean
+npw_header_list_read (GList** list, const gchar* filename)
+{
+	NPWHeader* header;
+
+	g_return_val_if_fail (list != NULL, FALSE);
+	g_return_val_if_fail (filename != NULL, FALSE);
+
+	header = npw_header_read (filename);
+	if (header == NULL) return FALSE;
 	
 	/* Add header to list if template does not already exist*/
 	if (npw_header_list_find_header (*list, header) == NULL)
@@ -31,6 +31,7 @@
 gboolean npw_header_list_readdir (GList** this, const gchar* pathname);
 
 gboolean npw_header_list_read (GList** this, const gchar* filename);
+gboolean npw_header_list_save_cache (void);
 
 
 typedef struct _NPWPageParser NPWPageParser;
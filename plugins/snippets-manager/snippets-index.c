@@ -0,0 +1,301 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    snippets-index.c
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+	Boston, MA  02110-1301  USA
+*/
+
+#include <string.h>
+#include "snippets-index.h"
+
+
+#define TRIGGER_RELEVANCE        1000
+#define NAME_RELEVANCE           1000
+#define FIRST_KEYWORD_RELEVANCE  100
+#define KEYWORD_RELEVANCE_DEC    5
+#define START_MATCH_BONUS        1.7
+
+#define RELEVANCE(search_str_len, key_len)  ((gdouble)(search_str_len)/(key_len - search_str_len + 1))
+
+/* The index keeps every suffix of the lower case trigger-key, name and keywords
+   of the snippets in a sorted sequence. All the suffixes starting with a typed
+   word are then next to each other, the ones at offset 0 being the prefix
+   matches, so a lookup is a binary search followed by a scan of the matches. */
+
+struct _SnippetsIndex
+{
+	/* The SnippetsIndexSuffix entries, sorted by text */
+	GSequence *suffixes;
+
+	/* AnjutaSnippet (referenced) -> GPtrArray of SnippetsIndexKey */
+	GHashTable *snippets;
+};
+
+typedef struct _SnippetsIndexKey
+{
+	AnjutaSnippet *snippet;
+	gchar *text;
+	gint len;
+	gdouble weight;
+
+	/* The GSequenceIter of each suffix, to remove them */
+	GPtrArray *suffixes;
+} SnippetsIndexKey;
+
+typedef struct _SnippetsIndexSuffix
+{
+	/* NULL for the probe used when searching */
+	SnippetsIndexKey *key;
+	const gchar *text;
+} SnippetsIndexSuffix;
+
+/* Private methods */
+
+static gint
+compare_suffixes (gconstpointer a,
+                  gconstpointer b,
+                  gpointer user_data)
+{
+	const SnippetsIndexSuffix *suffix1 = (const SnippetsIndexSuffix *)a,
+	                          *suffix2 = (const SnippetsIndexSuffix *)b;
+
+	/* The probe is put before all the suffixes starting with it, so searching
+	   returns the first match */
+	if (suffix1->key == NULL)
+		return strcmp (suffix1->text, suffix2->text) <= 0 ? -1 : 1;
+	if (suffix2->key == NULL)
+		return strcmp (suffix1->text, suffix2->text) < 0 ? -1 : 1;
+
+	return strcmp (suffix1->text, suffix2->text);
+}
+
+static void
+free_suffix (gpointer data)
+{
+	g_slice_free (SnippetsIndexSuffix, data);
+}
+
+static void
+free_key (gpointer data)
+{
+	SnippetsIndexKey *key = (SnippetsIndexKey *)data;
+	guint i = 0;
+
+	for (i = 0; i < key->suffixes->len; i ++)
+		g_sequence_remove ((GSequenceIter *)g_ptr_array_index (key->suffixes, i));
+	g_ptr_array_free (key->suffixes, TRUE);
+
+	g_free (key->text);
+	g_slice_free (SnippetsIndexKey, key);
+}
+
+static void
+add_key (SnippetsIndex *snippets_index,
+         GPtrArray *keys,
+         AnjutaSnippet *snippet,
+         const gchar *text,
+         gdouble weight)
+{
+	SnippetsIndexKey *key = NULL;
+	SnippetsIndexSuffix *suffix = NULL;
+	const gchar *p = NULL;
+
+	if (text == NULL || *text == '\0')
+		return;
+
+	key = g_slice_new (SnippetsIndexKey);
+	key->snippet  = snippet;
+	key->text     = g_utf8_strdown (text, -1);
+	key->len      = strlen (key->text);
+	key->weight   = weight;
+	key->suffixes = g_ptr_array_new ();
+
+	/* A suffix starting inside a multi-byte character can't match a word */
+	for (p = key->text; *p != '\0'; p = g_utf8_next_char (p))
+	{
+		suffix = g_slice_new (SnippetsIndexSuffix);
+		suffix->key  = key;
+		suffix->text = p;
+
+		g_ptr_array_add (key->suffixes,
+		                 g_sequence_insert_sorted (snippets_index->suffixes, suffix,
+		                                           compare_suffixes, NULL));
+	}
+
+	g_ptr_array_add (keys, key);
+}
+
+static void
+add_relevance (GHashTable *relevances,
+               AnjutaSnippet *snippet,
+               gdouble relevance)
+{
+	gdouble *cur_relevance = NULL;
+
+	cur_relevance = g_hash_table_lookup (relevances, snippet);
+	if (cur_relevance == NULL)
+	{
+		cur_relevance = g_new0 (gdouble, 1);
+		g_hash_table_insert (relevances, snippet, cur_relevance);
+	}
+
+	*cur_relevance += relevance;
+}
+
+/* Public methods */
+
+SnippetsIndex*
+snippets_index_new (void)
+{
+	SnippetsIndex *snippets_index = NULL;
+
+	snippets_index = g_new0 (SnippetsIndex, 1);
+	snippets_index->suffixes = g_sequence_new (free_suffix);
+	snippets_index->snippets = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+	                                                  g_object_unref,
+	                                                  (GDestroyNotify)g_ptr_array_unref);
+
+	return snippets_index;
+}
+
+void
+snippets_index_free (SnippetsIndex *snippets_index)
+{
+	g_return_if_fail (snippets_index != NULL);
+
+	/* Removing the keys removes their suffixes from the sequence */
+	g_hash_table_destroy (snippets_index->snippets);
+	g_sequence_free (snippets_index->suffixes);
+	g_free (snippets_index);
+}
+
+/**
+ * snippets_index_add_snippet:
+ * @snippets_index: A #SnippetsIndex.
+ * @snippet: The snippet to index.
+ *
+ * Adds the trigger-key, name and keywords of the snippet to the index. If the
+ * snippet is already indexed, it is indexed again with its current data.
+ */
+void
+snippets_index_add_snippet (SnippetsIndex *snippets_index,
+                            AnjutaSnippet *snippet)
+{
+	GPtrArray *keys = NULL;
+	GList *keywords = NULL, *iter = NULL;
+	gdouble keyword_relevance = FIRST_KEYWORD_RELEVANCE;
+
+	/* Assertions */
+	g_return_if_fail (snippets_index != NULL);
+	g_return_if_fail (ANJUTA_IS_SNIPPET (snippet));
+
+	snippets_index_remove_snippet (snippets_index, snippet);
+
+	keys = g_ptr_array_new_with_free_func (free_key);
+	add_key (snippets_index, keys, snippet, snippet_get_trigger_key (snippet), TRIGGER_RELEVANCE);
+	add_key (snippets_index, keys, snippet, snippet_get_name (snippet), NAME_RELEVANCE);
+
+	/* The first keywords are more relevant, the ones after the weight reaches
+	   0 don't count */
+	keywords = snippet_get_keywords_list (snippet);
+	for (iter = g_list_first (keywords); iter != NULL; iter = g_list_next (iter))
+	{
+		if (keyword_relevance <= 0.0)
+			break;
+
+		add_key (snippets_index, keys, snippet, (const gchar *)iter->data, keyword_relevance);
+		keyword_relevance -= KEYWORD_RELEVANCE_DEC;
+	}
+	g_list_free (keywords);
+
+	g_hash_table_insert (snippets_index->snippets, g_object_ref (snippet), keys);
+}
+
+void
+snippets_index_remove_snippet (SnippetsIndex *snippets_index,
+                               AnjutaSnippet *snippet)
+{
+	g_return_if_fail (snippets_index != NULL);
+
+	g_hash_table_remove (snippets_index->snippets, snippet);
+}
+
+/**
+ * snippets_index_search:
+ * @snippets_index: A #SnippetsIndex.
+ * @words_list: A #GList of lower case words typed by the user.
+ *
+ * Computes the relevance of the snippets for the typed words. Each occurrence
+ * of a word in the trigger-key, name or keywords of a snippet adds to its
+ * relevance, more if the word is found at the start.
+ *
+ * Returns: A #GHashTable from the #AnjutaSnippet with a non null relevance to
+ *          its gdouble relevance. If @words_list is NULL, all the snippets are
+ *          returned with a relevance of 1.0. It should be destroyed.
+ */
+GHashTable*
+snippets_index_search (SnippetsIndex *snippets_index,
+                       GList *words_list)
+{
+	GHashTable *relevances = NULL;
+	GHashTableIter h_iter;
+	GSequenceIter *s_iter = NULL;
+	SnippetsIndexSuffix probe, *suffix = NULL;
+	gpointer snippet = NULL;
+	gdouble relevance = 0.0;
+	GList *iter = NULL;
+	gint word_len = 0;
+
+	/* Assertions */
+	g_return_val_if_fail (snippets_index != NULL, NULL);
+
+	relevances = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, g_free);
+
+	/* If the user hasn't typed anything we just consider all snippets relevant */
+	if (words_list == NULL)
+	{
+		g_hash_table_iter_init (&h_iter, snippets_index->snippets);
+		while (g_hash_table_iter_next (&h_iter, &snippet, NULL))
+			add_relevance (relevances, ANJUTA_SNIPPET (snippet), 1.0);
+
+		return relevances;
+	}
+
+	for (iter = g_list_first (words_list); iter != NULL; iter = g_list_next (iter))
+	{
+		probe.key  = NULL;
+		probe.text = (const gchar *)iter->data;
+		word_len   = strlen (probe.text);
+
+		for (s_iter = g_sequence_search (snippets_index->suffixes, &probe,
+		                                 compare_suffixes, NULL);
+		     !g_sequence_iter_is_end (s_iter);
+		     s_iter = g_sequence_iter_next (s_iter))
+		{
+			suffix = (SnippetsIndexSuffix *)g_sequence_get (s_iter);
+			if (!g_str_has_prefix (suffix->text, probe.text))
+				break;
+
+			relevance = suffix->key->weight * RELEVANCE (word_len, suffix->key->len);
+			if (suffix->text == suffix->key->text)
+				relevance *= START_MATCH_BONUS;
+
+			add_relevance (relevances, suffix->key->snippet, relevance);
+		}
+	}
+
+	return relevances;
+}
@@ -0,0 +1,42 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+    snippets-index.h
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program; if not, write to the Free Software
+    Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+	Boston, MA  02110-1301  USA
+*/
+
+#ifndef __SNIPPETS_INDEX_H__
+#define __SNIPPETS_INDEX_H__
+
+#include <glib.h>
+#include "snippet.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SnippetsIndex SnippetsIndex;
+
+SnippetsIndex*  snippets_index_new            (void);
+void            snippets_index_free           (SnippetsIndex *snippets_index);
+void            snippets_index_add_snippet    (SnippetsIndex *snippets_index,
+                                               AnjutaSnippet *snippet);
+void            snippets_index_remove_snippet (SnippetsIndex *snippets_index,
+                                               AnjutaSnippet *snippet);
+GHashTable*     snippets_index_search         (SnippetsIndex *snippets_index,
+                                               GList *words_list);
+
+G_END_DECLS
+
+#endif /* __SNIPPETS_INDEX_H__ */
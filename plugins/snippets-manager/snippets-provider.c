@@ -28,15 +28,10 @@
 #include "snippets-provider.h"
 #include "snippet.h"
 #include "snippets-group.h"
+#include "snippets-index.h"
 
 
-#define TRIGGER_RELEVANCE        1000
-#define NAME_RELEVANCE           1000
-#define FIRST_KEYWORD_RELEVANCE  100
-#define KEYWORD_RELEVANCE_DEC    5
-#define START_MATCH_BONUS        1.7
-
-#define RELEVANCE(search_str_len, key_len)  ((gdouble)(search_str_len)/(key_len - search_str_len + 1))
+#define MAX_PROPOSALS            100
 
 #define IS_SEPARATOR(c)          ((c == ' ') || (c == '\n') || (c == '\t'))
 
@@ -56,6 +51,7 @@ struct _SnippetsProviderPrivate
 	IAnjutaIterable *start_iter;
 	GList *suggestions_list;
 
+	SnippetsIndex *snippets_index;
 };
 
 typedef struct _SnippetEntry
@@ -100,16 +96,32 @@ snippets_provider_init (SnippetsProvider *obj)
 	priv->start_iter       = NULL;
 	priv->suggestions_list = NULL;
 
+	priv->snippets_index = snippets_index_new ();
+
 	obj->anjuta_shell = NULL;
 
 }
 
+static void
+snippets_provider_finalize (GObject *obj)
+{
+	SnippetsProviderPrivate *priv = ANJUTA_SNIPPETS_PROVIDER_GET_PRIVATE (obj);
+
+	snippets_index_free (priv->snippets_index);
+
+	G_OBJECT_CLASS (snippets_provider_parent_class)->finalize (obj);
+}
+
 static void
 snippets_provider_class_init (SnippetsProviderClass *klass)
 {
+	GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
 	snippets_provider_parent_class = g_type_class_peek_parent (klass);
 	g_type_class_add_private (klass, sizeof (SnippetsProviderPrivate));	
 
+	object_class->finalize = snippets_provider_finalize;
+
 }
 
 static void 
@@ -124,113 +136,179 @@ snippets_provider_iface_init (IAnjutaProviderIface* iface)
 
 /* Private methods */
 
-static gdouble
-get_relevance_for_word (const gchar *search_word,
-                        const gchar *key_word)
+/* Orders the entries from the most to the least relevant */
+static gint
+compare_snippet_entries (gconstpointer a,
+                         gconstpointer b)
 {
-	gint i = 0, search_word_len = 0, key_word_len = 0;
-	gdouble relevance = 0.0, cur_relevance = 0.0;
+	const SnippetEntry *entry1 = (const SnippetEntry *)a,
+	                   *entry2 = (const SnippetEntry *)b;
 
-	search_word_len = strlen (search_word);
-	key_word_len    = strlen (key_word);
+	if (entry1->relevance != entry2->relevance)
+		return entry1->relevance > entry2->relevance ? -1 : 1;
 
-	for (i = 0; i < key_word_len - search_word_len + 1; i ++)
-	{
-		if (g_str_has_prefix (key_word + i, search_word))
-		{
-			cur_relevance = RELEVANCE (search_word_len, key_word_len);
-			if (i == 0)
-				cur_relevance *= START_MATCH_BONUS;
+	return g_strcmp0 (snippet_get_name (entry1->snippet),
+	                  snippet_get_name (entry2->snippet));
+}
 
-			relevance += cur_relevance;
-		}
-	}
+static void
+swap_snippet_entries (GArray *heap,
+                      guint i,
+                      guint j)
+{
+	SnippetEntry tmp = g_array_index (heap, SnippetEntry, i);
 
-	return relevance;
+	g_array_index (heap, SnippetEntry, i) = g_array_index (heap, SnippetEntry, j);
+	g_array_index (heap, SnippetEntry, j) = tmp;
 }
 
-static gdouble
-get_relevance_for_snippet (AnjutaSnippet *snippet,
-                           GList *words_list)
+#define HEAP_COMPARE(heap, i, j) \
+	compare_snippet_entries (&g_array_index (heap, SnippetEntry, i), \
+	                         &g_array_index (heap, SnippetEntry, j))
+
+/* Keeps the MAX_PROPOSALS best entries in a binary heap having the least
+   relevant one at the root, so each new entry costs at most O(log k) */
+static void
+add_top_snippet_entry (GArray *heap,
+                       const SnippetEntry *entry)
 {
-	gchar *cur_word = NULL, *name = NULL, *trigger = NULL, *cur_keyword = NULL;
-	gdouble relevance = 0.0, cur_relevance = 0.0, cur_keyword_relevance = 0.0;
-	GList *iter = NULL, *keywords = NULL, *keywords_down = NULL, *iter2 = NULL;
+	guint i = 0, parent = 0, child = 0;
 
-	/* Assertions */
-	g_return_val_if_fail (ANJUTA_IS_SNIPPET (snippet), 0.0);
+	if (heap->len < MAX_PROPOSALS)
+	{
+		g_array_append_vals (heap, entry, 1);
+		for (i = heap->len - 1; i > 0; i = parent)
+		{
+			parent = (i - 1) / 2;
+			if (HEAP_COMPARE (heap, i, parent) <= 0)
+				break;
+			swap_snippet_entries (heap, i, parent);
+		}
+		return;
+	}
 
-	/* If the user hasn't typed anything we just consider all snippets relevant */
-	if (words_list == NULL)
-		return 1.0;
+	/* Replace the root if the new entry is better */
+	if (compare_snippet_entries (entry, &g_array_index (heap, SnippetEntry, 0)) >= 0)
+		return;
+	g_array_index (heap, SnippetEntry, 0) = *entry;
 
-	/* Get the snippet data */
-	trigger  = g_utf8_strdown (snippet_get_trigger_key (snippet), -1);
-	name     = g_utf8_strdown (snippet_get_name (snippet), -1);
-	keywords = snippet_get_keywords_list (snippet);
-	for (iter = g_list_first (keywords); iter != NULL; iter = g_list_next (iter))
+	for (i = 0; (child = 2 * i + 1) < heap->len; i = child)
 	{
-		keywords_down = g_list_append (keywords_down, 
-		                               g_utf8_strdown ((gchar *)iter->data, -1));
+		if (child + 1 < heap->len && HEAP_COMPARE (heap, child + 1, child) > 0)
+			child ++;
+		if (HEAP_COMPARE (heap, child, i) <= 0)
+			break;
+		swap_snippet_entries (heap, i, child);
 	}
-	g_list_free (keywords);
+}
+
+/* Check that the snippet is still the one in the database for one of its
+   languages, a snippet removed only for some languages stays indexed */
+static gboolean
+snippet_is_in_db (AnjutaSnippet *snippet,
+                  SnippetsDB *snippets_db)
+{
+	const GList *l_iter = NULL;
 
-	/* We iterate over all the words */
-	for (iter = g_list_first (words_list); iter != NULL; iter = g_list_next (iter))
+	for (l_iter = snippet_get_languages (snippet); l_iter != NULL; l_iter = g_list_next (l_iter))
 	{
-		cur_word = (gchar *)iter->data;
+		if (snippets_db_get_snippet (snippets_db,
+		                             snippet_get_trigger_key (snippet),
+		                             (const gchar *)l_iter->data) == snippet)
+			return TRUE;
+	}
+
+	return FALSE;
+}
 
-		/* Check the trigger-key */
-		cur_relevance = get_relevance_for_word (cur_word, trigger);
-		cur_relevance *= TRIGGER_RELEVANCE;
-		relevance += cur_relevance;
+static void
+index_snippets_db_row (SnippetsProvider *snippets_provider,
+                       GtkTreeIter *iter)
+{
+	SnippetsProviderPrivate *priv = ANJUTA_SNIPPETS_PROVIDER_GET_PRIVATE (snippets_provider);
+	GtkTreeModel *model = GTK_TREE_MODEL (priv->snippets_db);
+	GObject *cur_object = NULL;
+	GtkTreeIter child;
 
-		/* Check the name */
-		cur_relevance = get_relevance_for_word (cur_word, name);
-		cur_relevance *= NAME_RELEVANCE;
-		relevance += cur_relevance;
+	gtk_tree_model_get (model, iter,
+	                    SNIPPETS_DB_MODEL_COL_CUR_OBJECT, &cur_object,
+	                    -1);
+	if (cur_object == NULL)
+		return;
 
-		/* Check each keyword */
-		cur_keyword_relevance = FIRST_KEYWORD_RELEVANCE;
-		for (iter2 = g_list_first (keywords_down); iter2 != NULL; iter2 = g_list_next (iter2))
+	if (ANJUTA_IS_SNIPPET (cur_object))
+	{
+		snippets_index_add_snippet (priv->snippets_index, ANJUTA_SNIPPET (cur_object));
+	}
+	else if (gtk_tree_model_iter_children (model, &child, iter))
+	{
+		/* A snippets group was added with its snippets */
+		do
 		{
-			/* If we have too many keywords */
-			if (cur_keyword_relevance < 0.0)
-				break;
+			index_snippets_db_row (snippets_provider, &child);
+		} while (gtk_tree_model_iter_next (model, &child));
+	}
+	g_object_unref (cur_object);
+}
 
-			cur_keyword = (gchar *)iter2->data;
+static void
+unindex_snippets_db_row (SnippetsProvider *snippets_provider,
+                         GtkTreeIter *iter,
+                         gboolean whole_group)
+{
+	SnippetsProviderPrivate *priv = ANJUTA_SNIPPETS_PROVIDER_GET_PRIVATE (snippets_provider);
+	GtkTreeModel *model = GTK_TREE_MODEL (priv->snippets_db);
+	GObject *cur_object = NULL;
+	GtkTreeIter child;
 
-			cur_relevance = get_relevance_for_word (cur_word, cur_keyword);
-			cur_relevance *= cur_keyword_relevance;
-			relevance += cur_relevance;
+	gtk_tree_model_get (model, iter,
+	                    SNIPPETS_DB_MODEL_COL_CUR_OBJECT, &cur_object,
+	                    -1);
+	if (cur_object == NULL)
+		return;
 
-			cur_keyword_relevance -= KEYWORD_RELEVANCE_DEC; 
-		}
+	if (ANJUTA_IS_SNIPPET (cur_object))
+	{
+		if (whole_group || !snippet_is_in_db (ANJUTA_SNIPPET (cur_object), priv->snippets_db))
+			snippets_index_remove_snippet (priv->snippets_index, ANJUTA_SNIPPET (cur_object));
 	}
-
-	return relevance;
+	else if (gtk_tree_model_iter_children (model, &child, iter))
+	{
+		/* A snippets group is removed with all its snippets */
+		do
+		{
+			unindex_snippets_db_row (snippets_provider, &child, TRUE);
+		} while (gtk_tree_model_iter_next (model, &child));
+	}
+	g_object_unref (cur_object);
 }
 
-static gint
-snippets_relevance_sort_func (gconstpointer a,
-                              gconstpointer b)
+static void
+on_snippets_db_row_inserted (GtkTreeModel *model,
+                             GtkTreePath *path,
+                             GtkTreeIter *iter,
+                             gpointer user_data)
 {
-	IAnjutaEditorAssistProposal *proposal1 = (IAnjutaEditorAssistProposal *)a,
-	                            *proposal2 = (IAnjutaEditorAssistProposal *)b;
-	SnippetEntry *entry1 = (SnippetEntry *)proposal1->data,
-	             *entry2 = (SnippetEntry *)proposal2->data;
+	index_snippets_db_row (ANJUTA_SNIPPETS_PROVIDER (user_data), iter);
+}
 
-	if (entry1->relevance - entry2->relevance == 0.0)
-		return g_strcmp0 (snippet_get_name (entry1->snippet),
-		                  snippet_get_name (entry2->snippet));
+/* The database emits the signal before removing the row, so it can still
+   be read here */
+static void
+on_snippets_db_row_deleted (GtkTreeModel *model,
+                            GtkTreePath *path,
+                            gpointer user_data)
+{
+	GtkTreeIter iter;
 
-	return (gint)(entry2->relevance - entry1->relevance);
+	if (gtk_tree_model_get_iter (model, &iter, path))
+		unindex_snippets_db_row (ANJUTA_SNIPPETS_PROVIDER (user_data), &iter, FALSE);
 }
 
 static IAnjutaEditorAssistProposal*
 get_proposal_for_snippet (AnjutaSnippet *snippet,
                           SnippetsDB *snippets_db,
-                          GList *words_list)
+                          gdouble relevance)
 {
 	IAnjutaEditorAssistProposal *proposal = NULL;
 	SnippetEntry *entry = NULL;
@@ -268,7 +346,7 @@ get_proposal_for_snippet (AnjutaSnippet *snippet,
 
 	/* Fill the data field */
 	entry->snippet   = snippet;
-	entry->relevance = get_relevance_for_snippet (snippet, words_list);
+	entry->relevance = relevance;
 	proposal->data = entry;
 
 	return proposal;
@@ -358,15 +436,16 @@ build_suggestions_list (SnippetsProvider *snippets_provider,
                         IAnjutaIterable *cur_cursor_position)
 {
 	SnippetsProviderPrivate *priv = NULL;
-	GtkTreeIter iter, iter2;
-	GObject *cur_object = NULL;
-	IAnjutaEditorAssistProposal *cur_proposal = NULL;
-	SnippetEntry *cur_entry = NULL;
+	GHashTable *relevances = NULL;
+	GHashTableIter h_iter;
+	gpointer snippet = NULL, relevance = NULL;
+	GArray *heap = NULL;
+	SnippetEntry cur_entry;
 	gchar *search_string = NULL, **words = NULL;
 	gboolean show_all_languages = FALSE;
 	const gchar *language = NULL;
 	gint i = 0;
-	GList *words_list = NULL, *l_iter = NULL;
+	GList *words_list = NULL, *removed_snippets = NULL, *l_iter = NULL;
 
 	/* Assertions */
 	g_return_if_fail (ANJUTA_IS_SNIPPETS_PROVIDER (snippets_provider));
@@ -407,56 +486,46 @@ build_suggestions_list (SnippetsProvider *snippets_provider,
 	}
 	g_strfreev (words);
 
-	if (!gtk_tree_model_get_iter_first (GTK_TREE_MODEL (priv->snippets_db), &iter))
-		return;
+	/* Get the relevant snippets from the index and keep the best ones */
+	relevances = snippets_index_search (priv->snippets_index, words_list);
+	heap = g_array_sized_new (FALSE, FALSE, sizeof (SnippetEntry), MAX_PROPOSALS);
 
-	do
+	g_hash_table_iter_init (&h_iter, relevances);
+	while (g_hash_table_iter_next (&h_iter, &snippet, &relevance))
 	{
-		/* Get the children for the current snippets group */
-		if (!gtk_tree_model_iter_children (GTK_TREE_MODEL (priv->snippets_db), &iter2, &iter))
+		/* If the current snippet isn't meant for the current editor language, we ignore it */
+		if (!show_all_languages && !snippet_has_language (ANJUTA_SNIPPET (snippet), language))
 			continue;
 
-		/* Iterate over the snippets */
-		do
+		if (!snippet_is_in_db (ANJUTA_SNIPPET (snippet), priv->snippets_db))
 		{
-			gtk_tree_model_get (GTK_TREE_MODEL (priv->snippets_db), &iter2,
-			                    SNIPPETS_DB_MODEL_COL_CUR_OBJECT, &cur_object,
-			                    -1);
-			g_object_unref (cur_object);
-
-			if (!ANJUTA_IS_SNIPPET (cur_object))
-				continue;
-
-			/* If the current snippet isn't meant for the current editor language, we ignore it */
-			if (!show_all_languages && !snippet_has_language (ANJUTA_SNIPPET (cur_object), language))
-				continue;
-			
-			/* Build a proposal for the current snippet based on the words the user typed */
-			cur_proposal = get_proposal_for_snippet (ANJUTA_SNIPPET (cur_object),
-			                                         priv->snippets_db,
-			                                         words_list);
-
-			/* If the snippet isn't relevant for the typed text, we neglect this proposal */
-			cur_entry = (SnippetEntry *)cur_proposal->data;
-			if (cur_entry->relevance == 0.0)
-			{
-				g_free (cur_entry);
-				g_free (cur_proposal->markup);
-				g_free (cur_proposal);
-
-				continue;
-			}
-
-			/* We add the proposal to the suggestions list */
-			priv->suggestions_list = g_list_insert_sorted (priv->suggestions_list,
-			                                               cur_proposal,
-			                                               snippets_relevance_sort_func);
-
-		} while (gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->snippets_db), &iter2));
-
-	} while (gtk_tree_model_iter_next (GTK_TREE_MODEL (priv->snippets_db), &iter));
+			removed_snippets = g_list_prepend (removed_snippets, snippet);
+			continue;
+		}
+
+		cur_entry.snippet   = ANJUTA_SNIPPET (snippet);
+		cur_entry.relevance = *(gdouble *)relevance;
+		add_top_snippet_entry (heap, &cur_entry);
+	}
+
+	/* Build the proposals from the most relevant snippet */
+	g_array_sort (heap, compare_snippet_entries);
+	for (i = (gint)heap->len - 1; i >= 0; i --)
+	{
+		cur_entry = g_array_index (heap, SnippetEntry, i);
+		priv->suggestions_list = g_list_prepend (priv->suggestions_list,
+		                                         get_proposal_for_snippet (cur_entry.snippet,
+		                                                                   priv->snippets_db,
+		                                                                   cur_entry.relevance));
+	}
+
+	for (l_iter = removed_snippets; l_iter != NULL; l_iter = g_list_next (l_iter))
+		snippets_index_remove_snippet (priv->snippets_index, ANJUTA_SNIPPET (l_iter->data));
 
 	/* Free the data */
+	g_list_free (removed_snippets);
+	g_array_free (heap, TRUE);
+	g_hash_table_destroy (relevances);
 	g_free (search_string);
 	for (l_iter = g_list_first (words_list); l_iter != NULL; l_iter = g_list_next (l_iter))
 		g_free (l_iter->data);
@@ -522,6 +591,7 @@ snippets_provider_new (SnippetsDB *snippets_db,
 {
 	SnippetsProvider *snippets_provider = NULL;
 	SnippetsProviderPrivate *priv = NULL;
+	GtkTreeIter iter;
 
 	/* Assertions */
 	g_return_val_if_fail (ANJUTA_IS_SNIPPETS_DB (snippets_db), NULL);
@@ -533,6 +603,23 @@ snippets_provider_new (SnippetsDB *snippets_db,
 	priv->snippets_db          = snippets_db;
 	priv->snippets_interaction = snippets_interaction;
 
+	/* Index the snippets already loaded and then follow the changes of the
+	   database. A snippet replaced without a removal is still dropped when
+	   it shows up in a search. */
+	if (gtk_tree_model_get_iter_first (GTK_TREE_MODEL (snippets_db), &iter))
+	{
+		do
+		{
+			index_snippets_db_row (snippets_provider, &iter);
+		} while (gtk_tree_model_iter_next (GTK_TREE_MODEL (snippets_db), &iter));
+	}
+	g_signal_connect_object (snippets_db, "row-inserted",
+	                         G_CALLBACK (on_snippets_db_row_inserted),
+	                         snippets_provider, 0);
+	g_signal_connect_object (snippets_db, "row-deleted",
+	                         G_CALLBACK (on_snippets_db_row_deleted),
+	                         snippets_provider, 0);
+
 	return snippets_provider;
 }
 
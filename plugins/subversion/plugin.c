@@ -554,6 +554,8 @@ activate_plugin (AnjutaPlugin *plugin)
 					  G_CALLBACK (on_session_save), plugin);
     g_signal_connect (plugin->shell, "load_session",
 					  G_CALLBACK (on_session_load), plugin);
+	
+	subversion->status_cache = svn_status_cache_new (subversion);
 							 
 	return TRUE;
 }
@@ -578,12 +580,16 @@ deactivate_plugin (AnjutaPlugin *plugin)
 	g_object_unref (ANJUTA_PLUGIN_SUBVERSION (plugin)->log_bxml);
 	g_list_free(ANJUTA_PLUGIN_SUBVERSION (plugin)->svn_commit_logs);
 	
+	svn_status_cache_free (subversion->status_cache);
+	subversion->status_cache = NULL;
+	
 	return TRUE;
 }
 
 static void
 finalize (GObject *obj)
 {
+	svn_command_free_client_contexts ();
 	apr_terminate ();
 	G_OBJECT_CLASS (parent_class)->finalize (obj);
 }
@@ -607,6 +613,7 @@ subversion_instance_init (GObject *obj)
 	plugin->current_editor_filename = NULL;
 	plugin->log_bxml = NULL;
 	plugin->log_viewer = NULL;
+	plugin->status_cache = NULL;
 	
 	apr_initialize ();
 }
@@ -80,6 +80,9 @@ struct _Subversion{
 	GtkWidget *log_viewer;
 	
 	GList *svn_commit_logs;
+	
+	/* Status of working copy files */
+	struct _SvnStatusCache *status_cache;
 };
 
 struct _SubversionClass{
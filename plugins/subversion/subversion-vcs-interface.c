@@ -183,38 +183,6 @@ subversion_ivcs_diff (IAnjutaVcs *obj, GFile* file,
 	anjuta_command_start (ANJUTA_COMMAND (diff_command));
 }
 
-/* FIXME: The stuff in subversion-ui-utils.c should be namespaced. */
-static void
-on_ivcs_status_command_data_arrived (AnjutaCommand *command, 
-									 IAnjutaVcsStatusCallback callback)
-{
-	GQueue *status_queue;
-	SvnStatus *status;
-	gchar *path;
-	GFile *file;
-	
-	status_queue = svn_status_command_get_status_queue (SVN_STATUS_COMMAND (command));
-	
-	while (g_queue_peek_head (status_queue))
-	{
-		status = g_queue_pop_head (status_queue);
-		path = svn_status_get_path (status);
-		file = g_file_new_for_path (path);
-		
-		if (file)
-		{
-			callback (file, 
-					  svn_status_get_vcs_status (status),
-					  g_object_get_data (G_OBJECT (command), "user-data"));
-			
-			g_object_unref (file);
-		}
-		
-		svn_status_destroy (status);
-		g_free (path);
-	}
-}
-
 void 
 subversion_ivcs_query_status (IAnjutaVcs *obj, GFile *file, 
 							  IAnjutaVcsStatusCallback callback,
@@ -222,38 +190,12 @@ subversion_ivcs_query_status (IAnjutaVcs *obj, GFile *file,
 							  AnjutaAsyncNotify *notify, GError **err)
 {
 	gchar *path;
-	SvnStatusCommand *status_command;
 	
 	path = g_file_get_path (file);
-	status_command = svn_status_command_new (path, FALSE, TRUE);
+	svn_status_cache_query (ANJUTA_PLUGIN_SUBVERSION (obj)->status_cache,
+							path, callback, user_data, cancel, notify);
 	
 	g_free (path);
-	
-	g_object_set_data (G_OBJECT (status_command), "user-data", user_data);
-	
-	g_signal_connect (G_OBJECT (status_command), "data-arrived",
-					  G_CALLBACK (on_ivcs_status_command_data_arrived),
-					  callback);
-	
-	g_signal_connect (G_OBJECT (status_command), "command-finished",
-					  G_CALLBACK (g_object_unref),
-					  NULL);
-	
-	if (cancel)
-	{
-		g_signal_connect_swapped (G_OBJECT (cancel), "cancelled",
-								  G_CALLBACK (anjuta_command_cancel),
-								  status_command);
-	}
-	
-	if (notify)
-	{
-		g_signal_connect_swapped (G_OBJECT (status_command), "command-finished",
-								  G_CALLBACK (anjuta_async_notify_notify_finished),
-								  notify);
-	}
-	
-	anjuta_command_start (ANJUTA_COMMAND (status_command));
 }
 
 void 
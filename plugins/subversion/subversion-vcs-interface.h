@@ -32,6 +32,7 @@
 #include "svn-checkout-command.h"
 #include "svn-diff-command.h"
 #include "svn-status-command.h"
+#include "svn-status-cache.h"
 #include "svn-remove-command.h"
 
 #include "subversion-ui-utils.h"
@@ -24,8 +24,24 @@
 
 #include "svn-command.h"
 
+/* Creating a client context means reading the whole Subversion configuration
+ * from disk and building the authentication providers, so initialized
+ * contexts are kept in a pool shared by all commands and reused. */
+#define SVN_COMMAND_MAX_IDLE_CONTEXTS 4
+
+typedef struct
+{
+	apr_pool_t *pool;
+	svn_client_ctx_t *client_context;
+	SvnCommand *command;	/* Command using this context, used by prompts */
+} SvnClientContext;
+
+G_LOCK_DEFINE_STATIC (svn_command_contexts);
+static GList *svn_command_idle_contexts = NULL;
+
 struct _SvnCommandPriv
 {
+	SvnClientContext *context;
 	svn_client_ctx_t *client_context;
 	apr_pool_t *pool;
 	GQueue *info_messages;
@@ -249,13 +265,13 @@ svn_auth_simple_prompt_func_cb (svn_auth_cred_simple_t **cred, void *baton,
 
 	args = g_new0 (SimplePromptArgs, 1);
 	args->cred = cred;
-	args->baton = baton;
 	args->realm = g_strdup (realm);
 	args->username = g_strdup (username);
 	args->may_save = may_save;
 	args->pool = pool;
 	
-	svn_command = SVN_COMMAND (baton);
+	svn_command = ((SvnClientContext *) baton)->command;
+	args->baton = svn_command;
 	
 	/* Wait for the dialog to finish */
 	g_mutex_lock (svn_command->priv->dialog_finished_lock);
@@ -297,7 +313,6 @@ svn_auth_ssl_server_trust_prompt_func_cb (svn_auth_cred_ssl_server_trust_t **cre
 	
 	args = g_new0 (SSLServerTrustArgs, 1);
 	args->cred = cred;
-	args->baton = baton;
 	args->realm = g_strdup (realm);
 	args->failures = failures;
 	args->cert_info = g_memdup (cert_info, 
@@ -305,7 +320,8 @@ svn_auth_ssl_server_trust_prompt_func_cb (svn_auth_cred_ssl_server_trust_t **cre
 	args->may_save = may_save;
 	args->pool = pool;
 	
-	svn_command = SVN_COMMAND (baton);
+	svn_command = ((SvnClientContext *) baton)->command;
+	args->baton = svn_command;
 
 	/* Wait for the dialog to finish */
 	g_mutex_lock (svn_command->priv->dialog_finished_lock);
@@ -471,88 +487,159 @@ on_svn_cancel (gpointer cancel_baton)
 		return SVN_NO_ERROR;
 }
 
-static void
-svn_command_init (SvnCommand *self)
+static SvnClientContext *
+svn_client_context_new (void)
 {
+	SvnClientContext *context;
 	svn_auth_baton_t *auth_baton;
 	apr_array_header_t *providers;
 	svn_auth_provider_object_t *provider;
 	
-	self->priv = g_new0 (SvnCommandPriv, 1);
+	context = g_new0 (SvnClientContext, 1);
 	
-	self->priv->pool = svn_pool_create (NULL);
-	svn_client_create_context (&self->priv->client_context, self->priv->pool);
-	self->priv->client_context->notify_func2 = on_svn_notify;
-	self->priv->client_context->notify_baton2 = self;
-	self->priv->client_context->cancel_func = on_svn_cancel;
-	self->priv->client_context->cancel_baton = self;
+	context->pool = svn_pool_create (NULL);
+	svn_client_create_context (&context->client_context, context->pool);
 	
-	svn_config_get_config (&(self->priv->client_context)->config,
+	svn_config_get_config (&(context->client_context)->config,
 						   NULL, /* default dir */
-						   self->priv->pool);
-	
-	self->priv->info_messages = g_queue_new ();
-	self->priv->dialog_finished_lock = g_mutex_new ();
-	self->priv->dialog_finished_condition = g_cond_new ();
+						   context->pool);
 	
 	/* Fill in the auth baton callbacks */
-	providers = apr_array_make (self->priv->pool, 1, 
+	providers = apr_array_make (context->pool, 1, 
 								sizeof (svn_auth_provider_object_t *));
 	
 	/* Provider that authenticates username/password from ~/.subversion */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
-	svn_client_get_simple_provider (&provider, self->priv->pool);
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
+	svn_client_get_simple_provider (&provider, context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that authenticates server trust from ~/.subversion */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
-	svn_client_get_ssl_server_trust_file_provider (&provider, self->priv->pool);
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
+	svn_client_get_ssl_server_trust_file_provider (&provider, context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that authenticates client cert from ~/.subversion */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
-	svn_client_get_ssl_client_cert_file_provider (&provider, self->priv->pool);
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
+	svn_client_get_ssl_client_cert_file_provider (&provider, context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that authenticates client cert password from ~/.subversion */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
 	svn_client_get_ssl_client_cert_pw_file_provider (&provider, 
-													 self->priv->pool);
+													 context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
-	/* Provider that prompts for username/password */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
+	/* Provider that prompts for username/password. The baton is the pooled
+	 * context, the prompt finds the command currently using it */
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
 	svn_client_get_simple_prompt_provider(&provider,
 										  svn_auth_simple_prompt_func_cb,
-										  self, 3, self->priv->pool);
+										  context, 3, context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that prompts for server trust */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
 	svn_client_get_ssl_server_trust_prompt_provider (&provider,
 													 svn_auth_ssl_server_trust_prompt_func_cb,
-													 self, 
-													 self->priv->pool);
+													 context, 
+													 context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that prompts for client certificate file */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
 	svn_client_get_ssl_client_cert_prompt_provider (&provider,
 													svn_auth_ssl_client_cert_prompt_func_cb,
-													NULL, 3, self->priv->pool);
+													NULL, 3, context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
 	/* Provider that prompts for client certificate file password */
-	provider = apr_pcalloc (self->priv->pool, sizeof(*provider));
+	provider = apr_pcalloc (context->pool, sizeof(*provider));
 	svn_client_get_ssl_client_cert_pw_prompt_provider (&provider,
 													   svn_auth_ssl_client_cert_pw_prompt_func_cb,
 													   NULL, 3, 
-													   self->priv->pool);
+													   context->pool);
 	*(svn_auth_provider_object_t **)apr_array_push (providers) = provider;
 	
-	svn_auth_open (&auth_baton, providers, self->priv->pool);
-	self->priv->client_context->auth_baton = auth_baton;
+	svn_auth_open (&auth_baton, providers, context->pool);
+	context->client_context->auth_baton = auth_baton;
+	
+	return context;
+}
+
+static void
+svn_client_context_free (SvnClientContext *context)
+{
+	svn_pool_destroy (context->pool);
+	g_free (context);
+}
+
+/* Get an initialized context from the pool or create a new one. Commands
+ * can be created from any thread */
+static SvnClientContext *
+svn_client_context_acquire (SvnCommand *command)
+{
+	SvnClientContext *context = NULL;
+	
+	G_LOCK (svn_command_contexts);
+	if (svn_command_idle_contexts != NULL)
+	{
+		context = (SvnClientContext *) svn_command_idle_contexts->data;
+		svn_command_idle_contexts = g_list_delete_link (svn_command_idle_contexts,
+		                                                svn_command_idle_contexts);
+	}
+	G_UNLOCK (svn_command_contexts);
+	
+	if (context == NULL)
+		context = svn_client_context_new ();
 	
+	context->command = command;
+	context->client_context->notify_func2 = on_svn_notify;
+	context->client_context->notify_baton2 = command;
+	context->client_context->cancel_func = on_svn_cancel;
+	context->client_context->cancel_baton = command;
+	
+	return context;
+}
+
+static void
+svn_client_context_release (SvnClientContext *context)
+{
+	/* Remove all references to the command */
+	context->command = NULL;
+	context->client_context->notify_func2 = NULL;
+	context->client_context->notify_baton2 = NULL;
+	context->client_context->cancel_func = NULL;
+	context->client_context->cancel_baton = NULL;
+	context->client_context->log_msg_func = NULL;
+	context->client_context->log_msg_baton = NULL;
+	
+	G_LOCK (svn_command_contexts);
+	if (g_list_length (svn_command_idle_contexts) < SVN_COMMAND_MAX_IDLE_CONTEXTS)
+	{
+		svn_command_idle_contexts = g_list_prepend (svn_command_idle_contexts,
+		                                            context);
+		context = NULL;
+	}
+	G_UNLOCK (svn_command_contexts);
+	
+	if (context != NULL)
+		svn_client_context_free (context);
+}
+
+static void
+svn_command_init (SvnCommand *self)
+{
+	self->priv = g_new0 (SvnCommandPriv, 1);
+	
+	/* The command pool is used for the operation itself, it is small and
+	 * destroyed with the command */
+	self->priv->pool = svn_pool_create (NULL);
+	self->priv->context = svn_client_context_acquire (self);
+	self->priv->client_context = self->priv->context->client_context;
+	
+	self->priv->info_messages = g_queue_new ();
+	self->priv->dialog_finished_lock = g_mutex_new ();
+	self->priv->dialog_finished_condition = g_cond_new ();
 }
 
 static void
@@ -563,6 +650,8 @@ svn_command_finalize (GObject *object)
 	
 	self = SVN_COMMAND (object);
 	
+	svn_client_context_release (self->priv->context);
+	
 	svn_pool_clear (self->priv->pool);
 	svn_pool_destroy (self->priv->pool);
 	
@@ -672,6 +761,20 @@ svn_command_make_canonical_path (SvnCommand *self, const gchar *path)
 	return g_strdup (canonical_path);
 }
 
+/* Free the unused client contexts, it has to be done before terminating APR */
+void
+svn_command_free_client_contexts (void)
+{
+	GList *contexts;
+	
+	G_LOCK (svn_command_contexts);
+	contexts = svn_command_idle_contexts;
+	svn_command_idle_contexts = NULL;
+	G_UNLOCK (svn_command_contexts);
+	
+	g_list_free_full (contexts, (GDestroyNotify) svn_client_context_free);
+}
+
 svn_opt_revision_t *
 svn_command_get_revision (const gchar *revision)
 {
@@ -70,6 +70,7 @@ gchar *svn_command_make_canonical_path (SvnCommand *self, const gchar *path);
 svn_opt_revision_t *svn_command_get_revision (const gchar *revision);
 GList *svn_command_copy_path_list (GList *list);
 void svn_command_free_path_list (GList *list);
+void svn_command_free_client_contexts (void);
 
 G_END_DECLS
 
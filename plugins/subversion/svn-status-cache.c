@@ -0,0 +1,581 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software.
+ * 
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+/* Keep the status of all files of a working copy in memory. The whole tree
+ * is read by one recursive status command, then directory queries are
+ * answered from the cache until a file monitor reports a change or the
+ * cache gets too old. Queried directories are monitored for edits, the
+ * administrative files (.svn/entries in each directory or the wc.db of a
+ * Subversion 1.7 working copy) for operations done outside Anjuta. */
+
+#include <string.h>
+
+#include "svn-status-cache.h"
+#include "svn-status-command.h"
+
+/* Read the whole tree again after this time, edits in directories without
+ * monitor are not noticed otherwise */
+#define SVN_STATUS_CACHE_TTL	(60 * G_USEC_PER_SEC)
+
+typedef struct _SvnStatusCacheRoot SvnStatusCacheRoot;
+
+struct _SvnStatusCache
+{
+	Subversion *plugin;
+	GList *roots;
+};
+
+/* One recursive status walk */
+struct _SvnStatusCacheRoot
+{
+	SvnStatusCache *cache;
+	gchar *path;
+	GHashTable *status;		/* path -> AnjutaVcsStatus */
+	GHashTable *children;	/* directory path -> GPtrArray of paths */
+	GHashTable *monitors;	/* directory path -> GFileMonitor */
+	GHashTable *admin_monitors;	/* directory path -> GFileMonitor on .svn/entries */
+	GFileMonitor *wc_db_monitor;
+	SvnStatusCommand *command;
+	gboolean valid;
+	gint64 timestamp;
+	gboolean restart;
+	GQueue queries;
+	guint idle_id;
+};
+
+typedef struct
+{
+	gchar *path;
+	IAnjutaVcsStatusCallback callback;
+	gpointer user_data;
+	GCancellable *cancel;
+	AnjutaAsyncNotify *notify;
+} SvnStatusQuery;
+
+static void svn_status_cache_root_update (SvnStatusCacheRoot *root);
+
+static void
+svn_status_cache_root_invalidate (SvnStatusCacheRoot *root)
+{
+	DEBUG_PRINT ("Subversion status cache of %s invalidated", root->path);
+	root->valid = FALSE;
+
+	/* Restart the walk, it could have already read the changed files */
+	if (root->command != NULL)
+	{
+		root->restart = TRUE;
+		anjuta_command_cancel (ANJUTA_COMMAND (root->command));
+	}
+}
+
+/* Queries
+ *---------------------------------------------------------------------------*/
+
+static void
+svn_status_query_free (SvnStatusQuery *query)
+{
+	g_free (query->path);
+	if (query->cancel != NULL) g_object_unref (query->cancel);
+	if (query->notify != NULL) g_object_unref (query->notify);
+	g_free (query);
+}
+
+static void
+svn_status_query_report (SvnStatusCacheRoot *root, SvnStatusQuery *query,
+                         const gchar *path)
+{
+	gpointer status;
+
+	if (g_hash_table_lookup_extended (root->status, path, NULL, &status))
+	{
+		GFile *file;
+
+		file = g_file_new_for_path (path);
+		query->callback (file, GPOINTER_TO_INT (status), query->user_data);
+		g_object_unref (file);
+	}
+}
+
+/* Directory monitors
+ *---------------------------------------------------------------------------*/
+
+static void
+on_monitor_changed (GFileMonitor *monitor, GFile *file, GFile *other_file,
+                    GFileMonitorEvent event_type, SvnStatusCacheRoot *root)
+{
+	switch (event_type)
+	{
+	case G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT:
+	case G_FILE_MONITOR_EVENT_ATTRIBUTE_CHANGED:
+	case G_FILE_MONITOR_EVENT_PRE_UNMOUNT:
+		break;
+	default:
+		svn_status_cache_root_invalidate (root);
+		break;
+	}
+}
+
+static GFileMonitor *
+svn_status_cache_root_monitor (SvnStatusCacheRoot *root, const gchar *path,
+                               gboolean directory)
+{
+	GFile *file;
+	GFileMonitor *monitor;
+
+	file = g_file_new_for_path (path);
+	if (directory)
+		monitor = g_file_monitor_directory (file, G_FILE_MONITOR_NONE, NULL, NULL);
+	else
+		monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, NULL);
+	g_object_unref (file);
+
+	if (monitor != NULL)
+	{
+		g_signal_connect (monitor, "changed",
+		                  G_CALLBACK (on_monitor_changed), root);
+	}
+
+	return monitor;
+}
+
+static void
+svn_status_cache_monitor_free (GFileMonitor *monitor)
+{
+	if (monitor == NULL) return;
+
+	g_signal_handlers_disconnect_matched (monitor, G_SIGNAL_MATCH_FUNC,
+	                                      0, 0, NULL, on_monitor_changed, NULL);
+	g_file_monitor_cancel (monitor);
+	g_object_unref (monitor);
+}
+
+/* Subversion 1.7 keeps the state of the whole working copy in a single
+ * database at its top, older versions have a .svn/entries file in each
+ * directory. Returns the path of the database or NULL. */
+static gchar *
+svn_status_cache_find_wc_db (const gchar *path)
+{
+	gchar *dir;
+
+	dir = g_strdup (path);
+	while (dir != NULL)
+	{
+		gchar *admin_dir;
+		gchar *wc_db;
+		gchar *parent;
+
+		admin_dir = g_build_filename (dir, ".svn", NULL);
+		wc_db = g_build_filename (admin_dir, "wc.db", NULL);
+		if (g_file_test (wc_db, G_FILE_TEST_IS_REGULAR))
+		{
+			g_free (admin_dir);
+			g_free (dir);
+
+			return wc_db;
+		}
+		g_free (wc_db);
+
+		/* Old working copy */
+		if (g_file_test (admin_dir, G_FILE_TEST_IS_DIR))
+		{
+			g_free (admin_dir);
+			break;
+		}
+		g_free (admin_dir);
+
+		parent = g_path_get_dirname (dir);
+		if (strcmp (parent, dir) == 0)
+		{
+			g_free (parent);
+			break;
+		}
+		g_free (dir);
+		dir = parent;
+	}
+	g_free (dir);
+
+	return NULL;
+}
+
+static gboolean
+is_admin_monitor_obsolete (const gchar *dir, GFileMonitor *monitor,
+                           SvnStatusCacheRoot *root)
+{
+	return (strcmp (dir, root->path) != 0) &&
+		!g_hash_table_lookup_extended (root->children, dir, NULL, NULL);
+}
+
+static void
+svn_status_cache_root_monitor_admin (SvnStatusCacheRoot *root, const gchar *dir)
+{
+	gchar *entries;
+
+	if (g_hash_table_lookup_extended (root->admin_monitors, dir, NULL, NULL))
+		return;
+
+	entries = g_build_filename (dir, ".svn", "entries", NULL);
+	if (g_file_test (entries, G_FILE_TEST_IS_REGULAR))
+	{
+		g_hash_table_insert (root->admin_monitors, g_strdup (dir),
+		                     svn_status_cache_root_monitor (root, entries, FALSE));
+	}
+	g_free (entries);
+}
+
+/* Follow the administrative files of all directories read by the walk */
+static void
+svn_status_cache_root_update_admin_monitors (SvnStatusCacheRoot *root)
+{
+	GHashTableIter iter;
+	gpointer dir;
+
+	/* The whole working copy is already followed */
+	if (root->wc_db_monitor != NULL) return;
+
+	g_hash_table_foreach_remove (root->admin_monitors,
+	                             (GHRFunc) is_admin_monitor_obsolete, root);
+
+	svn_status_cache_root_monitor_admin (root, root->path);
+	g_hash_table_iter_init (&iter, root->children);
+	while (g_hash_table_iter_next (&iter, &dir, NULL))
+	{
+		svn_status_cache_root_monitor_admin (root, (const gchar *) dir);
+	}
+}
+
+/* Answer a query from the cache, first the directory itself then its
+ * children like a non recursive status command. */
+static void
+svn_status_cache_root_answer (SvnStatusCacheRoot *root, SvnStatusQuery *query)
+{
+	if ((query->cancel == NULL) || !g_cancellable_is_cancelled (query->cancel))
+	{
+		GPtrArray *children;
+
+		svn_status_query_report (root, query, query->path);
+
+		children = g_hash_table_lookup (root->children, query->path);
+		if (children != NULL)
+		{
+			guint i;
+
+			for (i = 0; i < children->len; i++)
+			{
+				svn_status_query_report (root, query,
+				                         g_ptr_array_index (children, i));
+			}
+
+			if (!g_hash_table_lookup_extended (root->monitors, query->path, NULL, NULL))
+			{
+				g_hash_table_insert (root->monitors, g_strdup (query->path),
+				                     svn_status_cache_root_monitor (root, query->path, TRUE));
+			}
+		}
+	}
+
+	if (query->notify != NULL)
+		anjuta_async_notify_notify_finished (query->notify);
+}
+
+static void
+svn_status_cache_root_answer_all (SvnStatusCacheRoot *root)
+{
+	SvnStatusQuery *query;
+
+	while ((query = g_queue_pop_head (&root->queries)) != NULL)
+	{
+		svn_status_cache_root_answer (root, query);
+		svn_status_query_free (query);
+	}
+}
+
+static gboolean
+on_root_idle (SvnStatusCacheRoot *root)
+{
+	root->idle_id = 0;
+	svn_status_cache_root_update (root);
+
+	return FALSE;
+}
+
+/* Status walk
+ *---------------------------------------------------------------------------*/
+
+static void
+on_status_command_data_arrived (AnjutaCommand *command, SvnStatusCacheRoot *root)
+{
+	GQueue *status_queue;
+	SvnStatus *status;
+
+	status_queue = svn_status_command_get_status_queue (SVN_STATUS_COMMAND (command));
+
+	while ((status = g_queue_pop_head (status_queue)) != NULL)
+	{
+		gchar *path;
+
+		path = svn_status_get_path (status);
+		if (!g_hash_table_lookup_extended (root->status, path, NULL, NULL) &&
+		    (strcmp (path, root->path) != 0))
+		{
+			gchar *dir;
+			GPtrArray *children;
+
+			dir = g_path_get_dirname (path);
+			children = g_hash_table_lookup (root->children, dir);
+			if (children == NULL)
+			{
+				children = g_ptr_array_new_with_free_func (g_free);
+				g_hash_table_insert (root->children, dir, children);
+			}
+			else
+			{
+				g_free (dir);
+			}
+			g_ptr_array_add (children, g_strdup (path));
+		}
+		g_hash_table_replace (root->status, path,
+		                      GINT_TO_POINTER (svn_status_get_vcs_status (status)));
+
+		svn_status_destroy (status);
+	}
+}
+
+static void
+on_status_command_finished (AnjutaCommand *command, guint return_code,
+                            SvnStatusCacheRoot *root)
+{
+	root->command = NULL;
+	g_object_unref (command);
+
+	if (root->restart)
+	{
+		root->restart = FALSE;
+		svn_status_cache_root_update (root);
+	}
+	else
+	{
+		DEBUG_PRINT ("Subversion status of %s read, %d files",
+		             root->path, g_hash_table_size (root->status));
+		root->valid = TRUE;
+		root->timestamp = g_get_monotonic_time ();
+		svn_status_cache_root_update_admin_monitors (root);
+		svn_status_cache_root_answer_all (root);
+
+		/* Try again on the next query if the walk has failed */
+		if (return_code != 0) root->valid = FALSE;
+	}
+}
+
+static void
+svn_status_cache_root_start (SvnStatusCacheRoot *root)
+{
+	g_hash_table_remove_all (root->status);
+	g_hash_table_remove_all (root->children);
+
+	root->command = svn_status_command_new (root->path, TRUE, TRUE);
+	g_signal_connect (G_OBJECT (root->command), "data-arrived",
+	                  G_CALLBACK (on_status_command_data_arrived), root);
+	g_signal_connect (G_OBJECT (root->command), "command-finished",
+	                  G_CALLBACK (on_status_command_finished), root);
+
+	anjuta_command_start (ANJUTA_COMMAND (root->command));
+}
+
+static void
+svn_status_cache_root_update (SvnStatusCacheRoot *root)
+{
+	if (root->valid)
+	{
+		svn_status_cache_root_answer_all (root);
+	}
+	else if ((root->command == NULL) && !g_queue_is_empty (&root->queries))
+	{
+		svn_status_cache_root_start (root);
+	}
+}
+
+static SvnStatusCacheRoot *
+svn_status_cache_root_new (SvnStatusCache *cache, const gchar *path)
+{
+	SvnStatusCacheRoot *root;
+	gchar *wc_db;
+
+	root = g_new0 (SvnStatusCacheRoot, 1);
+	root->cache = cache;
+	root->path = g_strdup (path);
+	root->status = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                      g_free, NULL);
+	root->children = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                        g_free, (GDestroyNotify) g_ptr_array_unref);
+	root->monitors = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                        g_free, (GDestroyNotify) svn_status_cache_monitor_free);
+	root->admin_monitors = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                              g_free, (GDestroyNotify) svn_status_cache_monitor_free);
+	g_queue_init (&root->queries);
+
+	/* Subversion operations done outside Anjuta change the administrative
+	 * files, the .svn/entries of old working copies are monitored after
+	 * each walk */
+	wc_db = svn_status_cache_find_wc_db (path);
+	if (wc_db != NULL)
+		root->wc_db_monitor = svn_status_cache_root_monitor (root, wc_db, FALSE);
+	g_free (wc_db);
+
+	return root;
+}
+
+static void
+svn_status_cache_root_free (SvnStatusCacheRoot *root)
+{
+	if (root->command != NULL)
+	{
+		g_signal_handlers_disconnect_by_func (root->command,
+		                                      on_status_command_data_arrived,
+		                                      root);
+		g_signal_handlers_disconnect_by_func (root->command,
+		                                      on_status_command_finished,
+		                                      root);
+		g_signal_connect (G_OBJECT (root->command), "command-finished",
+		                  G_CALLBACK (g_object_unref), NULL);
+		anjuta_command_cancel (ANJUTA_COMMAND (root->command));
+	}
+	if (root->idle_id != 0) g_source_remove (root->idle_id);
+
+	g_queue_foreach (&root->queries, (GFunc) svn_status_query_free, NULL);
+	g_queue_clear (&root->queries);
+
+	svn_status_cache_monitor_free (root->wc_db_monitor);
+	g_hash_table_destroy (root->admin_monitors);
+	g_hash_table_destroy (root->monitors);
+	g_hash_table_destroy (root->children);
+	g_hash_table_destroy (root->status);
+	g_free (root->path);
+	g_free (root);
+}
+
+static gboolean
+is_path_inside (const gchar *path, const gchar *dir)
+{
+	gsize len = strlen (dir);
+
+	return (strncmp (path, dir, len) == 0) &&
+		((path[len] == '\0') || (path[len] == G_DIR_SEPARATOR));
+}
+
+static SvnStatusCacheRoot *
+svn_status_cache_get_root (SvnStatusCache *cache, const gchar *path)
+{
+	SvnStatusCacheRoot *root;
+	const gchar *top;
+	GList *item;
+
+	for (item = cache->roots; item != NULL; item = g_list_next (item))
+	{
+		root = (SvnStatusCacheRoot *) item->data;
+
+		if (is_path_inside (path, root->path)) return root;
+	}
+
+	/* Walk the whole project if the path is inside it */
+	top = cache->plugin->project_root_dir;
+	if ((top == NULL) || !is_path_inside (path, top)) top = path;
+
+	root = svn_status_cache_root_new (cache, top);
+	cache->roots = g_list_prepend (cache->roots, root);
+
+	return root;
+}
+
+/* Public functions
+ *---------------------------------------------------------------------------*/
+
+void
+svn_status_cache_query (SvnStatusCache *cache, const gchar *path,
+                        IAnjutaVcsStatusCallback callback,
+                        gpointer user_data, GCancellable *cancel,
+                        AnjutaAsyncNotify *notify)
+{
+	SvnStatusCacheRoot *root;
+	SvnStatusQuery *query;
+
+	root = svn_status_cache_get_root (cache, path);
+	if (root->valid &&
+	    (g_get_monotonic_time () - root->timestamp > SVN_STATUS_CACHE_TTL))
+	{
+		svn_status_cache_root_invalidate (root);
+	}
+
+	query = g_new0 (SvnStatusQuery, 1);
+	query->path = g_strdup (path);
+	query->callback = callback;
+	query->user_data = user_data;
+	query->cancel = cancel != NULL ? g_object_ref (cancel) : NULL;
+	query->notify = notify != NULL ? g_object_ref (notify) : NULL;
+	g_queue_push_tail (&root->queries, query);
+
+	/* Always answer asynchronously */
+	if (root->valid)
+	{
+		if (root->idle_id == 0)
+			root->idle_id = g_idle_add ((GSourceFunc) on_root_idle, root);
+	}
+	else
+	{
+		svn_status_cache_root_update (root);
+	}
+}
+
+void
+svn_status_cache_invalidate (SvnStatusCache *cache)
+{
+	GList *item;
+
+	for (item = cache->roots; item != NULL; item = g_list_next (item))
+	{
+		svn_status_cache_root_invalidate ((SvnStatusCacheRoot *) item->data);
+	}
+}
+
+SvnStatusCache *
+svn_status_cache_new (Subversion *plugin)
+{
+	SvnStatusCache *cache;
+
+	cache = g_new0 (SvnStatusCache, 1);
+	cache->plugin = plugin;
+
+	/* Commit, update... done by the plugin */
+	g_signal_connect_swapped (plugin, "status-changed",
+	                          G_CALLBACK (svn_status_cache_invalidate), cache);
+
+	return cache;
+}
+
+void
+svn_status_cache_free (SvnStatusCache *cache)
+{
+	g_signal_handlers_disconnect_by_func (cache->plugin,
+	                                      svn_status_cache_invalidate, cache);
+	g_list_free_full (cache->roots, (GDestroyNotify) svn_status_cache_root_free);
+	g_free (cache);
+}
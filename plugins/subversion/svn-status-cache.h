@@ -0,0 +1,45 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * anjuta
+ * 
+ * anjuta is free software.
+ * 
+ * You may redistribute it and/or modify it under the terms of the
+ * GNU General Public License, as published by the Free Software
+ * Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ * 
+ * anjuta is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with anjuta.  If not, write to:
+ * 	The Free Software Foundation, Inc.,
+ * 	51 Franklin Street, Fifth Floor
+ * 	Boston, MA  02110-1301, USA.
+ */
+
+#ifndef _SVN_STATUS_CACHE_H_
+#define _SVN_STATUS_CACHE_H_
+
+#include <glib.h>
+#include <libanjuta/interfaces/ianjuta-vcs.h>
+#include "plugin.h"
+
+G_BEGIN_DECLS
+
+typedef struct _SvnStatusCache SvnStatusCache;
+
+SvnStatusCache *svn_status_cache_new (Subversion *plugin);
+void svn_status_cache_free (SvnStatusCache *cache);
+void svn_status_cache_query (SvnStatusCache *cache, const gchar *path,
+                             IAnjutaVcsStatusCallback callback,
+                             gpointer user_data, GCancellable *cancel,
+                             AnjutaAsyncNotify *notify);
+void svn_status_cache_invalidate (SvnStatusCache *cache);
+
+G_END_DECLS
+
+#endif /* _SVN_STATUS_CACHE_H_ */
@@ -0,0 +1,209 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * model.c
+ *
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Measure the time spent in the main thread to display each screen of a
+ * symbol tree while scrolling through it, like a tree view would do. The
+ * backend query is simulated with a fixed delay.
+ *
+ * Usage: benchmark-model [symbols] [rows per scroll] [query delay in us]
+ */
+
+#include <stdlib.h>
+#include <libgda/libgda.h>
+#include "../../symbol-db-model.h"
+
+#define VISIBLE_ROWS 40
+#define FRAME_USEC 4000
+
+/* A flat model with generated symbols */
+
+typedef struct _BenchModel BenchModel;
+typedef struct _BenchModelClass BenchModelClass;
+
+struct _BenchModel
+{
+	SymbolDBModel parent;
+};
+
+struct _BenchModelClass
+{
+	SymbolDBModelClass parent_class;
+};
+
+static GType bench_model_get_type (void);
+
+G_DEFINE_TYPE (BenchModel, bench_model, SYMBOL_DB_TYPE_MODEL);
+
+static gint n_symbols = 100000;
+static gulong query_delay = 2000;
+static guint n_queries = 0;
+
+static gboolean
+bench_model_get_has_child (SymbolDBModel *model, gint tree_level,
+                           GValue column_values[])
+{
+	return FALSE;
+}
+
+static gint
+bench_model_get_n_children (SymbolDBModel *model, gint tree_level,
+                            GValue column_values[])
+{
+	return tree_level == 0 ? n_symbols : 0;
+}
+
+static GdaDataModel*
+bench_model_get_children (SymbolDBModel *model, gint tree_level,
+                          GValue column_values[], gint offset, gint limit)
+{
+	GdaDataModel *data_model;
+	gint i;
+
+	g_usleep (query_delay);
+	n_queries++;
+
+	data_model = gda_data_model_array_new_with_g_types (1, G_TYPE_STRING);
+	for (i = offset; i < offset + limit && i < n_symbols; i++)
+	{
+		GValue value = {0};
+		GList *values;
+
+		g_value_init (&value, G_TYPE_STRING);
+		g_value_take_string (&value, g_strdup_printf ("symbol_%d", i));
+		values = g_list_prepend (NULL, &value);
+		gda_data_model_append_values (data_model, values, NULL);
+		g_list_free (values);
+		g_value_unset (&value);
+	}
+
+	return data_model;
+}
+
+static void
+bench_model_init (BenchModel *model)
+{
+	GType types[] = {G_TYPE_STRING};
+	gint query_columns[] = {0};
+
+	symbol_db_model_set_columns (SYMBOL_DB_MODEL (model), 1, types,
+	                             query_columns);
+}
+
+static void
+bench_model_class_init (BenchModelClass *klass)
+{
+	SymbolDBModelClass *model_class = SYMBOL_DB_MODEL_CLASS (klass);
+
+	model_class->get_has_child = bench_model_get_has_child;
+	model_class->get_n_children = bench_model_get_n_children;
+	model_class->get_children = bench_model_get_children;
+}
+
+/* Let the page loader deliver its results during one frame */
+static void
+wait_frame (void)
+{
+	gint64 end = g_get_monotonic_time () + FRAME_USEC;
+
+	while (g_get_monotonic_time () < end)
+	{
+		if (!g_main_context_iteration (NULL, FALSE))
+			g_usleep (100);
+	}
+}
+
+static int
+compare_double (gconstpointer a, gconstpointer b)
+{
+	gdouble da = *(const gdouble *)a;
+	gdouble db = *(const gdouble *)b;
+
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+int
+main (int argc, char **argv)
+{
+	GtkTreeModel *model;
+	GTimer *timer;
+	GArray *latency;
+	gint step = 20;
+	gint first, row;
+	guint placeholders = 0;
+	guint displayed = 0;
+	gdouble total = 0;
+
+	if (argc > 1) n_symbols = atoi (argv[1]);
+	if (argc > 2) step = atoi (argv[2]);
+	if (argc > 3) query_delay = atol (argv[3]);
+	if ((n_symbols <= 0) || (step <= 0)) return 1;
+
+	g_type_init ();
+	gda_init ();
+
+	model = GTK_TREE_MODEL (g_object_new (bench_model_get_type (), NULL));
+	symbol_db_model_update (SYMBOL_DB_MODEL (model));
+
+	timer = g_timer_new ();
+	latency = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+	/* Scroll down the whole tree, reading the visible rows at each step */
+	for (first = 0; first < n_symbols; first += step)
+	{
+		gdouble elapsed;
+
+		g_timer_start (timer);
+		for (row = first; row < first + VISIBLE_ROWS && row < n_symbols; row++)
+		{
+			GtkTreeIter iter;
+			GValue value = {0};
+
+			if (!gtk_tree_model_iter_nth_child (model, &iter, NULL, row))
+			{
+				g_printerr ("missing row %d\n", row);
+				return 1;
+			}
+			gtk_tree_model_get_value (model, &iter, 0, &value);
+			if (g_value_get_string (&value) == NULL)
+				placeholders++;
+			displayed++;
+			g_value_unset (&value);
+		}
+		elapsed = g_timer_elapsed (timer, NULL) * 1000;
+		g_array_append_val (latency, elapsed);
+		total += elapsed;
+
+		wait_frame ();
+	}
+
+	g_array_sort (latency, compare_double);
+	g_print ("scroll %d symbols by %d rows: %u frames, %u queries\n",
+	         n_symbols, step, latency->len, n_queries);
+	g_print ("frame latency: mean %.3f ms, p95 %.3f ms, max %.3f ms\n",
+	         total / latency->len,
+	         g_array_index (latency, gdouble, latency->len * 95 / 100),
+	         g_array_index (latency, gdouble, latency->len - 1));
+	g_print ("placeholder rows: %u of %u\n", placeholders, displayed);
+
+	g_array_free (latency, TRUE);
+	g_timer_destroy (timer);
+	g_object_unref (model);
+
+	return 0;
+}
@@ -0,0 +1,877 @@
+/* -*- Mode: C; indent-tabs-mode: t; c-basic-offset: 4; tab-width: 4 -*- */
+/*
+ * suite.c
+ *
+ * anjuta is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * anjuta is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Generate a synthetic C and C++ project, always the same for a given seed
+ * and size, and measure the symbol database on it: the first scan, the
+ * update of some modified files, the update of an unsaved buffer and each
+ * kind of SymbolDBQuery, just after opening the database (cold) and when
+ * repeated (warm). The results are written as JSON, so two runs can be
+ * compared to find regressions.
+ *
+ * Usage: benchmark-suite [--files=N] [--symbols=N] [--updated-files=N]
+ *                        [--runs=N] [--cold-runs=N] [--seed=N]
+ *                        [--ctags=PATH] [--output=FILE] [--keep]
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <glib/gstdio.h>
+#include <libgda/libgda.h>
+#include <libanjuta/interfaces/ianjuta-symbol.h>
+#include <libanjuta/interfaces/ianjuta-symbol-query.h>
+
+#include "../../symbol-db-engine.h"
+#include "../../symbol-db-query.h"
+
+#define PROJECT_VERSION "1.0"
+#define SEARCH_ALL_LIMIT 1000
+#define SIGNALS_DELAY 1		/* ms */
+
+static gint n_files = 200;
+static gint n_symbols = 10;
+static gint n_updated_files = 10;
+static gint n_runs = 20;
+static gint n_cold_runs = 5;
+static gint seed = 1;
+static gchar *ctags_path = NULL;
+static gchar *output_path = NULL;
+static gboolean keep = FALSE;
+
+static GOptionEntry entries[] =
+{
+	{"files", 0, 0, G_OPTION_ARG_INT, &n_files, "Number of source files", "N"},
+	{"symbols", 0, 0, G_OPTION_ARG_INT, &n_symbols, "Number of types by file", "N"},
+	{"updated-files", 0, 0, G_OPTION_ARG_INT, &n_updated_files, "Number of files modified by update", "N"},
+	{"runs", 0, 0, G_OPTION_ARG_INT, &n_runs, "Number of repeated measures", "N"},
+	{"cold-runs", 0, 0, G_OPTION_ARG_INT, &n_cold_runs, "Number of measures after opening the database", "N"},
+	{"seed", 0, 0, G_OPTION_ARG_INT, &seed, "Seed of the generated project", "N"},
+	{"ctags", 0, 0, G_OPTION_ARG_FILENAME, &ctags_path, "Path of anjuta-tags", "PATH"},
+	{"output", 'o', 0, G_OPTION_ARG_FILENAME, &output_path, "Write results in FILE instead of stdout", "FILE"},
+	{"keep", 0, 0, G_OPTION_ARG_NONE, &keep, "Keep the generated project", NULL},
+	{NULL}
+};
+
+typedef struct
+{
+	SymbolDBEngine *dbe;
+	GMainLoop *loop;
+	gchar *root;
+	GPtrArray *files;		/* absolute paths */
+	GPtrArray *languages;
+	guint *generation;		/* of each file */
+	gint waiting_scan;
+	GString *results;
+} Bench;
+
+/* Synthetic project */
+
+static gboolean
+is_cpp_file (guint index)
+{
+	return (index % 4) >= 2;
+}
+
+static gchar *
+file_name (guint index)
+{
+	static const gchar *extensions[] = {"c", "h", "cc", "hh"};
+
+	return g_strdup_printf ("bench%05u.%s", index, extensions[index % 4]);
+}
+
+/* Number of types in a file, it depends only on the seed and the file */
+static guint
+file_types (guint index)
+{
+	GRand *rand;
+	guint count;
+
+	rand = g_rand_new_with_seed (seed + index);
+	count = g_rand_int_range (rand, n_symbols / 2 + 1, n_symbols + n_symbols / 2 + 2);
+	g_rand_free (rand);
+
+	return count;
+}
+
+static gchar *
+generate_c_file (guint index, guint generation, gboolean header)
+{
+	GString *text;
+	guint types;
+	guint i;
+
+	text = g_string_new (NULL);
+	types = file_types (index);
+
+	g_string_append_printf (text, "/* generation %u */\n\n#include <stdlib.h>\n\n",
+	                        generation);
+	for (i = 0; i < types; i++)
+	{
+		g_string_append_printf (text,
+		                        "typedef struct _BenchStruct%u_%u\n{\n"
+		                        "\tint field_a;\n\tchar *field_b;\n\tdouble field_c;\n"
+		                        "} BenchStruct%u_%u;\n\n",
+		                        index, i, index, i);
+		if (header)
+		{
+			g_string_append_printf (text,
+			                        "int bench_func_%u_%u (int a, BenchStruct%u_%u *s);\n\n",
+			                        index, i, index, i);
+		}
+		else
+		{
+			g_string_append_printf (text,
+			                        "static int bench_static_%u_%u = %u;\n\n"
+			                        "int\nbench_func_%u_%u (int a, BenchStruct%u_%u *s)\n"
+			                        "{\n\treturn a + s->field_a + bench_static_%u_%u;\n}\n\n",
+			                        index, i, generation,
+			                        index, i, index, i,
+			                        index, i);
+		}
+	}
+
+	/* Symbols added and removed by updates */
+	g_string_append_printf (text, "int bench_gen_%u_%u (void);\n", index, generation);
+
+	return g_string_free (text, FALSE);
+}
+
+static gchar *
+generate_cpp_file (guint index, guint generation, gboolean header)
+{
+	GString *text;
+	guint types;
+	guint i;
+
+	text = g_string_new (NULL);
+	types = file_types (index);
+
+	g_string_append_printf (text, "// generation %u\n\nnamespace bench_ns_%u\n{\n\n"
+	                        "class BenchBase_%u\n{\npublic:\n"
+	                        "\tvirtual int base_method (int x);\n"
+	                        "protected:\n\tint base_member;\n};\n\n",
+	                        generation, index, index);
+	for (i = 0; i < types; i++)
+	{
+		g_string_append_printf (text,
+		                        "class BenchClass_%u_%u : public BenchBase_%u\n{\npublic:\n"
+		                        "\tBenchClass_%u_%u ();\n"
+		                        "\tint method_a (int x)%s\n"
+		                        "\tint method_b (const char *s);\n"
+		                        "private:\n\tint member_a;\n\tdouble member_b;\n};\n\n",
+		                        index, i, index,
+		                        index, i,
+		                        header ? ";" : " { return x + member_a; }");
+	}
+	g_string_append_printf (text, "int bench_gen_%u_%u ();\n\n}\n", index, generation);
+
+	return g_string_free (text, FALSE);
+}
+
+static gchar *
+generate_file (guint index, guint generation)
+{
+	gboolean header = (index % 2) == 1;
+
+	if (is_cpp_file (index))
+		return generate_cpp_file (index, generation, header);
+	else
+		return generate_c_file (index, generation, header);
+}
+
+static gboolean
+write_file (Bench *bench, guint index)
+{
+	gchar *text;
+	GError *error = NULL;
+
+	text = generate_file (index, bench->generation[index]);
+	if (!g_file_set_contents (g_ptr_array_index (bench->files, index), text, -1,
+	                          &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		g_free (text);
+		return FALSE;
+	}
+	g_free (text);
+
+	return TRUE;
+}
+
+static gboolean
+create_project (Bench *bench)
+{
+	guint i;
+
+	bench->root = g_dir_make_tmp ("symbol-db-bench-XXXXXX", NULL);
+	if (bench->root == NULL)
+		return FALSE;
+
+	bench->files = g_ptr_array_new_with_free_func (g_free);
+	bench->languages = g_ptr_array_new ();
+	bench->generation = g_new0 (guint, n_files);
+	for (i = 0; i < n_files; i++)
+	{
+		gchar *name = file_name (i);
+
+		g_ptr_array_add (bench->files, g_build_filename (bench->root, name, NULL));
+		g_ptr_array_add (bench->languages, is_cpp_file (i) ? "C++" : "C");
+		g_free (name);
+		if (!write_file (bench, i))
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+static void
+remove_project (Bench *bench)
+{
+	GDir *dir;
+	const gchar *name;
+
+	dir = g_dir_open (bench->root, 0, NULL);
+	if (dir == NULL)
+		return;
+	while ((name = g_dir_read_name (dir)) != NULL)
+	{
+		gchar *path = g_build_filename (bench->root, name, NULL);
+
+		g_unlink (path);
+		g_free (path);
+	}
+	g_dir_close (dir);
+	g_rmdir (bench->root);
+}
+
+/* Results */
+
+static gint
+compare_double (gconstpointer a, gconstpointer b)
+{
+	gdouble x = *(const gdouble *)a;
+	gdouble y = *(const gdouble *)b;
+
+	return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+/* Nearest rank percentile of sorted samples */
+static gdouble
+percentile (GArray *samples, guint percent)
+{
+	guint rank;
+
+	rank = (samples->len * percent + 99) / 100;
+	if (rank == 0) rank = 1;
+
+	return g_array_index (samples, gdouble, rank - 1);
+}
+
+static void
+append_json_string (GString *out, const gchar *str)
+{
+	g_string_append_c (out, '"');
+	for (; *str != '\0'; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			g_string_append_c (out, '\\');
+		g_string_append_c (out, *str);
+	}
+	g_string_append_c (out, '"');
+}
+
+/* Add the statistics of samples in milliseconds */
+static void
+add_result (Bench *bench, const gchar *name, GArray *samples)
+{
+	gdouble sum = 0;
+	guint i;
+
+	if (samples->len == 0)
+		return;
+
+	g_array_sort (samples, compare_double);
+	for (i = 0; i < samples->len; i++)
+		sum += g_array_index (samples, gdouble, i);
+
+	if (bench->results->len > 0)
+		g_string_append (bench->results, ",\n");
+	g_string_append (bench->results, "    {\"name\": ");
+	append_json_string (bench->results, name);
+	g_string_append_printf (bench->results,
+	                        ", \"unit\": \"ms\", \"runs\": %u, \"min\": %.3f, "
+	                        "\"mean\": %.3f, \"p50\": %.3f, \"p90\": %.3f, "
+	                        "\"p99\": %.3f, \"max\": %.3f}",
+	                        samples->len,
+	                        g_array_index (samples, gdouble, 0),
+	                        sum / samples->len,
+	                        percentile (samples, 50),
+	                        percentile (samples, 90),
+	                        percentile (samples, 99),
+	                        g_array_index (samples, gdouble, samples->len - 1));
+}
+
+static glong
+peak_rss_kb (void)
+{
+	struct rusage usage;
+
+	if (getrusage (RUSAGE_SELF, &usage) != 0)
+		return -1;
+
+	/* ru_maxrss is in kilobytes on Linux */
+	return usage.ru_maxrss;
+}
+
+static gboolean
+write_results (Bench *bench)
+{
+	GString *out;
+	guint hits = 0;
+	guint misses = 0;
+	gdouble scope_stage = 0;
+	gdouble scope_resolve = 0;
+	gdouble heritage = 0;
+	gboolean ok = TRUE;
+
+	symbol_db_engine_get_query_statement_stats (bench->dbe, &hits, &misses);
+	symbol_db_engine_get_second_pass_stats (bench->dbe, &scope_stage,
+	                                        &scope_resolve, &heritage);
+
+	out = g_string_new ("{\n");
+	g_string_append_printf (out,
+	                        "  \"corpus\": {\"files\": %d, \"symbols\": %d, "
+	                        "\"updated_files\": %d, \"seed\": %d},\n",
+	                        n_files, n_symbols, n_updated_files, seed);
+	g_string_append_printf (out, "  \"results\": [\n%s\n  ],\n",
+	                        bench->results->str);
+	g_string_append_printf (out,
+	                        "  \"statement_cache\": {\"hits\": %u, \"misses\": %u},\n",
+	                        hits, misses);
+	g_string_append_printf (out,
+	                        "  \"second_pass_ms\": {\"scope_stage\": %.3f, "
+	                        "\"scope_resolve\": %.3f, \"heritage\": %.3f},\n",
+	                        scope_stage * 1000, scope_resolve * 1000, heritage * 1000);
+	g_string_append_printf (out, "  \"peak_rss_kb\": %ld\n}\n", peak_rss_kb ());
+
+	if (output_path == NULL)
+	{
+		g_print ("%s", out->str);
+	}
+	else
+	{
+		GError *error = NULL;
+
+		if (!g_file_set_contents (output_path, out->str, out->len, &error))
+		{
+			g_printerr ("%s\n", error->message);
+			g_error_free (error);
+			ok = FALSE;
+		}
+	}
+	g_string_free (out, TRUE);
+
+	return ok;
+}
+
+/* Scans */
+
+static void
+on_scan_end (SymbolDBEngine *dbe, gint process_id, Bench *bench)
+{
+	if (process_id == bench->waiting_scan)
+		g_main_loop_quit (bench->loop);
+}
+
+/* Wait for the end of a scan and return its duration in milliseconds. The
+ * engine is set to emit scan-end right after the scan, see main () */
+static gboolean
+wait_scan (Bench *bench, gint scan_id, gint64 start, gdouble *duration)
+{
+	if (scan_id <= 0)
+	{
+		g_printerr ("Scan not started\n");
+		return FALSE;
+	}
+
+	bench->waiting_scan = scan_id;
+	g_main_loop_run (bench->loop);
+	bench->waiting_scan = 0;
+	*duration = (g_get_monotonic_time () - start) / 1000.0;
+
+	return TRUE;
+}
+
+static gboolean
+open_db (Bench *bench)
+{
+	if (symbol_db_engine_open_db (bench->dbe, bench->root, bench->root) ==
+	    DB_OPEN_STATUS_FATAL)
+	{
+		g_printerr ("Could not open database in %s\n", bench->root);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gboolean
+bench_first_scan (Bench *bench)
+{
+	GArray *samples;
+	gint64 start;
+	gdouble duration;
+	gint scan_id;
+
+	if (!open_db (bench))
+		return FALSE;
+	symbol_db_engine_add_new_project (bench->dbe, NULL, bench->root,
+	                                  PROJECT_VERSION);
+
+	start = g_get_monotonic_time ();
+	scan_id = symbol_db_engine_add_new_files_full_async (bench->dbe, bench->root,
+	                                                     PROJECT_VERSION,
+	                                                     bench->files,
+	                                                     bench->languages, TRUE);
+	if (!wait_scan (bench, scan_id, start, &duration))
+		return FALSE;
+
+	samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+	g_array_append_val (samples, duration);
+	add_result (bench, "first-scan", samples);
+	g_array_free (samples, TRUE);
+
+	return TRUE;
+}
+
+static guint
+gcd (guint a, guint b)
+{
+	while (b != 0)
+	{
+		guint r = a % b;
+
+		a = b;
+		b = r;
+	}
+
+	return a;
+}
+
+/* Modify files spread over the project and update them */
+static gboolean
+bench_update_files (Bench *bench)
+{
+	GArray *samples;
+	guint stride;
+	gint run;
+
+	/* A stride coprime with the number of files gives different files in
+	 * each run */
+	stride = 7;
+	while (gcd (stride, n_files) != 1)
+		stride++;
+
+	samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+	for (run = 0; run < n_runs; run++)
+	{
+		GPtrArray *updated;
+		gint64 start;
+		gdouble duration;
+		gint i;
+
+		updated = g_ptr_array_new ();
+		for (i = 0; i < n_updated_files; i++)
+		{
+			guint index = (run * n_updated_files + i) * stride % n_files;
+
+			bench->generation[index]++;
+			write_file (bench, index);
+			g_ptr_array_add (updated, g_ptr_array_index (bench->files, index));
+		}
+
+		start = g_get_monotonic_time ();
+		if (!wait_scan (bench,
+		                symbol_db_engine_update_files_symbols (bench->dbe, bench->root,
+		                                                       updated, TRUE),
+		                start, &duration))
+		{
+			g_ptr_array_free (updated, TRUE);
+			g_array_free (samples, TRUE);
+			return FALSE;
+		}
+		g_array_append_val (samples, duration);
+		g_ptr_array_free (updated, TRUE);
+	}
+
+	add_result (bench, "update-files", samples);
+	g_array_free (samples, TRUE);
+
+	return TRUE;
+}
+
+/* Update the symbols of an unsaved C++ file, like while typing */
+static gboolean
+bench_update_buffer (Bench *bench)
+{
+	GArray *samples;
+	guint index = n_files > 2 ? 2 : 0;
+	gint run;
+
+	samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+	for (run = 0; run < n_runs; run++)
+	{
+		GPtrArray *real_files;
+		GPtrArray *buffers;
+		GPtrArray *sizes;
+		gchar *text;
+		gint64 start;
+		gdouble duration;
+		gboolean ok;
+
+		text = generate_file (index, bench->generation[index] + run + 1);
+		real_files = g_ptr_array_new ();
+		g_ptr_array_add (real_files, g_ptr_array_index (bench->files, index));
+		buffers = g_ptr_array_new ();
+		g_ptr_array_add (buffers, text);
+		sizes = g_ptr_array_new ();
+		g_ptr_array_add (sizes, GINT_TO_POINTER (strlen (text)));
+
+		start = g_get_monotonic_time ();
+		ok = wait_scan (bench,
+		                symbol_db_engine_update_buffer_symbols (bench->dbe, bench->root,
+		                                                        real_files, buffers,
+		                                                        sizes),
+		                start, &duration);
+		g_ptr_array_free (real_files, TRUE);
+		g_ptr_array_free (buffers, TRUE);
+		g_ptr_array_free (sizes, TRUE);
+		g_free (text);
+		if (!ok)
+		{
+			g_array_free (samples, TRUE);
+			return FALSE;
+		}
+		g_array_append_val (samples, duration);
+	}
+
+	add_result (bench, "update-buffer", samples);
+	g_array_free (samples, TRUE);
+
+	return TRUE;
+}
+
+/* Queries */
+
+typedef struct
+{
+	const gchar *name;
+	IAnjutaSymbolQueryName query;
+} QueryMode;
+
+static const QueryMode query_modes[] =
+{
+	{"search", IANJUTA_SYMBOL_QUERY_SEARCH},
+	{"search-all", IANJUTA_SYMBOL_QUERY_SEARCH_ALL},
+	{"search-file", IANJUTA_SYMBOL_QUERY_SEARCH_FILE},
+	{"search-in-scope", IANJUTA_SYMBOL_QUERY_SEARCH_IN_SCOPE},
+	{"search-id", IANJUTA_SYMBOL_QUERY_SEARCH_ID},
+	{"search-members", IANJUTA_SYMBOL_QUERY_SEARCH_MEMBERS},
+	{"search-class-parents", IANJUTA_SYMBOL_QUERY_SEARCH_CLASS_PARENTS},
+	{"search-scope", IANJUTA_SYMBOL_QUERY_SEARCH_SCOPE},
+	{"search-parent-scope", IANJUTA_SYMBOL_QUERY_SEARCH_PARENT_SCOPE},
+	{"search-parent-scope-file", IANJUTA_SYMBOL_QUERY_SEARCH_PARENT_SCOPE_FILE}
+};
+
+static IAnjutaSymbolQuery *
+new_query (Bench *bench, IAnjutaSymbolQueryName name)
+{
+	IAnjutaSymbolField fields[] = {
+		IANJUTA_SYMBOL_FIELD_ID,
+		IANJUTA_SYMBOL_FIELD_NAME,
+		IANJUTA_SYMBOL_FIELD_KIND,
+		IANJUTA_SYMBOL_FIELD_TYPE,
+		IANJUTA_SYMBOL_FIELD_FILE_POS};
+	IAnjutaSymbolQuery *query;
+
+	query = IANJUTA_SYMBOL_QUERY (symbol_db_query_new (bench->dbe, bench->dbe,
+	                                                   name,
+	                                                   IANJUTA_SYMBOL_QUERY_DB_PROJECT,
+	                                                   NULL));
+	ianjuta_symbol_query_set_fields (query, G_N_ELEMENTS (fields), fields, NULL);
+	if (name == IANJUTA_SYMBOL_QUERY_SEARCH_ALL)
+		ianjuta_symbol_query_set_limit (query, SEARCH_ALL_LIMIT, NULL);
+
+	return query;
+}
+
+/* A class of the first C++ file, used by queries on a symbol */
+static IAnjutaSymbol *
+find_class (Bench *bench)
+{
+	IAnjutaSymbolQuery *query;
+	IAnjutaIterable *iter;
+
+	query = new_query (bench, IANJUTA_SYMBOL_QUERY_SEARCH);
+	iter = ianjuta_symbol_query_search (query, "BenchClass_2_0", NULL);
+	g_object_unref (query);
+
+	return iter != NULL ? IANJUTA_SYMBOL (iter) : NULL;
+}
+
+static IAnjutaIterable *
+run_query (Bench *bench, IAnjutaSymbolQuery *query, IAnjutaSymbolQueryName name,
+           IAnjutaSymbol *symbol, guint run)
+{
+	const gchar *cpp_file = g_ptr_array_index (bench->files, 2);
+	gchar *pattern;
+	IAnjutaIterable *iter = NULL;
+
+	switch (name)
+	{
+		case IANJUTA_SYMBOL_QUERY_SEARCH:
+		{
+			/* Completion of a prefix */
+			pattern = g_strdup_printf ("bench_func_%u%%", run % 10);
+			iter = ianjuta_symbol_query_search (query, pattern, NULL);
+			g_free (pattern);
+			break;
+		}
+		case IANJUTA_SYMBOL_QUERY_SEARCH_ALL:
+			iter = ianjuta_symbol_query_search_all (query, NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_FILE:
+		{
+			GFile *file = g_file_new_for_path (cpp_file);
+
+			iter = ianjuta_symbol_query_search_file (query, "%", file, NULL);
+			g_object_unref (file);
+			break;
+		}
+		case IANJUTA_SYMBOL_QUERY_SEARCH_IN_SCOPE:
+			iter = ianjuta_symbol_query_search_in_scope (query, "method%", symbol,
+			                                             NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_ID:
+			iter = ianjuta_symbol_query_search_id (query,
+			                                       ianjuta_symbol_get_int (symbol,
+			                                                               IANJUTA_SYMBOL_FIELD_ID,
+			                                                               NULL),
+			                                       NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_MEMBERS:
+			iter = ianjuta_symbol_query_search_members (query, symbol, NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_CLASS_PARENTS:
+			iter = ianjuta_symbol_query_search_class_parents (query, symbol, NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_SCOPE:
+			iter = ianjuta_symbol_query_search_scope (query, cpp_file,
+			                                          10 + run % 20, NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_PARENT_SCOPE:
+			iter = ianjuta_symbol_query_search_parent_scope (query, symbol, NULL);
+			break;
+		case IANJUTA_SYMBOL_QUERY_SEARCH_PARENT_SCOPE_FILE:
+			iter = ianjuta_symbol_query_search_parent_scope_file (query, symbol,
+			                                                      cpp_file, NULL);
+			break;
+	}
+
+	return iter;
+}
+
+/* Read all results, like a completion list would do */
+static gdouble
+time_query (Bench *bench, IAnjutaSymbolQuery *query, IAnjutaSymbolQueryName name,
+            IAnjutaSymbol *symbol, guint run)
+{
+	IAnjutaIterable *iter;
+	gint64 start;
+
+	start = g_get_monotonic_time ();
+	iter = run_query (bench, query, name, symbol, run);
+	if (iter != NULL)
+	{
+		do
+		{
+			g_free (ianjuta_symbol_get_string (IANJUTA_SYMBOL (iter),
+			                                   IANJUTA_SYMBOL_FIELD_NAME, NULL));
+		}
+		while (ianjuta_iterable_next (iter, NULL));
+		g_object_unref (iter);
+	}
+
+	return (g_get_monotonic_time () - start) / 1000.0;
+}
+
+static gboolean
+bench_queries (Bench *bench)
+{
+	guint i;
+
+	for (i = 0; i < G_N_ELEMENTS (query_modes); i++)
+	{
+		GArray *cold;
+		GArray *warm;
+		IAnjutaSymbolQuery *query = NULL;
+		IAnjutaSymbol *symbol = NULL;
+		gchar *name;
+		gint run;
+
+		cold = g_array_new (FALSE, FALSE, sizeof (gdouble));
+		warm = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+		/* Reopening the database empties the statement and page caches */
+		for (run = 0; run < n_cold_runs; run++)
+		{
+			gdouble duration;
+
+			if (symbol != NULL) g_object_unref (symbol);
+			if (query != NULL) g_object_unref (query);
+			symbol_db_engine_close_db (bench->dbe);
+			if (!open_db (bench))
+			{
+				g_array_free (cold, TRUE);
+				g_array_free (warm, TRUE);
+				return FALSE;
+			}
+			query = new_query (bench, query_modes[i].query);
+			symbol = find_class (bench);
+			if (symbol == NULL)
+			{
+				g_printerr ("Symbol not found in database\n");
+				g_object_unref (query);
+				g_array_free (cold, TRUE);
+				g_array_free (warm, TRUE);
+				return FALSE;
+			}
+
+			duration = time_query (bench, query, query_modes[i].query, symbol, run);
+			g_array_append_val (cold, duration);
+		}
+
+		if (query == NULL)
+		{
+			query = new_query (bench, query_modes[i].query);
+			symbol = find_class (bench);
+		}
+		if (symbol != NULL)
+		{
+			for (run = 0; run < n_runs; run++)
+			{
+				gdouble duration;
+
+				duration = time_query (bench, query, query_modes[i].query, symbol,
+				                       run);
+				g_array_append_val (warm, duration);
+			}
+			g_object_unref (symbol);
+		}
+		g_object_unref (query);
+
+		name = g_strdup_printf ("query-%s-cold", query_modes[i].name);
+		add_result (bench, name, cold);
+		g_free (name);
+		name = g_strdup_printf ("query-%s-warm", query_modes[i].name);
+		add_result (bench, name, warm);
+		g_free (name);
+
+		g_array_free (cold, TRUE);
+		g_array_free (warm, TRUE);
+	}
+
+	return TRUE;
+}
+
+int
+main (int argc, char **argv)
+{
+	GOptionContext *context;
+	GError *error = NULL;
+	Bench bench = {0};
+	gboolean ok;
+
+	context = g_option_context_new ("- symbol database benchmark");
+	g_option_context_add_main_entries (context, entries, NULL);
+	if (!g_option_context_parse (context, &argc, &argv, &error))
+	{
+		g_printerr ("%s\n", error->message);
+		g_error_free (error);
+		return 1;
+	}
+	g_option_context_free (context);
+	/* Queries use a class of the third file */
+	if (n_files < 4 || n_symbols <= 0 || n_runs <= 0 || n_cold_runs < 0)
+	{
+		g_printerr ("Invalid options\n");
+		return 1;
+	}
+	if (n_updated_files > n_files) n_updated_files = n_files;
+
+	g_type_init ();
+	g_thread_init (NULL);
+	gda_init ();
+
+	if (!create_project (&bench))
+	{
+		g_printerr ("Could not create the project\n");
+		return 1;
+	}
+
+	bench.loop = g_main_loop_new (NULL, FALSE);
+	bench.results = g_string_new (NULL);
+	bench.dbe = symbol_db_engine_new_full (ctags_path != NULL ? ctags_path : "anjuta-tags",
+	                                       "benchmark-db");
+	if (bench.dbe == NULL)
+	{
+		g_printerr ("Could not create the symbol database engine\n");
+		return 1;
+	}
+	g_signal_connect (bench.dbe, "scan-end", G_CALLBACK (on_scan_end), &bench);
+
+	/* The signals are polled every 100 ms by default, it would hide the
+	 * duration of short scans */
+	symbol_db_engine_set_signals_delay (bench.dbe, SIGNALS_DELAY);
+
+	ok = bench_first_scan (&bench) &&
+		bench_update_files (&bench) &&
+		bench_update_buffer (&bench) &&
+		bench_queries (&bench) &&
+		write_results (&bench);
+
+	symbol_db_engine_close_db (bench.dbe);
+	g_object_unref (bench.dbe);
+	g_main_loop_unref (bench.loop);
+	g_string_free (bench.results, TRUE);
+
+	if (keep)
+		g_printerr ("Project kept in %s\n", bench.root);
+	else
+		remove_project (&bench);
+
+	g_ptr_array_free (bench.files, TRUE);
+	g_ptr_array_free (bench.languages, TRUE);
+	g_free (bench.generation);
+	g_free (bench.root);
+
+	return ok ? 0 : 1;
+}
@@ -57,6 +57,8 @@
 #define ICON_FILE 							"anjuta-symbol-db-plugin-48.png"
 #define BUFFER_UPDATE 						"symboldb-buffer-update"
 #define PARALLEL_SCAN 						"symboldb-parallel-scan"
+#define READ_CONNECTIONS 					"symboldb-read-connections"
+#define WAL_CHECKPOINT 						"symboldb-wal-checkpoint"
 #define PREFS_BUFFER_UPDATE 				"preferences_toggle:bool:1:1:symboldb-buffer-update"
 #define PREFS_PARALLEL_SCAN 				"preferences_toggle:bool:1:1:symboldb-parallel-scan"
 
@@ -1616,6 +1618,20 @@ on_project_loaded (IAnjutaProjectManager *pm, GError *error,
 	}
 }
 
+static void
+on_isymbol_manager_sys_package_start (SymbolDBSystem *sdbs, guint num_files,
+                                      const gchar *package, 
+                                      SymbolDBPlugin *sdb_plugin)
+{
+	PackageScanData *pkg_scan_data;
+
+	/* the engine scan has been queued, popped in scan-begin */
+	pkg_scan_data = g_new0 (PackageScanData, 1);
+	pkg_scan_data->files_length = num_files;
+	pkg_scan_data->package_name = g_strdup (package);
+	g_async_queue_push (sdb_plugin->global_scan_aqueue, pkg_scan_data);
+}
+
 /* add a new project */
 static void
 on_project_root_added (AnjutaPlugin *plugin, const gchar *name,
@@ -1654,6 +1670,9 @@ on_project_root_added (AnjutaPlugin *plugin, const gchar *name,
 		
 		sdb_plugin->sdbs = symbol_db_system_new (sdb_plugin, 
 												 sdb_plugin->sdbe_globals);		
+		g_signal_connect (G_OBJECT (sdb_plugin->sdbs), "scan-package-start",
+						  G_CALLBACK (on_isymbol_manager_sys_package_start), 
+						  sdb_plugin);
 	}
 	
 	/* Hide the progress bar. Default system tags thing: we'll import after abort even 
@@ -1919,7 +1938,7 @@ static void
 on_isymbol_manager_sys_scan_begin (SymbolDBEngine *dbe, gint process_id, 
                                    SymbolDBPlugin *sdb_plugin)
 {
-	sdb_plugin->current_pkg_scanned = g_async_queue_pop (sdb_plugin->global_scan_aqueue);
+	sdb_plugin->current_pkg_scanned = g_async_queue_try_pop (sdb_plugin->global_scan_aqueue);
 
 	if (sdb_plugin->current_pkg_scanned == NULL)
 		return;
@@ -2051,6 +2070,20 @@ symbol_db_activate (AnjutaPlugin *plugin)
 	}
 	
 	g_free (ctags_path);
+
+	/* let queries run while scanning */
+	symbol_db_engine_set_read_connections (sdb_plugin->sdbe_project,
+	                                       g_settings_get_int (sdb_plugin->settings, 
+	                                                           READ_CONNECTIONS));
+	symbol_db_engine_set_wal_checkpoint (sdb_plugin->sdbe_project,
+	                                     g_settings_get_int (sdb_plugin->settings, 
+	                                                         WAL_CHECKPOINT));
+	symbol_db_engine_set_read_connections (sdb_plugin->sdbe_globals,
+	                                       g_settings_get_int (sdb_plugin->settings, 
+	                                                           READ_CONNECTIONS));
+	symbol_db_engine_set_wal_checkpoint (sdb_plugin->sdbe_globals,
+	                                     g_settings_get_int (sdb_plugin->settings, 
+	                                                         WAL_CHECKPOINT));
 	
 	/* open it */
 	anjuta_cache_path = anjuta_util_get_user_cache_file_path (".", NULL);
@@ -2066,6 +2099,8 @@ symbol_db_activate (AnjutaPlugin *plugin)
 	sdb_plugin->global_scan_aqueue = g_async_queue_new ();
 	/* create the object that'll manage the globals population */
 	sdb_plugin->sdbs = symbol_db_system_new (sdb_plugin, sdb_plugin->sdbe_globals);
+	g_signal_connect (G_OBJECT (sdb_plugin->sdbs), "scan-package-start",
+					  G_CALLBACK (on_isymbol_manager_sys_package_start), sdb_plugin);
 #if 0
 	g_signal_connect (G_OBJECT (sdb_plugin->sdbs), "scan-package-start",
 					  G_CALLBACK (on_system_scan_package_start), plugin);	
@@ -2308,6 +2343,10 @@ symbol_db_deactivate (AnjutaPlugin *plugin)
 										  on_scan_end_manager,
 										  plugin);
 
+	g_signal_handlers_disconnect_by_func (G_OBJECT (sdb_plugin->sdbs),
+										  on_isymbol_manager_sys_package_start,
+										  plugin);
+
 	/* disconnect the interface ones */
 	/* connect signals for interface to receive them */
 	g_signal_handlers_disconnect_by_func (G_OBJECT (sdb_plugin->sdbe_globals),
@@ -2594,47 +2633,23 @@ isymbol_manager_add_package (IAnjutaSymbolManager *isymbol_manager,
     						 GError **err)
 {
 	SymbolDBPlugin *sdb_plugin;
-	IAnjutaLanguage *lang_manager;
 	GPtrArray *files_array;
-	PackageScanData *pkg_scan_data;
-	
+	gboolean ret;
 
 	g_return_val_if_fail (isymbol_manager != NULL, FALSE);
+	g_return_val_if_fail (files != NULL, FALSE);
 
-	/* DEBUG */
-	GList *node;
-	node = files;
-	while (node != NULL)
-	{
-		node = node->next;
-	}
-	
 	/*  FIXME: pkg_version comes with \n at the end. This should be avoided */
 	sdb_plugin = ANJUTA_PLUGIN_SYMBOL_DB (isymbol_manager);
-	lang_manager = anjuta_shell_get_interface (ANJUTA_PLUGIN (sdb_plugin)->shell, IAnjutaLanguage, 
-										NULL);	
-
-	if (symbol_db_engine_add_new_project (sdb_plugin->sdbe_globals, NULL, pkg_name, 
-	    pkg_version) == FALSE)
-	{
-		return FALSE;
-	}
 
+	/* files are classified in a thread and the package is scanned after the 
+	 * ones already queued, see on_isymbol_manager_sys_package_start () */
 	files_array = anjuta_util_convert_string_list_to_array (files);
-
-	pkg_scan_data = g_new0 (PackageScanData, 1);
-	
-	g_async_queue_push (sdb_plugin->global_scan_aqueue, pkg_scan_data);
-	pkg_scan_data->files_length = g_list_length (files);
-	pkg_scan_data->package_name = g_strdup (pkg_name);
-	pkg_scan_data->package_version = g_strdup (pkg_version);
-	
-	pkg_scan_data->proc_id = symbol_db_engine_add_new_files_async (sdb_plugin->sdbe_globals, lang_manager, 
-	    pkg_name, pkg_version, files_array);
-
+	ret = symbol_db_system_add_package (sdb_plugin->sdbs, pkg_name, pkg_version, 
+	                                    files_array);
 	g_ptr_array_unref (files_array);
 	
-	return TRUE;
+	return ret;
 }
 
 /* FIXME: do this thread safe */
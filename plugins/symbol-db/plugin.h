@@ -57,7 +57,6 @@ typedef struct _SymbolDBPluginClass SymbolDBPluginClass;
 typedef struct _PackageScanData {
 	gchar *package_name;
 	gchar *package_version;
-	gint proc_id;
 	gint files_length;
 	gint files_done;
 		
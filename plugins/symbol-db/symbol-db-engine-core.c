@@ -353,6 +353,30 @@ sdb_engine_execute_unknown_sql (SymbolDBEngine *dbe, const gchar *sql)
 	}
 }
 
+/* Execute a statement on another connection than the main one */
+static gboolean
+sdb_engine_execute_unknown_sql_on_connection (SymbolDBEngine *dbe, 
+                                              GdaConnection *cnc,
+                                              const gchar *sql)
+{
+	GdaStatement *stmt;
+	GObject *res;
+
+	stmt = gda_sql_parser_parse_string (dbe->priv->sql_parser, sql, NULL, NULL);
+	if (stmt == NULL)
+		return FALSE;
+
+	res = gda_connection_statement_execute (cnc, stmt, NULL,
+	                                        GDA_STATEMENT_MODEL_RANDOM_ACCESS,
+	                                        NULL, NULL);
+	g_object_unref (stmt);
+	if (res == NULL)
+		return FALSE;
+
+	g_object_unref (res);
+	return TRUE;
+}
+
 static GdaDataModel *
 sdb_engine_execute_select_sql (SymbolDBEngine * dbe, const gchar *sql)
 {
@@ -514,6 +538,117 @@ sdb_engine_free_cached_queries (SymbolDBEngine *dbe)
 	}
 }
 
+/* Open the read only connections, the database has to be in WAL mode */
+static void
+sdb_engine_open_read_connections (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	guint i;
+
+	priv = dbe->priv;
+	if (priv->read_connections_max == 0 || priv->read_connections != NULL)
+		return;
+
+	priv->read_connections = g_async_queue_new ();
+	priv->read_connection_list = g_ptr_array_new ();
+	for (i = 0; i < priv->read_connections_max; i++)
+	{
+		GdaConnection *cnc;
+
+		cnc = gda_connection_open_from_string ("SQLite", priv->cnc_string, NULL, 
+		                                       GDA_CONNECTION_OPTIONS_THREAD_SAFE |
+		                                       GDA_CONNECTION_OPTIONS_READ_ONLY,
+		                                       NULL);
+		if (!GDA_IS_CONNECTION (cnc))
+		{
+			g_warning ("Could not open read only connection to %s", 
+			           priv->cnc_string);
+			break;
+		}
+
+		sdb_engine_execute_unknown_sql_on_connection (dbe, cnc,
+		                                              priv->case_sensitive ? 
+		                                              "PRAGMA case_sensitive_like = 1" :
+		                                              "PRAGMA case_sensitive_like = 0");
+		g_ptr_array_add (priv->read_connection_list, cnc);
+		g_async_queue_push (priv->read_connections, cnc);
+	}
+	DEBUG_PRINT ("Opened %d read only connections", 
+	             priv->read_connection_list->len);
+}
+
+/* Wait until the read only connections are not used and take them */
+static void
+sdb_engine_lock_read_connections (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv = dbe->priv;
+	guint i;
+
+	for (i = 0; i < priv->read_connection_list->len; i++)
+		g_async_queue_pop (priv->read_connections);
+}
+
+static void
+sdb_engine_unlock_read_connections (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv = dbe->priv;
+	guint i;
+
+	for (i = 0; i < priv->read_connection_list->len; i++)
+		g_async_queue_push (priv->read_connections,
+		                    g_ptr_array_index (priv->read_connection_list, i));
+}
+
+static void
+sdb_engine_close_read_connections (SymbolDBEngine *dbe)
+{
+	SymbolDBEnginePriv *priv;
+	GAsyncQueue *queue;
+	guint i;
+
+	priv = dbe->priv;
+
+	/* New queries use the main connection from now. The running ones have
+	 * taken their connection with the mutex held, so they will give it back */
+	g_mutex_lock (priv->read_connections_mutex);
+	queue = priv->read_connections;
+	priv->read_connections = NULL;
+	g_mutex_unlock (priv->read_connections_mutex);
+
+	if (queue == NULL)
+		return;
+
+	for (i = 0; i < priv->read_connection_list->len; i++)
+		g_async_queue_pop (queue);
+
+	for (i = 0; i < priv->read_connection_list->len; i++)
+	{
+		GdaConnection *cnc = g_ptr_array_index (priv->read_connection_list, i);
+
+		gda_connection_close (cnc);
+		g_object_unref (cnc);
+	}
+	g_ptr_array_free (priv->read_connection_list, TRUE);
+	priv->read_connection_list = NULL;
+	g_async_queue_unref (queue);
+}
+
+/* Set when changes in the WAL file are copied in the database */
+static void
+sdb_engine_set_wal_checkpoint_parameter (SymbolDBEngine *dbe)
+{
+	gchar *sql;
+
+	/* Automatic checkpoints are needed for the writes done outside of the
+	 * scans, with 0 SQLite default is kept and a checkpoint is done at the
+	 * end of each scan too */
+	sql = g_strdup_printf ("PRAGMA wal_autocheckpoint = %d",
+	                       dbe->priv->wal_checkpoint > 0 ? 
+	                       dbe->priv->wal_checkpoint : WAL_DEFAULT_CHECKPOINT);
+	sdb_engine_execute_unknown_sql (dbe, sql);
+	g_free (sql);
+}
+
 static gboolean
 sdb_engine_disconnect_from_db (SymbolDBEngine * dbe)
 {
@@ -522,6 +657,8 @@ sdb_engine_disconnect_from_db (SymbolDBEngine * dbe)
 	g_return_val_if_fail (dbe != NULL, FALSE);
 	priv = dbe->priv;
 
+	sdb_engine_close_read_connections (dbe);
+
 	DEBUG_PRINT ("VACUUM command issued on %s", priv->cnc_string);
 	sdb_engine_execute_non_select_sql (dbe, "VACUUM");
 	
@@ -536,6 +673,11 @@ sdb_engine_disconnect_from_db (SymbolDBEngine * dbe)
 	if (priv->sql_parser != NULL)
 		g_object_unref (priv->sql_parser);
 	priv->sql_parser = NULL;
+
+	/* Statements have been compiled by the parser of this connection */
+	g_mutex_lock (priv->query_stmts_mutex);
+	g_hash_table_remove_all (priv->query_stmts);
+	g_mutex_unlock (priv->query_stmts_mutex);
 	
 	return TRUE;
 }
@@ -1132,6 +1274,12 @@ sdb_engine_timeout_trigger_signals (gpointer user_data)
 					gda_connection_commit_transaction (priv->db_connection, "symboltrans",
 		    						NULL);
 					DEBUG_PRINT ("... Done!");
+
+					/* Copy the new symbols in the database without blocking
+					 * the readers */
+					if (priv->read_connections != NULL && priv->wal_checkpoint <= 0)
+						sdb_engine_execute_unknown_sql (dbe, 
+						                                "PRAGMA wal_checkpoint(PASSIVE)");
 					
 					/* perform flush on db of the tablemaps, if this is the 1st scan */
 					if (priv->is_first_population == TRUE)
@@ -1235,7 +1383,7 @@ sdb_engine_ctags_output_callback_1 (AnjutaLauncher * launcher,
 	if (priv->timeout_trigger_handler <= 0)
 	{
 		priv->timeout_trigger_handler = 
-			g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, TRIGGER_SIGNALS_DELAY, 
+			g_timeout_add_full (G_PRIORITY_DEFAULT_IDLE, priv->trigger_signals_delay, 
 						   sdb_engine_timeout_trigger_signals, user_data, NULL);
 		priv->trigger_closure_retries = 0;
 	}
@@ -1665,6 +1813,7 @@ sdb_engine_init (SymbolDBEngine * object)
 
 	sdbe->priv->db_connection = NULL;
 	sdbe->priv->sql_parser = NULL;
+	sdbe->priv->case_sensitive = TRUE;
 	sdbe->priv->db_directory = NULL;
 	sdbe->priv->project_directory = NULL;
 	sdbe->priv->cnc_string = NULL;	
@@ -2033,10 +2182,50 @@ sdb_engine_init (SymbolDBEngine * object)
 	    	prj_id = (SELECT project_id FROM project \
 	    			  WHERE project_name = ## /* name:'prjname' type:gchararray */) AND \
 	    	file_path = ## /* name:'filepath' type:gchararray */");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_REMOVE_FILES_BY_PROJECT_OTHER_VERSIONS,
+	 	"DELETE FROM file WHERE \
+	    	prj_id IN (SELECT project_id FROM project \
+	    			  WHERE project_name = ## /* name:'prjname' type:gchararray */ AND \
+	    			  project_version != ## /* name:'prjversion' type:gchararray */)");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_REMOVE_PROJECT_OTHER_VERSIONS,
+	 	"DELETE FROM project WHERE \
+	    	project_name = ## /* name:'prjname' type:gchararray */ AND \
+	    	project_version != ## /* name:'prjversion' type:gchararray */");
+
+	/* -- tmp_scope -- */
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_TMP_SCOPE_NEW,
+	 	"INSERT OR REPLACE INTO __tmp_scope (symbol_id, type_type, type_name) VALUES ( \
+	 		## /* name:'symbolid' type:gint */, \
+	 		## /* name:'tokenname' type:gchararray */, \
+	 		## /* name:'objectname' type:gchararray */)");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_UPDATE_SYMBOL_SCOPE_ID_FROM_TMP,
+	 	"UPDATE symbol SET scope_id = (SELECT definition.scope_definition_id \
+	 		FROM __tmp_scope JOIN symbol AS definition ON \
+	 			definition.type_type = __tmp_scope.type_type AND \
+	 			definition.type_name = __tmp_scope.type_name \
+	 		WHERE __tmp_scope.symbol_id = symbol.symbol_id LIMIT 1) \
+	 	 WHERE symbol_id IN (SELECT symbol_id FROM __tmp_scope)");
+
+	STATIC_QUERY_POPULATE_INIT_NODE(sdbe->priv->static_query_list, 
+	 								PREP_QUERY_TMP_SCOPE_DELETE_ALL,
+	 	"DELETE FROM __tmp_scope");
 	
 	/* init cache hashtables */
 	sdb_engine_init_caches (sdbe);
 
+	sdbe->priv->trigger_signals_delay = TRIGGER_SIGNALS_DELAY;
+	sdbe->priv->query_stmts_mutex = g_mutex_new ();
+	sdbe->priv->read_connections_mutex = g_mutex_new ();
+	sdbe->priv->query_stmts = g_hash_table_new_full (g_str_hash, g_str_equal,
+	                                                 g_free, g_object_unref);
+
 	/* init table maps */
 	sdb_engine_init_table_maps (sdbe);
 }
@@ -2163,6 +2352,15 @@ sdb_engine_finalize (GObject * object)
 	sdb_engine_clear_caches (dbe);
 	sdb_engine_clear_tablemaps (dbe);
 
+	DEBUG_PRINT ("Query statement cache: %u hits, %u misses",
+	             priv->query_stmts_hits, priv->query_stmts_misses);
+	g_hash_table_destroy (priv->query_stmts);
+	priv->query_stmts = NULL;
+	g_mutex_free (priv->query_stmts_mutex);
+	priv->query_stmts_mutex = NULL;
+	g_mutex_free (priv->read_connections_mutex);
+	priv->read_connections_mutex = NULL;
+
 	g_free (priv->anjuta_db_file);
 	priv->anjuta_db_file = NULL;
 	
@@ -2413,7 +2611,16 @@ sdb_engine_set_defaults_db_parameters (SymbolDBEngine * dbe)
 	sdb_engine_execute_unknown_sql (dbe, "PRAGMA cache_size = 12288");
 	sdb_engine_execute_unknown_sql (dbe, "PRAGMA synchronous = OFF");
 	sdb_engine_execute_unknown_sql (dbe, "PRAGMA temp_store = MEMORY");	
-	sdb_engine_execute_unknown_sql (dbe, "PRAGMA journal_mode = OFF");
+	if (dbe->priv->read_connections_max > 0)
+	{
+		/* Readers see the last committed data while the symbols are written */
+		sdb_engine_execute_unknown_sql (dbe, "PRAGMA journal_mode = WAL");
+		sdb_engine_set_wal_checkpoint_parameter (dbe);
+	}
+	else
+	{
+		sdb_engine_execute_unknown_sql (dbe, "PRAGMA journal_mode = OFF");
+	}
 	sdb_engine_execute_unknown_sql (dbe, "PRAGMA read_uncommitted = 1");
 	sdb_engine_execute_unknown_sql (dbe, "PRAGMA foreign_keys = OFF");
 	symbol_db_engine_set_db_case_sensitive (dbe, TRUE);
@@ -2839,6 +3046,7 @@ symbol_db_engine_open_db (SymbolDBEngine * dbe, const gchar * base_db_path,
 	}
 	
 	sdb_engine_set_defaults_db_parameters (dbe);
+	sdb_engine_open_read_connections (dbe);
 
 	g_free (cnc_string);
 	g_free (db_file);
@@ -3401,44 +3609,30 @@ symbol_db_engine_add_new_files_async (SymbolDBEngine *dbe,
 	for (i = 0; i < sources_array->len; i++)
 	{		
 		IAnjutaLanguageId lang_id;
-		GFile *gfile;
-		GFileInfo *gfile_info;	
-		const gchar *file_mime;
+		gchar *file_mime;
 		const gchar *lang;
 		const gchar *local_filename;
 		
 		local_filename = g_ptr_array_index (sources_array, i);			
-		gfile = g_file_new_for_path (local_filename);		
-		gfile_info = g_file_query_info (gfile, 
-										"standard::content-type", 
-										G_FILE_QUERY_INFO_NONE,
-										NULL,
-										NULL);
-		if (gfile_info == NULL)
+		file_mime = symbol_db_util_get_mime_type (local_filename);
+		if (file_mime == NULL)
 		{
-			g_warning ("GFileInfo corresponding to %s was NULL", local_filename);
-			g_object_unref (gfile);
+			g_warning ("Mime type corresponding to %s was NULL", local_filename);
 			continue;
 		}
 		
-		file_mime = g_file_info_get_attribute_string (gfile_info,
-										  G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE);										  		
-					
 		lang_id = ianjuta_language_get_from_mime_type (lang_manager, 
 													 file_mime, NULL);
+		g_free (file_mime);
 					
 		if (!lang_id)
 		{
 			g_warning ("Language not found for %s was NULL", local_filename);
-			g_object_unref (gfile);
-			g_object_unref (gfile_info);			
 			continue;
 		}
 				
 		lang = ianjuta_language_get_name (lang_manager, lang_id, NULL);	
 		g_ptr_array_add (lang_array, g_strdup (lang));
-		g_object_unref (gfile);
-		g_object_unref (gfile_info);
 	}
 
 	gint res = symbol_db_engine_add_new_files_full_async (dbe, project_name, project_version, 
@@ -4124,6 +4318,52 @@ sdb_engine_add_new_tmp_heritage_scope (SymbolDBEngine * dbe,
 	g_queue_push_head (priv->tmp_heritage_tablemap, node);
 }
 
+/**
+ * Get the type of the symbol defining the scope given by a ctags field, like
+ * class:MyFooClass. Returns FALSE if the field doesn't define a scope, else
+ * type_type and type_name have to be freed.
+ */
+static gboolean
+sdb_engine_second_pass_get_scope_type (const gchar * token_name,
+									   const gchar * token_value,
+									   gchar ** type_type,
+									   gchar ** type_name)
+{
+	gchar **tmp_str_splitted;
+	gint tmp_str_splitted_length;
+
+	/* we don't need empty strings */
+	if (token_value == NULL || strlen (token_value) <= 0)
+	{
+		return FALSE;
+	}
+
+	/* we could have something like "First::Second::Third::Fourth" as tmp_str, so 
+	 * take only the lastscope, in this case 'Fourth'.
+	 */
+	tmp_str_splitted = g_strsplit (token_value, ":", 0);
+	tmp_str_splitted_length = g_strv_length (tmp_str_splitted);
+
+	if (tmp_str_splitted_length <= 0)
+	{
+		g_strfreev (tmp_str_splitted);
+		return FALSE;
+	}
+
+	/* handle special typedef case. Usually we have something like struct:my_foo.
+	 * splitting we have [0]-> struct [1]-> my_foo
+	 */
+	if (g_strcmp0 (token_name, "typedef") == 0)
+		*type_type = g_strdup (tmp_str_splitted[0]);
+	else
+		*type_type = g_strdup (token_name);
+
+	*type_name = g_strdup (tmp_str_splitted[tmp_str_splitted_length - 1]);
+	g_strfreev (tmp_str_splitted);
+
+	return TRUE;
+}
+
 /** 
  * ### Thread note: this function inherits the mutex lock ### 
  *
@@ -4136,11 +4376,8 @@ sdb_engine_second_pass_update_scope_1 (SymbolDBEngine * dbe,
 									   const gchar * token_value)
 {
 	gint symbol_referer_id;
-	const gchar *tmp_str;
-	gchar **tmp_str_splitted;
-	gint tmp_str_splitted_length;
+	gchar *type_type = NULL;
 	gchar *object_name = NULL;
-	gboolean free_token_name = FALSE;
 	const GdaSet *plist;
 	const GdaStatement *stmt;
 	GdaHolder *param;
@@ -4150,41 +4387,13 @@ sdb_engine_second_pass_update_scope_1 (SymbolDBEngine * dbe,
 	g_return_if_fail (token_value != NULL);
 		
 	priv = dbe->priv;
-	tmp_str = token_value;
-
-	/* we don't need empty strings */
-	if (strlen (tmp_str) <= 0)
-	{
-		return;
-	}
 
-	/* we could have something like "First::Second::Third::Fourth" as tmp_str, so 
-	 * take only the lastscope, in this case 'Fourth'.
-	 */
-	tmp_str_splitted = g_strsplit (tmp_str, ":", 0);
-	tmp_str_splitted_length = g_strv_length (tmp_str_splitted);
-
-	if (tmp_str_splitted_length > 0)
+	if (!sdb_engine_second_pass_get_scope_type (token_name, token_value,
+												&type_type, &object_name))
 	{
-		/* handle special typedef case. Usually we have something like struct:my_foo.
-		 * splitting we have [0]-> struct [1]-> my_foo
-		 */
-		if (g_strcmp0 (token_name, "typedef") == 0)
-		{
-			free_token_name = TRUE;
-			token_name = g_strdup (tmp_str_splitted[0]);
-		}
-
-		object_name = g_strdup (tmp_str_splitted[tmp_str_splitted_length - 1]);
-	}
-	else
-	{
-		g_strfreev (tmp_str_splitted);
 		return;
 	}
 
-	g_strfreev (tmp_str_splitted);
-
 	/* if we reach this point we should have a good scope_id.
 	 * Go on with symbol updating.
 	 */
@@ -4207,7 +4416,7 @@ sdb_engine_second_pass_update_scope_1 (SymbolDBEngine * dbe,
 		return;
 	}
 
-	SDB_PARAM_SET_STRING(param, token_name);
+	SDB_PARAM_SET_STRING(param, type_type);
 
 	/* objectname parameter */
 	if ((param = gda_set_get_holder ((GdaSet*)plist, "objectname")) == NULL)
@@ -4233,8 +4442,7 @@ sdb_engine_second_pass_update_scope_1 (SymbolDBEngine * dbe,
 													 (GdaSet*)plist, NULL,
 													 NULL);
 
-	if (free_token_name)
-		g_free (token_name);
+	g_free (type_type);
 	g_free (object_name);
 	
 	return;
@@ -4323,6 +4531,143 @@ sdb_engine_second_pass_update_scope (SymbolDBEngine * dbe)
 
 }
 
+/**
+ * ### Thread note: this function inherits the mutex lock ### 
+ *
+ * Same as sdb_engine_second_pass_update_scope () but the scope references
+ * are first staged in the __tmp_scope temporary table and then resolved
+ * with a single UPDATE joining the symbol table. The staging table is keyed
+ * by symbol_id so the UPDATE looks up each symbol directly.
+ * Returns FALSE if the temporary table is not available, the queue is left
+ * untouched in this case.
+ */
+static gboolean
+sdb_engine_second_pass_update_scope_set (SymbolDBEngine * dbe)
+{
+	SymbolDBEnginePriv *priv;
+	const GdaSet *plist;
+	const GdaStatement *stmt;
+	GdaHolder *param_symbol, *param_token, *param_object;
+	GValue v = {0};
+	gint i;
+	gint staged = 0;
+	gsize queue_length;
+	GTimer *timer;
+
+	priv = dbe->priv;
+
+	if (sdb_engine_execute_non_select_sql (dbe,
+			"CREATE TEMP TABLE IF NOT EXISTS __tmp_scope ("
+			"symbol_id integer PRIMARY KEY, type_type text, type_name text)") < 0)
+	{
+		return FALSE;
+	}
+
+	if ((stmt = sdb_engine_get_statement_by_query_id (dbe,
+											 PREP_QUERY_TMP_SCOPE_NEW))
+		== NULL)
+	{
+		g_warning ("query is null");
+		return FALSE;
+	}
+
+	plist = sdb_engine_get_query_parameters_list (dbe, PREP_QUERY_TMP_SCOPE_NEW);
+	param_symbol = gda_set_get_holder ((GdaSet*)plist, "symbolid");
+	param_token = gda_set_get_holder ((GdaSet*)plist, "tokenname");
+	param_object = gda_set_get_holder ((GdaSet*)plist, "objectname");
+	if (param_symbol == NULL || param_token == NULL || param_object == NULL)
+	{
+		g_warning ("params are NULL from pquery!");
+		return FALSE;
+	}
+
+	timer = g_timer_new ();
+
+	/* get a fixed length. There may be some tail_pushes during this loop */
+	queue_length = g_queue_get_length (priv->tmp_heritage_tablemap);
+
+	for (i = 0; i < queue_length; i++)
+	{
+		TableMapTmpHeritage *node;
+		gchar *type_type = NULL;
+		gchar *type_name = NULL;
+
+		node = g_queue_pop_head (priv->tmp_heritage_tablemap);
+
+		/* Each scope field overwrites the previous one in
+		 * sdb_engine_second_pass_update_scope (), so only the last one is
+		 * staged, in the same order. */
+		if (sdb_engine_second_pass_get_scope_type ("namespace",
+			    node->field_namespace, &type_type, &type_name) ||
+			sdb_engine_second_pass_get_scope_type ("union",
+			    node->field_union, &type_type, &type_name) ||
+			sdb_engine_second_pass_get_scope_type ("enum",
+			    node->field_enum, &type_type, &type_name) ||
+			sdb_engine_second_pass_get_scope_type ("typedef",
+			    node->field_typeref, &type_type, &type_name) ||
+			sdb_engine_second_pass_get_scope_type ("struct",
+			    node->field_struct, &type_type, &type_name) ||
+			sdb_engine_second_pass_get_scope_type ("class",
+			    node->field_class, &type_type, &type_name))
+		{
+			SDB_PARAM_SET_INT(param_symbol, node->symbol_referer_id);
+			SDB_PARAM_SET_STRING(param_token, type_type);
+			SDB_PARAM_SET_STRING(param_object, type_name);
+
+			gda_connection_statement_execute_non_select (priv->db_connection, 
+													 (GdaStatement*)stmt, 
+													 (GdaSet*)plist, NULL,
+													 NULL);
+			g_free (type_type);
+			g_free (type_name);
+			staged++;
+		}
+
+		/* last check: if inherits is not null keep the node for a later task */
+		if (node->field_inherits != NULL)
+		{
+			g_queue_push_tail (priv->tmp_heritage_tablemap, node);
+		}
+		else 
+		{
+			sdb_engine_tablemap_tmp_heritage_destroy (node);
+		}
+	}
+
+	priv->scope_stage_time += g_timer_elapsed (timer, NULL);
+	DEBUG_PRINT ("Staged %d scope references in %f sec", staged,
+	             g_timer_elapsed (timer, NULL));
+	g_timer_start (timer);
+
+	if (staged > 0)
+	{
+		if ((stmt = sdb_engine_get_statement_by_query_id (dbe,
+								PREP_QUERY_UPDATE_SYMBOL_SCOPE_ID_FROM_TMP)) != NULL)
+		{
+			gda_connection_statement_execute_non_select (priv->db_connection, 
+													 (GdaStatement*)stmt, 
+													 NULL, NULL, NULL);
+		}
+
+		DEBUG_PRINT ("Resolved scopes in %f sec",
+		             g_timer_elapsed (timer, NULL));
+
+		if ((stmt = sdb_engine_get_statement_by_query_id (dbe,
+								PREP_QUERY_TMP_SCOPE_DELETE_ALL)) != NULL)
+		{
+			gda_connection_statement_execute_non_select (priv->db_connection, 
+													 (GdaStatement*)stmt, 
+													 NULL, NULL, NULL);
+		}
+	}
+
+	/* Clearing the staging table is part of the resolution */
+	priv->scope_resolve_time += g_timer_elapsed (timer, NULL);
+	g_timer_destroy (timer);
+
+	return TRUE;
+}
+
 /**
  * ### Thread note: this function inherits the mutex lock ### 
  *
@@ -4514,14 +4859,29 @@ static void
 sdb_engine_second_pass_do (SymbolDBEngine * dbe)
 {
 	SymbolDBEnginePriv *priv;
+	GTimer *timer;
 
 	priv = dbe->priv;
 
 	/* prepare for scope second scan */
 	if (g_queue_get_length (priv->tmp_heritage_tablemap) > 0)
 	{
-		sdb_engine_second_pass_update_scope (dbe);
+		/* Fall back to updating each symbol if the staging table is missing,
+		 * it has no staging phase */
+		timer = g_timer_new ();
+		if (!sdb_engine_second_pass_update_scope_set (dbe))
+		{
+			sdb_engine_second_pass_update_scope (dbe);
+			priv->scope_resolve_time += g_timer_elapsed (timer, NULL);
+		}
+		DEBUG_PRINT ("Scope pass done in %f sec",
+		             g_timer_elapsed (timer, NULL));
+		g_timer_start (timer);
 		sdb_engine_second_pass_update_heritage (dbe);
+		priv->heritage_time += g_timer_elapsed (timer, NULL);
+		DEBUG_PRINT ("Heritage pass done in %f sec",
+		             g_timer_elapsed (timer, NULL));
+		g_timer_destroy (timer);
 	}
 }
 
@@ -5642,6 +6002,86 @@ symbol_db_engine_remove_file (SymbolDBEngine * dbe, const gchar *project,
 	return TRUE;
 }
 
+/**
+ * symbol_db_engine_remove_project_other_versions:
+ * @dbe: self
+ * @project: project name
+ * @version: project version to keep.
+ * 
+ * Remove the projects named @project with a version different from @version,
+ * together with their files and symbols. A file belongs to one project only, 
+ * so the files of an old version must be removed before scanning a new one.
+ * ~~~ Thread note: this function locks the mutex
+ * 
+ * Returns: TRUE if everything went good, FALSE otherwise.
+ */
+gboolean
+symbol_db_engine_remove_project_other_versions (SymbolDBEngine * dbe, 
+                                                const gchar *project,
+                                                const gchar *version)
+{
+	SymbolDBEnginePriv *priv;	
+	static_query_type queries[] = {
+		PREP_QUERY_REMOVE_FILES_BY_PROJECT_OTHER_VERSIONS,
+		PREP_QUERY_REMOVE_PROJECT_OTHER_VERSIONS
+	};
+	gint i;
+	
+	g_return_val_if_fail (dbe != NULL, FALSE);
+	g_return_val_if_fail (project != NULL, FALSE);
+	g_return_val_if_fail (version != NULL, FALSE);
+	priv = dbe->priv;
+	
+	SDB_LOCK(priv);
+
+	for (i = 0; i < G_N_ELEMENTS (queries); i++)
+	{
+		const GdaSet *plist;
+		const GdaStatement *stmt;
+		GdaHolder *param;
+		GValue v = {0};
+		
+		if ((stmt = sdb_engine_get_statement_by_query_id (dbe, queries[i])) == NULL)
+		{
+			g_warning ("query is null");
+			SDB_UNLOCK(priv);
+			return FALSE;
+		}
+
+		plist = sdb_engine_get_query_parameters_list (dbe, queries[i]);
+
+		if ((param = gda_set_get_holder ((GdaSet*)plist, "prjname")) == NULL)
+		{
+			g_warning ("param prjname is NULL from pquery!");
+			SDB_UNLOCK(priv);
+			return FALSE;
+		}
+
+		SDB_PARAM_SET_STRING(param, project);
+	
+		if ((param = gda_set_get_holder ((GdaSet*)plist, "prjversion")) == NULL)
+		{
+			g_warning ("param prjversion is NULL from pquery!");
+			SDB_UNLOCK(priv);
+			return FALSE;
+		}
+	
+		SDB_PARAM_SET_STRING(param, version);	
+
+		/* Triggers will take care of deleting the symbols of the files */
+		gda_connection_statement_execute_non_select (priv->db_connection, 
+		                                             (GdaStatement*)stmt, 
+		                                             (GdaSet*)plist, NULL, NULL);
+	}
+
+	/* emits removed symbols signals */
+	sdb_engine_detects_removed_ids (dbe);
+	
+	SDB_UNLOCK(priv);
+	
+	return TRUE;
+}
+
 void
 symbol_db_engine_remove_files (SymbolDBEngine * dbe, const gchar * project,
                                                          const GPtrArray * files)
@@ -5867,12 +6307,108 @@ symbol_db_engine_get_files_for_project (SymbolDBEngine *dbe)
 void
 symbol_db_engine_set_db_case_sensitive (SymbolDBEngine *dbe, gboolean case_sensitive)
 {
+	const gchar *sql;
+	
 	g_return_if_fail (dbe != NULL);
 
 	if (case_sensitive == TRUE)
-		sdb_engine_execute_unknown_sql (dbe, "PRAGMA case_sensitive_like = 1");
+		sql = "PRAGMA case_sensitive_like = 1";
 	else 
-		sdb_engine_execute_unknown_sql (dbe, "PRAGMA case_sensitive_like = 0");
+		sql = "PRAGMA case_sensitive_like = 0";
+
+	dbe->priv->case_sensitive = case_sensitive;
+	sdb_engine_execute_unknown_sql (dbe, sql);
+
+	/* Read only connections have to give the same results */
+	if (dbe->priv->read_connections != NULL)
+	{
+		guint i;
+
+		sdb_engine_lock_read_connections (dbe);
+		for (i = 0; i < dbe->priv->read_connection_list->len; i++)
+		{
+			sdb_engine_execute_unknown_sql_on_connection (dbe,
+			                                              g_ptr_array_index (dbe->priv->read_connection_list, i),
+			                                              sql);
+		}
+		sdb_engine_unlock_read_connections (dbe);
+	}
+}
+
+/**
+ * symbol_db_engine_set_read_connections:
+ * @dbe: self
+ * @count: number of read only connections, 0 to disable them.
+ * 
+ * Queries made with symbol_db_engine_execute_query_select() use one of
+ * @count read only connections, so they can run at the same time and don't
+ * wait for the end of a scan. They see the database as it was at the last
+ * commit. The database is switched to WAL mode to allow this. It is taken
+ * into account the next time the database is opened.
+ */
+void
+symbol_db_engine_set_read_connections (SymbolDBEngine *dbe, guint count)
+{
+	g_return_if_fail (SYMBOL_IS_DB_ENGINE (dbe));
+
+	dbe->priv->read_connections_max = count;
+}
+
+/**
+ * symbol_db_engine_set_wal_checkpoint:
+ * @dbe: self
+ * @pages: size of the WAL file in pages triggering a checkpoint, 0 to 
+ *        keep SQLite default and checkpoint at the end of each scan too.
+ * 
+ * Set when the changes in the WAL file are copied in the database, if the
+ * read only connections are enabled.
+ */
+void
+symbol_db_engine_set_wal_checkpoint (SymbolDBEngine *dbe, gint pages)
+{
+	g_return_if_fail (SYMBOL_IS_DB_ENGINE (dbe));
+
+	dbe->priv->wal_checkpoint = pages;
+	if (dbe->priv->read_connections != NULL)
+		sdb_engine_set_wal_checkpoint_parameter (dbe);
+}
+
+/**
+ * symbol_db_engine_set_signals_delay:
+ * @dbe: self
+ * @delay: time in milliseconds.
+ * 
+ * Set how often the signals queued by a scan are emitted, scan-end comes
+ * up to @delay milliseconds after the end of the scan. It is taken into
+ * account by the next scan.
+ */
+void
+symbol_db_engine_set_signals_delay (SymbolDBEngine *dbe, guint delay)
+{
+	g_return_if_fail (SYMBOL_IS_DB_ENGINE (dbe));
+
+	dbe->priv->trigger_signals_delay = delay;
+}
+
+/**
+ * symbol_db_engine_has_read_connections:
+ * @dbe: self
+ * 
+ * Returns: TRUE if queries use read only connections, they can then be
+ * executed while scanning.
+ */
+gboolean
+symbol_db_engine_has_read_connections (SymbolDBEngine *dbe)
+{
+	gboolean has_read_connections;
+	
+	g_return_val_if_fail (SYMBOL_IS_DB_ENGINE (dbe), FALSE);
+
+	g_mutex_lock (dbe->priv->read_connections_mutex);
+	has_read_connections = dbe->priv->read_connections != NULL;
+	g_mutex_unlock (dbe->priv->read_connections_mutex);
+
+	return has_read_connections;
 }
 
 /**
@@ -5932,6 +6468,104 @@ symbol_db_engine_get_statement (SymbolDBEngine *dbe, const gchar *sql_str)
 	return stmt;
 }
 
+/**
+ * symbol_db_engine_get_query_statement:
+ * @dbe: self
+ * @sql_str: sql statement.
+ * 
+ * Compiles an sql statement or returns the statement already compiled for the
+ * same sql string. Parameters of the statement are bound at execution, so
+ * queries having the same shape share one statement and the prepared
+ * statement of the connection. This function can be called from any thread.
+ * 
+ * Returns: a GdaStatement object which must be freed once used.
+ */
+GdaStatement*
+symbol_db_engine_get_query_statement (SymbolDBEngine *dbe, const gchar *sql_str)
+{
+	SymbolDBEnginePriv *priv;
+	GdaStatement* stmt;
+	
+	g_return_val_if_fail (SYMBOL_IS_DB_ENGINE (dbe), NULL);
+	priv = dbe->priv;
+
+	g_mutex_lock (priv->query_stmts_mutex);
+	stmt = g_hash_table_lookup (priv->query_stmts, sql_str);
+	if (stmt != NULL)
+	{
+		priv->query_stmts_hits++;
+		g_object_ref (stmt);
+	}
+	else
+	{
+		priv->query_stmts_misses++;
+		stmt = symbol_db_engine_get_statement (dbe, sql_str);
+		if (stmt != NULL)
+		{
+			/* Queries are built from a few templates, so the limit is
+			 * reached only by unusual combinations of fields and filters */
+			if (g_hash_table_size (priv->query_stmts) >= QUERY_STATEMENT_CACHE_MAX)
+				g_hash_table_remove_all (priv->query_stmts);
+			g_hash_table_insert (priv->query_stmts, g_strdup (sql_str),
+			                     g_object_ref (stmt));
+		}
+	}
+	g_mutex_unlock (priv->query_stmts_mutex);
+	
+	return stmt;
+}
+
+/**
+ * symbol_db_engine_get_query_statement_stats:
+ * @dbe: self
+ * @hits: (out) (allow-none): number of statements found in the cache.
+ * @misses: (out) (allow-none): number of statements compiled.
+ * 
+ * Gets the counters of symbol_db_engine_get_query_statement().
+ */
+void
+symbol_db_engine_get_query_statement_stats (SymbolDBEngine *dbe, guint *hits,
+                                            guint *misses)
+{
+	SymbolDBEnginePriv *priv;
+	
+	g_return_if_fail (SYMBOL_IS_DB_ENGINE (dbe));
+	priv = dbe->priv;
+
+	g_mutex_lock (priv->query_stmts_mutex);
+	if (hits) *hits = priv->query_stmts_hits;
+	if (misses) *misses = priv->query_stmts_misses;
+	g_mutex_unlock (priv->query_stmts_mutex);
+}
+
+/**
+ * symbol_db_engine_get_second_pass_stats:
+ * @dbe: self
+ * @scope_stage: (out) (allow-none): seconds spent staging scope references.
+ * @scope_resolve: (out) (allow-none): seconds spent resolving the scopes.
+ * @heritage: (out) (allow-none): seconds spent resolving the inheritance.
+ * 
+ * Gets the time spent in each phase of the second pass of the scans, summed
+ * since the engine was created.
+ */
+void
+symbol_db_engine_get_second_pass_stats (SymbolDBEngine *dbe,
+                                        gdouble *scope_stage,
+                                        gdouble *scope_resolve,
+                                        gdouble *heritage)
+{
+	SymbolDBEnginePriv *priv;
+	
+	g_return_if_fail (SYMBOL_IS_DB_ENGINE (dbe));
+	priv = dbe->priv;
+
+	SDB_LOCK(priv);
+	if (scope_stage) *scope_stage = priv->scope_stage_time;
+	if (scope_resolve) *scope_resolve = priv->scope_resolve_time;
+	if (heritage) *heritage = priv->heritage_time;
+	SDB_UNLOCK(priv);
+}
+
 /**
  * symbol_db_engine_execute_select:
  * @dbe: self
@@ -5963,3 +6597,58 @@ symbol_db_engine_execute_select (SymbolDBEngine *dbe, GdaStatement *stmt,
 	}
 	return res;
 }
+
+/**
+ * symbol_db_engine_execute_query_select:
+ * @dbe: self
+ * @stmt: A compiled GdaStatement sql statement.
+ * @params: Params for GdaStatement (i.e. a prepared statement).
+ * 
+ * Executes a parameterized sql statement on a read only connection if 
+ * available, else on the main connection. This function can be called from
+ * any thread.
+ * 
+ * Returns: A data model which must be freed once used.
+ */
+GdaDataModel*
+symbol_db_engine_execute_query_select (SymbolDBEngine *dbe, GdaStatement *stmt,
+                                       GdaSet *params)
+{
+	SymbolDBEnginePriv *priv;
+	GAsyncQueue *queue;
+	GdaConnection *cnc;
+	GdaDataModel *res;
+	GError *error = NULL;
+
+	priv = dbe->priv;
+	g_mutex_lock (priv->read_connections_mutex);
+	queue = priv->read_connections;
+	if (queue == NULL)
+	{
+		g_mutex_unlock (priv->read_connections_mutex);
+		return symbol_db_engine_execute_select (dbe, stmt, params);
+	}
+
+	/* The connection is taken with the mutex held, so that 
+	 * sdb_engine_close_read_connections () waits for it. All rows are read
+	 * before giving it back. */
+	g_async_queue_ref (queue);
+	cnc = g_async_queue_pop (queue);
+	g_mutex_unlock (priv->read_connections_mutex);
+	res = gda_connection_statement_execute_select_full (cnc, stmt, params, 
+	                                                    GDA_STATEMENT_MODEL_RANDOM_ACCESS,
+	                                                    NULL, &error);
+	if (error)
+	{
+		gchar *sql_str =
+			gda_statement_to_sql_extended (stmt, cnc, params, 0, NULL, NULL);
+
+		g_warning ("SQL select exec failed: %s, %s", sql_str, error->message);
+		g_free (sql_str);
+		g_error_free (error);
+	}
+	g_async_queue_push (queue, cnc);
+	g_async_queue_unref (queue);
+
+	return res;
+}
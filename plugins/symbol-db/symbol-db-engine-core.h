@@ -153,6 +153,11 @@ gboolean
 symbol_db_engine_remove_file (SymbolDBEngine *dbe, const gchar *project,
                               const gchar* rel_file);
 
+gboolean
+symbol_db_engine_remove_project_other_versions (SymbolDBEngine *dbe, 
+                                                const gchar *project,
+                                                const gchar *version);
+
 void
 symbol_db_engine_remove_files (SymbolDBEngine * dbe, const gchar *project,
                                const GPtrArray *rel_files);
@@ -179,6 +184,19 @@ symbol_db_engine_set_db_case_sensitive (SymbolDBEngine *dbe, gboolean case_sensi
 GdaStatement*
 symbol_db_engine_get_statement (SymbolDBEngine *dbe, const gchar *sql_str);
 
+GdaStatement*
+symbol_db_engine_get_query_statement (SymbolDBEngine *dbe, const gchar *sql_str);
+
+void
+symbol_db_engine_get_query_statement_stats (SymbolDBEngine *dbe, guint *hits,
+                                            guint *misses);
+
+void
+symbol_db_engine_get_second_pass_stats (SymbolDBEngine *dbe,
+                                        gdouble *scope_stage,
+                                        gdouble *scope_resolve,
+                                        gdouble *heritage);
+
 const GHashTable*
 symbol_db_engine_get_type_conversion_hash (SymbolDBEngine *dbe);
 
@@ -190,6 +208,22 @@ GdaDataModel*
 symbol_db_engine_execute_select (SymbolDBEngine *dbe, GdaStatement *stmt,
                                  GdaSet *params);
 
+GdaDataModel*
+symbol_db_engine_execute_query_select (SymbolDBEngine *dbe, GdaStatement *stmt,
+                                       GdaSet *params);
+
+void
+symbol_db_engine_set_read_connections (SymbolDBEngine *dbe, guint count);
+
+void
+symbol_db_engine_set_wal_checkpoint (SymbolDBEngine *dbe, gint pages);
+
+void
+symbol_db_engine_set_signals_delay (SymbolDBEngine *dbe, guint delay);
+
+gboolean
+symbol_db_engine_has_read_connections (SymbolDBEngine *dbe);
+
 G_END_DECLS
 
 #endif /* _SYMBOL_DB_ENGINE_H_ */
@@ -51,6 +51,12 @@
 
 #define BATCH_SYMBOL_NUMBER				15000
 
+/* Maximum number of different query statements kept compiled */
+#define QUERY_STATEMENT_CACHE_MAX		128
+
+/* SQLite default size of the WAL file in pages triggering a checkpoint */
+#define WAL_DEFAULT_CHECKPOINT			1000
+
 #define SDB_QUERY_SEARCH_HEADER \
 	GValue v = {0}; \
 	SymbolDBQueryPriv *priv; \
@@ -137,6 +143,11 @@ typedef enum
 	PREP_QUERY_GET_REMOVED_IDS,
 	PREP_QUERY_TMP_REMOVED_DELETE_ALL,
 	PREP_QUERY_REMOVE_FILE_BY_PROJECT_NAME,
+	PREP_QUERY_REMOVE_FILES_BY_PROJECT_OTHER_VERSIONS,
+	PREP_QUERY_REMOVE_PROJECT_OTHER_VERSIONS,
+	PREP_QUERY_TMP_SCOPE_NEW,
+	PREP_QUERY_UPDATE_SYMBOL_SCOPE_ID_FROM_TMP,
+	PREP_QUERY_TMP_SCOPE_DELETE_ALL,
 	PREP_QUERY_COUNT
 		
 } static_query_type;
@@ -214,11 +225,35 @@ struct _SymbolDBEnginePriv
 	GHashTable *implementation_cache;
 	GHashTable *language_cache;
 
+	/* Milliseconds between two emissions of the queued signals */
+	guint trigger_signals_delay;
+
 	/* Table maps */
 	GQueue *tmp_heritage_tablemap;
+
+	/* Seconds spent in each phase of the second pass, summed over the
+	 * batches */
+	gdouble scope_stage_time;
+	gdouble scope_resolve_time;
+	gdouble heritage_time;
 	
 	static_query_node *static_query_list[PREP_QUERY_COUNT]; 
 
+	/* Compiled SymbolDBQuery statements by SQL string */
+	GMutex *query_stmts_mutex;
+	GHashTable *query_stmts;
+	guint query_stmts_hits;
+	guint query_stmts_misses;
+
+	/* Read only connections used by queries when the database is in WAL
+	 * mode, so they don't wait for the scanning */
+	guint read_connections_max;
+	gint wal_checkpoint;
+	gboolean case_sensitive;
+	GMutex *read_connections_mutex;
+	GAsyncQueue *read_connections;
+	GPtrArray *read_connection_list;
+
 #ifdef DEBUG
 	GTimer *first_scan_timer_DEBUG;
 #endif	
@@ -22,6 +22,8 @@
  * 	Boston, MA  02110-1301, USA.
  */
 
+#include <string.h>
+
 #include <libanjuta/anjuta-debug.h>
 
 #include <libanjuta/resources.h>
@@ -155,6 +157,83 @@ symbol_db_util_get_files_with_zero_symbols (SymbolDBEngine *dbe)
 	return files_to_scan;
 }
 
+/* Mime types of the sources usually found in system include directories. It
+ * avoids sniffing the content of each file, which is the slowest part when
+ * preparing a package scan. */
+static const struct {
+	const gchar *extension;
+	const gchar *mime_type;
+} mime_by_extension[] = {
+	{".h", "text/x-chdr"},
+	{".c", "text/x-csrc"},
+	{".hh", "text/x-c++hdr"},
+	{".hpp", "text/x-c++hdr"},
+	{".hxx", "text/x-c++hdr"},
+	{".h++", "text/x-c++hdr"},
+	{".cc", "text/x-c++src"},
+	{".cpp", "text/x-c++src"},
+	{".cxx", "text/x-c++src"},
+	{".c++", "text/x-c++src"},
+	{".java", "text/x-java"},
+	{".py", "text/x-python"},
+	{".cs", "text/x-csharp"},
+	{".vala", "text/x-vala"},
+	{".vapi", "text/x-vala"},
+	{".js", "application/javascript"},
+	{NULL, NULL}
+};
+
+const gchar *
+symbol_db_util_get_mime_type_from_extension (const gchar *file_path)
+{
+	const gchar *extension;
+	gint i;
+
+	g_return_val_if_fail (file_path != NULL, NULL);
+
+	extension = strrchr (file_path, '.');
+	if (extension == NULL || strchr (extension, G_DIR_SEPARATOR) != NULL)
+		return NULL;
+
+	for (i = 0; mime_by_extension[i].extension != NULL; i++)
+	{
+		if (strcmp (extension, mime_by_extension[i].extension) == 0)
+			return mime_by_extension[i].mime_type;
+	}
+
+	return NULL;
+}
+
+gchar *
+symbol_db_util_get_mime_type (const gchar *file_path)
+{
+	const gchar *mime_type;
+	GFile *gfile;
+	GFileInfo *gfile_info;
+	gchar *sniffed = NULL;
+
+	g_return_val_if_fail (file_path != NULL, NULL);
+
+	if ((mime_type = symbol_db_util_get_mime_type_from_extension (file_path)) != NULL)
+		return g_strdup (mime_type);
+
+	/* unknown extension, e.g. C++ standard headers: look at the content */
+	gfile = g_file_new_for_path (file_path);
+	gfile_info = g_file_query_info (gfile, 
+									G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE, 
+									G_FILE_QUERY_INFO_NONE,
+									NULL,
+									NULL);
+	if (gfile_info != NULL)
+	{
+		sniffed = g_strdup (g_file_info_get_content_type (gfile_info));
+		g_object_unref (gfile_info);
+	}
+	g_object_unref (gfile);
+
+	return sniffed;
+}
+
 #define CREATE_SYM_ICON(N, F) \
 	pix_file = anjuta_res_get_pixmap_file (F); \
 	g_hash_table_insert (pixbufs_hash, \
@@ -74,6 +74,22 @@ symbol_db_util_get_file_db_path (SymbolDBEngine *dbe, const gchar* full_local_fi
 GPtrArray *
 symbol_db_util_get_files_with_zero_symbols (SymbolDBEngine *dbe);
 
+/**
+ * @return The mime type of a source file guessed from its extension only, or
+ * NULL if the extension is unknown. The returned string must not be freed.
+ * This function doesn't access the disk and can be called from any thread.
+ */
+const gchar *
+symbol_db_util_get_mime_type_from_extension (const gchar *file_path);
+
+/**
+ * @return The mime type of a source file, guessed from its extension first
+ * and by sniffing its content as a fallback. NULL on error.
+ * User must care to free the returned string.
+ */
+gchar *
+symbol_db_util_get_mime_type (const gchar *file_path);
+
 /**
  * @return The pixbufs. It will initialize pixbufs first if they weren't before
  * @param node_access can be NULL.
@@ -221,6 +221,8 @@ sdb_model_file_set_property (GObject *object, guint prop_id,
 	switch (prop_id)
 	{
 	case PROP_SYMBOL_DB_FILE_PATH:
+		/* the page loader thread may be reading the file path */
+		symbol_db_model_cancel_loads (SYMBOL_DB_MODEL (object));
 		old_file_path = priv->file_path;
 		priv->file_path = g_value_dup_string (value);
 		if (g_strcmp0 (old_file_path, priv->file_path) != 0)
@@ -130,6 +130,21 @@ sdb_model_project_update_sql_stmt (SymbolDBModel *model)
 	priv->param_offset = gda_set_get_holder (priv->params, "offset");
 }
 
+static void
+sdb_model_project_clear_sql_stmt (SymbolDBModelProjectPriv *priv)
+{
+	if (priv->stmt)
+	{
+		g_object_unref (priv->stmt);
+		g_object_unref (priv->params);
+		priv->stmt = NULL;
+		priv->params = NULL;
+		priv->param_parent_id = NULL;
+		priv->param_limit = NULL;
+		priv->param_offset = NULL;
+	}
+}
+
 static GdaDataModel*
 sdb_model_project_get_children (SymbolDBModel *model, gint tree_level,
                                      GValue column_values[], gint offset,
@@ -331,6 +346,10 @@ on_sdb_project_dbe_unref (SymbolDBModelProject *model)
 
 	g_return_if_fail (SYMBOL_DB_IS_MODEL_PROJECT (model));
 	priv = SYMBOL_DB_MODEL_PROJECT (model)->priv;
+
+	/* the page loader thread may be using the engine and its statement */
+	symbol_db_model_cancel_loads (SYMBOL_DB_MODEL (model));
+	sdb_model_project_clear_sql_stmt (priv);
 	priv->dbe = NULL;
 	symbol_db_model_update (SYMBOL_DB_MODEL (model));
 }
@@ -347,6 +366,9 @@ sdb_model_project_set_property (GObject *object, guint prop_id,
 	switch (prop_id)
 	{
 	case PROP_SYMBOL_DB_ENGINE:
+		/* the page loader thread may be using the engine and its statement */
+		symbol_db_model_cancel_loads (SYMBOL_DB_MODEL (object));
+		sdb_model_project_clear_sql_stmt (priv);
 		if (priv->dbe)
 		{
 			g_object_weak_unref (G_OBJECT (priv->dbe),
@@ -435,11 +457,7 @@ sdb_model_project_finalize (GObject *object)
 		                  object);
 	}
 
-	if (priv->stmt)
-	{
-		g_object_unref (priv->stmt);
-		g_object_unref (priv->params);
-	}
+	sdb_model_project_clear_sql_stmt (priv);
 	
 	g_free (priv);
 	
@@ -172,6 +172,8 @@ sdb_model_search_set_property (GObject *object, guint prop_id,
 	switch (prop_id)
 	{
 	case PROP_SEARCH_PATTERN:
+		/* the page loader thread may be reading the pattern */
+		symbol_db_model_cancel_loads (SYMBOL_DB_MODEL (object));
 		old_pattern = priv->search_pattern;
 		priv->search_pattern = g_strdup_printf ("%%%s%%",
 		                                        g_value_get_string (value));
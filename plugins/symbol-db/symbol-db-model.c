@@ -29,6 +29,12 @@
 #define SYMBOL_DB_MODEL_PAGE_SIZE 50
 #define SYMBOL_DB_MODEL_ENSURE_CHILDREN_BATCH_SIZE 10
 
+/* Number of pages loaded ahead in the scroll direction */
+#define SYMBOL_DB_MODEL_PREFETCH_PAGES 2
+
+/* Maximum number of cached pages per node, far away pages are evicted */
+#define SYMBOL_DB_MODEL_MAX_PAGES 64
+
 typedef struct _SymbolDBModelPage SymbolDBModelPage;
 struct _SymbolDBModelPage
 {
@@ -38,6 +44,23 @@ struct _SymbolDBModelPage
 };
 
 typedef struct _SymbolDBModelNode SymbolDBModelNode;
+
+/* A range of children being fetched by the page loader thread. Only
+ * data_model and cancelled are accessed from the thread.
+ */
+typedef struct _SymbolDBModelLoad SymbolDBModelLoad;
+struct _SymbolDBModelLoad
+{
+	SymbolDBModel *model;
+	SymbolDBModelNode *node;	/* NULL when cancelled */
+	gint level;
+	gint n_columns;
+	GValue *values;		/* Copy of the node column values */
+	gint begin_offset, end_offset;
+	volatile gint cancelled;
+	GdaDataModel *data_model;
+};
+
 struct _SymbolDBModelNode {
 
 	gint n_columns;
@@ -50,6 +73,10 @@ struct _SymbolDBModelNode {
 
 	/* List of currently active (cached) pages */
 	SymbolDBModelPage *pages;
+	gint n_pages;
+
+	/* Pending loads of children pages */
+	GSList *loads;
 	
 	/* Data structure */
 	gint level;
@@ -77,6 +104,18 @@ struct _SymbolDBModelNode {
 	gint *query_columns; /* Corresponding GdaDataModel column */
 	
 	SymbolDBModelNode *root;
+
+	/* Page loader, running backend queries out of the main thread. All
+	 * calls to the backend are serialized with backend_mutex.
+	 */
+	GThreadPool *loader;
+	GMutex *backend_mutex;
+	GList *loads;
+
+	/* Last page fault, used to prefetch in the scroll direction */
+	SymbolDBModelNode *fault_node;
+	gint fault_offset;
+	gint fault_direction;
 };
 
 enum {
@@ -122,6 +161,9 @@ static void sdb_model_ensure_node_children (SymbolDBModel *model,
                                             gboolean emit_has_child,
                                             gboolean fake_child);
 
+static GtkTreePath *sdb_model_get_path (GtkTreeModel *tree_model,
+                                        GtkTreeIter *iter);
+
 /* Class definition */
 G_DEFINE_TYPE_WITH_CODE (SymbolDBModel, sdb_model, G_TYPE_OBJECT,
                          G_IMPLEMENT_INTERFACE (GTK_TYPE_TREE_MODEL,
@@ -176,6 +218,20 @@ sdb_model_node_set_child (SymbolDBModelNode *node, gint child_offset,
 	node->children[child_offset] = val;
 }
 
+/**
+ * sdb_model_load_cancel:
+ * @load: The pending load
+ *
+ * Detaches @load from its node. The loader thread skips the query if it has
+ * not run yet, and the result is dropped when it comes back.
+ */
+static void
+sdb_model_load_cancel (SymbolDBModelLoad *load)
+{
+	g_atomic_int_set (&load->cancelled, TRUE);
+	load->node = NULL;
+}
+
 /**
  * sdb_model_node_cleanse:
  * @node: The node to cleanse
@@ -202,6 +258,11 @@ sdb_model_node_cleanse (SymbolDBModelNode *node, gboolean force)
 	{
 		g_return_val_if_fail (node->children_ref_count == 0, FALSE);
 	}
+
+	/* Pending pages are not wanted anymore */
+	g_slist_foreach (node->loads, (GFunc) sdb_model_load_cancel, NULL);
+	g_slist_free (node->loads);
+	node->loads = NULL;
 	
 	if (node->children)
 	{
@@ -233,6 +294,7 @@ sdb_model_node_cleanse (SymbolDBModelNode *node, gboolean force)
 		page = next;
 	}
 	node->pages = NULL;
+	node->n_pages = 0;
 	node->children_ensured = FALSE;
 	node->n_children = 0;
 
@@ -269,11 +331,14 @@ sdb_model_node_free (SymbolDBModelNode *node, gboolean force)
  *
  * Removes the cache @page from the @node. The associated nodes are all
  * destroyed and set to NULL. They could be re-fetched later if needed.
+ * None of them should have referenced children.
  */
 static void
 sdb_model_node_remove_page (SymbolDBModelNode *node,
                             SymbolDBModelPage *page)
 {
+	gint i;
+
 	if (page->prev)
 		page->prev->next = page->next;
 	else
@@ -282,7 +347,18 @@ sdb_model_node_remove_page (SymbolDBModelNode *node,
 	if (page->next)
 		page->next->prev = page->prev;
 
-	/* FIXME: Destroy the page */
+	/* Destroy the page */
+	for (i = page->begin_offset; i < page->end_offset && i < node->n_children; i++)
+	{
+		SymbolDBModelNode *child = sdb_model_node_get_child (node, i);
+		if (child)
+		{
+			sdb_model_node_free (child, FALSE);
+			sdb_model_node_set_child (node, i, NULL);
+		}
+	}
+	node->n_pages--;
+	g_slice_free (SymbolDBModelPage, page);
 }
 
 /**
@@ -302,6 +378,7 @@ sdb_model_node_insert_page (SymbolDBModelNode *node,
 {
 	
 	/* Insert the new page after "after" page */
+	page->prev = after;
 	if (after)
 	{
 		page->next = after->next;
@@ -312,6 +389,9 @@ sdb_model_node_insert_page (SymbolDBModelNode *node,
 		page->next = node->pages;
 		node->pages = page;
 	}
+	if (page->next)
+		page->next->prev = page;
+	node->n_pages++;
 }
 
 /**
@@ -577,6 +657,398 @@ sdb_model_page_fault (SymbolDBModel *model,
 	return page;
 }
 
+/* Page loader */
+
+static void
+sdb_model_load_free (SymbolDBModelLoad *load)
+{
+	gint i;
+
+	if (load->values)
+	{
+		for (i = 0; i < load->n_columns; i++)
+			g_value_unset (&load->values[i]);
+		g_free (load->values);
+	}
+	if (load->data_model)
+		g_object_unref (load->data_model);
+	g_object_unref (load->model);
+	g_slice_free (SymbolDBModelLoad, load);
+}
+
+/**
+ * sdb_model_node_find_child_load:
+ * @node: The node
+ * @child_offset: Offset of the child node.
+ *
+ * Find a pending load covering child node of @node at @child_offset.
+ *
+ * Returns: The load, or NULL if @child_offset is not being loaded.
+ */
+static SymbolDBModelLoad*
+sdb_model_node_find_child_load (SymbolDBModelNode *node, gint child_offset)
+{
+	GSList *item;
+
+	for (item = node->loads; item != NULL; item = g_slist_next (item))
+	{
+		SymbolDBModelLoad *load = (SymbolDBModelLoad *)item->data;
+
+		if (child_offset >= load->begin_offset &&
+		    child_offset < load->end_offset)
+			return load;
+	}
+	return NULL;
+}
+
+/**
+ * sdb_model_page_is_evictable:
+ * @node: The node with the page
+ * @page: The cached page
+ *
+ * Returns: TRUE if none of the children in @page has referenced children.
+ */
+static gboolean
+sdb_model_page_is_evictable (SymbolDBModelNode *node, SymbolDBModelPage *page)
+{
+	gint i;
+
+	for (i = page->begin_offset; i < page->end_offset && i < node->n_children; i++)
+	{
+		SymbolDBModelNode *child = sdb_model_node_get_child (node, i);
+		if (child && child->children_ref_count > 0)
+			return FALSE;
+	}
+	return TRUE;
+}
+
+/**
+ * sdb_model_node_evict_pages:
+ * @node: The node
+ * @focus: Offset of the child currently viewed
+ *
+ * Removes the cached pages farthest from @focus until @node keeps at most
+ * SYMBOL_DB_MODEL_MAX_PAGES pages. Pages holding referenced children are
+ * kept.
+ */
+static void
+sdb_model_node_evict_pages (SymbolDBModelNode *node, gint focus)
+{
+	while (node->n_pages > SYMBOL_DB_MODEL_MAX_PAGES)
+	{
+		SymbolDBModelPage *page, *farthest = NULL;
+		gint max_distance = -1;
+
+		for (page = node->pages; page != NULL; page = page->next)
+		{
+			gint distance;
+
+			if (page->begin_offset > focus)
+				distance = page->begin_offset - focus;
+			else if (page->end_offset <= focus)
+				distance = focus - page->end_offset + 1;
+			else
+				distance = 0;
+
+			if (distance > max_distance &&
+			    sdb_model_page_is_evictable (node, page))
+			{
+				max_distance = distance;
+				farthest = page;
+			}
+		}
+		if (farthest == NULL)
+			break;
+		sdb_model_node_remove_page (node, farthest);
+	}
+}
+
+static void
+sdb_model_emit_row_changed (SymbolDBModel *model, SymbolDBModelNode *node,
+                            gint child_offset)
+{
+	GtkTreePath *path;
+	GtkTreeIter iter = {0};
+
+	iter.stamp = SYMBOL_DB_MODEL_STAMP;
+	iter.user_data = node;
+	iter.user_data2 = GINT_TO_POINTER (child_offset);
+
+	path = sdb_model_get_path (GTK_TREE_MODEL (model), &iter);
+	gtk_tree_model_row_changed (GTK_TREE_MODEL (model), path, &iter);
+	gtk_tree_path_free (path);
+}
+
+/**
+ * sdb_model_load_apply:
+ * @model: The model
+ * @load: A completed load
+ *
+ * Creates the children nodes fetched by @load in the main thread. Children
+ * already cached by a synchronous page fault in the meantime are kept, the
+ * new rows replace the placeholders in the view.
+ */
+static void
+sdb_model_load_apply (SymbolDBModel *model, SymbolDBModelLoad *load)
+{
+	SymbolDBModelPriv *priv = model->priv;
+	SymbolDBModelNode *node = load->node;
+	GdaDataModelIter *data_iter;
+	gint i, end;
+
+	end = MIN (load->end_offset,
+	           load->begin_offset + gda_data_model_get_n_rows (load->data_model));
+	end = MIN (end, (gint)node->n_children);
+
+	data_iter = gda_data_model_create_iter (load->data_model);
+	i = load->begin_offset;
+	while (i < end)
+	{
+		SymbolDBModelPage *page, *prev_page, *next_page;
+
+		page = sdb_model_node_find_child_page (node, i, &prev_page);
+		if (page)
+		{
+			i = page->end_offset;
+			continue;
+		}
+
+		/* New page up to the next cached one */
+		page = g_slice_new0 (SymbolDBModelPage);
+		next_page = prev_page ? prev_page->next : node->pages;
+		page->begin_offset = i;
+		page->end_offset = end;
+		if (next_page && next_page->begin_offset < end)
+			page->end_offset = next_page->begin_offset;
+		sdb_model_node_insert_page (node, page, prev_page);
+
+		for (; i < page->end_offset; i++)
+		{
+			SymbolDBModelNode *child;
+
+			if (!gda_data_model_iter_move_to_row (data_iter,
+			                                      i - load->begin_offset))
+			{
+				/* Fewer rows than expected, keep what we have */
+				page->end_offset = end = i;
+				break;
+			}
+			child = sdb_model_node_new (model, node, i, load->data_model,
+			                            data_iter);
+			sdb_model_node_set_child (node, i, child);
+			sdb_model_emit_row_changed (model, node, i);
+		}
+		if (page->begin_offset == page->end_offset)
+			sdb_model_node_remove_page (node, page);
+	}
+	g_object_unref (data_iter);
+
+	sdb_model_node_evict_pages (node, priv->fault_node == node ?
+	                            priv->fault_offset : load->begin_offset);
+}
+
+static gboolean
+on_sdb_model_load_done (SymbolDBModelLoad *load)
+{
+	SymbolDBModelPriv *priv = load->model->priv;
+
+	priv->loads = g_list_remove (priv->loads, load);
+	if (load->node)
+	{
+		load->node->loads = g_slist_remove (load->node->loads, load);
+		if (load->data_model && priv->freeze_count == 0)
+			sdb_model_load_apply (load->model, load);
+	}
+	sdb_model_load_free (load);
+
+	return FALSE;
+}
+
+/* Runs in the page loader thread. The cancelled flag is checked with
+ * backend_mutex held, so the query parameters of the derived model can't
+ * change once sdb_model_cancel_loads() has returned.
+ */
+static void
+sdb_model_load_thread (SymbolDBModelLoad *load, gpointer user_data)
+{
+	SymbolDBModel *model = load->model;
+
+	g_mutex_lock (model->priv->backend_mutex);
+	if (!g_atomic_int_get (&load->cancelled))
+	{
+		load->data_model = SYMBOL_DB_MODEL_GET_CLASS(model)->
+			get_children (model, load->level, load->values,
+			              load->begin_offset,
+			              load->end_offset - load->begin_offset);
+	}
+	g_mutex_unlock (model->priv->backend_mutex);
+	g_idle_add ((GSourceFunc) on_sdb_model_load_done, load);
+}
+
+/**
+ * sdb_model_schedule_load:
+ * @model: The model
+ * @node: The node which needs children data fetched
+ * @begin_offset: Offset of the first child
+ * @end_offset: Offset after the last child
+ *
+ * Queues a fetch of the children of @node in the given range for the page
+ * loader thread. The range is first trimmed of any cached or pending
+ * children at both ends.
+ */
+static void
+sdb_model_schedule_load (SymbolDBModel *model, SymbolDBModelNode *node,
+                         gint begin_offset, gint end_offset)
+{
+	SymbolDBModelPriv *priv = model->priv;
+	SymbolDBModelPage *page, *prev_page;
+	SymbolDBModelLoad *load;
+	gint i;
+
+	begin_offset = MAX (begin_offset, 0);
+	end_offset = MIN (end_offset, (gint)node->n_children);
+
+	while (begin_offset < end_offset)
+	{
+		page = sdb_model_node_find_child_page (node, begin_offset, &prev_page);
+		if (page)
+		{
+			begin_offset = page->end_offset;
+			continue;
+		}
+		load = sdb_model_node_find_child_load (node, begin_offset);
+		if (load)
+		{
+			begin_offset = load->end_offset;
+			continue;
+		}
+		break;
+	}
+	while (begin_offset < end_offset)
+	{
+		page = sdb_model_node_find_child_page (node, end_offset - 1, &prev_page);
+		if (page)
+		{
+			end_offset = page->begin_offset;
+			continue;
+		}
+		load = sdb_model_node_find_child_load (node, end_offset - 1);
+		if (load)
+		{
+			end_offset = load->begin_offset;
+			continue;
+		}
+		break;
+	}
+	if (begin_offset >= end_offset)
+		return;
+
+	load = g_slice_new0 (SymbolDBModelLoad);
+	load->model = g_object_ref (model);
+	load->node = node;
+	load->level = node->level;
+	load->begin_offset = begin_offset;
+	load->end_offset = end_offset;
+	if (node->values)
+	{
+		load->n_columns = node->n_columns;
+		load->values = g_new0 (GValue, node->n_columns);
+		for (i = 0; i < node->n_columns; i++)
+		{
+			g_value_init (&load->values[i], G_VALUE_TYPE (&node->values[i]));
+			g_value_copy (&node->values[i], &load->values[i]);
+		}
+	}
+
+	node->loads = g_slist_prepend (node->loads, load);
+	priv->loads = g_list_prepend (priv->loads, load);
+
+	if (priv->loader == NULL)
+	{
+		priv->loader =
+			g_thread_pool_new ((GFunc) sdb_model_load_thread, NULL,
+			                   1, FALSE, NULL);
+	}
+	g_thread_pool_push (priv->loader, load, NULL);
+}
+
+/**
+ * sdb_model_page_fault_async:
+ * @parent_node: The node which needs children data fetched
+ * @child_offset: Offset of the child where page fault occured
+ *
+ * Same as sdb_model_page_fault() but the page is fetched by the loader
+ * thread, the view displays empty rows until the data is available. The
+ * following pages in the scroll direction are fetched too.
+ */
+static void
+sdb_model_page_fault_async (SymbolDBModel *model,
+                            SymbolDBModelNode *parent_node,
+                            gint child_offset)
+{
+	SymbolDBModelPriv *priv;
+	gint direction = 0;
+	gint i;
+
+	/* If model is frozen, can't fetch data from backend */
+	priv = model->priv;
+	if (priv->freeze_count > 0)
+		return;
+
+	/* Guess scroll direction from the previous fault */
+	if (priv->fault_node == parent_node)
+	{
+		if (child_offset > priv->fault_offset)
+			direction = 1;
+		else if (child_offset < priv->fault_offset)
+			direction = -1;
+		else
+			direction = priv->fault_direction;
+	}
+	priv->fault_node = parent_node;
+	priv->fault_offset = child_offset;
+	priv->fault_direction = direction;
+
+	sdb_model_schedule_load (model, parent_node,
+	                         child_offset - SYMBOL_DB_MODEL_PAGE_SIZE,
+	                         child_offset + SYMBOL_DB_MODEL_PAGE_SIZE);
+
+	for (i = 1; direction != 0 && i <= SYMBOL_DB_MODEL_PREFETCH_PAGES; i++)
+	{
+		gint offset = child_offset + direction * 2 * i * SYMBOL_DB_MODEL_PAGE_SIZE;
+
+		sdb_model_schedule_load (model, parent_node,
+		                         offset - SYMBOL_DB_MODEL_PAGE_SIZE,
+		                         offset + SYMBOL_DB_MODEL_PAGE_SIZE);
+	}
+}
+
+/**
+ * sdb_model_cancel_loads:
+ * @model: The model
+ *
+ * Cancels all pending loads and waits for a running backend query to
+ * complete, so the backend is not accessed anymore when this returns.
+ */
+static void
+sdb_model_cancel_loads (SymbolDBModel *model)
+{
+	SymbolDBModelPriv *priv = model->priv;
+	GList *item;
+
+	for (item = priv->loads; item != NULL; item = g_list_next (item))
+	{
+		SymbolDBModelLoad *load = (SymbolDBModelLoad *)item->data;
+
+		if (load->node)
+			load->node->loads = g_slist_remove (load->node->loads, load);
+		sdb_model_load_cancel (load);
+	}
+
+	g_mutex_lock (priv->backend_mutex);
+	g_mutex_unlock (priv->backend_mutex);
+}
+
 /* GtkTreeModel implementation */
 
 static GtkTreeModelFlags
@@ -694,7 +1166,6 @@ sdb_model_get_value (GtkTreeModel *tree_model,
 {
 	SymbolDBModelPriv *priv;
 	SymbolDBModelNode *parent_node, *node;
-	SymbolDBModelPage *page;
 	gint offset;
 	
 	g_return_if_fail (sdb_model_iter_is_valid (tree_model, iter));
@@ -708,11 +1179,12 @@ sdb_model_get_value (GtkTreeModel *tree_model,
 	offset = GPOINTER_TO_INT (iter->user_data2);
 
 	if (sdb_model_node_get_child (parent_node, offset) == NULL)
-		page = sdb_model_page_fault (SYMBOL_DB_MODEL (tree_model),
-		                             parent_node, offset);
+		sdb_model_page_fault_async (SYMBOL_DB_MODEL (tree_model),
+		                            parent_node, offset);
 	node = sdb_model_node_get_child (parent_node, offset);
 	g_value_init (value, priv->column_types[column]);
 
+	/* Keep an empty placeholder until the page is loaded */
 	if (node == NULL)
 		return;
 	
@@ -1218,10 +1690,12 @@ sdb_model_get_has_child (SymbolDBModel *model, SymbolDBModelNode *node)
 		return node->has_child;
 	
 	node->has_child_ensured = TRUE;
+	g_mutex_lock (model->priv->backend_mutex);
 	node->has_child =
 		SYMBOL_DB_MODEL_GET_CLASS(model)->get_has_child (model,
 		                                                 node->level,
 		                                                 node->values);
+	g_mutex_unlock (model->priv->backend_mutex);
 	if (node->has_child)
 	{
 		sdb_model_emit_has_child (model, node);
@@ -1253,8 +1727,14 @@ static gint
 sdb_model_get_n_children (SymbolDBModel *model, gint tree_level,
                           GValue column_values[])
 {
-	return SYMBOL_DB_MODEL_GET_CLASS(model)->get_n_children (model, tree_level,
-	                                                         column_values);
+	gint n_children;
+
+	g_mutex_lock (model->priv->backend_mutex);
+	n_children =
+		SYMBOL_DB_MODEL_GET_CLASS(model)->get_n_children (model, tree_level,
+		                                                  column_values);
+	g_mutex_unlock (model->priv->backend_mutex);
+	return n_children;
 }
 
 /**
@@ -1282,13 +1762,19 @@ sdb_model_get_children_real (SymbolDBModel *model, gint tree_level,
 	return data_model;
 }
 
+/* Called from the main thread, the loader thread calls get_children () itself */
 static GdaDataModel*
 sdb_model_get_children (SymbolDBModel *model, gint tree_level,
                         GValue column_values[], gint offset,
                         gint limit)
 {
-	return SYMBOL_DB_MODEL_GET_CLASS(model)->
+	GdaDataModel *data_model;
+
+	g_mutex_lock (model->priv->backend_mutex);
+	data_model = SYMBOL_DB_MODEL_GET_CLASS(model)->
 		get_children (model, tree_level, column_values, offset, limit);
+	g_mutex_unlock (model->priv->backend_mutex);
+	return data_model;
 }
 
 /* Object implementation */
@@ -1299,6 +1785,12 @@ sdb_model_finalize (GObject *object)
 	SymbolDBModelPriv *priv;
 
 	priv = SYMBOL_DB_MODEL (object)->priv;;
+
+	/* Pending loads keep a reference on the model, so none is left here */
+	if (priv->loader)
+		g_thread_pool_free (priv->loader, TRUE, TRUE);
+	g_mutex_free (priv->backend_mutex);
+
 	g_free (priv->column_types);
 	g_free (priv->query_columns);
 	sdb_model_node_cleanse (priv->root, TRUE);
@@ -1348,6 +1840,7 @@ sdb_model_init (SymbolDBModel *object)
 	priv->n_columns = 0;
 	priv->column_types = NULL;
 	priv->query_columns = NULL;
+	priv->backend_mutex = g_mutex_new ();
 }
 
 static void
@@ -1471,9 +1964,25 @@ symbol_db_model_update (SymbolDBModel *model)
 
 	priv = model->priv;
 
+	priv->fault_node = NULL;
 	sdb_model_update_node_children (model, priv->root, FALSE);
 }
 
+/**
+ * symbol_db_model_cancel_loads:
+ * @model: The model
+ *
+ * Cancels the pages being loaded in the background. Derived models call it
+ * before changing the parameters read by their get_children() implementation.
+ */
+void
+symbol_db_model_cancel_loads (SymbolDBModel *model)
+{
+	g_return_if_fail (SYMBOL_DB_IS_MODEL (model));
+
+	sdb_model_cancel_loads (model);
+}
+
 void
 symbol_db_model_freeze (SymbolDBModel *model)
 {
@@ -1483,6 +1992,10 @@ symbol_db_model_freeze (SymbolDBModel *model)
 	
 	priv = model->priv;
 	priv->freeze_count++;
+
+	/* The backend is going to be busy, stop loading pages */
+	if (priv->freeze_count == 1)
+		sdb_model_cancel_loads (model);
 }
 
 void
@@ -52,7 +52,9 @@ struct _SymbolDBModelClass
 	                                GdaDataModel *data_model, gint position,
 	                                gint column, GValue *value);
 
-	/* Pure virtual methods; alternatives to signals */
+	/* Pure virtual methods; alternatives to signals. get_children can be
+	 * called from the page loader thread, calls to these methods are never
+	 * run concurrently. */
 	
 	gboolean (*get_has_child) (SymbolDBModel *model, gint tree_level,
 	                           GValue column_values[]);
@@ -88,6 +90,7 @@ void symbol_db_model_set_columns (SymbolDBModel *model, gint n_columns,
                                   GType *types, gint *data_cols);
 
 void symbol_db_model_update (SymbolDBModel *model);
+void symbol_db_model_cancel_loads (SymbolDBModel *model);
 void symbol_db_model_freeze (SymbolDBModel *model);
 void symbol_db_model_thaw (SymbolDBModel *model);
 
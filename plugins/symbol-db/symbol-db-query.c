@@ -494,7 +494,8 @@ sdb_query_update (SymbolDBQuery *query)
 	 * otherwise compile it now.
 	 */
 	if (symbol_db_engine_is_connected (priv->dbe_selected))
-		priv->stmt = symbol_db_engine_get_statement (priv->dbe_selected, sql->str);
+		priv->stmt = symbol_db_engine_get_query_statement (priv->dbe_selected,
+		                                                   sql->str);
 	else
 		priv->stmt = NULL;
 	g_string_free (sql, FALSE);
@@ -522,17 +523,18 @@ sdb_query_execute_real (SymbolDBQuery *query)
 		g_warning ("Attempt to make a query when database is not connected");
 		return GINT_TO_POINTER (-1);
 	}
-	if (symbol_db_engine_is_scanning (priv->dbe_selected))
+	if (symbol_db_engine_is_scanning (priv->dbe_selected) &&
+	    !symbol_db_engine_has_read_connections (priv->dbe_selected))
 		return GINT_TO_POINTER (-1);
 	
 	if (!priv->sql_stmt)
 		sdb_query_update (query);
 	else if (!priv->stmt)
-		priv->stmt = symbol_db_engine_get_statement (priv->dbe_selected,
-		                                             priv->sql_stmt);
-	data_model = symbol_db_engine_execute_select (priv->dbe_selected,
-	                                              priv->stmt,
-	                                              priv->params);
+		priv->stmt = symbol_db_engine_get_query_statement (priv->dbe_selected,
+		                                                   priv->sql_stmt);
+	data_model = symbol_db_engine_execute_query_select (priv->dbe_selected,
+	                                                    priv->stmt,
+	                                                    priv->params);
 	
 	if (!data_model) return GINT_TO_POINTER (-1);
 	return symbol_db_query_result_new (data_model, 
@@ -643,8 +645,8 @@ on_sdb_query_dbe_connected (SymbolDBEngine *dbe, SymbolDBQuery *query)
 	if (!query->priv->stmt && query->priv->sql_stmt)
 	{
 		query->priv->stmt =
-			symbol_db_engine_get_statement (query->priv->dbe_selected,
-			                                query->priv->sql_stmt);
+			symbol_db_engine_get_query_statement (query->priv->dbe_selected,
+			                                      query->priv->sql_stmt);
 	}
 }
 
@@ -662,7 +664,8 @@ on_sdb_query_dbe_scan_end (SymbolDBEngine *dbe, gint something,
 	
 	if (query->priv->mode == IANJUTA_SYMBOL_QUERY_MODE_QUEUED &&
 	    query->priv->query_queued &&
-	    !symbol_db_engine_is_scanning (query->priv->dbe_selected))
+	    (!symbol_db_engine_is_scanning (query->priv->dbe_selected) ||
+	     symbol_db_engine_has_read_connections (query->priv->dbe_selected)))
 	{
 		sdb_query_handle_result (query, sdb_query_execute_real (query));
 		query->priv->query_queued = FALSE;
@@ -676,9 +679,9 @@ on_sdb_query_dbe_scan_end (SymbolDBEngine *dbe, gint something,
  * Executes the query. If the query is in sync mode, the query is executed
  * immediately. If the query is in async mode, an async command is started
  * and pending async count increased. If the query is in queued mode, the
- * query is executed immediately if the DB is not busy scanning, otherwise,
- * it is defered until the DB is done scanning (at which point "async-result"
- * will be emitted).
+ * query is executed immediately if the DB is not busy scanning or has read
+ * only connections, otherwise, it is defered until the DB is done scanning
+ * (at which point "async-result" will be emitted).
  *
  * Returns: The resultset iterator for sync or successful queued queries,
  * otherwise returns NULL for async or unsuccessful queued queries (their
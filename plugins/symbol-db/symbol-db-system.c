@@ -24,6 +24,7 @@
 
 
 #include "symbol-db-system.h"
+#include "symbol-db-engine-utils.h"
 #include "plugin.h"
 
 #include <glib.h>
@@ -33,6 +34,13 @@
 #include <libanjuta/interfaces/ianjuta-language.h>
 #include <string.h>
 
+/* Number of threads listing and classifying the files of queued packages */
+#define PREPARE_THREADS_MAX			4
+#define PREPARE_POLL_INTERVAL		50
+
+/* Used when pkg-config doesn't give a version for the package */
+#define SYSTEM_PACKAGE_DEFAULT_VERSION	"1.0"
+
 struct _SymbolDBSystemPriv
 {
 	AnjutaLauncher  *single_package_scan_launcher;
@@ -41,12 +49,25 @@ struct _SymbolDBSystemPriv
 	
 	GQueue *sscan_queue;
 	GQueue *engine_queue;
+
+	/* The files of the packages waiting in engine_queue are listed by the
+	 * prepare_pool threads while the engine scans the head of the queue.
+	 * Prepared packages come back through prepared_queue.
+	 */
+	GThreadPool *prepare_pool;
+	GAsyncQueue *prepared_queue;
+	guint prepare_poll_id;
+	gint preparing;
+
+	/* mime type -> language name, NULL if the language is not supported */
+	GHashTable *languages;
 }; 
 
 typedef struct _SingleScanData {
 	SymbolDBSystem *sdbs;
 	gchar *package_name;
 	gchar *contents;
+	GList *cflags;
 	gboolean engine_scan;
 
 	PackageParseableCallback parseable_cb;
@@ -57,10 +78,13 @@ typedef struct _SingleScanData {
 typedef struct _EngineScanData {
 	SymbolDBSystem *sdbs;
 	gchar *package_name;	
+	gchar *package_version;
 	GList *cflags;
 	gboolean special_abort_scan;
+	gboolean prepared;
 	GPtrArray *files_to_scan_array;		
 	GPtrArray *languages_array;			
+	GPtrArray *mime_types_array;
 	
 } EngineScanData;
 
@@ -82,9 +106,34 @@ on_pkg_config_exit (AnjutaLauncher * launcher, int child_pid,
 				   int exit_status, gulong time_taken_in_seconds,
 				   gpointer user_data);
 
+static void
+on_pkg_config_version_exit (AnjutaLauncher * launcher, int child_pid,
+							int exit_status, gulong time_taken_in_seconds,
+							gpointer user_data);
+
+static void
+sdb_system_prepare_files_thread (EngineScanData *es_data, SymbolDBSystem *sdbs);
+
 static void
 on_engine_package_scan_end (SymbolDBEngine *dbe, gint process_id, gpointer user_data);
 
+static void
+free_strings_array (GPtrArray *array)
+{
+	if (array == NULL)
+		return;
+	
+	g_ptr_array_foreach (array, (GFunc)g_free, NULL);
+	g_ptr_array_free (array, TRUE);
+}
+
+static void
+free_cflags (GList *cflags)
+{
+	g_list_foreach (cflags, (GFunc)g_free, NULL);
+	g_list_free (cflags);
+}
+
 static void
 destroy_single_scan_data (SingleScanData *ss_data)
 {
@@ -92,6 +141,7 @@ destroy_single_scan_data (SingleScanData *ss_data)
 	
 	g_free (ss_data->package_name);
 	g_free (ss_data->contents);
+	free_cflags (ss_data->cflags);
 	
 	g_free (ss_data);
 }
@@ -99,22 +149,15 @@ destroy_single_scan_data (SingleScanData *ss_data)
 static void
 destroy_engine_scan_data (EngineScanData *es_data)
 {
-	if (es_data->cflags)
-	{
-		g_list_foreach (es_data->cflags, (GFunc)g_free, NULL);
-		g_list_free (es_data->cflags);
-	}
+	free_cflags (es_data->cflags);
 	
 	g_free (es_data->package_name);
+	g_free (es_data->package_version);
 	
-	if (es_data->special_abort_scan == TRUE)
-	{
-		g_ptr_array_foreach (es_data->files_to_scan_array, (GFunc)g_free, NULL);
-		g_ptr_array_free (es_data->files_to_scan_array, TRUE);
-			
-		g_ptr_array_foreach (es_data->languages_array, (GFunc)g_free, NULL);
-		g_ptr_array_free (es_data->languages_array, TRUE);
-	}
+	free_strings_array (es_data->files_to_scan_array);
+	free_strings_array (es_data->languages_array);
+	free_strings_array (es_data->mime_types_array);
+
 	g_free (es_data);
 }
 
@@ -144,7 +187,14 @@ sdb_system_init (SymbolDBSystem *object)
 	/* single scan launcher's queue */
 	sdbs->priv->sscan_queue = g_queue_new ();		
 	sdbs->priv->engine_queue = g_queue_new ();
-	
+
+	/* files of the queued packages are listed in parallel */
+	sdbs->priv->prepare_pool = 
+		g_thread_pool_new ((GFunc) sdb_system_prepare_files_thread, sdbs,
+						   PREPARE_THREADS_MAX, FALSE, NULL);
+	sdbs->priv->prepared_queue = g_async_queue_new ();
+	sdbs->priv->languages = g_hash_table_new_full (g_str_hash, g_str_equal,
+												   g_free, g_free);
 }
 
 static void
@@ -175,8 +225,22 @@ sdb_system_finalize (GObject *object)
 		priv->single_package_scan_launcher = NULL;		
 	}
 
+	/* drop the packages not yet prepared and wait for the running threads.
+	 * The prepared ones are still in engine_queue, freed below. */
+	g_thread_pool_free (priv->prepare_pool, TRUE, TRUE);
+	priv->prepare_pool = NULL;
+	if (priv->prepare_poll_id != 0)
+	{
+		g_source_remove (priv->prepare_poll_id);
+		priv->prepare_poll_id = 0;
+	}
+	g_async_queue_unref (priv->prepared_queue);
+	priv->prepared_queue = NULL;
+	g_hash_table_destroy (priv->languages);
+	priv->languages = NULL;
+
 	/* free also the queue */
-	g_queue_foreach (priv->sscan_queue, (GFunc)g_free, NULL);
+	g_queue_foreach (priv->sscan_queue, (GFunc)destroy_single_scan_data, NULL);
 	g_queue_free (priv->sscan_queue);
 	priv->sscan_queue = NULL;	
 	
@@ -380,16 +444,15 @@ sdb_system_files_visit_dir (GList **files_list, GFile *file)
 	return files_list;
 }
 
+/**
+ * List the files under the cflags directories.
+ */
 static void
-prepare_files_to_be_scanned (SymbolDBSystem *sdbs,
-							 GList *cflags, 
-							 GPtrArray *OUT_files_to_scan_array, 
-							 GPtrArray *OUT_languages_array)
+prepare_files_to_be_scanned (GList *cflags, 
+							 GPtrArray *OUT_files_array)
 {
-	SymbolDBSystemPriv *priv;
 	GList *node;
 	
-	priv = sdbs->priv;	
 	node = cflags;	
 	
 	do 
@@ -412,32 +475,10 @@ prepare_files_to_be_scanned (SymbolDBSystem *sdbs,
 			GList *tmp_node;
 			tmp_node = files_tmp_list;
 			do {
-				GFileInfo *info;
+				gchar *file_path;
 				
-				if ((info = g_file_query_info ((GFile *)tmp_node->data, G_FILE_ATTRIBUTE_STANDARD_CONTENT_TYPE,
-											  G_FILE_QUERY_INFO_NONE, NULL, NULL)))
-				{
-					IAnjutaLanguageId lang_id;
-					const char *lang;
-					
-					lang_id = ianjuta_language_get_from_mime_type (priv->lang_manager,
-																   g_file_info_get_content_type (info), 
-																   NULL);
-					
-					g_object_unref (info);
-					
-					/* No supported language... */
-					if (!lang_id)
-					{
-						continue;
-					}
-					
-					lang = ianjuta_language_get_name (priv->lang_manager, lang_id, NULL);				
-					
-					g_ptr_array_add (OUT_languages_array, g_strdup (lang));				
-					g_ptr_array_add (OUT_files_to_scan_array, 
-									 g_file_get_path ((GFile *)tmp_node->data));
-				}
+				if ((file_path = g_file_get_path ((GFile *)tmp_node->data)) != NULL)
+					g_ptr_array_add (OUT_files_array, file_path);
 			} while ((tmp_node = tmp_node->next) != NULL);		
 			
 			/* free the tmp files list */
@@ -447,21 +488,149 @@ prepare_files_to_be_scanned (SymbolDBSystem *sdbs,
 	} while ((node = node->next) != NULL);
 }
 
+/**
+ * Move the files of files_array having a known mime type to 
+ * OUT_files_to_scan_array, the others are freed. The mime type is guessed from
+ * the extension and the content is sniffed only for unknown extensions. It 
+ * doesn't use the language manager, so that it can run in the prepare threads.
+ */
+static void
+classify_files_to_be_scanned (GPtrArray *files_array,
+							  GPtrArray *OUT_files_to_scan_array, 
+							  GPtrArray *OUT_mime_types_array)
+{
+	gint i;
+	
+	for (i = 0; i < files_array->len; i++)
+	{
+		gchar *file_path;
+		gchar *mime_type;
+		
+		file_path = g_ptr_array_index (files_array, i);
+		if ((mime_type = symbol_db_util_get_mime_type (file_path)) == NULL)
+		{
+			g_free (file_path);
+			continue;
+		}
+		
+		g_ptr_array_add (OUT_mime_types_array, mime_type);
+		g_ptr_array_add (OUT_files_to_scan_array, file_path);
+	}
+}
+
+static void
+sdb_system_prepare_files_thread (EngineScanData *es_data, SymbolDBSystem *sdbs)
+{
+	GPtrArray *files_array;
+	
+	/* packages added with their list of files don't need to visit the 
+	 * cflags directories */
+	if (es_data->files_to_scan_array != NULL)
+	{
+		files_array = es_data->files_to_scan_array;
+	}
+	else
+	{
+		files_array = g_ptr_array_new ();
+		prepare_files_to_be_scanned (es_data->cflags, files_array);
+	}
+	
+	es_data->files_to_scan_array = g_ptr_array_new ();
+	es_data->mime_types_array = g_ptr_array_new ();
+
+	classify_files_to_be_scanned (files_array, es_data->files_to_scan_array,
+								  es_data->mime_types_array);
+	/* file paths have been moved or freed already */
+	g_ptr_array_free (files_array, TRUE);
+
+	g_async_queue_push (sdbs->priv->prepared_queue, es_data);
+}
+
+/**
+ * @return The language name for mime_type or NULL if not supported. The 
+ * languages manager is queried once per mime type.
+ */
+static const gchar *
+sdb_system_get_language (SymbolDBSystem *sdbs, const gchar *mime_type)
+{
+	SymbolDBSystemPriv *priv;
+	gpointer lang;
+	
+	priv = sdbs->priv;
+	
+	if (g_hash_table_lookup_extended (priv->languages, mime_type, NULL, &lang) == FALSE)
+	{
+		IAnjutaLanguageId lang_id;
+		
+		lang_id = ianjuta_language_get_from_mime_type (priv->lang_manager,
+													   mime_type, NULL);
+		lang = lang_id ? 
+			g_strdup (ianjuta_language_get_name (priv->lang_manager, lang_id, NULL)) :
+			NULL;
+		g_hash_table_insert (priv->languages, g_strdup (mime_type), lang);
+	}
+	
+	return lang;
+}
+
+/**
+ * Replace the mime types of a prepared package by the language names, dropping
+ * the files of unsupported languages. Must be called in the main thread.
+ */
+static void
+sdb_system_set_languages (SymbolDBSystem *sdbs, EngineScanData *es_data)
+{
+	GPtrArray *files_to_scan_array;
+	GPtrArray *languages_array;
+	gint i;
+	
+	files_to_scan_array = g_ptr_array_new ();
+	languages_array = g_ptr_array_new ();
+	
+	for (i = 0; i < es_data->files_to_scan_array->len; i++)
+	{
+		gchar *file_path;
+		const gchar *lang;
+		
+		file_path = g_ptr_array_index (es_data->files_to_scan_array, i);
+		lang = sdb_system_get_language (sdbs, 
+							g_ptr_array_index (es_data->mime_types_array, i));
+		
+		/* No supported language... */
+		if (lang == NULL)
+		{
+			g_free (file_path);
+			continue;
+		}
+		
+		g_ptr_array_add (files_to_scan_array, file_path);
+		g_ptr_array_add (languages_array, g_strdup (lang));
+	}
+	
+	/* file paths have been moved or freed already */
+	g_ptr_array_free (es_data->files_to_scan_array, TRUE);
+	free_strings_array (es_data->mime_types_array);
+	es_data->mime_types_array = NULL;
+	
+	es_data->files_to_scan_array = files_to_scan_array;
+	es_data->languages_array = languages_array;
+}
+
 static GNUC_INLINE void 
-sdb_system_do_scan_package_1 (SymbolDBSystem *sdbs,							
-							SingleScanData *ss_data)
+sdb_system_run_pkg_config (SymbolDBSystem *sdbs,
+						   SingleScanData *ss_data,
+						   const gchar *option,
+						   GCallback exit_cb)
 {
 	SymbolDBSystemPriv *priv;
 	gchar *exe_string;
 	priv = sdbs->priv;
 	
-	DEBUG_PRINT ("SCANNING %s", 
-				 ss_data->package_name);
-	exe_string = g_strdup_printf ("pkg-config --cflags %s", 
+	exe_string = g_strdup_printf ("pkg-config %s %s", option,
 								  ss_data->package_name);
 	
 	g_signal_connect (G_OBJECT (priv->single_package_scan_launcher), 
-					  "child-exited", G_CALLBACK (on_pkg_config_exit), ss_data);	
+					  "child-exited", exit_cb, ss_data);	
 	
 	anjuta_launcher_execute (priv->single_package_scan_launcher,
 							 	exe_string, on_pkg_config_output, 
@@ -469,6 +638,16 @@ sdb_system_do_scan_package_1 (SymbolDBSystem *sdbs,
 	g_free (exe_string);	
 }
 
+static GNUC_INLINE void 
+sdb_system_do_scan_package_1 (SymbolDBSystem *sdbs,							
+							SingleScanData *ss_data)
+{
+	DEBUG_PRINT ("SCANNING %s", 
+				 ss_data->package_name);
+	sdb_system_run_pkg_config (sdbs, ss_data, "--cflags", 
+							   G_CALLBACK (on_pkg_config_exit));
+}
+
 /**
  * Scan the next package in queue, if exists.
  */
@@ -492,46 +671,51 @@ static GNUC_INLINE void
 sdb_system_do_engine_scan (SymbolDBSystem *sdbs, EngineScanData *es_data)
 {
 	SymbolDBSystemPriv *priv;
-	GPtrArray *files_to_scan_array; 
-	GPtrArray *languages_array;
 	gint proc_id;
-	gboolean special_abort_scan; 
 	
 	priv = sdbs->priv;
-	special_abort_scan = es_data->special_abort_scan ;
 
-	if (special_abort_scan == FALSE)
+	if (es_data->prepared == FALSE)
 	{
-		files_to_scan_array = g_ptr_array_new ();
-		languages_array = g_ptr_array_new();
-		
-		/* the above arrays will be populated with this function */
-		prepare_files_to_be_scanned (sdbs, es_data->cflags, files_to_scan_array,
-								 languages_array);
-		
-		symbol_db_engine_add_new_project (priv->sdbe_globals, NULL,
-								  		es_data->package_name, "1.0");
+		/* on_prepare_poll () will start it when its files are listed */
+		DEBUG_PRINT ("waiting for the files of %s", es_data->package_name);
+		return;
 	}
-	else 
+
+	if (es_data->special_abort_scan == FALSE)
 	{
-		files_to_scan_array = es_data->files_to_scan_array;
-		languages_array = es_data->languages_array;
+		/* a file belongs to one project only: the headers of an older version
+		 * of the package must go away, otherwise they wouldn't be scanned
+		 * again for the new one.
+		 */
+		symbol_db_engine_remove_project_other_versions (priv->sdbe_globals,
+										es_data->package_name,
+										es_data->package_version);
+		symbol_db_engine_add_new_project (priv->sdbe_globals, NULL,
+								  		es_data->package_name, 
+										es_data->package_version);
 	}
-	
 			
 	/* note the FALSE as last parameter: we don't want
 	 * to re-scan an already present file. There's the possibility
 	 * infact to have more references of the same files in different
 	 * packages
 	 */
-	proc_id = symbol_db_engine_add_new_files_full_async (priv->sdbe_globals,
+	if (es_data->files_to_scan_array->len > 0)
+	{
+		proc_id = symbol_db_engine_add_new_files_full_async (priv->sdbe_globals,
 							es_data->special_abort_scan == FALSE ? 
 									es_data->package_name : NULL, 
-	    					"1.0",
-							files_to_scan_array,
-							languages_array,
+	    					es_data->package_version,
+							es_data->files_to_scan_array,
+							es_data->languages_array,
 							es_data->special_abort_scan == FALSE ? 
 									FALSE : TRUE);
+	}
+	else
+	{
+		proc_id = -1;
+	}
 		
 	if (proc_id > 0)
 	{
@@ -543,7 +727,7 @@ sdb_system_do_engine_scan (SymbolDBSystem *sdbs, EngineScanData *es_data)
 	 	* to the db 
 	 	*/
 		g_signal_emit (sdbs, signals[SCAN_PACKAGE_START], 0, 
-					   files_to_scan_array->len,
+					   es_data->files_to_scan_array->len,
 					   es_data->package_name); 
 	}
 	/* if no scan has started destroy the engine data here */
@@ -567,16 +751,100 @@ sdb_system_do_engine_scan (SymbolDBSystem *sdbs, EngineScanData *es_data)
 			sdb_system_do_engine_scan (sdbs, es_data);
 		}
 	}	
+}
 
-	if (special_abort_scan == FALSE)
+static gboolean
+on_prepare_poll (SymbolDBSystem *sdbs)
+{
+	SymbolDBSystemPriv *priv;
+	EngineScanData *es_data;
+	
+	priv = sdbs->priv;
+	
+	while ((es_data = g_async_queue_try_pop (priv->prepared_queue)) != NULL)
 	{
-		DEBUG_PRINT ("special_abort_scan");
-		g_ptr_array_foreach (files_to_scan_array, (GFunc)g_free, NULL);
-		g_ptr_array_free (files_to_scan_array, TRUE);
-			
-		g_ptr_array_foreach (languages_array, (GFunc)g_free, NULL);
-		g_ptr_array_free (languages_array, TRUE);
+		priv->preparing--;
+		sdb_system_set_languages (sdbs, es_data);
+		es_data->prepared = TRUE;
+		
+		/* the engine is waiting for this package */
+		if (es_data == g_queue_peek_head (priv->engine_queue))
+		{
+			DEBUG_PRINT ("adding %s", es_data->package_name);
+			sdb_system_do_engine_scan (sdbs, es_data);
+		}
 	}
+	
+	if (priv->preparing > 0)
+		return TRUE;
+	
+	priv->prepare_poll_id = 0;
+	return FALSE;
+}
+
+/**
+ * Append es_data to the engine queue. Package files are listed in a thread
+ * while the engine is busy with the previous packages.
+ */
+static void
+sdb_system_queue_engine_scan (SymbolDBSystem *sdbs, EngineScanData *es_data)
+{
+	SymbolDBSystemPriv *priv;
+	priv = sdbs->priv;
+	
+	if (es_data->prepared == FALSE)
+	{
+		priv->preparing++;
+		g_thread_pool_push (priv->prepare_pool, es_data, NULL);
+		if (priv->prepare_poll_id == 0)
+		{
+			priv->prepare_poll_id = 
+				g_timeout_add (PREPARE_POLL_INTERVAL, 
+							   (GSourceFunc) on_prepare_poll, sdbs);
+		}
+	}
+	
+	/* is the engine queue already full && working? */
+	if (g_queue_get_length (priv->engine_queue) > 0) 
+	{
+		/* just push the tail waiting for a later processing [i.e. after
+		 * a scan-end received 
+		 */
+		DEBUG_PRINT ("pushing on engine queue [length %d] %s", 
+					 g_queue_get_length (priv->engine_queue),
+					 es_data->package_name);
+		g_queue_push_tail (priv->engine_queue, es_data);
+	}
+	else
+	{
+		/* push the tail to signal a 'working engine' */
+		DEBUG_PRINT ("scanning with engine queue [length %d] %s", 
+					 g_queue_get_length (priv->engine_queue),
+					 es_data->package_name);
+		
+		g_queue_push_tail (priv->engine_queue, es_data);
+		
+		sdb_system_do_engine_scan (sdbs, es_data);
+	}
+}
+
+static gboolean
+sdb_system_is_package_queued (SymbolDBSystem *sdbs,
+							  const gchar *package_name,
+							  const gchar *package_version)
+{
+	GList *node;
+	
+	for (node = sdbs->priv->engine_queue->head; node != NULL; node = node->next)
+	{
+		EngineScanData *es_data = (EngineScanData *)node->data;
+		
+		if (g_strcmp0 (es_data->package_name, package_name) == 0 &&
+			g_strcmp0 (es_data->package_version, package_version) == 0)
+			return TRUE;
+	}
+	
+	return FALSE;
 }
 
 static void
@@ -675,37 +943,112 @@ on_pkg_config_exit (AnjutaLauncher * launcher, int child_pid,
 
 	/* no callback to call. Just parse the package on */
 	if (ss_data->engine_scan == TRUE && cflags != NULL)
+	{
+		/* packages are stored once per version on globals db: ask for the 
+		 * version before deciding if the package needs a scan. ss_data stays
+		 * on the head of the queue meanwhile.
+		 */
+		ss_data->cflags = cflags;
+		g_free (ss_data->contents);
+		ss_data->contents = NULL;
+		
+		sdb_system_run_pkg_config (sdbs, ss_data, "--modversion",
+								   G_CALLBACK (on_pkg_config_version_exit));
+		return;
+	}
+	free_cflags (cflags);
+	
+	/* destroys, after popping, the ss_data from the queue */
+	g_queue_remove (priv->sscan_queue, ss_data);
+	destroy_single_scan_data (ss_data);
+	
+	/* proceed with another scan */	
+	sdb_system_do_scan_next_package (sdbs);	
+}
+
+gboolean
+symbol_db_system_add_package (SymbolDBSystem *sdbs,
+							  const gchar *package_name,
+							  const gchar *package_version,
+							  const GPtrArray *files_array)
+{
+	EngineScanData *es_data;
+	gint i;
+	
+	g_return_val_if_fail (sdbs != NULL, FALSE);
+	g_return_val_if_fail (package_name != NULL, FALSE);
+	g_return_val_if_fail (package_version != NULL, FALSE);
+	g_return_val_if_fail (files_array != NULL, FALSE);
+	
+	if (files_array->len == 0 ||
+		symbol_db_system_is_package_parsed (sdbs, package_name, 
+											package_version) == TRUE ||
+		sdb_system_is_package_queued (sdbs, package_name, package_version) == TRUE)
+	{
+		DEBUG_PRINT ("no need to scan %s %s", package_name, package_version);
+		return FALSE;
+	}
+	
+	es_data = g_new0 (EngineScanData, 1);
+	es_data->sdbs = sdbs;
+	es_data->package_name = g_strdup (package_name);
+	es_data->package_version = g_strdup (package_version);
+	es_data->special_abort_scan = FALSE;
+	
+	/* the prepare thread works on its own copy */
+	es_data->files_to_scan_array = g_ptr_array_sized_new (files_array->len);
+	for (i = 0; i < files_array->len; i++)
+	{
+		g_ptr_array_add (es_data->files_to_scan_array, 
+						 g_strdup (g_ptr_array_index (files_array, i)));
+	}
+	
+	sdb_system_queue_engine_scan (sdbs, es_data);
+	return TRUE;
+}
+
+static void
+on_pkg_config_version_exit (AnjutaLauncher * launcher, int child_pid,
+							int exit_status, gulong time_taken_in_seconds,
+							gpointer user_data)
+{
+	SymbolDBSystem *sdbs;
+	SymbolDBSystemPriv *priv;
+	SingleScanData *ss_data;
+	const gchar *version;
+	
+	ss_data = (SingleScanData *)user_data;
+	sdbs = ss_data->sdbs;
+	priv = sdbs->priv;	
+		
+	/* first of all disconnect the signals */
+	g_signal_handlers_disconnect_by_func (launcher, on_pkg_config_version_exit,
+										  user_data);
+	
+	version = SYSTEM_PACKAGE_DEFAULT_VERSION;
+	if (ss_data->contents != NULL && strlen (g_strstrip (ss_data->contents)) > 0)
+		version = ss_data->contents;
+	
+	if (symbol_db_system_is_package_parsed (sdbs, ss_data->package_name, 
+											version) == TRUE ||
+		sdb_system_is_package_queued (sdbs, ss_data->package_name, version) == TRUE)
+	{
+		DEBUG_PRINT ("no need to scan %s %s", ss_data->package_name, version);
+	}
+	else
 	{
 		EngineScanData *es_data;
 		
+		DEBUG_PRINT ("NEED to scan %s %s", ss_data->package_name, version);
 		es_data = g_new0 (EngineScanData, 1);
 		es_data->sdbs = sdbs;
-		es_data->cflags = cflags;
+		es_data->cflags = ss_data->cflags;
 		es_data->package_name = g_strdup (ss_data->package_name);
+		es_data->package_version = g_strdup (version);
 		es_data->special_abort_scan = FALSE;
-			
-		/* is the engine queue already full && working? */
-		if (g_queue_get_length (priv->engine_queue) > 0) 
-		{
-			/* just push the tail waiting for a later processing [i.e. after
-			 * a scan-end received 
-			 */
-			DEBUG_PRINT ("pushing on engine queue [length %d] %s", 
-						 g_queue_get_length (priv->engine_queue),
-						 es_data->package_name);
-			g_queue_push_tail (priv->engine_queue, es_data);
-		}
-		else
-		{
-			/* push the tail to signal a 'working engine' */
-			DEBUG_PRINT ("scanning with engine queue [length %d] %s", 
-						 g_queue_get_length (priv->engine_queue),
-						 es_data->package_name);
-			
-			g_queue_push_tail (priv->engine_queue, es_data);
-			
-			sdb_system_do_engine_scan (sdbs, es_data);
-		}
+		ss_data->cflags = NULL;
+		
+		sdb_system_queue_engine_scan (sdbs, es_data);
 	}
 	
 	/* destroys, after popping, the ss_data from the queue */
@@ -728,18 +1071,9 @@ symbol_db_system_scan_package (SymbolDBSystem *sdbs,
 
 	priv = sdbs->priv;
 	
-	/* does is already exist on db? */
-	if (symbol_db_system_is_package_parsed (sdbs, package_name, "1.0") == TRUE)
-	{
-		DEBUG_PRINT ("symbol_db_system_scan_package (): no need to scan %s",
-					 package_name);
-		return FALSE;
-	}
-	else 
-	{
-		DEBUG_PRINT ("symbol_db_system_scan_package (): NEED to scan %s",
-					 package_name);
-	}
+	/* whether it already exists on db is checked in 
+	 * on_pkg_config_version_exit (), when the package version is known.
+	 */
 	
 	/* create the object to store in the queue */
 	ss_data = (SingleScanData*)g_new0 (SingleScanData, 1);
@@ -807,28 +1141,13 @@ symbol_db_system_parse_aborted_package (SymbolDBSystem *sdbs,
 	es_data->cflags = NULL;
 	es_data->package_name = g_strdup (_("Resuming glb scan."));
 	es_data->special_abort_scan = TRUE;
+	es_data->prepared = TRUE;
 	es_data->files_to_scan_array = files_to_scan_array;
 	es_data->languages_array = languages_array;
 		
 		
 	DEBUG_PRINT ("SYSTEM ABORT PARSING.....");
 	
-	/* is the engine queue already full && working? */
-	if (g_queue_get_length (priv->engine_queue) > 0) 
-	{
-		/* just push the tail waiting for a later processing [i.e. after
-		 * a scan-end received 
-		 */
-		DEBUG_PRINT ("pushing on engine queue %s", es_data->package_name);
-		g_queue_push_tail (priv->engine_queue, es_data);
-	}
-	else
-	{
-		DEBUG_PRINT ("aborted package");
-		/* push the tail to signal a 'working engine' */
-		g_queue_push_tail (priv->engine_queue, es_data);
-	
-		sdb_system_do_engine_scan (sdbs, es_data);
-	}
+	sdb_system_queue_engine_scan (sdbs, es_data);
 }
 
@@ -96,11 +96,26 @@ symbol_db_system_is_package_parseable (SymbolDBSystem *sdbs,
  * Scan a package. We won't do a check if the package is really parseable, but only
  * if it already exists on db. E.g. if a package has a wrong cflags string then 
  * the population won't start.
+ * Packages are stored with the version given by pkg-config, so the scan is
+ * skipped asynchronously if that version is already on db.
+ * @return TRUE if the package has been queued.
  */
 gboolean 
 symbol_db_system_scan_package (SymbolDBSystem *sdbs,
 							  const gchar * package_name);
 
+/**
+ * Add a package and its files to the globals db. Files are classified in a
+ * thread and the package is scanned after the previously added ones. Other
+ * versions of the package are removed from db when its scan starts.
+ * @return FALSE if this version of the package is already on db or queued.
+ */
+gboolean
+symbol_db_system_add_package (SymbolDBSystem *sdbs,
+							  const gchar *package_name,
+							  const gchar *package_version,
+							  const GPtrArray *files_array);
+
 /**
  * Scan global db for unscanned files.
  * @warning @param files_to_scan_array Must not to be freed by caller. They'll be 